@@ -49,6 +49,7 @@
 #include "db_metadata/meetinginformationdialog.h"
 
 #include "printing/wizard/printwizard.h"
+#include "odt_export/batch/sheetbatchexportdlg.h"
 
 #ifdef ENABLE_USER_QUERY
 #    include "sqlconsole/sqlconsole.h"
@@ -224,6 +225,7 @@ void MainWindow::setup_actions()
 
     databaseActionGroup->addAction(ui->actionExport_PDF);
     databaseActionGroup->addAction(ui->actionExport_Svg);
+    databaseActionGroup->addAction(ui->actionExport_Sheets);
 
     databaseActionGroup->addAction(ui->actionPrev_Job_Segment);
     databaseActionGroup->addAction(ui->actionNext_Job_Segment);
@@ -237,6 +239,7 @@ void MainWindow::setup_actions()
     connect(ui->actionPrint, &QAction::triggered, this, &MainWindow::onPrint);
     connect(ui->actionExport_PDF, &QAction::triggered, this, &MainWindow::onPrintPDF);
     connect(ui->actionExport_Svg, &QAction::triggered, this, &MainWindow::onExportSvg);
+    connect(ui->actionExport_Sheets, &QAction::triggered, this, &MainWindow::onExportSheets);
     connect(ui->actionProperties, &QAction::triggered, this, &MainWindow::onProperties);
 
     connect(ui->actionStations, &QAction::triggered, this, &MainWindow::onStationManager);
@@ -913,6 +916,16 @@ void MainWindow::onExportSvg()
     wizard->exec();
 }
 
+void MainWindow::onExportSheets()
+{
+    // Dialog lists items when created, editors must not change them later
+    if (!Session->getViewManager()->closeEditors())
+        return;
+
+    OwningQPointer<SheetBatchExportDlg> dlg = new SheetBatchExportDlg(Session->m_Db, this);
+    dlg->exec();
+}
+
 #ifdef ENABLE_USER_QUERY
 void MainWindow::onExecQuery()
 {
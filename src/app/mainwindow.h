@@ -82,6 +82,7 @@ private slots:
     void onPrint();
     void onPrintPDF();
     void onExportSvg();
+    void onExportSheets();
 
 #ifdef ENABLE_USER_QUERY
     void onExecQuery();
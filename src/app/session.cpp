@@ -27,6 +27,9 @@
 
 #include "viewmanager/viewmanager.h"
 #include "db_metadata/metadatamanager.h"
+#include "rollingstock/rsoccupancyindex.h"
+#include "odt_export/batch/sheetexporttracker.h"
+#include "stations/manager/stations/model/stationsvgplancache.h"
 
 #ifdef ENABLE_BACKGROUND_MANAGER
 #    include "backgroundmanager/backgroundmanager.h"
@@ -70,6 +73,43 @@ MeetingSession::MeetingSession() :
 
     metaDataMgr.reset(new MetaDataManager(m_Db));
 
+    // Keep rollingstock index up to date
+    rsOccupancy.reset(new RSOccupancyIndex(m_Db));
+    connect(this, &MeetingSession::rollingStockPlanChanged, rsOccupancy.get(),
+            &RSOccupancyIndex::invalidateRS);
+    connect(this, &MeetingSession::stationJobsPlanChanged, rsOccupancy.get(),
+            &RSOccupancyIndex::invalidateStations);
+    connect(this, &MeetingSession::rollingstockRemoved, rsOccupancy.get(),
+            &RSOccupancyIndex::onRollingstockRemoved);
+    connect(this, &MeetingSession::jobRemoved, rsOccupancy.get(), &RSOccupancyIndex::onJobRemoved);
+
+    // Remember which sheets need to be exported again
+    sheetTracker.reset(new SheetExportTracker);
+    SheetExportTracker *tracker = sheetTracker.get();
+    connect(this, &MeetingSession::shiftAdded, tracker, &SheetExportTracker::markShift);
+    connect(this, &MeetingSession::shiftNameChanged, tracker, &SheetExportTracker::markShift);
+    connect(this, &MeetingSession::shiftJobsChanged, tracker,
+            &SheetExportTracker::onShiftJobsChanged);
+    connect(this, &MeetingSession::jobAdded, tracker, &SheetExportTracker::markJob);
+    connect(this, &MeetingSession::jobRemoved, tracker, &SheetExportTracker::onJobRemoved);
+    connect(this, &MeetingSession::jobChanged, tracker, &SheetExportTracker::onJobChanged);
+    connect(this, &MeetingSession::stationNameChanged, tracker, &SheetExportTracker::markStation);
+    connect(this, &MeetingSession::stationJobsPlanChanged, tracker,
+            &SheetExportTracker::markStations);
+    connect(this, &MeetingSession::stationTrackPlanChanged, tracker,
+            &SheetExportTracker::markStations);
+    connect(this, &MeetingSession::rollingstockRemoved, tracker,
+            &SheetExportTracker::markRollingstock);
+    connect(this, &MeetingSession::rollingStockModified, tracker,
+            &SheetExportTracker::markRollingstock);
+    connect(this, &MeetingSession::rollingStockPlanChanged, tracker,
+            &SheetExportTracker::markRollingstockSet);
+
+    // Keep parsed station plans, dropped when station is removed
+    svgPlanCache.reset(new StationSVGPlanCache);
+    connect(this, &MeetingSession::stationRemoved, svgPlanCache.get(),
+            &StationSVGPlanCache::invalidateStation);
+
 #ifdef ENABLE_BACKGROUND_MANAGER
     backgroundManager.reset(new BackgroundManager);
 #endif
@@ -97,7 +137,8 @@ DB_Error MeetingSession::openDB(const QString &str, bool ignoreVersion)
     }
 
     // try{
-    if (m_Db.connect(str.toUtf8(), SQLITE_OPEN_READWRITE) != SQLITE_OK)
+    // Allow URI file names so other files can be attached read-only
+    if (m_Db.connect(str.toUtf8(), SQLITE_OPEN_READWRITE | SQLITE_OPEN_URI) != SQLITE_OK)
     {
         // throw database_error(m_Db);
         qWarning() << "DB:" << m_Db.error_msg();
@@ -206,6 +247,10 @@ DB_Error MeetingSession::closeDB()
     backgroundManager->clearResults();
 #endif
 
+    rsOccupancy->clear();
+    sheetTracker->clear();
+    svgPlanCache->clear();
+
     fileName.clear();
 
     return DB_Error::NoError;
@@ -225,7 +270,8 @@ DB_Error MeetingSession::createNewDB(const QString &file)
     if ((code) != SQLITE_OK) \
     qWarning() << __LINE__ << (code) << m_Db.error_code() << m_Db.error_msg()
 
-    result = m_Db.connect(file.toUtf8(), SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    result =
+      m_Db.connect(file.toUtf8(), SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI);
     CHECK(result);
 
     // See 'openDB()'
@@ -35,6 +35,9 @@ using namespace sqlite3pp;
 
 class ViewManager;
 class MetaDataManager;
+class RSOccupancyIndex;
+class SheetExportTracker;
+class StationSVGPlanCache;
 
 #ifdef ENABLE_BACKGROUND_MANAGER
 class BackgroundManager;
@@ -82,6 +85,21 @@ public:
         return metaDataMgr.get();
     }
 
+    inline RSOccupancyIndex *getRSOccupancyIndex()
+    {
+        return rsOccupancy.get();
+    }
+
+    inline SheetExportTracker *getSheetExportTracker()
+    {
+        return sheetTracker.get();
+    }
+
+    inline StationSVGPlanCache *getStationSVGPlanCache()
+    {
+        return svgPlanCache.get();
+    }
+
 #ifdef ENABLE_BACKGROUND_MANAGER
     BackgroundManager *getBackgroundManager() const;
 #endif
@@ -128,6 +146,12 @@ private:
 
     std::unique_ptr<MetaDataManager> metaDataMgr;
 
+    std::unique_ptr<RSOccupancyIndex> rsOccupancy;
+
+    std::unique_ptr<SheetExportTracker> sheetTracker;
+
+    std::unique_ptr<StationSVGPlanCache> svgPlanCache;
+
 #ifdef ENABLE_BACKGROUND_MANAGER
     std::unique_ptr<BackgroundManager> backgroundManager;
 #endif
@@ -0,0 +1,84 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphstationcache.h"
+
+GraphStationCache::GraphStationCache(qint64 maxBytes)
+{
+    setMaxBytes(maxBytes);
+}
+
+void GraphStationCache::setMaxBytes(qint64 maxBytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.setMaxCost(int(qBound(qint64(0), maxBytes, qint64(INT_MAX))));
+}
+
+bool GraphStationCache::getStation(StationGraphObject &st, QString &outFullName)
+{
+    QMutexLocker lock(&m_mutex);
+
+    const Entry *entry = m_cache.object(st.stationId);
+    if (!entry)
+        return false;
+
+    outFullName    = entry->fullName;
+    st.stationName = entry->stationName;
+    st.stationType = entry->stationType;
+    st.platforms   = entry->platforms;
+    return true;
+}
+
+void GraphStationCache::addStation(const StationGraphObject &st, const QString &fullName)
+{
+    Entry *entry       = new Entry;
+    entry->fullName    = fullName;
+    entry->stationName = st.stationName;
+    entry->stationType = st.stationType;
+    entry->platforms   = st.platforms;
+
+    // Do not store job stops
+    for (StationGraphObject::PlatformGraph &platf : entry->platforms)
+        platf.jobStops.clear();
+
+    QMutexLocker lock(&m_mutex);
+
+    // Takes ownership, entry is deleted if bigger than budget
+    m_cache.insert(st.stationId, entry, estimateCost(*entry));
+}
+
+void GraphStationCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
+int GraphStationCache::estimateCost(const Entry &entry)
+{
+    int cost = int(sizeof(Entry));
+    cost += (entry.fullName.size() + entry.stationName.size()) * int(sizeof(QChar));
+
+    for (const StationGraphObject::PlatformGraph &platf : entry.platforms)
+    {
+        cost += int(sizeof(StationGraphObject::PlatformGraph));
+        cost += platf.platformName.size() * int(sizeof(QChar));
+    }
+
+    return cost;
+}
@@ -0,0 +1,76 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHSTATIONCACHE_H
+#define GRAPHSTATIONCACHE_H
+
+#include <QCache>
+#include <QMutex>
+
+#include "stationgraphobject.h"
+
+/*!
+ * \brief The GraphStationCache class
+ *
+ * Keeps station names and tracks loaded by LineGraphScene
+ * so scenes loaded one after another do not query them again.
+ * Job stops are not cached, they are specific to each scene.
+ *
+ * Memory usage is bounded by an approximate budget in bytes,
+ * least recently used stations are discarded first.
+ * It can be shared by scenes loaded from different threads.
+ *
+ * \sa LineGraphScene::setStationCache()
+ */
+class GraphStationCache
+{
+public:
+    explicit GraphStationCache(qint64 maxBytes);
+
+    void setMaxBytes(qint64 maxBytes);
+
+    /*!
+     * \brief getStation
+     * \param st station to fill, \ref StationGraphObject::stationId must be set
+     * \param outFullName filled with station full name
+     * \return true if station was in cache
+     */
+    bool getStation(StationGraphObject &st, QString &outFullName);
+
+    void addStation(const StationGraphObject &st, const QString &fullName);
+
+    void clear();
+
+private:
+    struct Entry
+    {
+        QString fullName;
+        QString stationName;
+        utils::StationType stationType;
+        QVector<StationGraphObject::PlatformGraph> platforms;
+    };
+
+    static int estimateCost(const Entry &entry);
+
+private:
+    QMutex m_mutex;
+    QCache<db_id, Entry> m_cache;
+};
+
+#endif // GRAPHSTATIONCACHE_H
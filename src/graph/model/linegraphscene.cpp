@@ -19,6 +19,8 @@
 
 #include "linegraphscene.h"
 
+#include "graphstationcache.h"
+
 #include "graph/view/backgroundhelper.h"
 
 #include "app/session.h"
@@ -57,7 +59,9 @@ LineGraphScene::LineGraphScene(sqlite3pp::database &db, QObject *parent) :
     mDb(db),
     graphObjectId(0),
     graphType(LineGraphType::NoGraph),
-    m_drawSelection(true)
+    m_drawSelection(true),
+    m_mergeJobPaths(false),
+    m_stationCache(nullptr)
 {
 }
 
@@ -68,9 +72,10 @@ void LineGraphScene::renderContents(QPainter *painter, const QRectF &sceneRect)
     if (getGraphType() == LineGraphType::NoGraph)
         return; // Nothing to draw
 
-    BackgroundHelper::drawStations(painter, this, sceneRect);
-    BackgroundHelper::drawJobStops(painter, this, sceneRect, m_drawSelection);
-    BackgroundHelper::drawJobSegments(painter, this, sceneRect, m_drawSelection);
+    BackgroundHelper::drawStations(painter, this, sceneRect, m_mergeJobPaths);
+    BackgroundHelper::drawJobStops(painter, this, sceneRect, m_drawSelection, m_mergeJobPaths);
+    BackgroundHelper::drawJobSegments(painter, this, sceneRect, m_drawSelection,
+                                      m_mergeJobPaths);
 }
 
 void LineGraphScene::renderHeader(QPainter *painter, const QRectF &sceneRect,
@@ -98,8 +103,8 @@ void LineGraphScene::recalcContentSize()
     // Add an additional half station offset after last station
     // This gives extra space to center station label
     const double maxWidth =
-      entry.xPos + platfCount * Session->platformOffset + Session->stationOffset / 2;
-    const double lastY   = Session->vertOffset + Session->hourOffset * 24 + 10;
+      entry.xPos + platfCount * m_style.platformOffset + m_style.stationOffset / 2;
+    const double lastY   = m_style.vertOffset + m_style.hourOffset * 24 + 10;
 
     m_cachedContentsSize = QSize(maxWidth, lastY);
 }
@@ -114,6 +119,8 @@ bool LineGraphScene::loadGraph(db_id objectId, LineGraphType type, bool force)
     if (!force && objectId == graphObjectId && type == graphType)
         return true; // Already loaded
 
+    m_style       = GraphStyle::current();
+
     // Initial state is invalid
     graphType     = LineGraphType::NoGraph;
     graphObjectId = 0;
@@ -144,7 +151,7 @@ bool LineGraphScene::loadGraph(db_id objectId, LineGraphType type, bool force)
 
     // Leave on left horizOffset plus half station offset to separate first station from HourPanel
     // and to give more space to station label.
-    const double curPos = Session->horizOffset + Session->stationOffset / 2;
+    const double curPos = m_style.horizOffset + m_style.stationOffset / 2;
 
     if (type == LineGraphType::SingleStation)
     {
@@ -195,7 +202,7 @@ bool LineGraphScene::loadGraph(db_id objectId, LineGraphType type, bool force)
 
         stA.xPos = curPos;
         stB.xPos =
-          stA.xPos + stA.platforms.count() * Session->platformOffset + Session->stationOffset;
+          stA.xPos + stA.platforms.count() * m_style.platformOffset + m_style.stationOffset;
 
         stations.insert(stA.stationId, stA);
         stations.insert(stB.stationId, stB);
@@ -235,6 +242,8 @@ bool LineGraphScene::reloadJobs()
     if (graphType == LineGraphType::NoGraph)
         return false;
 
+    m_style = GraphStyle::current();
+
     // TODO: maybe only load visible
 
     for (StationGraphObject &st : stations)
@@ -290,7 +299,7 @@ bool LineGraphScene::reloadJobs()
 
 void LineGraphScene::updateHeaderSize()
 {
-    QSizeF headerSize(Session->horizOffset, Session->vertOffset);
+    QSizeF headerSize(m_style.horizOffset, m_style.vertOffset);
     if (headerSize != m_cachedHeaderSize)
     {
         m_cachedHeaderSize = headerSize;
@@ -302,7 +311,7 @@ JobStopEntry LineGraphScene::getJobStopAt(const StationGraphObject *prevSt,
                                           const StationGraphObject *nextSt, const QPointF &pos,
                                           const double tolerance)
 {
-    const double platformOffset = Session->platformOffset;
+    const double platformOffset = m_style.platformOffset;
 
     JobStopEntry job;
 
@@ -477,6 +486,9 @@ JobStopEntry LineGraphScene::getJobAt(const QPointF &pos, const double tolerance
 
 bool LineGraphScene::loadStation(StationGraphObject &st, QString &outFullName)
 {
+    if (m_stationCache && m_stationCache->getStation(st, outFullName))
+        return true;
+
     sqlite3pp::query q(mDb);
 
     q.prepare("SELECT name,short_name,type FROM stations WHERE id=?");
@@ -517,6 +529,9 @@ bool LineGraphScene::loadStation(StationGraphObject &st, QString &outFullName)
         st.platforms.append(platf);
     }
 
+    if (m_stationCache)
+        m_stationCache->addStation(st, outFullName);
+
     return true;
 }
 
@@ -586,7 +601,7 @@ bool LineGraphScene::loadFullLine(db_id lineId)
     q.bind(1, lineId);
 
     db_id lastStationId = 0;
-    double curPos       = Session->horizOffset + Session->stationOffset / 2;
+    double curPos       = m_style.horizOffset + m_style.stationOffset / 2;
 
     QString unusedStFullName;
 
@@ -624,7 +639,7 @@ bool LineGraphScene::loadFullLine(db_id lineId)
             st.xPos = curPos;
             stations.insert(st.stationId, st);
             stationPositions.append({st.stationId, railwaySegmentId, st.xPos, {}});
-            curPos += st.platforms.count() * Session->platformOffset + Session->stationOffset;
+            curPos += st.platforms.count() * m_style.platformOffset + m_style.stationOffset;
         }
         else if (fromStationId != lastStationId)
         {
@@ -644,7 +659,7 @@ bool LineGraphScene::loadFullLine(db_id lineId)
         stationPositions.last().segmentId = railwaySegmentId;
         stationPositions.append({stB.stationId, 0, stB.xPos, {}});
 
-        curPos += stB.platforms.count() * Session->platformOffset + Session->stationOffset;
+        curPos += stB.platforms.count() * m_style.platformOffset + m_style.stationOffset;
         lastStationId = stB.stationId;
     }
 
@@ -679,8 +694,8 @@ bool LineGraphScene::loadStationJobStops(StationGraphObject &st)
                        " ORDER BY stops.arrival");
     q.bind(1, st.stationId);
 
-    const double vertOffset = Session->vertOffset;
-    const double hourOffset = Session->hourOffset;
+    const double vertOffset = m_style.vertOffset;
+    const double hourOffset = m_style.hourOffset;
 
     for (auto stop : q)
     {
@@ -788,9 +803,9 @@ bool LineGraphScene::loadSegmentJobs(LineGraphScene::StationPosEntry &stPos,
     // Reset previous job segment graph
     stPos.nextSegmentJobGraphs.clear();
 
-    const double vertOffset  = Session->vertOffset;
-    const double hourOffset  = Session->hourOffset;
-    const double platfOffset = Session->platformOffset;
+    const double vertOffset  = m_style.vertOffset;
+    const double hourOffset  = m_style.hourOffset;
+    const double platfOffset = m_style.platformOffset;
 
     sqlite3pp::query q(
       mDb, "SELECT sub.*, jobs.category, g_out.track_id, g_in.track_id FROM ("
@@ -920,9 +935,9 @@ bool LineGraphScene::requestShowZone(db_id stationId, db_id segmentId, QTime fro
 {
     // TODO: when we will load incrementally, ensure relevant items are loaded
 
-    const double vertOffset  = Session->vertOffset;
-    const double hourOffset  = Session->hourOffset;
-    const double platfOffset = Session->platformOffset;
+    const double vertOffset  = m_style.vertOffset;
+    const double hourOffset  = m_style.hourOffset;
+    const double platfOffset = m_style.platformOffset;
 
     QRectF result;
     result.setTop(vertOffset + timeToHourFraction(from) * hourOffset);
@@ -30,9 +30,12 @@
 #include "utils/types.h"
 
 #include "graph/linegraphtypes.h"
+#include "graph/view/graphstyle.h"
 
 #include "stationgraphobject.h"
 
+class GraphStationCache;
+
 namespace sqlite3pp {
 class database;
 }
@@ -173,6 +176,43 @@ public:
         m_drawSelection = val;
     }
 
+    /*!
+     * \brief getMergeJobPaths
+     * \return true if job lines are merged when rendering
+     *
+     * \sa setMergeJobPaths()
+     */
+    inline bool getMergeJobPaths() const
+    {
+        return m_mergeJobPaths;
+    }
+
+    /*!
+     * \brief setMergeJobPaths
+     * \param val true to merge job lines
+     *
+     * When true, job lines of same category are collected in a single path
+     * and drawn after all other lines, then job labels are drawn on top.
+     * Output looks the same but vector devices like PDF get far fewer
+     * drawing operations. Used when printing.
+     */
+    inline void setMergeJobPaths(bool val)
+    {
+        m_mergeJobPaths = val;
+    }
+
+    /*!
+     * \brief setStationCache
+     * \param cache shared cache or nullptr to always query stations
+     *
+     * Stations loaded by next \ref loadGraph() are taken from and stored in \a cache
+     * Cache is not owned by scene and must outlive it.
+     */
+    inline void setStationCache(GraphStationCache *cache)
+    {
+        m_stationCache = cache;
+    }
+
     /*!
      * \brief requestShowZone
      * \param stationId null if you want to select segment
@@ -356,6 +396,14 @@ private:
     QVector<StationPosEntry> stationPositions;
     QHash<db_id, StationGraphObject> stations;
 
+    /*!
+     * \brief Graph offsets
+     *
+     * Taken when loading so scenes loaded by print threads do not read settings.
+     * Refreshed by \ref loadGraph() and \ref reloadJobs()
+     */
+    GraphStyle m_style;
+
     /*!
      * \brief Job selection
      *
@@ -364,6 +412,9 @@ private:
     JobStopEntry selectedJob;
 
     bool m_drawSelection;
+    bool m_mergeJobPaths;
+
+    GraphStationCache *m_stationCache;
 
     PendingUpdateFlags pendingUpdate;
 };
@@ -18,29 +18,122 @@
  */
 
 #include "backgroundhelper.h"
-
-#include "app/session.h"
+#include "graphstyle.h"
 
 #include "graph/model/linegraphscene.h"
 #include "utils/jobcategorystrings.h"
 
 #include <QPainter>
+#include <QPainterPath>
 #include "utils/font_utils.h"
 
+#include <QMap>
+
 #include <QtMath>
 
 #include <QDebug>
 
+namespace {
+
+// Includes NCategories, used by jobs with unknown category
+constexpr int NCategoryLines = int(JobCategory::NCategories) + 1;
+
+// Job lines collected by category, each category is drawn with a single path
+struct CategoryLines
+{
+    QPainterPath paths[NCategoryLines];
+    QVector<QPointF> points[NCategoryLines]; // Stops with null duration
+
+    inline void addLine(JobCategory cat, const QPointF &p1, const QPointF &p2)
+    {
+        QPainterPath &path = paths[int(cat)];
+        path.moveTo(p1);
+        path.lineTo(p2);
+    }
+
+    inline void addPoint(JobCategory cat, const QPointF &p)
+    {
+        points[int(cat)].append(p);
+    }
+
+    void draw(QPainter *painter, QPen &jobPen, const GraphStyle &style) const
+    {
+        // Paths must only be stroked
+        painter->setBrush(Qt::NoBrush);
+
+        for (int i = 0; i < NCategoryLines; i++)
+        {
+            if (paths[i].isEmpty() && points[i].isEmpty())
+                continue;
+
+            jobPen.setColor(style.colorForCat(JobCategory(i)));
+            painter->setPen(jobPen);
+
+            if (!paths[i].isEmpty())
+                painter->drawPath(paths[i]);
+            if (!points[i].isEmpty())
+                painter->drawPoints(points[i].constData(), points[i].size());
+        }
+    }
+};
+
+struct JobLabel
+{
+    QRectF rect; // Stop label rect
+    QLineF line; // Segment line, from departure to arrival
+    db_id jobId          = 0;
+    JobCategory category = JobCategory::NCategories;
+};
+
+} // namespace
+
+static void drawJobSegmentLabel(QPainter *painter, const QLineF &line, const QString &jobName,
+                                const QTextOption &textOption, const QColor &textBackground)
+{
+    // Save old transformation to reset it after drawing text
+    const QTransform oldTransf = painter->transform();
+
+    // Move to line center, it will be rotation pivot
+    painter->translate(line.center());
+
+    // Rotate by line angle
+    qreal angle = line.angle();
+    if (line.x1() > line.x2())
+        angle += 180.0; // Prevent flipping text
+
+    painter->rotate(-angle); // minus because QPainter wants clockwise angle
+
+    const double lineLength = line.length();
+    QRectF textRect(-lineLength / 2, -30, lineLength, 25);
+
+    // Try to avoid overlapping text of crossing jobs, move text towards arrival
+    if (line.x2() > line.x1())
+        textRect.moveLeft(textRect.left() + lineLength / 5);
+    else
+        textRect.moveLeft(textRect.left() - lineLength / 5);
+
+    textRect = painter->boundingRect(textRect, jobName, textOption);
+
+    // Draw a semi transparent background to ease text reading
+    painter->fillRect(textRect, textBackground);
+    painter->drawText(textRect, jobName, textOption);
+
+    // Reset to old transformation
+    painter->setTransform(oldTransf);
+}
+
 void BackgroundHelper::drawHourPanel(QPainter *painter, const QRectF &rect)
 {
+    const GraphStyle style = GraphStyle::current();
+
     // TODO: settings
     QFont hourTextFont;
     setFontPointSizeDPI(hourTextFont, 15, painter);
 
-    QPen hourTextPen(AppSettings.getHourTextColor());
+    QPen hourTextPen(style.hourTextColor);
 
-    const int vertOffset = Session->vertOffset;
-    const int hourOffset = Session->hourOffset;
+    const int vertOffset = style.vertOffset;
+    const int hourOffset = style.hourOffset;
 
     painter->setFont(hourTextFont);
     painter->setPen(hourTextPen);
@@ -70,11 +163,13 @@ void BackgroundHelper::drawHourPanel(QPainter *painter, const QRectF &rect)
 
 void BackgroundHelper::drawBackgroundHourLines(QPainter *painter, const QRectF &rect)
 {
-    const double horizOffset = Session->horizOffset;
-    const double vertOffset  = Session->vertOffset;
-    const double hourOffset  = Session->hourOffset;
+    const GraphStyle style = GraphStyle::current();
 
-    QPen hourLinePen(AppSettings.getHourLineColor(), AppSettings.getHourLineWidth());
+    const double horizOffset = style.horizOffset;
+    const double vertOffset  = style.vertOffset;
+    const double hourOffset  = style.hourOffset;
+
+    QPen hourLinePen(style.hourLineColor, style.hourLineWidth);
 
     const qreal x1 = qMax(qreal(horizOffset), rect.left());
     const qreal x2 = rect.right();
@@ -116,11 +211,13 @@ void BackgroundHelper::drawBackgroundHourLines(QPainter *painter, const QRectF &
 void BackgroundHelper::drawStationHeader(QPainter *painter, LineGraphScene *scene,
                                          const QRectF &rect)
 {
+    const GraphStyle style = GraphStyle::current();
+
     QFont stationFont;
     stationFont.setBold(true);
     setFontPointSizeDPI(stationFont, 25, painter);
 
-    QPen stationPen(AppSettings.getStationTextColor());
+    QPen stationPen(style.stationTextColor);
 
     QFont platfBoldFont = stationFont;
     setFontPointSizeDPI(platfBoldFont, 16, painter);
@@ -131,8 +228,8 @@ void BackgroundHelper::drawStationHeader(QPainter *painter, LineGraphScene *scen
     QPen electricPlatfPen(Qt::blue);
     QPen nonElectricPlatfPen(Qt::black);
 
-    const qreal platformOffset = Session->platformOffset;
-    const int stationOffset    = Session->stationOffset;
+    const qreal platformOffset = style.platformOffset;
+    const int stationOffset    = style.stationOffset;
 
     // On left go back by half station offset to center station label
     // and center platform label by going a back of half platformOffset
@@ -187,24 +284,30 @@ void BackgroundHelper::drawStationHeader(QPainter *painter, LineGraphScene *scen
     }
 }
 
-void BackgroundHelper::drawStations(QPainter *painter, LineGraphScene *scene, const QRectF &rect)
+void BackgroundHelper::drawStations(QPainter *painter, LineGraphScene *scene, const QRectF &rect,
+                                    bool mergePaths)
 {
+    const GraphStyle style = GraphStyle::current();
+
     const QRgb white = qRgb(255, 255, 255);
 
-    // const int horizOffset = Session->horizOffset;
-    const int vertOffset = Session->vertOffset;
-    // const int stationOffset = Session->stationOffset;
-    const double platfOffset    = Session->platformOffset;
-    const int lastY             = vertOffset + Session->hourOffset * 24 + 10;
+    // const int horizOffset = style.horizOffset;
+    const int vertOffset = style.vertOffset;
+    // const int stationOffset = style.stationOffset;
+    const double platfOffset    = style.platformOffset;
+    const int lastY             = vertOffset + style.hourOffset * 24 + 10;
 
-    const int width             = AppSettings.getPlatformLineWidth();
-    const QColor mainPlatfColor = AppSettings.getMainPlatfColor();
+    const int width             = style.platformLineWidth;
+    const QColor mainPlatfColor = style.mainPlatfColor;
 
     QPen platfPen(mainPlatfColor, width);
 
     QPointF top(0, vertOffset);
     QPointF bottom(0, lastY);
 
+    // Ordered by color so output is always the same
+    QMap<QRgb, QVector<QLineF>> linesByColor;
+
     for (const StationGraphObject &st : qAsConst(scene->stations))
     {
         const double left  = st.xPos;
@@ -217,33 +320,50 @@ void BackgroundHelper::drawStations(QPainter *painter, LineGraphScene *scene, co
 
         for (const StationGraphObject::PlatformGraph &platf : st.platforms)
         {
-            if (platf.color == white)
-                platfPen.setColor(mainPlatfColor);
+            if (mergePaths)
+            {
+                const QRgb color = platf.color == white ? mainPlatfColor.rgba() : platf.color;
+                linesByColor[color].append(QLineF(top, bottom));
+            }
             else
-                platfPen.setColor(platf.color);
+            {
+                if (platf.color == white)
+                    platfPen.setColor(mainPlatfColor);
+                else
+                    platfPen.setColor(platf.color);
 
-            painter->setPen(platfPen);
+                painter->setPen(platfPen);
 
-            painter->drawLine(top, bottom);
+                painter->drawLine(top, bottom);
+            }
 
             top.rx() += platfOffset;
             bottom.rx() += platfOffset;
         }
     }
+
+    for (auto it = linesByColor.constBegin(); it != linesByColor.constEnd(); it++)
+    {
+        platfPen.setColor(QColor::fromRgba(it.key()));
+        painter->setPen(platfPen);
+        painter->drawLines(it.value());
+    }
 }
 
 void BackgroundHelper::drawJobStops(QPainter *painter, LineGraphScene *scene, const QRectF &rect,
-                                    bool drawSelection)
+                                    bool drawSelection, bool mergePaths)
 {
-    const double platfOffset   = Session->platformOffset;
-    const double stationOffset = Session->stationOffset;
+    const GraphStyle style = GraphStyle::current();
+
+    const double platfOffset   = style.platformOffset;
+    const double stationOffset = style.stationOffset;
 
     QFont jobNameFont;
     setFontPointSizeDPI(jobNameFont, 20, painter);
     painter->setFont(jobNameFont);
 
     QPen jobPen;
-    jobPen.setWidth(AppSettings.getJobLineWidth());
+    jobPen.setWidth(style.jobLineWidth);
     jobPen.setCapStyle(Qt::RoundCap);
     jobPen.setJoinStyle(Qt::RoundJoin);
 
@@ -256,7 +376,7 @@ void BackgroundHelper::drawJobStops(QPainter *painter, LineGraphScene *scene, co
         selectedJobPen.setCapStyle(Qt::RoundCap);
         selectedJobPen.setJoinStyle(Qt::RoundJoin);
 
-        QColor color = Session->colorForCat(selectedJob.category);
+        QColor color = style.colorForCat(selectedJob.category);
         color.setAlpha(SelectedJobAlphaFactor);
         selectedJobPen.setColor(color);
     }
@@ -267,6 +387,10 @@ void BackgroundHelper::drawJobStops(QPainter *painter, LineGraphScene *scene, co
     JobCategory lastJobCategory = JobCategory::NCategories;
     QTextOption textOption(Qt::AlignTop | Qt::AlignLeft);
 
+    // Used only when merging paths, labels are drawn after all lines
+    CategoryLines mergedLines;
+    QVector<JobLabel> labels;
+
     for (const StationGraphObject &st : qAsConst(scene->stations))
     {
         const double left  = st.xPos;
@@ -308,9 +432,32 @@ void BackgroundHelper::drawJobStops(QPainter *painter, LineGraphScene *scene, co
                     painter->setPen(jobPen);
                 }
 
+                // Put label a bit to the left in respect to the stop arrival point
+                // Calculate width so it doesn't go after maxJobLabelX
+                const qreal topWithMargin = top.x() + platfOffset / 2;
+                const QRectF labelRect(topWithMargin, top.y(), maxJobLabelX - topWithMargin, 25);
+
+                if (mergePaths)
+                {
+                    if (nullStopDuration)
+                        mergedLines.addPoint(jobStop.stop.category, top);
+                    else
+                        mergedLines.addLine(jobStop.stop.category, top, bottom);
+
+                    if (jobStop.drawLabel)
+                    {
+                        JobLabel label;
+                        label.rect     = labelRect;
+                        label.jobId    = jobStop.stop.jobId;
+                        label.category = jobStop.stop.category;
+                        labels.append(label);
+                    }
+                    continue;
+                }
+
                 if (lastJobCategory != jobStop.stop.category)
                 {
-                    QColor color = Session->colorForCat(jobStop.stop.category);
+                    QColor color = style.colorForCat(jobStop.stop.category);
                     jobPen.setColor(color);
                     painter->setPen(jobPen);
                     lastJobCategory = jobStop.stop.category;
@@ -325,12 +472,7 @@ void BackgroundHelper::drawJobStops(QPainter *painter, LineGraphScene *scene, co
                 {
                     const QString jobName =
                       JobCategoryName::jobName(jobStop.stop.jobId, jobStop.stop.category);
-
-                    // Put label a bit to the left in respect to the stop arrival point
-                    // Calculate width so it doesn't go after maxJobLabelX
-                    const qreal topWithMargin = top.x() + platfOffset / 2;
-                    QRectF r(topWithMargin, top.y(), maxJobLabelX - topWithMargin, 25);
-                    painter->drawText(r, jobName, textOption);
+                    painter->drawText(labelRect, jobName, textOption);
                 }
             }
 
@@ -338,12 +480,32 @@ void BackgroundHelper::drawJobStops(QPainter *painter, LineGraphScene *scene, co
             bottom.rx() += platfOffset;
         }
     }
+
+    if (!mergePaths)
+        return;
+
+    mergedLines.draw(painter, jobPen, style);
+
+    for (const JobLabel &label : qAsConst(labels))
+    {
+        if (lastJobCategory != label.category)
+        {
+            jobPen.setColor(style.colorForCat(label.category));
+            painter->setPen(jobPen);
+            lastJobCategory = label.category;
+        }
+
+        const QString jobName = JobCategoryName::jobName(label.jobId, label.category);
+        painter->drawText(label.rect, jobName, textOption);
+    }
 }
 
 void BackgroundHelper::drawJobSegments(QPainter *painter, LineGraphScene *scene, const QRectF &rect,
-                                       bool drawSelection)
+                                       bool drawSelection, bool mergePaths)
 {
-    const double stationOffset = Session->stationOffset;
+    const GraphStyle style = GraphStyle::current();
+
+    const double stationOffset = style.stationOffset;
 
     QFont jobNameFont;
     setFontPointSizeDPI(jobNameFont, 20, painter);
@@ -353,7 +515,7 @@ void BackgroundHelper::drawJobSegments(QPainter *painter, LineGraphScene *scene,
     textBackground.setAlpha(100);
 
     QPen jobPen;
-    jobPen.setWidth(AppSettings.getJobLineWidth());
+    jobPen.setWidth(style.jobLineWidth);
     jobPen.setCapStyle(Qt::RoundCap);
     jobPen.setJoinStyle(Qt::RoundJoin);
 
@@ -366,7 +528,7 @@ void BackgroundHelper::drawJobSegments(QPainter *painter, LineGraphScene *scene,
         selectedJobPen.setCapStyle(Qt::RoundCap);
         selectedJobPen.setJoinStyle(Qt::RoundJoin);
 
-        QColor color = Session->colorForCat(selectedJob.category);
+        QColor color = style.colorForCat(selectedJob.category);
         color.setAlpha(SelectedJobAlphaFactor);
         selectedJobPen.setColor(color);
     }
@@ -374,6 +536,10 @@ void BackgroundHelper::drawJobSegments(QPainter *painter, LineGraphScene *scene,
     JobCategory lastJobCategory = JobCategory::NCategories;
     QTextOption textOption(Qt::AlignCenter);
 
+    // Used only when merging paths, labels are drawn after all lines
+    CategoryLines mergedLines;
+    QVector<JobLabel> labels;
+
     // Iterate until one but last
     // This way we can always acces next station
     for (int i = 0; i < scene->stationPositions.size() - 1; i++)
@@ -414,9 +580,21 @@ void BackgroundHelper::drawJobSegments(QPainter *painter, LineGraphScene *scene,
                 painter->setPen(jobPen);
             }
 
+            if (mergePaths)
+            {
+                mergedLines.addLine(job.category, line.p1(), line.p2());
+
+                JobLabel label;
+                label.line     = line;
+                label.jobId    = job.jobId;
+                label.category = job.category;
+                labels.append(label);
+                continue;
+            }
+
             if (lastJobCategory != job.category)
             {
-                QColor color = Session->colorForCat(job.category);
+                QColor color = style.colorForCat(job.category);
                 jobPen.setColor(color);
                 painter->setPen(jobPen);
                 lastJobCategory = job.category;
@@ -425,37 +603,25 @@ void BackgroundHelper::drawJobSegments(QPainter *painter, LineGraphScene *scene,
             painter->drawLine(line);
 
             const QString jobName = JobCategoryName::jobName(job.jobId, job.category);
+            drawJobSegmentLabel(painter, line, jobName, textOption, textBackground);
+        }
+    }
 
-            // Save old transformation to reset it after drawing text
-            const QTransform oldTransf = painter->transform();
-
-            // Move to line center, it will be rotation pivot
-            painter->translate(line.center());
-
-            // Rotate by line angle
-            qreal angle = line.angle();
-            if (job.fromDeparture.x() > job.toArrival.x())
-                angle += 180.0; // Prevent flipping text
-
-            painter->rotate(-angle); // minus because QPainter wants clockwise angle
-
-            const double lineLength = line.length();
-            QRectF textRect(-lineLength / 2, -30, lineLength, 25);
-
-            // Try to avoid overlapping text of crossing jobs, move text towards arrival
-            if (job.toArrival.x() > job.fromDeparture.x())
-                textRect.moveLeft(textRect.left() + lineLength / 5);
-            else
-                textRect.moveLeft(textRect.left() - lineLength / 5);
-
-            textRect = painter->boundingRect(textRect, jobName, textOption);
+    if (!mergePaths)
+        return;
 
-            // Draw a semi transparent background to ease text reading
-            painter->fillRect(textRect, textBackground);
-            painter->drawText(textRect, jobName, textOption);
+    mergedLines.draw(painter, jobPen, style);
 
-            // Reset to old transformation
-            painter->setTransform(oldTransf);
+    for (const JobLabel &label : qAsConst(labels))
+    {
+        if (lastJobCategory != label.category)
+        {
+            jobPen.setColor(style.colorForCat(label.category));
+            painter->setPen(jobPen);
+            lastJobCategory = label.category;
         }
+
+        const QString jobName = JobCategoryName::jobName(label.jobId, label.category);
+        drawJobSegmentLabel(painter, label.line, jobName, textOption, textBackground);
     }
 }
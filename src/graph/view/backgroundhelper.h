@@ -42,13 +42,15 @@ public:
 
     static void drawStationHeader(QPainter *painter, LineGraphScene *scene, const QRectF &rect);
 
-    static void drawStations(QPainter *painter, LineGraphScene *scene, const QRectF &rect);
+    // When mergePaths is true lines are batched by color to reduce vector output size
+    static void drawStations(QPainter *painter, LineGraphScene *scene, const QRectF &rect,
+                             bool mergePaths = false);
 
     static void drawJobStops(QPainter *painter, LineGraphScene *scene, const QRectF &rect,
-                             bool drawSelection);
+                             bool drawSelection, bool mergePaths = false);
 
     static void drawJobSegments(QPainter *painter, LineGraphScene *scene, const QRectF &rect,
-                                bool drawSelection);
+                                bool drawSelection, bool mergePaths = false);
 
 public:
     static constexpr double SelectedJobWidthFactor = 3.0;
@@ -0,0 +1,67 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "graphstyle.h"
+
+#include "app/session.h"
+
+static thread_local const GraphStyle *threadStyle = nullptr;
+
+GraphStyle GraphStyle::fromSettings()
+{
+    GraphStyle style;
+    style.hourOffset        = Session->hourOffset;
+    style.stationOffset     = Session->stationOffset;
+    style.platformOffset    = Session->platformOffset;
+    style.horizOffset       = Session->horizOffset;
+    style.vertOffset        = Session->vertOffset;
+
+    style.platformLineWidth = AppSettings.getPlatformLineWidth();
+    style.hourLineWidth     = AppSettings.getHourLineWidth();
+    style.jobLineWidth      = AppSettings.getJobLineWidth();
+
+    style.hourLineColor     = AppSettings.getHourLineColor();
+    style.hourTextColor     = AppSettings.getHourTextColor();
+    style.stationTextColor  = AppSettings.getStationTextColor();
+    style.mainPlatfColor    = AppSettings.getMainPlatfColor();
+    style.depotPlatfColor   = AppSettings.getDepotPlatfColor();
+
+    for (int cat = 0; cat < int(JobCategory::NCategories); cat++)
+        style.categoryColors[cat] = Session->colorForCat(JobCategory(cat));
+
+    return style;
+}
+
+GraphStyle GraphStyle::current()
+{
+    if (threadStyle)
+        return *threadStyle;
+    return fromSettings();
+}
+
+GraphStyle::ThreadScope::ThreadScope(const GraphStyle *style) :
+    m_prevStyle(threadStyle)
+{
+    threadStyle = style;
+}
+
+GraphStyle::ThreadScope::~ThreadScope()
+{
+    threadStyle = m_prevStyle;
+}
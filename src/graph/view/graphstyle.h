@@ -0,0 +1,81 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef GRAPHSTYLE_H
+#define GRAPHSTYLE_H
+
+#include <QColor>
+
+#include "utils/types.h"
+
+/*!
+ * \brief The GraphStyle struct
+ *
+ * Settings read by LineGraphScene and BackgroundHelper while loading and rendering.
+ * Settings are not thread safe, so printing threads use a copy taken on main thread
+ * and installed with \ref GraphStyle::ThreadScope.
+ *
+ * \sa current()
+ */
+struct GraphStyle
+{
+    int hourOffset        = 140;
+    int stationOffset     = 150;
+    qreal platformOffset  = 15;
+    int horizOffset       = 50;
+    int vertOffset        = 30;
+
+    int platformLineWidth = 2;
+    int hourLineWidth     = 2;
+    int jobLineWidth      = 6;
+
+    QColor hourLineColor;
+    QColor hourTextColor;
+    QColor stationTextColor;
+    QColor mainPlatfColor;
+    QColor depotPlatfColor;
+
+    QColor categoryColors[int(JobCategory::NCategories)];
+
+    inline QColor colorForCat(JobCategory cat) const
+    {
+        if (cat < JobCategory::FREIGHT || cat >= JobCategory::NCategories)
+            return QColor(Qt::gray); // Error
+        return categoryColors[int(cat)];
+    }
+
+    // Must be called on main thread
+    static GraphStyle fromSettings();
+
+    // Style installed on current thread, or current settings if none
+    static GraphStyle current();
+
+    // Installs a style on current thread for the scope lifetime
+    class ThreadScope
+    {
+    public:
+        explicit ThreadScope(const GraphStyle *style);
+        ~ThreadScope();
+
+    private:
+        const GraphStyle *m_prevStyle;
+    };
+};
+
+#endif // GRAPHSTYLE_H
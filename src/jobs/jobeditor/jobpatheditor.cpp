@@ -50,6 +50,7 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
 #include "utils/files/recentdirstore.h"
 
 #include <QCloseEvent>
@@ -57,6 +58,8 @@
 JobPathEditor::JobPathEditor(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::JobPathEditor),
+    undoAct(nullptr),
+    redoAct(nullptr),
     stopModel(nullptr),
     jobNumberTimerId(0),
     isClear(true),
@@ -122,6 +125,22 @@ JobPathEditor::JobPathEditor(QWidget *parent) :
 
     connect(ui->sheetBut, &QPushButton::clicked, this, &JobPathEditor::onSaveSheet);
 
+    // Undo/Redo stop edits
+    undoAct = new QAction(tr("Undo"), this);
+    undoAct->setShortcut(QKeySequence::Undo);
+    undoAct->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(undoAct, &QAction::triggered, this, &JobPathEditor::onUndo);
+    addAction(undoAct);
+
+    redoAct = new QAction(tr("Redo"), this);
+    redoAct->setShortcut(QKeySequence::Redo);
+    redoAct->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(redoAct, &QAction::triggered, this, &JobPathEditor::onRedo);
+    addAction(redoAct);
+
+    connect(stopModel, &StopModel::undoRedoChanged, this, &JobPathEditor::onUndoRedoChanged);
+    onUndoRedoChanged(false, false);
+
     ui->stopsView->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(ui->stopsView, &QListView::customContextMenuRequested, this,
             &JobPathEditor::showStopsContextMenu);
@@ -292,12 +311,17 @@ void JobPathEditor::showStopsContextMenu(const QPoint &pos)
     QAction *editStopAct    = menu->addAction(tr("Edit stop"));
     QAction *showStationSVG = menu->addAction(tr("Station SVG Plan"));
     menu->insertSeparator(editStopAct);
+    QAction *shiftTimesAct = menu->addAction(tr("Shift times..."));
     QAction *removeStopAct = menu->addAction(tr("Remove"));
+    menu->addSeparator();
+    menu->addAction(undoAct);
+    menu->addAction(redoAct);
 
     toggleTransitAct->setEnabled(!m_readOnly);
     setToTransitAct->setEnabled(!m_readOnly);
     unsetTransit->setEnabled(!m_readOnly);
     removeStopAct->setEnabled(!m_readOnly);
+    shiftTimesAct->setEnabled(!m_readOnly);
 
     const StopItem stop = stopModel->getItemAt(index.row());
     showStationSVG->setEnabled(stop.stationId != 0); // Enable only if station is set
@@ -361,6 +385,20 @@ void JobPathEditor::showStopsContextMenu(const QPoint &pos)
     {
         stopModel->removeStop(index);
     }
+    else if (act == shiftTimesAct)
+    {
+        bool ok = false;
+        int minutes =
+          QInputDialog::getInt(this, tr("Shift times"),
+                               tr("Shift this stop and following ones by minutes:"), 0,
+                               -24 * 60 + 1, 24 * 60 - 1, 1, &ok);
+        if (!ok || minutes == 0)
+            return;
+
+        QString errMsg;
+        if (!stopModel->retimeStops(index.row(), minutes, 1.0, &errMsg))
+            QMessageBox::warning(this, tr("Shift times"), errMsg);
+    }
 }
 
 void JobPathEditor::showJobContextMenu(const QPoint &pos)
@@ -696,6 +734,8 @@ void JobPathEditor::setReadOnly(bool readOnly)
 
     ui->buttonBox->setVisible(!m_readOnly);
 
+    onUndoRedoChanged(stopModel->canUndo(), stopModel->canRedo());
+
     // If read-only hide 'AddHere' row (last one)
     int size = stopModel->rowCount();
     if (size > 0)
@@ -711,6 +751,30 @@ void JobPathEditor::setReadOnly(bool readOnly)
     }
 }
 
+void JobPathEditor::onUndo()
+{
+    if (m_readOnly)
+        return;
+
+    closeStopEditor(); // Stops get reloaded, close before
+    stopModel->undo();
+}
+
+void JobPathEditor::onRedo()
+{
+    if (m_readOnly)
+        return;
+
+    closeStopEditor();
+    stopModel->redo();
+}
+
+void JobPathEditor::onUndoRedoChanged(bool canUndo, bool canRedo)
+{
+    undoAct->setEnabled(canUndo && !m_readOnly);
+    redoAct->setEnabled(canRedo && !m_readOnly);
+}
+
 void JobPathEditor::onSaveSheet()
 {
     const QLatin1String job_sheet_key = QLatin1String("job_sheet_dir");
@@ -735,7 +799,7 @@ void JobPathEditor::onSaveSheet()
 
     RecentDirStore::setPath(job_sheet_key, fileName);
 
-    JobSheetExport sheet(stopModel->getJobId(), stopModel->getCategory());
+    JobSheetExport sheet(Session->m_Db, stopModel->getJobId(), stopModel->getCategory());
     sheet.write();
     sheet.save(fileName);
 
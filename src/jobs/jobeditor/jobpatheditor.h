@@ -26,6 +26,7 @@
 
 class StopDelegate;
 class CustomCompletionLineEdit;
+class QAction;
 
 class StopModel;
 class NextPrevRSJobsModel;
@@ -101,6 +102,10 @@ private slots:
 
     void onJobShiftChanged(db_id shiftId);
 
+    void onUndo();
+    void onRedo();
+    void onUndoRedoChanged(bool canUndo, bool canRedo);
+
 private:
     void setSpinColor(const QColor &col);
 
@@ -114,6 +119,9 @@ private:
 
     CustomCompletionLineEdit *shiftCombo;
 
+    QAction *undoAct;
+    QAction *redoAct;
+
     StopModel *stopModel;
     StopDelegate *delegate;
 
@@ -78,6 +78,10 @@ bool RSCouplingInterface::contains(db_id rsId, RsOp op) const
 bool RSCouplingInterface::coupleRS(db_id rsId, const QString &rsName, bool on,
                                    bool checkTractionType)
 {
+    StopModel::UndoScope undoScope(stopsModel, StopUndoJournal::EditKind::Coupling,
+                                   stopsModel->getStopRow(m_stopId));
+    stopsModel->undoJournal.touchStop(m_stopId);
+
     stopsModel->startStopsEditing();
     stopsModel->markRsToUpdate(rsId);
 
@@ -223,6 +227,7 @@ bool RSCouplingInterface::coupleRS(db_id rsId, const QString &rsName, bool on,
             {
                 qDebug() << "Deleting coupling";
 
+                stopsModel->undoJournal.touchStop(stopId);
                 q_deleteCoupling.bind(1, stopId);
                 q_deleteCoupling.bind(2, rsId);
                 ret = q_deleteCoupling.execute();
@@ -295,6 +300,7 @@ bool RSCouplingInterface::coupleRS(db_id rsId, const QString &rsName, bool on,
             {
                 qDebug() << "Deleting coupling";
 
+                stopsModel->undoJournal.touchStop(stopId);
                 q_deleteCoupling.bind(1, stopId);
                 q_deleteCoupling.bind(2, rsId);
                 ret = q_deleteCoupling.execute();
@@ -319,6 +325,10 @@ bool RSCouplingInterface::coupleRS(db_id rsId, const QString &rsName, bool on,
 
 bool RSCouplingInterface::uncoupleRS(db_id rsId, const QString &rsName, bool on)
 {
+    StopModel::UndoScope undoScope(stopsModel, StopUndoJournal::EditKind::Coupling,
+                                   stopsModel->getStopRow(m_stopId));
+    stopsModel->undoJournal.touchStop(m_stopId);
+
     stopsModel->startStopsEditing();
     stopsModel->markRsToUpdate(rsId);
 
@@ -379,6 +389,7 @@ bool RSCouplingInterface::uncoupleRS(db_id rsId, const QString &rsName, bool on)
             {
                 qDebug() << "Deleting coupling";
 
+                stopsModel->undoJournal.touchStop(stopId);
                 q_deleteCoupling.bind(1, stopId);
                 q_deleteCoupling.bind(2, rsId);
                 ret = q_deleteCoupling.execute();
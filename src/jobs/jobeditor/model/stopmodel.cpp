@@ -30,11 +30,16 @@ using namespace sqlite3pp;
 
 #include "stations/station_utils.h"
 
+#include "jobs/jobsmanager/model/jobshelper.h"
+
+#include "rollingstock/rsoccupancyindex.h"
+
 #include <QtMath>
 
 StopModel::StopModel(database &db, QObject *parent) :
     QAbstractListModel(parent),
     mDb(db),
+    undoJournal(db),
     mJobId(0),
     mNewJobId(0),
     jobShiftId(0),
@@ -106,6 +111,9 @@ bool StopModel::loadJobStops(db_id jobId)
     mNewJobId = mJobId = jobId;
     emit jobIdChanged(mJobId);
 
+    undoJournal.setJobId(mJobId);
+    emit undoRedoChanged(false, false);
+
     {
         query q_getCatAndShift(mDb, "SELECT category,shift_id FROM jobs WHERE id=?");
         q_getCatAndShift.bind(1, mJobId);
@@ -124,175 +132,7 @@ bool StopModel::loadJobStops(db_id jobId)
         emit jobShiftChanged(jobShiftId);
     }
 
-    query q_selectStops(mDb, "SELECT COUNT(id) FROM stops WHERE job_id=?");
-    q_selectStops.bind(1, mJobId);
-    if (q_selectStops.step() != SQLITE_ROW)
-    {
-        qWarning() << database_error(mDb).what();
-    }
-    int count = q_selectStops.getRows().get<int>(0);
-    q_selectStops.finish();
-
-    if (count == 0)
-    {
-        // Job has no stops, start editing so it cannot be saved without adding stops to it
-        endResetModel();
-
-        insertAddHere(0, 1);
-        stops.squeeze();
-
-        startStopsEditing();
-
-        return true;
-    }
-
-    stops.reserve(count);
-
-    int i = 0;
-
-    StopItem::Segment prevSegment;
-    db_id prevOutGateId = 0;
-
-    q_selectStops.prepare(
-      "SELECT stops.id, stops.station_id, stops.arrival, stops.departure, stops.type,"
-      "stops.in_gate_conn, g1.gate_id, g1.gate_track, g1.track_id, g1.track_side,"
-      "stops.out_gate_conn, g2.gate_id, g2.gate_track, g2.track_id, g2.track_side,"
-      "stops.next_segment_conn_id, c.seg_id, c.in_track, c.out_track,"
-      "seg.in_gate_id, seg.out_gate_id"
-      " FROM stops"
-      " LEFT JOIN railway_connections c ON c.id=stops.next_segment_conn_id"
-      " LEFT JOIN station_gate_connections g1 ON g1.id=stops.in_gate_conn"
-      " LEFT JOIN station_gate_connections g2 ON g2.id=stops.out_gate_conn"
-      " LEFT JOIN railway_segments seg ON seg.id=c.seg_id"
-      " WHERE stops.job_id=?1"
-      " ORDER BY stops.arrival ASC");
-    q_selectStops.bind(1, mJobId);
-    for (auto stop : q_selectStops)
-    {
-        StopItem s;
-        s.stopId                    = stop.get<db_id>(0);
-        s.stationId                 = stop.get<db_id>(1);
-
-        s.arrival                   = stop.get<QTime>(2);
-        s.departure                 = stop.get<QTime>(3);
-
-        int stopType                = stop.get<int>(4);
-
-        s.fromGate.gateConnId       = stop.get<db_id>(5);
-        s.fromGate.gateId           = stop.get<db_id>(6);
-        s.fromGate.gateTrackNum     = stop.get<int>(7);
-        s.trackId                   = stop.get<db_id>(8);
-        s.fromGate.stationTrackSide = utils::Side(stop.get<int>(9));
-
-        s.toGate.gateConnId         = stop.get<db_id>(10);
-        s.toGate.gateId             = stop.get<db_id>(11);
-        s.toGate.gateTrackNum       = stop.get<int>(12);
-        db_id otherTrackId          = stop.get<db_id>(13);
-        s.toGate.stationTrackSide   = utils::Side(stop.get<int>(14));
-
-        s.nextSegment.segConnId     = stop.get<db_id>(15);
-        s.nextSegment.segmentId     = stop.get<db_id>(16);
-        s.nextSegment.inTrackNum    = stop.get<db_id>(17);
-        s.nextSegment.outTrackNum   = stop.get<db_id>(18);
-
-        db_id segInGateId           = stop.get<db_id>(19);
-        db_id segOutGateId          = stop.get<db_id>(20);
-
-        if (s.toGate.gateId && s.toGate.gateId == segOutGateId)
-        {
-            // Segment is reversed
-            qSwap(segInGateId, segOutGateId);
-            qSwap(s.nextSegment.inTrackNum, s.nextSegment.outTrackNum);
-            s.nextSegment.reversed = true;
-        }
-
-        // Fix station track on First stop
-        if (!s.fromGate.gateConnId)
-        {
-            // If station has no 'in' connection use 'out' connection
-            // This might happen on first stop
-            s.trackId = otherTrackId;
-        }
-
-        // Check consistency
-        if (s.trackId != otherTrackId && s.toGate.gateConnId)
-        {
-            // Last stop has no 'out' connection so do not check track if on 'Last' stop
-            // In gate leads to a different station track than out gate
-            qWarning() << "Stop:" << s.stopId << "Different track:" << s.fromGate.gateConnId
-                       << s.toGate.gateConnId;
-        }
-        if (prevSegment.segmentId != 0)
-        {
-            if (prevOutGateId != s.fromGate.gateId)
-            {
-                // Previous segment leads to a different in gate
-                qWarning() << "Stop:" << s.stopId
-                           << "Different prev segment:" << prevSegment.segConnId
-                           << s.fromGate.gateConnId;
-            }
-
-            if (s.fromGate.gateTrackNum != prevSegment.outTrackNum)
-            {
-                // Previous segment leads to a different track than in gate track
-                qWarning() << "Stop:" << s.stopId
-                           << "Different in gate track:" << s.fromGate.gateConnId
-                           << s.toGate.gateConnId;
-            }
-        }
-        if (s.nextSegment.segmentId != 0)
-        {
-            if (segInGateId != s.toGate.gateId)
-            {
-                // Out gate leads to a different next semgent
-                qWarning() << "Stop:" << s.stopId
-                           << "Different next segment:" << s.nextSegment.segConnId
-                           << s.toGate.gateConnId;
-            }
-
-            if (s.toGate.gateTrackNum != s.nextSegment.inTrackNum)
-            {
-                // Out gate leads to a different than next segment in track
-                qWarning() << "Stop:" << s.stopId
-                           << "Different out gate track:" << s.toGate.gateConnId
-                           << s.nextSegment.segConnId;
-            }
-        }
-
-        prevSegment   = s.nextSegment;
-        prevOutGateId = segOutGateId;
-
-        s.type        = StopType::Normal;
-
-        if (i == 0)
-        {
-            s.type = StopType::First;
-            if (stopType != 0)
-            {
-                // Error First cannot be a transit
-                qWarning() << "Error: First stop cannot be transit! Job:" << mJobId
-                           << "StopId:" << s.stopId;
-            }
-        }
-        else if (stopType)
-        {
-            s.type = StopType::Transit;
-
-            if (i == count - 1)
-            {
-                // Error Last cannot be a transit
-                qWarning() << "Error: Last stop cannot be transit! Job:" << mJobId
-                           << "StopId:" << s.stopId;
-            }
-        }
-
-        stops.append(s);
-        i++;
-    }
-    q_selectStops.finish();
-
-    if (!stops.isEmpty() && stops.last().type != StopType::First)
-        stops.last().type = StopType::Last; // Update Last stop type unless it's First
+    loadStopsFromDB();
 
     endResetModel();
 
@@ -319,6 +159,9 @@ void StopModel::clearJob()
     oldCategory = category = JobCategory(-1);
     emit categoryChanged(int(category));
 
+    undoJournal.setJobId(0);
+    emit undoRedoChanged(false, false);
+
     int count = stops.count();
     if (count == 0)
         return;
@@ -506,6 +349,8 @@ void StopModel::addStop()
     if (stops.count() == 0)
         return;
 
+    UndoScope undoScope(this, StopUndoJournal::EditKind::AddStop, stops.count() - 1);
+
     startStopsEditing();
 
     int idx        = stops.count() - 1;
@@ -524,6 +369,8 @@ void StopModel::addStop()
         last.type   = StopType::Last;
 
         StopItem &s = stops[prevIdx];
+        undoJournal.touchStop(s.stopId);
+
         if (prevIdx > 0)
         {
             // Update stop time and type
@@ -619,6 +466,9 @@ void StopModel::removeStop(const QModelIndex &idx)
     if (s.addHere != 0)
         return;
 
+    UndoScope undoScope(this, StopUndoJournal::EditKind::RemoveStop, row);
+    undoJournal.touchStop(s.stopId);
+
     startStopsEditing();
 
     // Mark the station for update
@@ -651,6 +501,7 @@ void StopModel::removeStop(const QModelIndex &idx)
         next.type           = StopType::First;
         const QTime oldArr  = next.arrival;
         const QTime oldDep  = next.arrival;
+        undoJournal.touchStop(next.stopId);
         updateStopTime(next, row + 1, true, oldArr, oldDep);
 
         // Set type to Normal
@@ -671,6 +522,7 @@ void StopModel::removeStop(const QModelIndex &idx)
     {
         QModelIndex prevIdx = index(row - 1, idx.column());
         StopItem &prev      = stops[prevIdx.row()];
+        undoJournal.touchStop(prev.stopId);
 
         if (autoMoveUncoupleToNewLast)
         {
@@ -783,6 +635,8 @@ void StopModel::uncoupleStillCoupledAtLastStop()
 
 void StopModel::uncoupleStillCoupledAtStop(const StopItem &s)
 {
+    undoJournal.touchStop(s.stopId);
+
     // Uncouple all still-coupled RS
     command q_uncoupleRS(
       mDb, "INSERT OR REPLACE INTO coupling(id,stop_id,rs_id,operation) VALUES(NULL,?,?,0)");
@@ -805,6 +659,42 @@ void StopModel::uncoupleStillCoupledAtStop(const StopItem &s)
     }
 }
 
+bool StopModel::canUndo() const
+{
+    return editState == StopsEditing && undoJournal.canUndo();
+}
+
+bool StopModel::canRedo() const
+{
+    return editState == StopsEditing && undoJournal.canRedo();
+}
+
+bool StopModel::undo()
+{
+    if (!canUndo())
+        return false;
+
+    StopUndoJournal::AppliedStep step;
+    if (!undoJournal.undo(step))
+        return false;
+
+    applyUndoStep(step);
+    return true;
+}
+
+bool StopModel::redo()
+{
+    if (!canRedo())
+        return false;
+
+    StopUndoJournal::AppliedStep step;
+    if (!undoJournal.redo(step))
+        return false;
+
+    applyUndoStep(step);
+    return true;
+}
+
 JobCategory StopModel::getCategory() const
 {
     return category;
@@ -893,6 +783,20 @@ void StopModel::setStopInfo(const QModelIndex &idx, StopItem newStop, StopItem::
 
     StopItem &s = stops[row];
 
+    // Pure time edits get merged together by undo journal
+    bool onlyTimeChanged = s.stationId == newStop.stationId
+                           && s.fromGate.gateConnId == newStop.fromGate.gateConnId
+                           && s.toGate.gateConnId == newStop.toGate.gateConnId
+                           && s.nextSegment.segConnId == newStop.nextSegment.segConnId;
+    if (s.type != StopType::First && row > 0)
+        onlyTimeChanged &= stops.at(row - 1).nextSegment.segmentId == prevSeg.segmentId;
+
+    UndoScope undoScope(this,
+                        onlyTimeChanged ? StopUndoJournal::EditKind::StopTime
+                                        : StopUndoJournal::EditKind::StopInfo,
+                        row);
+    undoJournal.touchStop(s.stopId);
+
     stationsToUpdate.insert(s.stationId);
     stationsToUpdate.insert(newStop.stationId);
 
@@ -908,6 +812,7 @@ void StopModel::setStopInfo(const QModelIndex &idx, StopItem newStop, StopItem::
                 return;
 
             startStopsEditing();
+            undoJournal.touchStop(prevStop.stopId);
 
             // Update prev stop
             cmd.prepare("UPDATE stops SET out_gate_conn=?, next_segment_conn_id=? WHERE id=?");
@@ -1060,6 +965,8 @@ bool StopModel::setStopTypeRange(int firstRow, int lastRow, StopType type)
 
     StopType destType   = type;
 
+    UndoScope undoScope(this, StopUndoJournal::EditKind::StopType, firstRow);
+
     startStopsEditing();
     shiftStopsBy24hoursFrom(stops.at(firstRow).arrival);
 
@@ -1071,6 +978,7 @@ bool StopModel::setStopTypeRange(int firstRow, int lastRow, StopType type)
     for (int r = firstRow; r <= lastRow; r++)
     {
         StopItem &s = stops[r];
+        undoJournal.touchStop(s.stopId);
 
         if (s.type == StopType::First || s.type == StopType::Last)
         {
@@ -1158,7 +1066,9 @@ bool StopModel::setStopTypeRange(int firstRow, int lastRow, StopType type)
     for (int r = lastRow + 1; r < stops.count(); r++)
     {
         StopItem &s = stops[r];
-        destType    = s.type;
+        undoJournal.touchStop(s.stopId);
+
+        destType = s.type;
         if (s.type == StopType::First || s.type == StopType::Last)
             destType = StopType::Normal;
 
@@ -1177,6 +1087,86 @@ bool StopModel::setStopTypeRange(int firstRow, int lastRow, StopType type)
     return true;
 }
 
+/*!
+ * \brief StopModel::retimeStops
+ * \param firstRow first stop to retime
+ * \param offsetMinutes shift applied to first stop and propagated to following stops
+ * \param travelFactor multiplier of travel times after first stop
+ * \param errMsg if not null, on failure it gets set to a human readable reason
+ * \return true on success
+ *
+ * Retimes all stops from \a firstRow to Last stop at once.
+ * New times are validated in memory and written in a single pass
+ * instead of calling setStopInfo() for each stop.
+ *
+ * \sa JobsHelper::calcRetimedStops()
+ */
+bool StopModel::retimeStops(int firstRow, int offsetMinutes, double travelFactor, QString *errMsg)
+{
+    const int lastStopRow = stops.count() - 2; // Last index (size - 1) is AddHere
+    if (firstRow < 0 || firstRow > lastStopRow)
+        return false;
+
+    QVector<JobsHelper::StopTimes> times;
+    times.reserve(lastStopRow + 1);
+    for (int r = 0; r <= lastStopRow; r++)
+    {
+        const StopItem &s = stops.at(r);
+        JobsHelper::StopTimes item;
+        item.stopId    = s.stopId;
+        item.arrival   = s.arrival.msecsSinceStartOfDay() / 60000;
+        item.departure = s.departure.msecsSinceStartOfDay() / 60000;
+        times.append(item);
+    }
+
+    const int oldFirstArrival = times.at(firstRow).arrival;
+    if (!JobsHelper::calcRetimedStops(times, firstRow, offsetMinutes, travelFactor, errMsg))
+        return false;
+
+    UndoScope undoScope(this, StopUndoJournal::EditKind::Generic, firstRow);
+
+    startStopsEditing();
+
+    // Mark RS to update
+    query q_selectRS(mDb, "SELECT DISTINCT coupling.rs_id FROM stops"
+                          " JOIN coupling ON coupling.stop_id=stops.id"
+                          " WHERE stops.job_id=? AND stops.arrival>=?");
+    q_selectRS.bind(1, mJobId);
+    q_selectRS.bind(2, oldFirstArrival);
+    for (auto rs : q_selectRS)
+    {
+        rsToUpdate.insert(rs.get<db_id>(0));
+    }
+    q_selectRS.finish();
+
+    for (int r = firstRow; r <= lastStopRow; r++)
+        undoJournal.touchStop(stops.at(r).stopId);
+
+    mDb.execute("SAVEPOINT retime_stops");
+    if (!JobsHelper::writeStopTimes(mDb, mJobId, times, firstRow, oldFirstArrival))
+    {
+        if (errMsg)
+            *errMsg = mDb.error_msg();
+        mDb.execute("ROLLBACK TO SAVEPOINT retime_stops");
+        mDb.execute("RELEASE SAVEPOINT retime_stops");
+        return false;
+    }
+    mDb.execute("RELEASE SAVEPOINT retime_stops");
+
+    for (int r = firstRow; r <= lastStopRow; r++)
+    {
+        StopItem &s = stops[r];
+        s.arrival   = QTime::fromMSecsSinceStartOfDay(times.at(r).arrival * 60000);
+        s.departure = QTime::fromMSecsSinceStartOfDay(times.at(r).departure * 60000);
+
+        if (s.stationId)
+            stationsToUpdate.insert(s.stationId);
+    }
+
+    emit dataChanged(index(firstRow, 0), index(lastStopRow, 0));
+    return true;
+}
+
 QString StopModel::getDescription(const StopItem &s) const
 {
     if (s.addHere != 0)
@@ -1200,6 +1190,9 @@ void StopModel::setDescription(const QModelIndex &idx, const QString &descr)
     if (s.addHere != 0)
         return;
 
+    UndoScope undoScope(this, StopUndoJournal::EditKind::Description, idx.row());
+    undoJournal.touchStop(s.stopId);
+
     startStopsEditing();
 
     // Mark the station for update
@@ -1619,6 +1612,297 @@ void StopModel::reloadSettings()
     setAutoUncoupleAtLast(AppSettings.getAutoUncoupleAtLastStop());
 }
 
+// Columns read by readStopItem(), callers append their WHERE clause
+static const char sql_selectStopItems[] =
+  "SELECT stops.id, stops.station_id, stops.arrival, stops.departure, stops.type,"
+  "stops.in_gate_conn, g1.gate_id, g1.gate_track, g1.track_id, g1.track_side,"
+  "stops.out_gate_conn, g2.gate_id, g2.gate_track, g2.track_id, g2.track_side,"
+  "stops.next_segment_conn_id, c.seg_id, c.in_track, c.out_track,"
+  "seg.in_gate_id, seg.out_gate_id"
+  " FROM stops"
+  " LEFT JOIN railway_connections c ON c.id=stops.next_segment_conn_id"
+  " LEFT JOIN station_gate_connections g1 ON g1.id=stops.in_gate_conn"
+  " LEFT JOIN station_gate_connections g2 ON g2.id=stops.out_gate_conn"
+  " LEFT JOIN railway_segments seg ON seg.id=c.seg_id";
+
+// Returns raw stop type, 'type' of item is left to the caller because it depends on position
+static int readStopItem(query::rows &stop, StopItem &s, db_id &otherTrackId, db_id &segInGateId,
+                        db_id &segOutGateId)
+{
+    s.stopId                    = stop.get<db_id>(0);
+    s.stationId                 = stop.get<db_id>(1);
+
+    s.arrival                   = stop.get<QTime>(2);
+    s.departure                 = stop.get<QTime>(3);
+
+    int stopType                = stop.get<int>(4);
+
+    s.fromGate.gateConnId       = stop.get<db_id>(5);
+    s.fromGate.gateId           = stop.get<db_id>(6);
+    s.fromGate.gateTrackNum     = stop.get<int>(7);
+    s.trackId                   = stop.get<db_id>(8);
+    s.fromGate.stationTrackSide = utils::Side(stop.get<int>(9));
+
+    s.toGate.gateConnId         = stop.get<db_id>(10);
+    s.toGate.gateId             = stop.get<db_id>(11);
+    s.toGate.gateTrackNum       = stop.get<int>(12);
+    otherTrackId                = stop.get<db_id>(13);
+    s.toGate.stationTrackSide   = utils::Side(stop.get<int>(14));
+
+    s.nextSegment.segConnId     = stop.get<db_id>(15);
+    s.nextSegment.segmentId     = stop.get<db_id>(16);
+    s.nextSegment.inTrackNum    = stop.get<db_id>(17);
+    s.nextSegment.outTrackNum   = stop.get<db_id>(18);
+
+    segInGateId                 = stop.get<db_id>(19);
+    segOutGateId                = stop.get<db_id>(20);
+
+    if (s.toGate.gateId && s.toGate.gateId == segOutGateId)
+    {
+        // Segment is reversed
+        qSwap(segInGateId, segOutGateId);
+        qSwap(s.nextSegment.inTrackNum, s.nextSegment.outTrackNum);
+        s.nextSegment.reversed = true;
+    }
+
+    // Fix station track on First stop
+    if (!s.fromGate.gateConnId)
+    {
+        // If station has no 'in' connection use 'out' connection
+        // This might happen on first stop
+        s.trackId = otherTrackId;
+    }
+
+    return stopType;
+}
+
+// Fills 'stops' without AddHere item, must be called inside model reset
+int StopModel::loadStopsFromDB()
+{
+    query q_selectStops(mDb, "SELECT COUNT(id) FROM stops WHERE job_id=?");
+    q_selectStops.bind(1, mJobId);
+    if (q_selectStops.step() != SQLITE_ROW)
+    {
+        qWarning() << database_error(mDb).what();
+    }
+    int count = q_selectStops.getRows().get<int>(0);
+    q_selectStops.finish();
+
+    if (count == 0)
+    {
+        // Job has no stops, caller starts editing so it cannot be saved without adding stops to it
+        return 0;
+    }
+
+    stops.reserve(count);
+
+    int i = 0;
+
+    StopItem::Segment prevSegment;
+    db_id prevOutGateId = 0;
+
+    q_selectStops.prepare(QByteArray(sql_selectStopItems)
+                          + " WHERE stops.job_id=?1 ORDER BY stops.arrival ASC");
+    q_selectStops.bind(1, mJobId);
+    for (auto stop : q_selectStops)
+    {
+        StopItem s;
+        db_id otherTrackId = 0, segInGateId = 0, segOutGateId = 0;
+        const int stopType = readStopItem(stop, s, otherTrackId, segInGateId, segOutGateId);
+
+        // Check consistency
+        if (s.trackId != otherTrackId && s.toGate.gateConnId)
+        {
+            // Last stop has no 'out' connection so do not check track if on 'Last' stop
+            // In gate leads to a different station track than out gate
+            qWarning() << "Stop:" << s.stopId << "Different track:" << s.fromGate.gateConnId
+                       << s.toGate.gateConnId;
+        }
+        if (prevSegment.segmentId != 0)
+        {
+            if (prevOutGateId != s.fromGate.gateId)
+            {
+                // Previous segment leads to a different in gate
+                qWarning() << "Stop:" << s.stopId
+                           << "Different prev segment:" << prevSegment.segConnId
+                           << s.fromGate.gateConnId;
+            }
+
+            if (s.fromGate.gateTrackNum != prevSegment.outTrackNum)
+            {
+                // Previous segment leads to a different track than in gate track
+                qWarning() << "Stop:" << s.stopId
+                           << "Different in gate track:" << s.fromGate.gateConnId
+                           << s.toGate.gateConnId;
+            }
+        }
+        if (s.nextSegment.segmentId != 0)
+        {
+            if (segInGateId != s.toGate.gateId)
+            {
+                // Out gate leads to a different next semgent
+                qWarning() << "Stop:" << s.stopId
+                           << "Different next segment:" << s.nextSegment.segConnId
+                           << s.toGate.gateConnId;
+            }
+
+            if (s.toGate.gateTrackNum != s.nextSegment.inTrackNum)
+            {
+                // Out gate leads to a different than next segment in track
+                qWarning() << "Stop:" << s.stopId
+                           << "Different out gate track:" << s.toGate.gateConnId
+                           << s.nextSegment.segConnId;
+            }
+        }
+
+        prevSegment   = s.nextSegment;
+        prevOutGateId = segOutGateId;
+
+        s.type        = StopType::Normal;
+
+        if (i == 0)
+        {
+            s.type = StopType::First;
+            if (stopType != 0)
+            {
+                // Error First cannot be a transit
+                qWarning() << "Error: First stop cannot be transit! Job:" << mJobId
+                           << "StopId:" << s.stopId;
+            }
+        }
+        else if (stopType)
+        {
+            s.type = StopType::Transit;
+
+            if (i == count - 1)
+            {
+                // Error Last cannot be a transit
+                qWarning() << "Error: Last stop cannot be transit! Job:" << mJobId
+                           << "StopId:" << s.stopId;
+            }
+        }
+
+        stops.append(s);
+        i++;
+    }
+    q_selectStops.finish();
+
+    if (!stops.isEmpty() && stops.last().type != StopType::First)
+        stops.last().type = StopType::Last; // Update Last stop type unless it's First
+
+    return stops.count();
+}
+
+void StopModel::endUndoRecord()
+{
+    // Index reads main connection so it sees uncommitted changes once marked dirty
+    // Views are notified only on commit or revert
+    RSOccupancyIndex *index = Session->getRSOccupancyIndex();
+    index->invalidateRS(rsToUpdate);
+    index->invalidateStations(stationsToUpdate);
+
+    if (undoJournal.endEdit())
+        emit undoRedoChanged(canUndo(), canRedo());
+}
+
+// Reloads a single stop, First and Last types must be fixed by caller
+bool StopModel::loadStopItem(db_id stopId, StopItem &s)
+{
+    query q(mDb);
+    q.prepare(QByteArray(sql_selectStopItems) + " WHERE stops.id=?1");
+    q.bind(1, stopId);
+    if (q.step() != SQLITE_ROW)
+        return false;
+
+    auto stop          = q.getRows();
+    db_id otherTrackId = 0, segInGateId = 0, segOutGateId = 0;
+    const int stopType = readStopItem(stop, s, otherTrackId, segInGateId, segOutGateId);
+    s.type             = stopType ? StopType::Transit : StopType::Normal;
+    return true;
+}
+
+void StopModel::applyUndoStep(const StopUndoJournal::AppliedStep &step)
+{
+    // Only rows changed by this step get reloaded, AddHere always stays last
+    for (db_id stopId : step.removedStops)
+    {
+        const int row = getStopRow(stopId);
+        if (row < 0)
+            continue;
+
+        beginRemoveRows(QModelIndex(), row, row);
+        stops.removeAt(row);
+        endRemoveRows();
+    }
+
+    // Steps do not reorder stops, so changed stops keep their row
+    for (db_id stopId : step.changedStops)
+    {
+        const int row = getStopRow(stopId);
+        StopItem s;
+        if (row < 0 || !loadStopItem(stopId, s))
+            continue;
+
+        stops[row] = s;
+        emit dataChanged(index(row, 0), index(row, 0));
+    }
+
+    for (db_id stopId : step.addedStops)
+    {
+        StopItem s;
+        if (!loadStopItem(stopId, s))
+            continue;
+
+        // Keep stops ordered by arrival
+        int row = 0;
+        while (row < stops.count() - 1 && stops.at(row).arrival < s.arrival)
+            row++;
+
+        beginInsertRows(QModelIndex(), row, row);
+        stops.insert(row, s);
+        endInsertRows();
+    }
+
+    // First and Last depend on position which might have changed
+    const int lastStopRow = stops.count() - 2; // Last index (size - 1) is AddHere
+    for (int row = 0; row <= lastStopRow; row++)
+    {
+        StopItem &s   = stops[row];
+        StopType type = s.type;
+        if (row == 0)
+        {
+            type = StopType::First;
+        }
+        else if (row == lastStopRow)
+        {
+            type = StopType::Last;
+        }
+        else if (type == StopType::First || type == StopType::Last)
+        {
+            // No longer at the edge, restore stored type
+            StopItem item;
+            if (loadStopItem(s.stopId, item))
+                type = item.type;
+        }
+
+        if (type != s.type)
+        {
+            s.type = type;
+            emit dataChanged(index(row, 0), index(row, 0));
+        }
+    }
+
+    // Commit/Revert will still notify all of them
+    stationsToUpdate.unite(step.stations);
+    rsToUpdate.unite(step.rollingstock);
+
+    // Notify only what changed in this step so views can update incrementally
+    emit Session->stationJobsPlanChanged(step.stations);
+    emit Session->rollingStockPlanChanged(step.rollingstock);
+
+    emit undoRedoChanged(canUndo(), canRedo());
+}
+
 void StopModel::insertAddHere(int row, int type)
 {
     DEBUG_ENTRY;
@@ -1653,11 +1937,14 @@ db_id StopModel::createStop(db_id jobId, const QTime &arr, const QTime &dep, Sto
     sqlite3_mutex_leave(mutex);
     q_addStop.reset();
 
+    undoJournal.stopCreated(stopId);
     return stopId;
 }
 
 void StopModel::deleteStop(db_id stopId)
 {
+    undoJournal.touchStop(stopId);
+
     command q_removeStop(mDb, "DELETE FROM stops WHERE id=?");
     q_removeStop.bind(1, stopId);
     int ret = q_removeStop.execute();
@@ -1806,6 +2093,8 @@ void StopModel::rebaseTimesToSpeed(int firstIdx, QTime firstArr, QTime firstDep)
 
 bool StopModel::updateCurrentInGate(StopItem &curStop, const StopItem::Segment &prevSeg)
 {
+    undoJournal.touchStop(curStop.stopId);
+
     command cmd(mDb);
 
     if (!curStop.fromGate.gateConnId)
@@ -1879,6 +2168,8 @@ bool StopModel::updateStopTime(StopItem &item, int row, bool propagate, const QT
     // NOTE: they must be set togheter so CHECK constraint fires at the end
     // Otherwise it would be impossible to set arrival > departure and then update departure
 
+    undoJournal.touchStop(item.stopId);
+
     // Check time values and fix them if necessary
     if (item.type == StopType::First)
         item.arrival = item.departure; // We set departure, arrival follows same value
@@ -2006,6 +2297,16 @@ void StopModel::shiftStopsBy24hoursFrom(const QTime &startTime)
     // the time once at a time
     //           so in the end they all will have correct time (no need to shift backwards)
 
+    if (undoJournal.isRecording())
+    {
+        // Record shifted stops before changing them
+        query q_selectShifted(mDb, "SELECT id FROM stops WHERE job_id=? AND arrival>?");
+        q_selectShifted.bind(1, mJobId);
+        q_selectShifted.bind(2, startTime);
+        for (auto stop : q_selectShifted)
+            undoJournal.touchStop(stop.get<db_id>(0));
+    }
+
     command q_shiftArrDep(
       mDb,
       "UPDATE stops SET arrival=arrival+?1,departure=departure+?1 WHERE job_id=?2 AND arrival>?3");
@@ -2103,6 +2404,10 @@ bool StopModel::endStopsEditing()
     rsToUpdate.clear();
     stationsToUpdate.clear();
 
+    // Saved or discarded changes cannot be undone
+    undoJournal.clear();
+    emit undoRedoChanged(false, false);
+
     editState = NotEditing;
 
     emit edited(false);
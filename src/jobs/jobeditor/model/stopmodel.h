@@ -28,6 +28,8 @@
 
 #include "stations/station_utils.h"
 
+#include "stopundojournal.h"
+
 namespace sqlite3pp {
 class database;
 }
@@ -110,6 +112,12 @@ public:
     void uncoupleStillCoupledAtLastStop();
     void uncoupleStillCoupledAtStop(const StopItem &s);
 
+    // Undo/Redo
+    bool canUndo() const;
+    bool canRedo() const;
+    bool undo();
+    bool redo();
+
     // Getters
     JobCategory getCategory() const;
     db_id getJobId() const;
@@ -122,6 +130,9 @@ public:
 
     bool setStopTypeRange(int firstRow, int lastRow, StopType type);
 
+    bool retimeStops(int firstRow, int offsetMinutes, double travelFactor = 1.0,
+                     QString *errMsg = nullptr);
+
     // Stop Description
     QString getDescription(const StopItem &s) const;
     void setDescription(const QModelIndex &idx, const QString &descr);
@@ -171,6 +182,8 @@ signals:
     void jobShiftChanged(db_id shiftId);
     void errorSetShiftWithoutStops(); // TODO: find better way to show errors
 
+    void undoRedoChanged(bool canUndo, bool canRedo);
+
 public slots:
     void setCategory(int value);
     bool setNewJobId(db_id jobId);
@@ -185,6 +198,8 @@ private slots:
     void onStationSegmentNameChanged();
 
 private:
+    int loadStopsFromDB();
+    bool loadStopItem(db_id stopId, StopItem &s);
     void insertAddHere(int row, int type);
     db_id createStop(db_id jobId, const QTime &arr, const QTime &dep, StopType type);
     void deleteStop(db_id stopId);
@@ -207,6 +222,29 @@ private:
         rsToUpdate.insert(rsId);
     }
 
+    // Records changes made to the database by an edit in the undo journal
+    // and marks them dirty in RSOccupancyIndex
+    class UndoScope
+    {
+    public:
+        UndoScope(StopModel *m, StopUndoJournal::EditKind kind, int row) :
+            model(m)
+        {
+            model->undoJournal.beginEdit(kind, row);
+        }
+
+        ~UndoScope()
+        {
+            model->endUndoRecord();
+        }
+
+    private:
+        StopModel *model;
+    };
+
+    void endUndoRecord();
+    void applyUndoStep(const StopUndoJournal::AppliedStep &step);
+
 private:
     // To simulate acceleration/braking we add 4 km to distance
     static constexpr double accelerationDistMeters = 4000.0;
@@ -218,6 +256,8 @@ private:
     QSet<db_id> rsToUpdate;
     QSet<db_id> stationsToUpdate;
 
+    StopUndoJournal undoJournal;
+
     db_id mJobId;
     db_id mNewJobId;
 
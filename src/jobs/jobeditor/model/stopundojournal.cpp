@@ -0,0 +1,553 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stopundojournal.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+#include <QDebug>
+
+bool StopUndoJournal::StopRow::operator==(const StopRow &other) const
+{
+    if (exists != other.exists)
+        return false;
+    if (!exists)
+        return true; // Both missing, other fields are meaningless
+
+    return stationId == other.stationId && inGateConn == other.inGateConn
+           && outGateConn == other.outGateConn && nextSegConn == other.nextSegConn
+           && arrival == other.arrival && departure == other.departure && type == other.type
+           && description == other.description
+           && description.isNull() == other.description.isNull();
+}
+
+bool StopUndoJournal::CouplingRow::operator==(const CouplingRow &other) const
+{
+    if (exists != other.exists)
+        return false;
+    if (!exists)
+        return true;
+
+    return stopId == other.stopId && rsId == other.rsId && operation == other.operation;
+}
+
+static void bindStopRow(command &cmd, const StopUndoJournal::StopRow &row, int firstIdx)
+{
+    cmd.bindOrNull(firstIdx, row.stationId);
+    cmd.bind(firstIdx + 1, row.arrival);
+    cmd.bind(firstIdx + 2, row.departure);
+    cmd.bind(firstIdx + 3, row.type);
+    if (row.description.isNull())
+        cmd.bind(firstIdx + 4); // Bind NULL
+    else
+        cmd.bind(firstIdx + 4, row.description);
+    cmd.bindOrNull(firstIdx + 5, row.inGateConn);
+    cmd.bindOrNull(firstIdx + 6, row.outGateConn);
+    cmd.bindOrNull(firstIdx + 7, row.nextSegConn);
+}
+
+StopUndoJournal::StopUndoJournal(database &db) :
+    mDb(db),
+    m_jobId(0),
+    q_selectStop(mDb),
+    q_selectCouplings(mDb),
+    m_pos(0),
+    m_pendingKind(EditKind::Generic),
+    m_pendingRow(-1),
+    m_pendingValid(false),
+    m_nestingLevel(0),
+    m_applying(false)
+{
+}
+
+void StopUndoJournal::setJobId(db_id jobId)
+{
+    clear();
+    m_jobId = jobId;
+
+    // Prepared on first edit
+    q_selectStop.finish();
+    q_selectCouplings.finish();
+}
+
+void StopUndoJournal::clear()
+{
+    m_entries.clear();
+    m_entries.squeeze();
+    m_pos = 0;
+
+    m_pendingSnapshot = Snapshot();
+    m_pendingStops.clear();
+    m_nestingLevel = 0;
+    m_lastEditTimer.invalidate();
+}
+
+void StopUndoJournal::beginEdit(EditKind kind, int row)
+{
+    if (m_applying || !m_jobId)
+        return;
+
+    if (m_nestingLevel++ > 0)
+        return; // Outer edit already started recording
+
+    m_pendingKind     = kind;
+    m_pendingRow      = row;
+    m_pendingValid    = true;
+    m_pendingSnapshot = Snapshot();
+    m_pendingStops.clear();
+
+    if (!q_selectStop.stmt())
+    {
+        int ret = q_selectStop.prepare("SELECT station_id,arrival,departure,type,description,"
+                                       "in_gate_conn,out_gate_conn,next_segment_conn_id"
+                                       " FROM stops WHERE id=?");
+        if (ret == SQLITE_OK)
+            ret = q_selectCouplings.prepare(
+              "SELECT id,rs_id,operation FROM coupling WHERE stop_id=?");
+        if (ret != SQLITE_OK)
+        {
+            qWarning() << "StopUndoJournal: cannot prepare queries" << mDb.error_msg();
+            q_selectStop.finish();
+            m_pendingValid = false;
+        }
+    }
+}
+
+bool StopUndoJournal::endEdit()
+{
+    if (m_applying || !m_jobId || m_nestingLevel == 0)
+        return false;
+
+    if (--m_nestingLevel > 0)
+        return false; // Wait for outermost edit
+
+    // Load after images of the same rows
+    Snapshot current;
+    bool ok = m_pendingValid;
+    for (auto it = m_pendingStops.constBegin(); ok && it != m_pendingStops.constEnd(); it++)
+        ok = loadStop(*it, current);
+
+    if (!ok)
+    {
+        // We cannot trust previous entries anymore
+        qWarning() << "StopUndoJournal: cannot record edit of job" << m_jobId << mDb.error_msg();
+        clear();
+        return true;
+    }
+
+    Entry entry;
+    entry.kind = m_pendingKind;
+    entry.row  = m_pendingRow;
+    diffSnapshots(m_pendingSnapshot, current, entry);
+    m_pendingSnapshot = Snapshot();
+    m_pendingStops.clear();
+
+    if (entry.stops.isEmpty() && entry.couplings.isEmpty())
+        return false; // Nothing changed
+
+    if (tryMergeWithLast(entry))
+    {
+        m_lastEditTimer.start();
+        return true;
+    }
+
+    // Discard redo history
+    m_entries.resize(m_pos);
+    m_entries.append(entry);
+    if (m_entries.size() > MaxDepth)
+        m_entries.removeFirst();
+    m_pos = m_entries.size();
+
+    m_lastEditTimer.start();
+    return true;
+}
+
+void StopUndoJournal::touchStop(db_id stopId)
+{
+    if (!stopId || !isRecording() || m_pendingStops.contains(stopId))
+        return;
+
+    m_pendingStops.insert(stopId);
+    if (!loadStop(stopId, m_pendingSnapshot))
+        m_pendingValid = false; // Entry gets discarded by endEdit()
+}
+
+void StopUndoJournal::stopCreated(db_id stopId)
+{
+    if (!stopId || !isRecording())
+        return;
+
+    // Before image is missing so the stop gets removed on undo
+    m_pendingStops.insert(stopId);
+}
+
+bool StopUndoJournal::undo(AppliedStep &out)
+{
+    if (!canUndo() || m_nestingLevel > 0)
+        return false;
+
+    const Entry &entry = m_entries.at(m_pos - 1);
+    if (!applyEntry(entry, true))
+        return false;
+
+    fillAppliedStep(entry, true, out);
+    m_pos--;
+
+    // Do not merge next edit with an entry which was undone
+    m_lastEditTimer.invalidate();
+    return true;
+}
+
+bool StopUndoJournal::redo(AppliedStep &out)
+{
+    if (!canRedo() || m_nestingLevel > 0)
+        return false;
+
+    const Entry &entry = m_entries.at(m_pos);
+    if (!applyEntry(entry, false))
+        return false;
+
+    fillAppliedStep(entry, false, out);
+    m_pos++;
+
+    m_lastEditTimer.invalidate();
+    return true;
+}
+
+bool StopUndoJournal::loadStop(db_id stopId, Snapshot &snap)
+{
+    q_selectStop.bind(1, stopId);
+    int ret = q_selectStop.step();
+    if (ret == SQLITE_ROW)
+    {
+        auto r = q_selectStop.getRows();
+        StopRow row;
+        row.exists    = true;
+        row.stationId = r.get<db_id>(0);
+        row.arrival   = r.get<int>(1);
+        row.departure = r.get<int>(2);
+        row.type      = r.get<int>(3);
+        if (r.column_type(4) != SQLITE_NULL)
+            row.description = r.get<QString>(4);
+        row.inGateConn  = r.get<db_id>(5);
+        row.outGateConn = r.get<db_id>(6);
+        row.nextSegConn = r.get<db_id>(7);
+
+        snap.stops.insert(stopId, row);
+    }
+    q_selectStop.reset();
+
+    if (ret != SQLITE_ROW && ret != SQLITE_DONE)
+        return false;
+
+    // Deleted stops have no couplings left, so this is empty for them
+    q_selectCouplings.bind(1, stopId);
+    while ((ret = q_selectCouplings.step()) == SQLITE_ROW)
+    {
+        auto r = q_selectCouplings.getRows();
+        CouplingRow row;
+        row.exists    = true;
+        row.stopId    = stopId;
+        row.rsId      = r.get<db_id>(1);
+        row.operation = r.get<int>(2);
+
+        snap.couplings.insert(r.get<db_id>(0), row);
+    }
+    q_selectCouplings.reset();
+
+    return ret == SQLITE_DONE;
+}
+
+void StopUndoJournal::diffSnapshots(const Snapshot &before, const Snapshot &after,
+                                    Entry &entry) const
+{
+    // Stops changed, added or removed
+    for (auto it = before.stops.constBegin(); it != before.stops.constEnd(); it++)
+    {
+        const StopRow afterRow = after.stops.value(it.key());
+        if (afterRow != it.value())
+            entry.stops.insert(it.key(), {it.value(), afterRow});
+    }
+    for (auto it = after.stops.constBegin(); it != after.stops.constEnd(); it++)
+    {
+        if (!before.stops.contains(it.key()))
+            entry.stops.insert(it.key(), {StopRow(), it.value()});
+    }
+
+    // Couplings changed, added or removed
+    for (auto it = before.couplings.constBegin(); it != before.couplings.constEnd(); it++)
+    {
+        const CouplingRow afterRow = after.couplings.value(it.key());
+        if (afterRow != it.value())
+            entry.couplings.insert(it.key(), {it.value(), afterRow});
+    }
+    for (auto it = after.couplings.constBegin(); it != after.couplings.constEnd(); it++)
+    {
+        if (!before.couplings.contains(it.key()))
+            entry.couplings.insert(it.key(), {CouplingRow(), it.value()});
+    }
+
+    // Collect stations touched by this edit
+    for (const Delta<StopRow> &d : qAsConst(entry.stops))
+    {
+        if (d.before.stationId)
+            entry.stations.insert(d.before.stationId);
+        if (d.after.stationId)
+            entry.stations.insert(d.after.stationId);
+    }
+
+    // Collect rollingstock which changed operation or which is coupled/uncoupled
+    // at a stop whose time or station changed
+    for (auto it = entry.couplings.constBegin(); it != entry.couplings.constEnd(); it++)
+    {
+        const Delta<CouplingRow> &d = it.value();
+        const db_id rsId            = d.before.exists ? d.before.rsId : d.after.rsId;
+        const db_id stopId          = d.before.exists ? d.before.stopId : d.after.stopId;
+        entry.rollingstock.insert(rsId);
+
+        // Station sheets show coupling operations too
+        const db_id stationId = after.stops.value(stopId, before.stops.value(stopId)).stationId;
+        if (stationId)
+            entry.stations.insert(stationId);
+    }
+
+    for (const Snapshot *snap : {&before, &after})
+    {
+        for (const CouplingRow &c : snap->couplings)
+        {
+            if (entry.stops.contains(c.stopId))
+                entry.rollingstock.insert(c.rsId);
+        }
+    }
+}
+
+bool StopUndoJournal::tryMergeWithLast(Entry &entry)
+{
+    if (entry.kind != EditKind::StopTime || canRedo() || m_entries.isEmpty())
+        return false;
+
+    if (!m_lastEditTimer.isValid() || m_lastEditTimer.elapsed() > CoalesceTimeout)
+        return false;
+
+    Entry &last = m_entries.last();
+    if (last.kind != EditKind::StopTime || last.row != entry.row)
+        return false;
+
+    // Keep oldest 'before' image, take newest 'after' image
+    for (auto it = entry.stops.constBegin(); it != entry.stops.constEnd(); it++)
+    {
+        auto lastIt = last.stops.find(it.key());
+        if (lastIt == last.stops.end())
+            last.stops.insert(it.key(), it.value());
+        else
+            lastIt->after = it->after;
+    }
+    for (auto it = entry.couplings.constBegin(); it != entry.couplings.constEnd(); it++)
+    {
+        auto lastIt = last.couplings.find(it.key());
+        if (lastIt == last.couplings.end())
+            last.couplings.insert(it.key(), it.value());
+        else
+            lastIt->after = it->after;
+    }
+
+    // Rows which went back to their original value are not needed anymore
+    for (auto it = last.stops.begin(); it != last.stops.end();)
+    {
+        if (it->before == it->after)
+            it = last.stops.erase(it);
+        else
+            it++;
+    }
+    for (auto it = last.couplings.begin(); it != last.couplings.end();)
+    {
+        if (it->before == it->after)
+            it = last.couplings.erase(it);
+        else
+            it++;
+    }
+
+    last.stations.unite(entry.stations);
+    last.rollingstock.unite(entry.rollingstock);
+
+    if (last.stops.isEmpty() && last.couplings.isEmpty())
+    {
+        // Edits cancelled each other
+        m_entries.removeLast();
+        m_pos = m_entries.size();
+    }
+
+    return true;
+}
+
+bool StopUndoJournal::applyEntry(const Entry &entry, bool useBefore)
+{
+    // NOTE: savepoint so we do not conflict with an already open transaction
+    if (mDb.execute("SAVEPOINT stop_undo_journal") != SQLITE_OK)
+        return false;
+
+    m_applying = true;
+
+    command cmd(mDb, "DELETE FROM coupling WHERE id=?");
+    int ret = SQLITE_OK;
+
+    // Remove current couplings, they get re-inserted at the end with target values
+    for (auto it = entry.couplings.constBegin();
+         ret == SQLITE_OK && it != entry.couplings.constEnd(); it++)
+    {
+        const CouplingRow &cur = useBefore ? it->after : it->before;
+        if (!cur.exists)
+            continue;
+
+        cmd.bind(1, it.key());
+        ret = cmd.execute();
+        cmd.reset();
+    }
+
+    // Remove stops which do not exist in target image
+    if (ret == SQLITE_OK)
+        ret = cmd.prepare("DELETE FROM stops WHERE id=?");
+    for (auto it = entry.stops.constBegin(); ret == SQLITE_OK && it != entry.stops.constEnd(); it++)
+    {
+        const StopRow &cur    = useBefore ? it->after : it->before;
+        const StopRow &target = useBefore ? it->before : it->after;
+        if (!cur.exists || target.exists)
+            continue;
+
+        cmd.bind(1, it.key());
+        ret = cmd.execute();
+        cmd.reset();
+    }
+
+    // Move changed stops to a negative time unique for each stop.
+    // This avoids hitting UNIQUE(job_id,arrival) while rows are rewritten in arbitrary order
+    if (ret == SQLITE_OK)
+        ret = cmd.prepare("UPDATE stops SET arrival=?2,departure=?2 WHERE id=?1");
+    for (auto it = entry.stops.constBegin(); ret == SQLITE_OK && it != entry.stops.constEnd(); it++)
+    {
+        const StopRow &cur    = useBefore ? it->after : it->before;
+        const StopRow &target = useBefore ? it->before : it->after;
+        if (!cur.exists || !target.exists)
+            continue;
+
+        cmd.bind(1, it.key());
+        cmd.bind(2, -it.key());
+        ret = cmd.execute();
+        cmd.reset();
+    }
+
+    if (ret == SQLITE_OK)
+        ret = cmd.prepare("UPDATE stops SET station_id=?1,arrival=?2,departure=?3,type=?4,"
+                          "description=?5,in_gate_conn=?6,out_gate_conn=?7,"
+                          "next_segment_conn_id=?8"
+                          " WHERE id=?9");
+    for (auto it = entry.stops.constBegin(); ret == SQLITE_OK && it != entry.stops.constEnd(); it++)
+    {
+        const StopRow &cur    = useBefore ? it->after : it->before;
+        const StopRow &target = useBefore ? it->before : it->after;
+        if (!cur.exists || !target.exists)
+            continue;
+
+        bindStopRow(cmd, target, 1);
+        cmd.bind(9, it.key());
+        ret = cmd.execute();
+        cmd.reset();
+    }
+
+    // Re-create stops which do not exist anymore, with their original ID
+    if (ret == SQLITE_OK)
+        ret = cmd.prepare("INSERT INTO stops(station_id,arrival,departure,type,description,"
+                          "in_gate_conn,out_gate_conn,next_segment_conn_id,id,job_id)"
+                          " VALUES(?1,?2,?3,?4,?5,?6,?7,?8,?9,?10)");
+    for (auto it = entry.stops.constBegin(); ret == SQLITE_OK && it != entry.stops.constEnd(); it++)
+    {
+        const StopRow &cur    = useBefore ? it->after : it->before;
+        const StopRow &target = useBefore ? it->before : it->after;
+        if (cur.exists || !target.exists)
+            continue;
+
+        bindStopRow(cmd, target, 1);
+        cmd.bind(9, it.key());
+        cmd.bind(10, m_jobId);
+        ret = cmd.execute();
+        cmd.reset();
+    }
+
+    // Finally restore couplings
+    if (ret == SQLITE_OK)
+        ret = cmd.prepare("INSERT INTO coupling(id,stop_id,rs_id,operation) VALUES(?,?,?,?)");
+    for (auto it = entry.couplings.constBegin();
+         ret == SQLITE_OK && it != entry.couplings.constEnd(); it++)
+    {
+        const CouplingRow &target = useBefore ? it->before : it->after;
+        if (!target.exists)
+            continue;
+
+        cmd.bind(1, it.key());
+        cmd.bind(2, target.stopId);
+        cmd.bind(3, target.rsId);
+        cmd.bind(4, target.operation);
+        ret = cmd.execute();
+        cmd.reset();
+    }
+
+    cmd.finish();
+
+    if (ret != SQLITE_OK)
+    {
+        qWarning() << "StopUndoJournal: cannot apply step for job" << m_jobId << ret
+                   << mDb.error_msg() << mDb.extended_error_code();
+        mDb.execute("ROLLBACK TO SAVEPOINT stop_undo_journal");
+    }
+    mDb.execute("RELEASE SAVEPOINT stop_undo_journal");
+
+    m_applying = false;
+    return ret == SQLITE_OK;
+}
+
+void StopUndoJournal::fillAppliedStep(const Entry &entry, bool useBefore, AppliedStep &out) const
+{
+    out              = AppliedStep();
+    out.stations     = entry.stations;
+    out.rollingstock = entry.rollingstock;
+
+    for (auto it = entry.stops.constBegin(); it != entry.stops.constEnd(); it++)
+    {
+        const StopRow &cur    = useBefore ? it->after : it->before;
+        const StopRow &target = useBefore ? it->before : it->after;
+        if (!target.exists)
+            out.removedStops.append(it.key());
+        else if (!cur.exists)
+            out.addedStops.append(it.key());
+        else
+            out.changedStops.append(it.key());
+    }
+
+    // Coupling operations are shown on their stop, repaint it
+    for (const Delta<CouplingRow> &d : entry.couplings)
+    {
+        for (const CouplingRow *c : {&d.before, &d.after})
+        {
+            if (c->exists && !entry.stops.contains(c->stopId)
+                && !out.changedStops.contains(c->stopId))
+                out.changedStops.append(c->stopId);
+        }
+    }
+}
@@ -0,0 +1,207 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef STOPUNDOJOURNAL_H
+#define STOPUNDOJOURNAL_H
+
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QElapsedTimer>
+
+#include "sqlite3pp/sqlite3pp.h"
+
+#include "utils/types.h"
+
+/*!
+ * \brief The StopUndoJournal class
+ *
+ * Undo/redo stack for job path edits made through StopModel.
+ * Each entry stores before and after images of the stops and coupling rows
+ * touched by a single edit, so applying a step only costs as much as the rows it changed.
+ * Edits must call touchStop() before modifying a stop or its couplings
+ * and stopCreated() after creating a new stop, only those rows get recorded.
+ * Consecutive time edits of the same stop are merged in a single entry.
+ *
+ * The journal is only valid while StopModel is editing a job,
+ * it gets cleared when changes are saved or discarded.
+ *
+ * \sa StopModel
+ */
+class StopUndoJournal
+{
+public:
+    enum class EditKind
+    {
+        Generic = 0,
+        AddStop,
+        RemoveStop,
+        StopInfo,
+        StopTime,
+        StopType,
+        Description,
+        Coupling
+    };
+
+    // Mirrors a row of 'stops' table, 0 is used for NULL ids
+    struct StopRow
+    {
+        db_id stationId   = 0;
+        db_id inGateConn  = 0;
+        db_id outGateConn = 0;
+        db_id nextSegConn = 0;
+        int arrival       = 0;
+        int departure     = 0;
+        int type          = 0;
+        QString description;
+        bool exists = false;
+
+        bool operator==(const StopRow &other) const;
+        inline bool operator!=(const StopRow &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    // Mirrors a row of 'coupling' table
+    struct CouplingRow
+    {
+        db_id stopId  = 0;
+        db_id rsId    = 0;
+        int operation = 0;
+        bool exists   = false;
+
+        bool operator==(const CouplingRow &other) const;
+        inline bool operator!=(const CouplingRow &other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    template <typename Row> struct Delta
+    {
+        Row before;
+        Row after;
+    };
+
+    typedef QHash<db_id, Delta<StopRow>> StopDeltas;
+    typedef QHash<db_id, Delta<CouplingRow>> CouplingDeltas;
+
+    struct Entry
+    {
+        EditKind kind = EditKind::Generic;
+        int row       = -1;
+
+        StopDeltas stops;         // Keyed by stop ID
+        CouplingDeltas couplings; // Keyed by coupling ID
+
+        QSet<db_id> stations;
+        QSet<db_id> rollingstock;
+    };
+
+    // Result of undo()/redo(), tells StopModel which rows to update
+    struct AppliedStep
+    {
+        QVector<db_id> removedStops;
+        QVector<db_id> addedStops;
+        QVector<db_id> changedStops; // Includes stops whose couplings changed
+
+        QSet<db_id> stations;
+        QSet<db_id> rollingstock;
+    };
+
+    // Maximum number of steps which can be undone
+    static constexpr int MaxDepth        = 200;
+
+    // Time edits on same stop closer than this are merged
+    static constexpr int CoalesceTimeout = 1500;
+
+    explicit StopUndoJournal(sqlite3pp::database &db);
+
+    void setJobId(db_id jobId);
+    void clear();
+
+    inline bool canUndo() const
+    {
+        return m_pos > 0;
+    }
+
+    inline bool canRedo() const
+    {
+        return m_pos < m_entries.size();
+    }
+
+    inline bool isApplying() const
+    {
+        return m_applying;
+    }
+
+    inline bool isRecording() const
+    {
+        return m_nestingLevel > 0 && m_pendingValid;
+    }
+
+    // Recording, calls can be nested, only outermost pair creates an entry
+    void beginEdit(EditKind kind, int row);
+    bool endEdit();
+
+    void touchStop(db_id stopId);
+    void stopCreated(db_id stopId);
+
+    // Applying
+    bool undo(AppliedStep &out);
+    bool redo(AppliedStep &out);
+
+private:
+    // Images of touched stops and of their couplings
+    struct Snapshot
+    {
+        QHash<db_id, StopRow> stops;
+        QHash<db_id, CouplingRow> couplings;
+    };
+
+    bool loadStop(db_id stopId, Snapshot &snap);
+    void diffSnapshots(const Snapshot &before, const Snapshot &after, Entry &entry) const;
+    bool tryMergeWithLast(Entry &entry);
+    bool applyEntry(const Entry &entry, bool useBefore);
+    void fillAppliedStep(const Entry &entry, bool useBefore, AppliedStep &out) const;
+
+private:
+    sqlite3pp::database &mDb;
+    db_id m_jobId;
+
+    sqlite3pp::query q_selectStop;
+    sqlite3pp::query q_selectCouplings;
+
+    QVector<Entry> m_entries;
+    int m_pos; // Entries before m_pos are done, the others can be redone
+
+    Snapshot m_pendingSnapshot;
+    QSet<db_id> m_pendingStops; // Touched or created by pending edit
+    EditKind m_pendingKind;
+    int m_pendingRow;
+    bool m_pendingValid;
+    int m_nestingLevel;
+
+    QElapsedTimer m_lastEditTimer;
+    bool m_applying;
+};
+
+#endif // STOPUNDOJOURNAL_H
@@ -29,6 +29,7 @@
 #include "model/joblistmodel.h"
 #include "model/jobshelper.h"
 #include "utils/jobcategorystrings.h"
+#include "utils/rs_utils.h"
 
 #include "utils/delegates/sql/modelpageswitcher.h"
 
@@ -36,6 +37,7 @@
 #include "viewmanager/viewmanager.h"
 
 #include <QMessageBox>
+#include <QInputDialog>
 #include "newjobsamepathdlg.h"
 #include "utils/owningqpointer.h"
 
@@ -53,6 +55,7 @@ JobsManager::JobsManager(QWidget *parent) :
     toolBar->addSeparator();
     actEditJob        = toolBar->addAction(tr("Edit"), this, &JobsManager::onEditJob);
     actShowJobInGraph = toolBar->addAction(tr("Show Graph"), this, &JobsManager::onShowJobGraph);
+    actShiftJobTime   = toolBar->addAction(tr("Shift Time"), this, &JobsManager::onShiftJobTime);
     toolBar->addSeparator();
     QAction *actRemoveAll =
       toolBar->addAction(tr("Remove All"), this, &JobsManager::onRemoveAllJobs);
@@ -87,6 +90,7 @@ JobsManager::JobsManager(QWidget *parent) :
     actEditJob->setToolTip(tr("Open selected Job in Job Editor.<br>"
                               "<b>You can double click on a row to edit Job.</b>"));
     actShowJobInGraph->setToolTip(tr("Show selected Job in graph"));
+    actShiftJobTime->setToolTip(tr("Move all stops of selected Job by some minutes"));
     actRemoveAll->setToolTip(tr("Delete all Jobs of this session"));
 
     setWindowTitle("Jobs Manager");
@@ -157,17 +161,87 @@ void JobsManager::onNewJobSamePath()
         return;
 
     const QTime newStart = dlg->getNewStartTime();
-    const int secsOffset = times.first.secsTo(newStart);
 
-    db_id newJobId       = 0;
-    if (!JobsHelper::createNewJob(Session->m_Db, newJobId, jobCat))
+    if (dlg->shouldReversePath())
+    {
+        const int secsOffset = times.first.secsTo(newStart);
+
+        db_id newJobId       = 0;
+        if (!JobsHelper::createNewJob(Session->m_Db, newJobId, jobCat))
+            return;
+
+        JobsHelper::copyStops(Session->m_Db, jobId, newJobId, secsOffset, dlg->shouldCopyRs(),
+                              true);
+
+        // Let user edit newly created job
+        Session->getViewManager()->requestJobEditor(newJobId);
         return;
+    }
+
+    JobsHelper::CloneOptions opt;
+    opt.count        = dlg->getCopiesCount();
+    opt.startOffset  = times.first.secsTo(newStart) / 60;
+    opt.interval     = dlg->getIntervalMinutes();
+    opt.numberStep   = dlg->getNumberStep();
+    opt.copyCoupling = dlg->shouldCopyRs();
+
+    QVector<db_id> newJobIds;
+    QVector<JobsHelper::CloneConflict> conflicts;
+    QString errMsg;
+    if (!JobsHelper::cloneJobs(Session->m_Db, jobId, opt, newJobIds, &conflicts, &errMsg))
+    {
+        QMessageBox::warning(this, tr("New Same Path"), errMsg);
+        return;
+    }
 
-    JobsHelper::copyStops(Session->m_Db, jobId, newJobId, secsOffset, dlg->shouldCopyRs(),
-                          dlg->shouldReversePath());
+    if (!conflicts.isEmpty())
+        showCloneConflicts(conflicts);
 
     // Let user edit newly created job
-    Session->getViewManager()->requestJobEditor(newJobId);
+    if (newJobIds.size() == 1)
+        Session->getViewManager()->requestJobEditor(newJobIds.first());
+}
+
+void JobsManager::showCloneConflicts(const QVector<JobsHelper::CloneConflict> &conflicts)
+{
+    // Do not flood message box, only show first conflicts
+    constexpr int MaxShownConflicts = 10;
+
+    query q_getRSName(Session->m_Db, "SELECT rs_list.number,rs_models.name,rs_models.suffix,"
+                                     "rs_models.type FROM rs_list"
+                                     " JOIN rs_models ON rs_models.id=rs_list.model_id"
+                                     " WHERE rs_list.id=?");
+
+    QStringList lines;
+    for (int i = 0; i < conflicts.size() && i < MaxShownConflicts; i++)
+    {
+        const JobsHelper::CloneConflict &conflict = conflicts.at(i);
+
+        QString rsName;
+        q_getRSName.bind(1, conflict.rsId);
+        if (q_getRSName.step() == SQLITE_ROW)
+        {
+            auto r = q_getRSName.getRows();
+            rsName = rs_utils::formatName(r.get<QString>(1), r.get<int>(0), r.get<QString>(2),
+                                          RsType(r.get<int>(3)));
+        }
+        q_getRSName.reset();
+
+        const QTime time = QTime(0, 0).addSecs(conflict.time * 60);
+        lines.append(tr("<b>%1</b> coupled by job %2 at %3 while still coupled to job %4")
+                       .arg(rsName)
+                       .arg(conflict.jobId)
+                       .arg(time.toString("HH:mm"))
+                       .arg(conflict.otherJobId));
+    }
+
+    if (conflicts.size() > MaxShownConflicts)
+        lines.append(tr("And %1 more.").arg(conflicts.size() - MaxShownConflicts));
+
+    QMessageBox::warning(this, tr("Rollingstock Conflicts"),
+                         tr("Jobs were created but some rollingstock items are used by more than"
+                            " one job at the same time:<br>%1")
+                           .arg(lines.join(QLatin1String("<br>"))));
 }
 
 void JobsManager::onEditJob()
@@ -191,6 +265,27 @@ void JobsManager::onShowJobGraph()
     showMinimized();
 }
 
+void JobsManager::onShiftJobTime()
+{
+    QModelIndex idx = view->currentIndex();
+    if (!idx.isValid())
+        return;
+
+    db_id jobId = jobsModel->getIdAtRow(idx.row());
+    if (!jobId)
+        return;
+
+    bool ok     = false;
+    int minutes = QInputDialog::getInt(this, tr("Shift Time"), tr("Shift job stops by minutes:"),
+                                       0, -24 * 60 + 1, 24 * 60 - 1, 1, &ok);
+    if (!ok || minutes == 0)
+        return;
+
+    QString errMsg;
+    if (!JobsHelper::retimeJobs(Session->m_Db, {jobId}, minutes, 1.0, &errMsg))
+        QMessageBox::warning(this, tr("Shift Time"), errMsg);
+}
+
 void JobsManager::onSelectionChanged()
 {
     const bool hasSel = view->selectionModel()->hasSelection();
@@ -199,4 +294,5 @@ void JobsManager::onSelectionChanged()
     actNewJobSamePath->setEnabled(hasSel);
     actEditJob->setEnabled(hasSel);
     actShowJobInGraph->setEnabled(hasSel);
+    actShiftJobTime->setEnabled(hasSel);
 }
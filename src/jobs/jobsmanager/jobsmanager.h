@@ -22,6 +22,8 @@
 
 #include <QWidget>
 
+#include "model/jobshelper.h"
+
 class QTableView;
 class JobListModel;
 
@@ -39,11 +41,15 @@ private slots:
     void onNewJobSamePath();
     void onEditJob();
     void onShowJobGraph();
+    void onShiftJobTime();
 
     void onRemoveAllJobs();
 
     void onSelectionChanged();
 
+private:
+    void showCloneConflicts(const QVector<JobsHelper::CloneConflict> &conflicts);
+
 private:
     QTableView *view;
 
@@ -51,6 +57,7 @@ private:
     QAction *actNewJobSamePath;
     QAction *actEditJob;
     QAction *actShowJobInGraph;
+    QAction *actShiftJobTime;
 
     JobListModel *jobsModel;
 };
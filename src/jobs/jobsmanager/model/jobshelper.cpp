@@ -23,8 +23,20 @@
 
 #include <sqlite3pp/sqlite3pp.h>
 
+#include <QCoreApplication>
+#include <QStringList>
+#include <QtMath>
+
 #include <QDebug>
 
+class JobsHelperStrings
+{
+    Q_DECLARE_TR_FUNCTIONS(JobsHelperStrings)
+};
+
+// Minutes in a day, 'stops' table stores times as minutes since midnight
+static constexpr int MinutesPerDay = 24 * 60;
+
 bool JobsHelper::createNewJob(sqlite3pp::database &db, db_id &outJobId, JobCategory cat)
 {
     sqlite3pp::command q_newJob(db, "INSERT INTO jobs(id,category,shift_id) VALUES(?,?,NULL)");
@@ -66,12 +78,6 @@ bool JobsHelper::removeJob(sqlite3pp::database &db, db_id jobId)
     db_id shiftId = q.getRows().get<db_id>(0);
     q.reset();
 
-    if (shiftId != 0)
-    {
-        // Remove job from shift
-        emit Session->shiftJobsChanged(shiftId, jobId);
-    }
-
     // Get stations in which job stopped or transited
     QSet<db_id> stationsToUpdate;
     q.prepare("SELECT station_id FROM stops WHERE job_id=?"
@@ -135,6 +141,13 @@ bool JobsHelper::removeJob(sqlite3pp::database &db, db_id jobId)
         return false;
     }
 
+    if (shiftId != 0)
+    {
+        // Remove job from shift
+        // NOTE: job row is gone now, listeners cannot look up its shift anymore
+        emit Session->shiftJobsChanged(shiftId, jobId);
+    }
+
     emit Session->jobRemoved(jobId);
 
     // Refresh graphs and station views
@@ -326,6 +339,501 @@ bool JobsHelper::checkShiftsExist(sqlite3pp::database &db)
     return q.step() == SQLITE_ROW;
 }
 
+bool JobsHelper::calcRetimedStops(QVector<StopTimes> &times, int firstIdx, int offsetMinutes,
+                                  double travelFactor, QString *errMsg)
+{
+    if (firstIdx < 0 || firstIdx >= times.size() || travelFactor <= 0)
+        return false;
+
+    int prevOldDep = 0;
+    int prevNewDep = -1;
+    if (firstIdx > 0)
+        prevNewDep = prevOldDep = times.at(firstIdx - 1).departure;
+
+    for (int i = firstIdx; i < times.size(); i++)
+    {
+        StopTimes &stop    = times[i];
+        const int oldArr   = stop.arrival;
+        const int stopTime = stop.departure - stop.arrival;
+
+        if (i == firstIdx)
+        {
+            stop.arrival = oldArr + offsetMinutes;
+        }
+        else
+        {
+            // Keep at least 1 minute between stops, see StopModel::updateStopTime()
+            const int travel = qMax(1, qRound((oldArr - prevOldDep) * travelFactor));
+            stop.arrival     = prevNewDep + travel;
+        }
+        stop.departure = stop.arrival + stopTime;
+
+        prevOldDep     = oldArr + stopTime;
+
+        if (stop.arrival <= prevNewDep)
+        {
+            if (errMsg)
+                *errMsg =
+                  JobsHelperStrings::tr("Stop %1 would arrive before previous stop departs.")
+                    .arg(i + 1);
+            return false;
+        }
+
+        if (stop.arrival < 0 || stop.departure >= MinutesPerDay || stopTime < 0)
+        {
+            if (errMsg)
+                *errMsg = JobsHelperStrings::tr("Stop %1 would be moved outside of the day.")
+                            .arg(i + 1);
+            return false;
+        }
+
+        prevNewDep = stop.departure;
+    }
+
+    return true;
+}
+
+bool JobsHelper::writeStopTimes(sqlite3pp::database &db, db_id jobId,
+                                const QVector<StopTimes> &times, int firstIdx,
+                                int oldFirstArrival)
+{
+    // Move stops after the valid range first so rows can be written in any order
+    // without hitting UNIQUE(job_id,arrival) and UNIQUE(job_id,departure)
+    command cmd(db, "UPDATE stops SET arrival=arrival+?1,departure=departure+?1"
+                    " WHERE job_id=?2 AND arrival>=?3");
+    cmd.bind(1, 2 * MinutesPerDay);
+    cmd.bind(2, jobId);
+    cmd.bind(3, oldFirstArrival);
+    if (cmd.execute() != SQLITE_OK)
+        return false;
+
+    cmd.prepare("UPDATE stops SET arrival=?,departure=? WHERE id=?");
+    for (int i = firstIdx; i < times.size(); i++)
+    {
+        const StopTimes &stop = times.at(i);
+        cmd.bind(1, stop.arrival);
+        cmd.bind(2, stop.departure);
+        cmd.bind(3, stop.stopId);
+        int ret = cmd.execute();
+        cmd.reset();
+
+        if (ret != SQLITE_OK)
+        {
+            qWarning() << "JobsHelper::writeStopTimes() error setting stop" << stop.stopId
+                       << "Job:" << jobId << db.error_msg();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JobsHelper::retimeJobs(sqlite3pp::database &db, const QVector<db_id> &jobIds,
+                            int offsetMinutes, double travelFactor, QString *errMsg)
+{
+    query q_isEditing(db, "SELECT 1 FROM old_stops WHERE job_id=? LIMIT 1");
+    query q_getStops(db, "SELECT id,arrival,departure,station_id FROM stops"
+                         " WHERE job_id=? ORDER BY arrival ASC");
+    query q_getRS(db, "SELECT DISTINCT coupling.rs_id FROM stops"
+                      " JOIN coupling ON coupling.stop_id=stops.id"
+                      " WHERE stops.job_id=?");
+    query q_getShift(db, "SELECT shift_id FROM jobs WHERE id=?");
+
+    QSet<db_id> stationsToUpdate;
+    QSet<db_id> rsToUpdate;
+
+    // Compute and validate all jobs before touching database
+    QVector<QVector<StopTimes>> allTimes;
+    QVector<int> oldFirstArrivals;
+    QVector<db_id> shiftIds;
+    allTimes.reserve(jobIds.size());
+    oldFirstArrivals.reserve(jobIds.size());
+    shiftIds.reserve(jobIds.size());
+
+    for (db_id jobId : jobIds)
+    {
+        q_isEditing.bind(1, jobId);
+        const bool isEditing = q_isEditing.step() == SQLITE_ROW;
+        q_isEditing.reset();
+
+        if (isEditing)
+        {
+            if (errMsg)
+                *errMsg =
+                  JobsHelperStrings::tr("Job %1 is being edited, save it first.").arg(jobId);
+            return false;
+        }
+
+        db_id shiftId = 0;
+        q_getShift.bind(1, jobId);
+        if (q_getShift.step() == SQLITE_ROW)
+            shiftId = q_getShift.getRows().get<db_id>(0);
+        q_getShift.reset();
+        shiftIds.append(shiftId);
+
+        QVector<StopTimes> times;
+        q_getStops.bind(1, jobId);
+        for (auto stop : q_getStops)
+        {
+            StopTimes item;
+            item.stopId    = stop.get<db_id>(0);
+            item.arrival   = stop.get<int>(1);
+            item.departure = stop.get<int>(2);
+            times.append(item);
+
+            stationsToUpdate.insert(stop.get<db_id>(3));
+        }
+        q_getStops.reset();
+
+        if (times.isEmpty())
+        {
+            allTimes.append(times);
+            oldFirstArrivals.append(0);
+            continue;
+        }
+
+        oldFirstArrivals.append(times.first().arrival);
+
+        QString stopErr;
+        if (!calcRetimedStops(times, 0, offsetMinutes, travelFactor, &stopErr))
+        {
+            if (errMsg)
+                *errMsg = JobsHelperStrings::tr("Job %1: %2").arg(jobId).arg(stopErr);
+            return false;
+        }
+        allTimes.append(times);
+
+        q_getRS.bind(1, jobId);
+        for (auto rs : q_getRS)
+        {
+            rsToUpdate.insert(rs.get<db_id>(0));
+        }
+        q_getRS.reset();
+    }
+
+    q_isEditing.finish();
+    q_getStops.finish();
+    q_getRS.finish();
+    q_getShift.finish();
+
+    // Write all jobs in a single transaction
+    if (db.execute("BEGIN TRANSACTION") != SQLITE_OK)
+    {
+        if (errMsg)
+            *errMsg = db.error_msg();
+        return false;
+    }
+
+    for (int i = 0; i < jobIds.size(); i++)
+    {
+        const QVector<StopTimes> &times = allTimes.at(i);
+        if (times.isEmpty())
+            continue;
+
+        if (!writeStopTimes(db, jobIds.at(i), times, 0, oldFirstArrivals.at(i)))
+        {
+            if (errMsg)
+                *errMsg = db.error_msg();
+            db.execute("ROLLBACK");
+            return false;
+        }
+    }
+
+    // Check new times against other jobs of same shift, like JobPathEditor does.
+    // All jobs are already written so retimed jobs are also checked between each other.
+    query q_shiftBusy(db, "SELECT jobs.id FROM jobs"
+                          " JOIN stops s1 ON s1.job_id=jobs.id"
+                          " JOIN stops s2 ON s2.job_id=jobs.id"
+                          " WHERE jobs.shift_id=?1 AND jobs.id<>?2"
+                          " AND s2.departure>?3 AND s1.arrival<?4"
+                          " LIMIT 1");
+    for (int i = 0; i < jobIds.size(); i++)
+    {
+        const QVector<StopTimes> &times = allTimes.at(i);
+        if (!shiftIds.at(i) || times.isEmpty())
+            continue;
+
+        q_shiftBusy.bind(1, shiftIds.at(i));
+        q_shiftBusy.bind(2, jobIds.at(i));
+        q_shiftBusy.bind(3, times.first().arrival);
+        q_shiftBusy.bind(4, times.last().departure);
+        db_id otherJobId = 0;
+        if (q_shiftBusy.step() == SQLITE_ROW)
+            otherJobId = q_shiftBusy.getRows().get<db_id>(0);
+        q_shiftBusy.reset();
+
+        if (otherJobId)
+        {
+            if (errMsg)
+                *errMsg = JobsHelperStrings::tr("Job %1 would overlap job %2 in its shift.")
+                            .arg(jobIds.at(i))
+                            .arg(otherJobId);
+            q_shiftBusy.finish();
+            db.execute("ROLLBACK");
+            return false;
+        }
+    }
+    q_shiftBusy.finish();
+
+    db.execute("COMMIT");
+
+    // Refresh graphs and station views
+    stationsToUpdate.remove(0);
+    emit Session->stationJobsPlanChanged(stationsToUpdate);
+
+    // Refresh Rollingstock views
+    emit Session->rollingStockPlanChanged(rsToUpdate);
+
+    // Refresh job lists, shifts and job graphs
+    for (int i = 0; i < jobIds.size(); i++)
+    {
+        const db_id jobId = jobIds.at(i);
+        if (shiftIds.at(i))
+            emit Session->shiftJobsChanged(shiftIds.at(i), jobId);
+        emit Session->jobChanged(jobId, jobId);
+    }
+
+    return true;
+}
+
+bool JobsHelper::cloneJobs(sqlite3pp::database &db, db_id srcJobId, const CloneOptions &opt,
+                           QVector<db_id> &outJobIds, QVector<CloneConflict> *outConflicts,
+                           QString *errMsg)
+{
+    outJobIds.clear();
+    if (outConflicts)
+        outConflicts->clear();
+
+    if (opt.count < 1 || opt.numberStep < 0)
+        return false;
+
+    query q(db, "SELECT 1 FROM jobs WHERE id=?");
+    q.bind(1, srcJobId);
+    if (q.step() != SQLITE_ROW)
+        return false; // Job doesn't exist
+
+    // Copy 'n' gets job number (firstId + n * idStep)
+    db_id firstId = 0;
+    db_id idStep  = opt.numberStep;
+    if (idStep > 0)
+    {
+        firstId = srcJobId + idStep;
+    }
+    else
+    {
+        q.prepare("SELECT MAX(id) FROM jobs");
+        q.step();
+        firstId = q.getRows().get<db_id>(0) + 1;
+        idStep  = 1;
+    }
+
+    outJobIds.reserve(opt.count);
+    for (int n = 0; n < opt.count; n++)
+        outJobIds.append(firstId + n * idStep);
+
+    // Check all job numbers at once
+    QStringList errors;
+    q.prepare("SELECT 1 FROM jobs WHERE id=?");
+    for (db_id jobId : qAsConst(outJobIds))
+    {
+        q.bind(1, jobId);
+        if (q.step() == SQLITE_ROW)
+            errors.append(QString::number(jobId));
+        q.reset();
+    }
+
+    if (!errors.isEmpty())
+    {
+        if (errMsg)
+            *errMsg = JobsHelperStrings::tr("Job numbers already in use: %1.")
+                        .arg(errors.join(QLatin1String(", ")));
+        outJobIds.clear();
+        return false;
+    }
+
+    // Check all copies fit in the day
+    q.prepare("SELECT MIN(arrival),MAX(departure) FROM stops WHERE job_id=?");
+    q.bind(1, srcJobId);
+    q.step();
+    if (q.getRows().column_type(0) != SQLITE_NULL)
+    {
+        const int srcFirstArr = q.getRows().get<int>(0);
+        const int srcLastDep  = q.getRows().get<int>(1);
+        for (int n = 0; n < opt.count; n++)
+        {
+            const int offset = opt.startOffset + n * opt.interval;
+            if (srcFirstArr + offset < 0 || srcLastDep + offset >= MinutesPerDay)
+                errors.append(QString::number(outJobIds.at(n)));
+        }
+    }
+
+    if (!errors.isEmpty())
+    {
+        if (errMsg)
+            *errMsg = JobsHelperStrings::tr("Jobs would be moved outside of the day: %1.")
+                        .arg(errors.join(QLatin1String(", ")));
+        outJobIds.clear();
+        return false;
+    }
+
+    QSet<db_id> stationsToUpdate;
+    q.prepare("SELECT DISTINCT station_id FROM stops WHERE job_id=?");
+    q.bind(1, srcJobId);
+    for (auto st : q)
+    {
+        stationsToUpdate.insert(st.get<db_id>(0));
+    }
+
+    QSet<db_id> rsToUpdate;
+    if (opt.copyCoupling)
+    {
+        q.prepare("SELECT DISTINCT coupling.rs_id FROM stops"
+                  " JOIN coupling ON coupling.stop_id=stops.id"
+                  " WHERE stops.job_id=?");
+        q.bind(1, srcJobId);
+        for (auto rs : q)
+        {
+            rsToUpdate.insert(rs.get<db_id>(0));
+        }
+    }
+    q.finish();
+
+    if (db.execute("BEGIN TRANSACTION") != SQLITE_OK)
+    {
+        if (errMsg)
+            *errMsg = db.error_msg();
+        return false;
+    }
+
+    // Recursive CTE generates copy index 'n' from 0 to count-1
+    // ?1 count, ?2 first job ID, ?3 job ID step, ?4 first offset, ?5 interval, ?6 source job
+    command cmd(db, "WITH RECURSIVE copies(n) AS (SELECT 0 UNION ALL"
+                    " SELECT n+1 FROM copies WHERE n+1<?1)"
+                    " INSERT INTO jobs(id,category,shift_id)"
+                    " SELECT ?2+copies.n*?3,jobs.category,NULL FROM copies,jobs WHERE jobs.id=?6");
+    cmd.bind(1, opt.count);
+    cmd.bind(2, firstId);
+    cmd.bind(3, idStep);
+    cmd.bind(6, srcJobId);
+    int ret = cmd.execute();
+
+    if (ret == SQLITE_OK)
+    {
+        cmd.prepare("WITH RECURSIVE copies(n) AS (SELECT 0 UNION ALL"
+                    " SELECT n+1 FROM copies WHERE n+1<?1)"
+                    " INSERT INTO stops(job_id,station_id,arrival,departure,type,description,"
+                    "in_gate_conn,out_gate_conn,next_segment_conn_id)"
+                    " SELECT ?2+copies.n*?3,s.station_id,"
+                    "s.arrival+?4+copies.n*?5,s.departure+?4+copies.n*?5,s.type,s.description,"
+                    "s.in_gate_conn,s.out_gate_conn,s.next_segment_conn_id"
+                    " FROM copies,stops s WHERE s.job_id=?6");
+        cmd.bind(1, opt.count);
+        cmd.bind(2, firstId);
+        cmd.bind(3, idStep);
+        cmd.bind(4, opt.startOffset);
+        cmd.bind(5, opt.interval);
+        cmd.bind(6, srcJobId);
+        ret = cmd.execute();
+    }
+
+    if (ret == SQLITE_OK && opt.copyCoupling)
+    {
+        // Match copied stops by UNIQUE(job_id,arrival)
+        cmd.prepare("WITH RECURSIVE copies(n) AS (SELECT 0 UNION ALL"
+                    " SELECT n+1 FROM copies WHERE n+1<?1)"
+                    " INSERT INTO coupling(stop_id,rs_id,operation)"
+                    " SELECT ns.id,c.rs_id,c.operation FROM copies"
+                    " JOIN stops os ON os.job_id=?6"
+                    " JOIN coupling c ON c.stop_id=os.id"
+                    " JOIN stops ns ON ns.job_id=?2+copies.n*?3"
+                    " AND ns.arrival=os.arrival+?4+copies.n*?5");
+        cmd.bind(1, opt.count);
+        cmd.bind(2, firstId);
+        cmd.bind(3, idStep);
+        cmd.bind(4, opt.startOffset);
+        cmd.bind(5, opt.interval);
+        cmd.bind(6, srcJobId);
+        ret = cmd.execute();
+    }
+
+    if (ret != SQLITE_OK)
+    {
+        qWarning() << "JobsHelper::cloneJobs() error copying job" << srcJobId << db.error_msg();
+        if (errMsg)
+            *errMsg = db.error_msg();
+        db.execute("ROLLBACK");
+        outJobIds.clear();
+        return false;
+    }
+
+    db.execute("COMMIT");
+
+    if (outConflicts && !rsToUpdate.isEmpty())
+    {
+        // Walk operations of copied rollingstock in time order,
+        // an item coupled while still coupled to another job is a conflict
+        QSet<db_id> clonedJobs;
+        clonedJobs.reserve(outJobIds.size());
+        for (db_id jobId : qAsConst(outJobIds))
+            clonedJobs.insert(jobId);
+
+        q.prepare("SELECT c.rs_id,c.operation,s.job_id,s.arrival FROM coupling c"
+                  " JOIN stops s ON s.id=c.stop_id"
+                  " WHERE c.rs_id IN (SELECT c2.rs_id FROM coupling c2"
+                  " JOIN stops s2 ON s2.id=c2.stop_id WHERE s2.job_id=?)"
+                  " ORDER BY c.rs_id,s.arrival,c.operation");
+        q.bind(1, srcJobId);
+
+        db_id lastRsId     = 0;
+        db_id holdingJobId = 0;
+        for (auto op : q)
+        {
+            const db_id rsId  = op.get<db_id>(0);
+            const RsOp rsOp   = RsOp(op.get<int>(1));
+            const db_id jobId = op.get<db_id>(2);
+
+            if (rsId != lastRsId)
+            {
+                lastRsId     = rsId;
+                holdingJobId = 0;
+            }
+
+            if (rsOp == RsOp::Uncoupled)
+            {
+                if (jobId == holdingJobId)
+                    holdingJobId = 0;
+                continue;
+            }
+
+            if (holdingJobId && holdingJobId != jobId
+                && (clonedJobs.contains(jobId) || clonedJobs.contains(holdingJobId)))
+            {
+                CloneConflict conflict;
+                conflict.jobId      = jobId;
+                conflict.otherJobId = holdingJobId;
+                conflict.rsId       = rsId;
+                conflict.time       = op.get<int>(3);
+                outConflicts->append(conflict);
+            }
+
+            holdingJobId = jobId;
+        }
+    }
+
+    // Listeners track jobs individually, notify each copy
+    for (db_id jobId : qAsConst(outJobIds))
+        emit Session->jobAdded(jobId);
+
+    // Refresh graphs and station views
+    stationsToUpdate.remove(0);
+    emit Session->stationJobsPlanChanged(stationsToUpdate);
+
+    // Refresh Rollingstock views
+    emit Session->rollingStockPlanChanged(rsToUpdate);
+
+    return true;
+}
+
 JobStopDirectionHelper::JobStopDirectionHelper(sqlite3pp::database &db) :
     mDb(db),
     m_query(new sqlite3pp::query(mDb))
@@ -365,13 +873,18 @@ utils::Side JobStopDirectionHelper::getStopOutSide(db_id stopId)
     if (r.column_type(1) != SQLITE_NULL)
         out_side = utils::Side(r.get<int>(1));
 
+    return directionFromGateSides(in_side, out_side);
+}
+
+utils::Side JobStopDirectionHelper::directionFromGateSides(utils::Side inSide, utils::Side outSide)
+{
     // Prefer out side
-    if (out_side != utils::Side::NSides)
-        return out_side;
+    if (outSide != utils::Side::NSides)
+        return outSide;
 
     // We only have in side, invert it
-    if (in_side == utils::Side::NSides)
-        return in_side;
+    if (inSide == utils::Side::NSides)
+        return inSide;
 
-    return in_side == utils::Side::East ? utils::Side::West : utils::Side::East;
+    return inSide == utils::Side::East ? utils::Side::West : utils::Side::East;
 }
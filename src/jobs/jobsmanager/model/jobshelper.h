@@ -23,6 +23,10 @@
 #include "utils/types.h"
 #include "stations/station_utils.h"
 
+#include <QVector>
+
+class QString;
+
 namespace sqlite3pp {
 class database;
 class query;
@@ -31,6 +35,46 @@ class query;
 class JobsHelper
 {
 public:
+    /*!
+     * \brief The StopTimes struct
+     *
+     * Arrival and departure of a stop in minutes since midnight,
+     * same unit used by 'stops' table
+     */
+    struct StopTimes
+    {
+        db_id stopId  = 0;
+        int arrival   = 0;
+        int departure = 0;
+    };
+
+    /*!
+     * \brief The CloneOptions struct
+     *
+     * Parameters of a batch of copies created by cloneJobs()
+     */
+    struct CloneOptions
+    {
+        int count         = 1;    // Number of copies to create
+        int startOffset   = 0;    // Minutes between source job and first copy
+        int interval      = 60;   // Minutes between two consecutive copies
+        int numberStep    = 0;    // Job number increment, 0 picks first free numbers
+        bool copyCoupling = true; // Copy rollingstock operations
+    };
+
+    /*!
+     * \brief The CloneConflict struct
+     *
+     * A copy couples a rollingstock item which is still coupled to another job
+     */
+    struct CloneConflict
+    {
+        db_id jobId      = 0; // The job coupling the item
+        db_id otherJobId = 0; // The job holding the item
+        db_id rsId       = 0;
+        int time         = 0; // Minutes since midnight
+    };
+
     /*!
      * \brief createNewJob
      * \param db open database connection
@@ -51,6 +95,78 @@ public:
                           bool copyRsOps, bool reversePath);
 
     static bool checkShiftsExist(sqlite3pp::database &db);
+
+    /*!
+     * \brief calcRetimedStops
+     * \param times stops of a job sorted by arrival, gets updated in place
+     * \param firstIdx first stop to retime, previous stops are left untouched
+     * \param offsetMinutes shift applied to first retimed stop
+     * \param travelFactor multiplier of travel time between retimed stops (1.0 keeps it)
+     * \param errMsg if not null, on failure it gets set to a human readable reason
+     * \return true if new times satisfy all 'stops' table constraints
+     *
+     * Computes new times in memory. Stop durations are preserved.
+     * Travel time is rounded to minutes and kept at least 1 minute long
+     * so arrivals and departures remain unique and sorted.
+     * On failure \a times is left in an unspecified state.
+     */
+    static bool calcRetimedStops(QVector<StopTimes> &times, int firstIdx, int offsetMinutes,
+                                 double travelFactor, QString *errMsg = nullptr);
+
+    /*!
+     * \brief writeStopTimes
+     * \param db open database connection
+     * \param jobId the job which owns the stops
+     * \param times new stop times, must be validated with calcRetimedStops()
+     * \param firstIdx first stop with changed time
+     * \param oldFirstArrival original arrival of \a firstIdx stop
+     * \return true on success
+     *
+     * Writes stop times with a single prepared statement.
+     * Caller is responsible of wrapping it in a transaction and of sending notifications.
+     */
+    static bool writeStopTimes(sqlite3pp::database &db, db_id jobId,
+                               const QVector<StopTimes> &times, int firstIdx,
+                               int oldFirstArrival);
+
+    /*!
+     * \brief retimeJobs
+     * \param db open database connection
+     * \param jobIds the jobs to retime
+     * \param offsetMinutes shift applied to all stops
+     * \param travelFactor multiplier of travel time between stops (1.0 keeps it)
+     * \param errMsg if not null, on failure it gets set to a human readable reason
+     * \return true on success
+     *
+     * Shifts or stretches all stops of many jobs at once.
+     * All jobs are validated before writing, if one fails nothing is changed.
+     * Jobs currently being edited in JobPathEditor are rejected.
+     * Jobs which would overlap other jobs of their shift are rejected.
+     * Stations and rollingstock plans are notified once for all jobs.
+     */
+    static bool retimeJobs(sqlite3pp::database &db, const QVector<db_id> &jobIds,
+                           int offsetMinutes, double travelFactor, QString *errMsg = nullptr);
+
+    /*!
+     * \brief cloneJobs
+     * \param db open database connection
+     * \param srcJobId the job to copy
+     * \param opt number of copies, time interval and job number step
+     * \param outJobIds filled with IDs of created jobs
+     * \param outConflicts if not null, filled with rollingstock conflicts of all copies
+     * \param errMsg if not null, on failure it gets set to a human readable reason
+     * \return true on success
+     *
+     * Creates all copies in a single transaction with set based statements,
+     * so cost does not depend on number of copies.
+     * Job numbers and times of every copy are validated before writing,
+     * if one is not valid nothing is created.
+     * Rollingstock conflicts do not prevent creation, they are reported so the user can fix them.
+     * Copies keep source job path, use copyStops() to reverse it.
+     */
+    static bool cloneJobs(sqlite3pp::database &db, db_id srcJobId, const CloneOptions &opt,
+                          QVector<db_id> &outJobIds, QVector<CloneConflict> *outConflicts,
+                          QString *errMsg = nullptr);
 };
 
 class JobStopDirectionHelper
@@ -61,6 +177,14 @@ public:
 
     utils::Side getStopOutSide(db_id stopId);
 
+    /*!
+     * \brief get direction from gate sides
+     * \param inSide side of stop in gate, NSides if missing
+     * \param outSide side of stop out gate, NSides if missing
+     * \return out side if known, otherwise opposite of in side
+     */
+    static utils::Side directionFromGateSides(utils::Side inSide, utils::Side outSide);
+
 private:
     sqlite3pp::database &mDb;
     sqlite3pp::query *m_query;
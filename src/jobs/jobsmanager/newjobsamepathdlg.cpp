@@ -22,9 +22,11 @@
 #include "utils/jobcategorystrings.h"
 
 #include <QVBoxLayout>
+#include <QFormLayout>
 #include <QLabel>
 #include <QCheckBox>
 #include <QTimeEdit>
+#include <QSpinBox>
 #include <QDialogButtonBox>
 
 #include <QMessageBox>
@@ -48,6 +50,28 @@ NewJobSamePathDlg::NewJobSamePathDlg(QWidget *parent) :
     reversePathCheck->setChecked(false); // Disabled by default
     lay->addWidget(reversePathCheck);
 
+    // Batch copies, for regular interval services
+    QFormLayout *batchLay = new QFormLayout;
+    lay->addLayout(batchLay);
+
+    copiesSpin = new QSpinBox;
+    copiesSpin->setRange(1, 1000);
+    batchLay->addRow(tr("Copies"), copiesSpin);
+
+    intervalSpin = new QSpinBox;
+    intervalSpin->setRange(1, 24 * 60 - 1);
+    intervalSpin->setValue(60);
+    intervalSpin->setSuffix(tr(" min"));
+    batchLay->addRow(tr("Interval"), intervalSpin);
+
+    numberStepSpin = new QSpinBox;
+    numberStepSpin->setRange(0, 10000);
+    numberStepSpin->setSpecialValueText(tr("Auto"));
+    numberStepSpin->setToolTip(tr("Job number increment between copies.<br>"
+                                  "<b>Auto</b> uses consecutive numbers after the highest"
+                                  " existing job number."));
+    batchLay->addRow(tr("Number step"), numberStepSpin);
+
     QDialogButtonBox *box = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
     lay->addWidget(box);
 
@@ -55,6 +79,9 @@ NewJobSamePathDlg::NewJobSamePathDlg(QWidget *parent) :
     connect(box, &QDialogButtonBox::rejected, this, &QDialog::reject);
 
     connect(startTimeEdit, &QTimeEdit::timeChanged, this, &NewJobSamePathDlg::checkTimeIsValid);
+    connect(intervalSpin, qOverload<int>(&QSpinBox::valueChanged), this,
+            &NewJobSamePathDlg::updateMaxCopies);
+    connect(reversePathCheck, &QCheckBox::toggled, this, &NewJobSamePathDlg::updateMaxCopies);
 
     setMinimumSize(200, 100);
     setWindowTitle(tr("New Job With Same Path"));
@@ -77,6 +104,8 @@ void NewJobSamePathDlg::setSourceJob(db_id jobId, JobCategory cat, const QTime &
     // Prevent calling checkTimeIsValid()
     QSignalBlocker blk(startTimeEdit);
     startTimeEdit->setTime(sourceStart);
+
+    updateMaxCopies();
 }
 
 QTime NewJobSamePathDlg::getNewStartTime() const
@@ -94,6 +123,21 @@ bool NewJobSamePathDlg::shouldReversePath() const
     return reversePathCheck->isChecked();
 }
 
+int NewJobSamePathDlg::getCopiesCount() const
+{
+    return copiesSpin->value();
+}
+
+int NewJobSamePathDlg::getIntervalMinutes() const
+{
+    return intervalSpin->value();
+}
+
+int NewJobSamePathDlg::getNumberStep() const
+{
+    return numberStepSpin->value();
+}
+
 void NewJobSamePathDlg::checkTimeIsValid()
 {
     const QTime lastValidTime     = QTime(23, 59);
@@ -114,4 +158,28 @@ void NewJobSamePathDlg::checkTimeIsValid()
         QSignalBlocker blk(startTimeEdit);
         startTimeEdit->setTime(newStart);
     }
+
+    updateMaxCopies();
+}
+
+void NewJobSamePathDlg::updateMaxCopies()
+{
+    // Reversed path is not supported for batch copies
+    const bool canBatch = !reversePathCheck->isChecked();
+    copiesSpin->setEnabled(canBatch);
+    intervalSpin->setEnabled(canBatch);
+    numberStepSpin->setEnabled(canBatch);
+
+    int maxCopies = 1;
+    if (canBatch)
+    {
+        // Last copy must end before midnight
+        const int travelDurationMins = sourceStart.secsTo(sourceEnd) / 60;
+        const int minsToMidnight     = startTimeEdit->time().secsTo(QTime(23, 59)) / 60;
+        const int freeMins           = minsToMidnight - travelDurationMins;
+        if (freeMins > 0)
+            maxCopies = 1 + freeMins / intervalSpin->value();
+    }
+
+    copiesSpin->setMaximum(qBound(1, maxCopies, 1000));
 }
@@ -28,6 +28,7 @@
 class QLabel;
 class QCheckBox;
 class QTimeEdit;
+class QSpinBox;
 
 class NewJobSamePathDlg : public QDialog
 {
@@ -41,14 +42,22 @@ public:
     bool shouldCopyRs() const;
     bool shouldReversePath() const;
 
+    int getCopiesCount() const;
+    int getIntervalMinutes() const;
+    int getNumberStep() const;
+
 private slots:
     void checkTimeIsValid();
+    void updateMaxCopies();
 
 private:
     QLabel *label;
     QTimeEdit *startTimeEdit;
     QCheckBox *copyRsCheck;
     QCheckBox *reversePathCheck;
+    QSpinBox *copiesSpin;
+    QSpinBox *intervalSpin;
+    QSpinBox *numberStepSpin;
 
     db_id sourceJobId        = 0;
     JobCategory sourceJobCat = JobCategory::NCategories;
@@ -0,0 +1,471 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetbatchexportdlg.h"
+
+#include "sheetbatchexporthandler.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+
+#include <QCheckBox>
+#include <QTreeWidget>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QDialogButtonBox>
+
+#include <QGroupBox>
+#include <QLabel>
+#include <QProgressBar>
+#include <QPlainTextEdit>
+
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QDir>
+#include <QHash>
+
+#include "utils/files/recentdirstore.h"
+
+#include "sheetcontenthash.h"
+#include "sheetexporttracker.h"
+
+#include "odt_export/common/sheetexportoptions.h"
+
+#include "app/session.h"
+
+#include "utils/jobcategorystrings.h"
+
+static const QLatin1String sheet_batch_key = QLatin1String("sheet_batch_dir");
+
+// Remove characters which are not allowed in file names
+static QString sanitizeFileName(QString name)
+{
+    static const QString forbiddenChars = QStringLiteral("\\/:*?\"<>|");
+    for (QChar &ch : name)
+    {
+        if (forbiddenChars.contains(ch) || ch < QChar(' '))
+            ch = QChar('_');
+    }
+    return name;
+}
+
+// Tree item data, top level items are indexed by SheetBatch::ItemType
+enum ItemDataRole
+{
+    IdRole = Qt::UserRole,
+    FileNameRole,
+    CategoryRole
+};
+
+SheetBatchExportDlg::SheetBatchExportDlg(sqlite3pp::database &db, QWidget *parent) :
+    QDialog(parent),
+    mDb(db),
+    m_finished(false)
+{
+    QVBoxLayout *lay = new QVBoxLayout(this);
+
+    // Setup Options Group Box
+    optionsBox         = new QGroupBox(tr("Sheets:"));
+    QVBoxLayout *opLay = new QVBoxLayout(optionsBox);
+
+    itemsTree          = new QTreeWidget;
+    itemsTree->setHeaderHidden(true);
+    opLay->addWidget(itemsTree);
+
+    incrementalCheck = new QCheckBox(tr("Only changed sheets"));
+    incrementalCheck->setToolTip(
+      tr("Skip sheets which did not change since last export in this folder"));
+    incrementalCheck->setChecked(true);
+    opLay->addWidget(incrementalCheck);
+
+    QHBoxLayout *folderLay = new QHBoxLayout;
+    folderEdit             = new QLineEdit;
+    folderEdit->setPlaceholderText(tr("Destination folder"));
+    folderEdit->setText(RecentDirStore::getDir(sheet_batch_key, RecentDirStore::Documents));
+    folderLay->addWidget(folderEdit);
+
+    QPushButton *folderBut = new QPushButton(tr("Choose..."));
+    folderLay->addWidget(folderBut);
+    opLay->addLayout(folderLay);
+
+    lay->addWidget(optionsBox);
+
+    connect(itemsTree, &QTreeWidget::itemChanged, this, &SheetBatchExportDlg::updateExportButton);
+    connect(folderEdit, &QLineEdit::textChanged, this, &SheetBatchExportDlg::updateExportButton);
+    connect(folderBut, &QPushButton::clicked, this, &SheetBatchExportDlg::onChooseFolder);
+
+    // Setup Progress Group Box
+    progressBox          = new QGroupBox(tr("Progress:"));
+    QVBoxLayout *progLay = new QVBoxLayout(progressBox);
+
+    progressLabel        = new QLabel;
+    progLay->addWidget(progressLabel);
+    progressBar = new QProgressBar;
+    progLay->addWidget(progressBar);
+    errorLog = new QPlainTextEdit;
+    errorLog->setReadOnly(true);
+    errorLog->setVisible(false);
+    progLay->addWidget(errorLog);
+
+    progressBox->setVisible(false);
+    lay->addWidget(progressBox);
+
+    // Dialog button box
+    buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+    lay->addWidget(buttonBox);
+
+    // Change 'Ok' button to 'Export'
+    buttonBox->button(QDialogButtonBox::Ok)->setText(tr("Export"));
+
+    connect(buttonBox, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    setWindowTitle(tr("Export Sheets"));
+    resize(450, 500);
+
+    exportHandler = new SheetBatchExportHandler(this);
+    connect(exportHandler, &SheetBatchExportHandler::progressMaxChanged, this,
+            &SheetBatchExportDlg::progressMaxChanged);
+    connect(exportHandler, &SheetBatchExportHandler::progressChanged, this,
+            &SheetBatchExportDlg::progressChanged);
+    connect(exportHandler, &SheetBatchExportHandler::itemFailed, this,
+            &SheetBatchExportDlg::onItemFailed);
+    connect(exportHandler, &SheetBatchExportHandler::progressFinished, this,
+            &SheetBatchExportDlg::handleProgressFinished);
+
+    loadTree();
+    updateExportButton();
+}
+
+SheetBatchExportDlg::~SheetBatchExportDlg()
+{
+    exportHandler->abortExport();
+}
+
+void SheetBatchExportDlg::done(int res)
+{
+    if (res == QDialog::Rejected && !m_finished && exportHandler->taskIsRunning())
+    {
+        if (!exportHandler->waitingForTaskToStop())
+        {
+            int ret = QMessageBox::question(this, tr("Abort Export?"),
+                                            tr("Do you want to stop exporting sheets?"));
+            if (ret == QMessageBox::Yes)
+                exportHandler->stopTaskGracefully();
+        }
+        return; // Wait for tasks to stop
+    }
+    else if (res == QDialog::Accepted && !m_finished && !exportHandler->taskIsRunning())
+    {
+        startExport();
+        return;
+    }
+
+    if (exportHandler->taskIsRunning())
+        return; // Task is running, cannot quit now
+
+    QDialog::done(res);
+}
+
+void SheetBatchExportDlg::onChooseFolder()
+{
+    QString path = QFileDialog::getExistingDirectory(this, tr("Destination Folder"),
+                                                     folderEdit->text());
+    if (path.isEmpty())
+        return;
+
+    folderEdit->setText(QDir::toNativeSeparators(path));
+}
+
+void SheetBatchExportDlg::updateExportButton()
+{
+    bool hasSheets = false;
+    for (int i = 0; i < itemsTree->topLevelItemCount() && !hasSheets; i++)
+    {
+        hasSheets = itemsTree->topLevelItem(i)->checkState(0) != Qt::Unchecked;
+    }
+
+    buttonBox->button(QDialogButtonBox::Ok)
+      ->setEnabled(hasSheets && !folderEdit->text().trimmed().isEmpty());
+}
+
+void SheetBatchExportDlg::progressMaxChanged(int max)
+{
+    progressBar->setMaximum(max);
+}
+
+void SheetBatchExportDlg::progressChanged(int val, const QString &msg)
+{
+    progressBar->setValue(val);
+    progressLabel->setText(msg);
+}
+
+void SheetBatchExportDlg::onItemFailed(const QString &fileName, const QString &errMsg)
+{
+    errorLog->setVisible(true);
+    if (fileName.isEmpty())
+        errorLog->appendHtml(errMsg);
+    else
+        errorLog->appendHtml(QStringLiteral("%1: %2").arg(fileName, errMsg));
+}
+
+void SheetBatchExportDlg::handleProgressFinished(bool aborted, int failedCount)
+{
+    Q_UNUSED(aborted)
+    Q_UNUSED(failedCount)
+
+    m_finished = true;
+    storeResults();
+
+    // When finished, disable Cancel button.
+    buttonBox->button(QDialogButtonBox::Cancel)->setEnabled(false);
+
+    // Enable button 'Ok' whith default test
+    buttonBox->button(QDialogButtonBox::Ok)->setText(tr("Ok"));
+    buttonBox->button(QDialogButtonBox::Ok)->setEnabled(true);
+}
+
+void SheetBatchExportDlg::loadTree()
+{
+    QSignalBlocker blocker(itemsTree);
+
+    QTreeWidgetItem *shifts   = new QTreeWidgetItem(itemsTree, {tr("Job Shifts")});
+    QTreeWidgetItem *stations = new QTreeWidgetItem(itemsTree, {tr("Stations")});
+    QTreeWidgetItem *jobs     = new QTreeWidgetItem(itemsTree, {tr("Jobs")});
+
+    // Different names can give same file name once sanitized
+    // Count them case insensitive, some file systems do not distinguish case
+    QHash<QString, int> fileNameCount;
+
+    auto addItem = [&fileNameCount](QTreeWidgetItem *parent, db_id id, const QString &name,
+                                    const QString &fileName)
+    {
+        QTreeWidgetItem *item = new QTreeWidgetItem(parent, {name});
+        item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+        item->setCheckState(0, Qt::Unchecked); // Parent only propagates to checkable children
+        item->setData(0, IdRole, id);
+        item->setData(0, FileNameRole, fileName);
+        fileNameCount[fileName.toLower()]++;
+        return item;
+    };
+
+    sqlite3pp::query q(mDb, "SELECT id,name FROM jobshifts ORDER BY name");
+    for (auto shift : q)
+    {
+        const QString name = shift.get<QString>(1);
+        addItem(shifts, shift.get<db_id>(0), name, sanitizeFileName(tr("shift_%1.odt").arg(name)));
+    }
+
+    q.prepare("SELECT id,name FROM stations ORDER BY name");
+    for (auto st : q)
+    {
+        const QString name = st.get<QString>(1);
+        addItem(stations, st.get<db_id>(0), name, sanitizeFileName(tr("%1_station.odt").arg(name)));
+    }
+
+    q.prepare("SELECT id,category FROM jobs ORDER BY id");
+    for (auto job : q)
+    {
+        const db_id jobId     = job.get<db_id>(0);
+        const JobCategory cat = JobCategory(job.get<int>(1));
+        QTreeWidgetItem *item = addItem(jobs, jobId, JobCategoryName::jobName(jobId, cat),
+                                        tr("job%1_sheet.odt").arg(jobId));
+        item->setData(0, CategoryRole, int(cat));
+    }
+
+    for (int type = 0; type < itemsTree->topLevelItemCount(); type++)
+    {
+        QTreeWidgetItem *parent = itemsTree->topLevelItem(type);
+        parent->setFlags(parent->flags() | Qt::ItemIsUserCheckable | Qt::ItemIsAutoTristate);
+
+        // Add ID to all colliding names, so file name of an item
+        // does not depend on which items are exported
+        for (int i = 0; i < parent->childCount(); i++)
+        {
+            QTreeWidgetItem *item = parent->child(i);
+            QString fileName      = item->data(0, FileNameRole).toString();
+            if (fileNameCount.value(fileName.toLower()) < 2)
+                continue;
+
+            fileName.insert(fileName.lastIndexOf('.'),
+                            QStringLiteral("_%1").arg(item->data(0, IdRole).toLongLong()));
+            item->setData(0, FileNameRole, fileName);
+        }
+
+        // Jobs are many and less useful, do not export them by default
+        // NOTE: set after adding children so it's applied to them too
+        const bool checked = type != int(SheetBatch::ItemType::Job);
+        parent->setCheckState(0, checked ? Qt::Checked : Qt::Unchecked);
+    }
+}
+
+bool SheetBatchExportDlg::isTypeComplete(SheetBatch::ItemType type) const
+{
+    return itemsTree->topLevelItem(int(type))->checkState(0) == Qt::Checked;
+}
+
+bool SheetBatchExportDlg::startExport()
+{
+    const QString outDir = folderEdit->text().trimmed();
+    if (!QDir().mkpath(outDir))
+    {
+        QMessageBox::warning(this, tr("Export Error"),
+                             tr("Cannot create folder <b>%1</b>").arg(outDir));
+        return false;
+    }
+
+    // Tasks use their own connection, so they see only committed changes
+    // NOTE: editors are closed before opening this dialog
+    Session->releaseAllSavepoints();
+
+    RecentDirStore::setPath(sheet_batch_key, outDir);
+
+    // Tasks cannot read settings, pass them a copy
+    const SheetExportOptions options = SheetExportOptions::fromSettings();
+
+    // Changes not notified by session are detected by fingerprint
+    const QByteArray salt = SheetContentHash::calcGlobalSalt(mDb, options);
+    m_fingerprint         = salt + SheetContentHash::calcRollingstockFingerprint(mDb);
+    m_outDir              = outDir;
+    m_manifest.load(m_outDir);
+
+    SheetExportTracker *tracker = Session->getSheetExportTracker();
+    tracker->collectChanges(mDb);
+
+    QSharedPointer<SheetBatch::Queue> queue = QSharedPointer<SheetBatch::Queue>::create();
+    queue->incremental                      = incrementalCheck->isChecked();
+    queue->salt                             = salt;
+    queue->options                          = options;
+    loadItems(queue->items);
+
+    for (SheetBatch::Item &item : queue->items)
+    {
+        item.oldHash    = m_manifest.getHash(item.fileName);
+        item.knownClean = !item.oldHash.isEmpty()
+                          && tracker->isKnownClean(item.type, item.id, m_outDir, m_fingerprint);
+    }
+
+    // Disable options and show progress
+    optionsBox->setEnabled(false);
+    progressBox->setVisible(true);
+    errorLog->clear();
+
+    // Disable 'Export' while exporting
+    buttonBox->button(QDialogButtonBox::Ok)->setEnabled(false);
+
+    exportHandler->startExport(Session->fileName, outDir, queue);
+    return true;
+}
+
+void SheetBatchExportDlg::loadItems(QVector<SheetBatch::Item> &items)
+{
+    SheetBatch::Item item;
+
+    for (int type = 0; type < itemsTree->topLevelItemCount(); type++)
+    {
+        const QTreeWidgetItem *parent = itemsTree->topLevelItem(type);
+        if (parent->checkState(0) == Qt::Unchecked)
+            continue;
+
+        item.type = SheetBatch::ItemType(type);
+
+        for (int i = 0; i < parent->childCount(); i++)
+        {
+            const QTreeWidgetItem *child = parent->child(i);
+            if (child->checkState(0) != Qt::Checked)
+                continue;
+
+            item.id       = child->data(0, IdRole).toLongLong();
+            item.cat      = JobCategory(child->data(0, CategoryRole).toInt()); // Only jobs have it
+            item.fileName = child->data(0, FileNameRole).toString();
+            items.append(item);
+        }
+    }
+}
+
+void SheetBatchExportDlg::storeResults()
+{
+    QSharedPointer<SheetBatch::Queue> queue = exportHandler->lastBatch();
+    if (!queue || m_outDir.isEmpty())
+        return;
+
+    // Items to check again on next export, indexed by SheetBatch::ItemType
+    QSet<db_id> notExported[3];
+
+    // Exported sheets of each type, indexed by SheetBatch::ItemType
+    QSet<QString> fileNames[3];
+
+    for (int i = 0; i < queue->items.size(); i++)
+    {
+        const SheetBatch::Item &item = queue->items.at(i);
+        fileNames[int(item.type)].insert(item.fileName);
+
+        switch (queue->results.at(i))
+        {
+        case SheetBatch::Result::Exported:
+        case SheetBatch::Result::Unchanged:
+            m_manifest.setHash(item.fileName, item.type, queue->newHashes.at(i));
+            break;
+        case SheetBatch::Result::Failed:
+            m_manifest.removeHash(item.fileName);
+            notExported[int(item.type)].insert(item.id);
+            break;
+        case SheetBatch::Result::Pending:
+            // Aborted before processing, old file and hash are still valid
+            notExported[int(item.type)].insert(item.id);
+            break;
+        }
+    }
+
+    // Remove sheets of shifts, stations and jobs deleted since last export
+    QDir dir(m_outDir);
+    for (int type = 0; type < 3; type++)
+    {
+        if (!isTypeComplete(SheetBatch::ItemType(type)))
+            continue; // Not all exported, we do not know which sheets are still valid
+
+        const QStringList stale =
+          m_manifest.takeStaleFiles(SheetBatch::ItemType(type), fileNames[type]);
+        for (const QString &fileName : stale)
+        {
+            if (dir.exists(fileName) && !dir.remove(fileName))
+            {
+                errorLog->setVisible(true);
+                errorLog->appendHtml(tr("%1: cannot remove sheet of deleted item").arg(fileName));
+            }
+        }
+    }
+
+    if (!m_manifest.save(m_outDir))
+    {
+        errorLog->setVisible(true);
+        errorLog->appendHtml(tr("Cannot save export manifest, next export will be complete"));
+    }
+
+    // Tracker can only record types whose items were all checked
+    SheetExportTracker *tracker = Session->getSheetExportTracker();
+    for (int type = 0; type < 3; type++)
+    {
+        if (isTypeComplete(SheetBatch::ItemType(type)))
+        {
+            tracker->markExported(SheetBatch::ItemType(type), m_outDir, m_fingerprint,
+                                  notExported[type]);
+        }
+    }
+}
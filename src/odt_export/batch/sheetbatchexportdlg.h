@@ -0,0 +1,102 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETBATCHEXPORTDLG_H
+#define SHEETBATCHEXPORTDLG_H
+
+#include <QDialog>
+#include <QVector>
+
+#include "sheetbatchexporttask.h"
+#include "sheetexportmanifest.h"
+
+class QCheckBox;
+class QTreeWidget;
+class QLineEdit;
+class QDialogButtonBox;
+
+class QGroupBox;
+class QLabel;
+class QProgressBar;
+class QPlainTextEdit;
+
+class SheetBatchExportHandler;
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The SheetBatchExportDlg class
+ *
+ * Saves shift, station and job sheets of whole session, or of checked items only, in a folder.
+ * Sheets are exported in parallel by SheetBatchExportHandler.
+ * Sheets of deleted items are removed only if all items of their type are exported.
+ * Optionally only sheets changed since last export in same folder are saved.
+ */
+class SheetBatchExportDlg : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit SheetBatchExportDlg(sqlite3pp::database &db, QWidget *parent = nullptr);
+    ~SheetBatchExportDlg();
+
+    void done(int res) override;
+
+private slots:
+    void onChooseFolder();
+    void updateExportButton();
+    void progressMaxChanged(int max);
+    void progressChanged(int val, const QString &msg);
+    void onItemFailed(const QString &fileName, const QString &errMsg);
+    void handleProgressFinished(bool aborted, int failedCount);
+
+private:
+    void loadTree();
+    bool isTypeComplete(SheetBatch::ItemType type) const;
+
+    bool startExport();
+    void loadItems(QVector<SheetBatch::Item> &items);
+    void storeResults();
+
+private:
+    sqlite3pp::database &mDb;
+
+    QGroupBox *optionsBox;
+    QTreeWidget *itemsTree;
+    QCheckBox *incrementalCheck;
+    QLineEdit *folderEdit;
+
+    QDialogButtonBox *buttonBox;
+
+    QGroupBox *progressBox;
+    QLabel *progressLabel;
+    QProgressBar *progressBar;
+    QPlainTextEdit *errorLog;
+
+    SheetBatchExportHandler *exportHandler;
+    bool m_finished;
+
+    // Current export
+    QString m_outDir;
+    QByteArray m_fingerprint;
+    SheetExportManifest m_manifest;
+};
+
+#endif // SHEETBATCHEXPORTDLG_H
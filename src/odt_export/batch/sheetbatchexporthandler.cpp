@@ -0,0 +1,188 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetbatchexporthandler.h"
+
+#include "utils/thread/taskprogressevent.h"
+
+#include <QThread>
+#include <QThreadPool>
+
+SheetBatchExportHandler::SheetBatchExportHandler(QObject *parent) :
+    QObject(parent),
+    m_doneCount(0),
+    m_failedCount(0),
+    m_unchangedCount(0),
+    m_aborted(false),
+    isStoppingTask(false)
+{
+}
+
+SheetBatchExportHandler::~SheetBatchExportHandler()
+{
+    abortExport();
+}
+
+bool SheetBatchExportHandler::event(QEvent *e)
+{
+    if (e->type() == TaskProgressEvent::_Type)
+    {
+        TaskProgressEvent *ev = static_cast<TaskProgressEvent *>(e);
+        ev->setAccepted(true);
+
+        SheetBatchExportTask *task = static_cast<SheetBatchExportTask *>(ev->task);
+        if (!m_tasks.contains(task))
+            return true; // Old task, already cleaned up
+
+        if (ev->progress == TaskProgressEvent::ProgressFinished
+            || ev->progress == TaskProgressEvent::ProgressAbortedByUser)
+        {
+            // Task finished, delete it
+            m_tasks.removeOne(task);
+            delete task;
+
+            if (ev->progress == TaskProgressEvent::ProgressAbortedByUser)
+                m_aborted = true;
+
+            if (m_tasks.isEmpty())
+            {
+                isStoppingTask = false;
+
+                QString description;
+                if (m_aborted)
+                    description = tr("Canceled");
+                else if (m_failedCount)
+                    description = tr("Done, %1 sheets could not be saved").arg(m_failedCount);
+                else if (m_unchangedCount)
+                    description = tr("Done! %1 sheets were unchanged").arg(m_unchangedCount);
+                else
+                    description = tr("Done!");
+
+                emit progressChanged(m_doneCount, description);
+                emit progressFinished(m_aborted, m_failedCount);
+            }
+            return true;
+        }
+
+        QString description;
+        if (ev->progress == TaskProgressEvent::ProgressError)
+        {
+            // progressMax is item index or -1 if task could not even start
+            QString fileName;
+            if (ev->progressMax >= 0)
+            {
+                fileName = m_queue->items.at(ev->progressMax).fileName;
+                m_doneCount++;
+            }
+
+            m_failedCount++;
+            emit itemFailed(fileName, ev->description);
+
+            description = tr("Error saving %1").arg(fileName);
+        }
+        else
+        {
+            m_doneCount++;
+            if (m_queue->results.at(ev->progress) == SheetBatch::Result::Unchanged)
+            {
+                m_unchangedCount++;
+                description = tr("Unchanged %1").arg(ev->description);
+            }
+            else
+            {
+                description = tr("Saved %1").arg(ev->description);
+            }
+        }
+
+        if (!isStoppingTask)
+            emit progressChanged(m_doneCount, description);
+
+        return true;
+    }
+
+    return QObject::event(e);
+}
+
+void SheetBatchExportHandler::startExport(const QString &dbPath, const QString &outDir,
+                                          QSharedPointer<SheetBatch::Queue> queue, int maxThreads)
+{
+    abortExport();
+
+    m_doneCount      = 0;
+    m_failedCount    = 0;
+    m_unchangedCount = 0;
+    m_aborted        = false;
+
+    const int count  = queue->items.size();
+    emit progressMaxChanged(count);
+
+    m_queue = queue;
+    m_queue->nextIdx.storeRelease(0);
+    m_queue->newHashes.fill(QByteArray(), count);
+    m_queue->results.fill(SheetBatch::Result::Pending, count);
+
+    if (count == 0)
+    {
+        emit progressChanged(0, tr("Nothing to export"));
+        emit progressFinished(false, 0);
+        return;
+    }
+
+    if (maxThreads <= 0)
+        maxThreads = QThread::idealThreadCount();
+    const int taskCount = qBound(1, maxThreads, count);
+
+    for (int i = 0; i < taskCount; i++)
+    {
+        SheetBatchExportTask *task = new SheetBatchExportTask(dbPath, outDir, m_queue, this);
+        m_tasks.append(task);
+        QThreadPool::globalInstance()->start(task);
+    }
+
+    // Start progress
+    emit progressChanged(0, tr("Starting..."));
+}
+
+void SheetBatchExportHandler::abortExport()
+{
+    for (SheetBatchExportTask *task : qAsConst(m_tasks))
+    {
+        task->stop();
+        task->cleanup();
+    }
+    m_tasks.clear();
+    m_queue.reset();
+    isStoppingTask = false;
+}
+
+void SheetBatchExportHandler::stopTaskGracefully()
+{
+    if (m_tasks.isEmpty())
+        return;
+
+    for (SheetBatchExportTask *task : qAsConst(m_tasks))
+    {
+        task->stop();
+    }
+
+    // Wait for tasks to finish their current document
+    isStoppingTask = true;
+
+    emit progressChanged(m_doneCount, tr("Aborting..."));
+}
@@ -0,0 +1,91 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETBATCHEXPORTHANDLER_H
+#define SHEETBATCHEXPORTHANDLER_H
+
+#include <QObject>
+#include <QVector>
+
+#include "sheetbatchexporttask.h"
+
+/*!
+ * \brief The SheetBatchExportHandler class
+ *
+ * Splits a batch of sheets between multiple SheetBatchExportTask
+ * running on global thread pool and merges their progress.
+ * A failed document does not stop the batch, it's reported with itemFailed()
+ *
+ * \sa SheetBatchExportDlg
+ */
+class SheetBatchExportHandler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SheetBatchExportHandler(QObject *parent = nullptr);
+    ~SheetBatchExportHandler();
+
+    bool event(QEvent *e) override;
+
+    inline bool taskIsRunning() const
+    {
+        return !m_tasks.isEmpty();
+    }
+    inline bool waitingForTaskToStop() const
+    {
+        return isStoppingTask;
+    }
+
+    // Last started batch, read it only when tasks are not running
+    inline QSharedPointer<SheetBatch::Queue> lastBatch() const
+    {
+        return m_queue;
+    }
+
+signals:
+    void progressMaxChanged(int max);
+    void progressChanged(int val, const QString &msg);
+    void itemFailed(const QString &fileName, const QString &errMsg);
+    void progressFinished(bool aborted, int failedCount);
+
+public:
+    /*!
+     * \brief start exporting
+     * \param dbPath session database, opened read-only by each task
+     * \param outDir folder in which sheets are saved
+     * \param queue documents to export, results are stored in it
+     * \param maxThreads 0 to use QThread::idealThreadCount()
+     */
+    void startExport(const QString &dbPath, const QString &outDir,
+                     QSharedPointer<SheetBatch::Queue> queue, int maxThreads = 0);
+    void abortExport();
+    void stopTaskGracefully();
+
+private:
+    QVector<SheetBatchExportTask *> m_tasks;
+    QSharedPointer<SheetBatch::Queue> m_queue;
+
+    int m_doneCount;
+    int m_failedCount;
+    int m_unchangedCount;
+    bool m_aborted;
+    bool isStoppingTask;
+};
+
+#endif // SHEETBATCHEXPORTHANDLER_H
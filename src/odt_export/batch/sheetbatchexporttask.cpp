@@ -0,0 +1,170 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetbatchexporttask.h"
+
+#include "utils/thread/taskprogressevent.h"
+
+#include "sheetcontenthash.h"
+
+#include "odt_export/common/odtexportcontext.h"
+#include "odt_export/jobsheetexport.h"
+#include "odt_export/shiftsheetexport.h"
+#include "odt_export/stationsheetexport.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+SheetBatchExportTask::SheetBatchExportTask(const QString &dbPath, const QString &outDir,
+                                           QSharedPointer<SheetBatch::Queue> queue,
+                                           QObject *receiver) :
+    IQuittableTask(receiver),
+    m_dbPath(dbPath),
+    m_outDir(outDir),
+    m_queue(queue)
+{
+}
+
+void SheetBatchExportTask::run()
+{
+    const int count = m_queue->items.size();
+
+    database db;
+    if (db.connect(m_dbPath.toUtf8(), SQLITE_OPEN_READONLY) != SQLITE_OK)
+    {
+        const QString errMsg = tr("Cannot open database: %1").arg(db.error_msg());
+        sendEvent(new TaskProgressEvent(this, TaskProgressEvent::ProgressError, -1, errMsg),
+                  false);
+        sendEvent(new TaskProgressEvent(this, TaskProgressEvent::ProgressFinished, count), true);
+        return;
+    }
+
+    // Same settings as main connection
+    db.enable_foreign_keys(true);
+    db.enable_extended_result_codes(true);
+
+    // Share statements and styles between all documents of this task
+    // NOTE: declared after database so statements are finalized before it gets closed
+    OdtExportContext ctx(db);
+    SheetContentHash hasher(db, m_queue->salt);
+
+    SheetExportOptions::ThreadScope optionsScope(&m_queue->options);
+
+    while (true)
+    {
+        if (wasStopped())
+        {
+            sendEvent(new TaskProgressEvent(this, TaskProgressEvent::ProgressAbortedByUser, count),
+                      true);
+            return;
+        }
+
+        const int idx = m_queue->nextIdx.fetchAndAddRelaxed(1);
+        if (idx >= count)
+            break;
+
+        QString errMsg;
+        const SheetBatch::Result res = processItem(ctx, hasher, db, idx, errMsg);
+        m_queue->results[idx]        = res;
+
+        if (res == SheetBatch::Result::Failed)
+        {
+            sendEvent(new TaskProgressEvent(this, TaskProgressEvent::ProgressError, idx, errMsg),
+                      false);
+        }
+        else
+        {
+            sendEvent(new TaskProgressEvent(this, idx, count, m_queue->items.at(idx).fileName),
+                      false);
+        }
+    }
+
+    sendEvent(new TaskProgressEvent(this, TaskProgressEvent::ProgressFinished, count), true);
+}
+
+SheetBatch::Result SheetBatchExportTask::processItem(OdtExportContext &ctx,
+                                                     SheetContentHash &hasher, database &db,
+                                                     int idx, QString &errMsg)
+{
+    const SheetBatch::Item &item = m_queue->items.at(idx);
+    const QString path           = QDir(m_outDir).filePath(item.fileName);
+
+    if (m_queue->incremental && item.knownClean && QFileInfo::exists(path))
+    {
+        m_queue->newHashes[idx] = item.oldHash;
+        return SheetBatch::Result::Unchanged;
+    }
+
+    // Always calculate hash so manifest is updated also on full export
+    const QByteArray hash = hasher.hashItem(item);
+
+    if (m_queue->incremental && !item.oldHash.isEmpty() && hash == item.oldHash
+        && QFileInfo::exists(path))
+    {
+        m_queue->newHashes[idx] = hash;
+        return SheetBatch::Result::Unchanged;
+    }
+
+    if (!exportItem(ctx, db, item, path))
+    {
+        errMsg = tr("Could not save <b>%1</b>").arg(item.fileName);
+        return SheetBatch::Result::Failed;
+    }
+
+    m_queue->newHashes[idx] = hash;
+    return SheetBatch::Result::Exported;
+}
+
+bool SheetBatchExportTask::exportItem(OdtExportContext &ctx, database &db,
+                                      const SheetBatch::Item &item, const QString &path)
+{
+    bool ok = false;
+    switch (item.type)
+    {
+    case SheetBatch::ItemType::Shift:
+    {
+        ShiftSheetExport w(db, item.id);
+        w.setContext(&ctx);
+        w.write();
+        ok = w.save(path);
+        break;
+    }
+    case SheetBatch::ItemType::Station:
+    {
+        StationSheetExport w(db, item.id);
+        w.setContext(&ctx);
+        w.write();
+        ok = w.save(path);
+        break;
+    }
+    case SheetBatch::ItemType::Job:
+    {
+        JobSheetExport w(db, item.id, item.cat);
+        w.setContext(&ctx);
+        w.write();
+        ok = w.save(path);
+        break;
+    }
+    }
+
+    return ok;
+}
@@ -0,0 +1,135 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETBATCHEXPORTTASK_H
+#define SHEETBATCHEXPORTTASK_H
+
+#include "utils/thread/iquittabletask.h"
+
+#include <QCoreApplication>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+
+#include "utils/types.h"
+
+#include "odt_export/common/sheetexportoptions.h"
+
+class OdtExportContext;
+class SheetContentHash;
+
+namespace sqlite3pp {
+class database;
+}
+
+namespace SheetBatch {
+
+enum class ItemType
+{
+    Shift = 0,
+    Station,
+    Job
+};
+
+enum class Result
+{
+    Pending = 0,
+    Exported,
+    Unchanged,
+    Failed
+};
+
+struct Item
+{
+    ItemType type   = ItemType::Shift;
+    db_id id        = 0;
+    JobCategory cat = JobCategory::FREIGHT; // Only used by jobs
+    QString fileName;
+
+    QByteArray oldHash;      // Hash stored in export manifest, empty if unknown
+    bool knownClean = false; // Not changed since last export, skip hash check
+};
+
+/*!
+ * \brief The Queue struct
+ *
+ * Shared by all tasks of a batch, each task takes next item
+ * so work is balanced even if some documents are bigger than others.
+ */
+struct Queue
+{
+    QVector<Item> items;
+    QAtomicInt nextIdx;
+
+    // Skip items whose content hash matches Item::oldHash
+    bool incremental = false;
+    QByteArray salt;
+
+    // Settings copy taken on main thread, installed by each task
+    SheetExportOptions options;
+
+    // Sized as items, each task only writes entries of items it took
+    QVector<QByteArray> newHashes;
+    QVector<Result> results;
+};
+
+} // namespace SheetBatch
+
+/*!
+ * \brief The SheetBatchExportTask class
+ *
+ * Exports sheets taken from a shared SheetBatch::Queue.
+ * Each task opens its own read-only connection to session database
+ * so it never touches main thread connection.
+ * Settings are read from SheetBatch::Queue::options for the same reason.
+ *
+ * In incremental mode documents whose content hash did not change since last export
+ * and whose file still exists are not written again.
+ *
+ * For each document it sends a TaskProgressEvent with item index as progress
+ * and file name as description. If export fails progress is set to ProgressError,
+ * item index is stored in progressMax and description holds the error.
+ * Task always ends with ProgressFinished or ProgressAbortedByUser.
+ *
+ * \sa SheetBatchExportHandler
+ */
+class SheetBatchExportTask : public IQuittableTask
+{
+    Q_DECLARE_TR_FUNCTIONS(SheetBatchExportTask)
+public:
+    SheetBatchExportTask(const QString &dbPath, const QString &outDir,
+                         QSharedPointer<SheetBatch::Queue> queue, QObject *receiver);
+
+    void run() override;
+
+private:
+    SheetBatch::Result processItem(OdtExportContext &ctx, SheetContentHash &hasher,
+                                   sqlite3pp::database &db, int idx, QString &errMsg);
+    bool exportItem(OdtExportContext &ctx, sqlite3pp::database &db, const SheetBatch::Item &item,
+                    const QString &path);
+
+private:
+    QString m_dbPath;
+    QString m_outDir;
+    QSharedPointer<SheetBatch::Queue> m_queue;
+};
+
+#endif // SHEETBATCHEXPORTTASK_H
@@ -0,0 +1,262 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetcontenthash.h"
+
+#include <QCryptographicHash>
+
+#include "odt_export/common/sheetexportoptions.h"
+#include "info.h"
+
+static constexpr QCryptographicHash::Algorithm hashAlgorithm = QCryptographicHash::Sha1;
+
+// Add a prefix to tell apart different kind of items with same ID
+static inline void addTag(QCryptographicHash &h, char tag, db_id id)
+{
+    const qint64 val = id;
+    h.addData(&tag, 1);
+    h.addData(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+static inline void addString(QCryptographicHash &h, const QString &str)
+{
+    const QByteArray data = str.toUtf8();
+    const qint32 len      = data.size();
+    h.addData(reinterpret_cast<const char *>(&len), sizeof(len));
+    h.addData(data);
+}
+
+SheetContentHash::SheetContentHash(database &db, const QByteArray &salt) :
+    mDb(db),
+    m_salt(salt),
+    q_getJob(mDb, "SELECT category,shift_id FROM jobs WHERE id=?"),
+    q_getJobStops(mDb, "SELECT stops.id,stops.station_id,stations.name,"
+                       "stops.arrival,stops.departure,stops.type,stops.description,"
+                       "t1.name,t2.name,g1.track_side,g2.track_side"
+                       " FROM stops"
+                       " JOIN stations ON stations.id=stops.station_id"
+                       " LEFT JOIN station_gate_connections g1 ON g1.id=stops.in_gate_conn"
+                       " LEFT JOIN station_gate_connections g2 ON g2.id=stops.out_gate_conn"
+                       " LEFT JOIN station_tracks t1 ON t1.id=g1.track_id"
+                       " LEFT JOIN station_tracks t2 ON t2.id=g2.track_id"
+                       " WHERE stops.job_id=? ORDER BY stops.arrival"),
+    q_getJobCouplings(mDb, "SELECT coupling.stop_id,coupling.operation,coupling.rs_id,"
+                           "rs_list.number,rs_models.name,rs_models.suffix,rs_models.type,"
+                           "rs_models.axes"
+                           " FROM coupling"
+                           " JOIN stops ON stops.id=coupling.stop_id"
+                           " JOIN rs_list ON rs_list.id=coupling.rs_id"
+                           " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
+                           " WHERE stops.job_id=?"
+                           " ORDER BY stops.arrival,coupling.operation,coupling.rs_id"),
+    q_getJobPassings(mDb, "SELECT s1.id,s2.job_id,jobs.category,s2.arrival,s2.departure"
+                          " FROM stops s1"
+                          " JOIN stops s2 ON s2.station_id=s1.station_id"
+                          " AND s2.departure>=s1.arrival AND s2.arrival<=s1.departure"
+                          " AND s2.job_id<>s1.job_id"
+                          " JOIN jobs ON jobs.id=s2.job_id"
+                          " WHERE s1.job_id=? ORDER BY s1.arrival,s2.job_id"),
+    q_getShift(mDb, "SELECT name FROM jobshifts WHERE id=?"),
+    q_getShiftJobs(mDb, "SELECT jobs.id,MIN(s1.arrival)"
+                        " FROM jobs"
+                        " JOIN stops s1 ON s1.job_id=jobs.id"
+                        " WHERE jobs.shift_id=?"
+                        " GROUP BY jobs.id"
+                        " ORDER BY s1.arrival ASC"),
+    q_getStation(mDb, "SELECT name,short_name FROM stations WHERE id=?"),
+    q_getStationStops(mDb, "SELECT stops.id,stops.job_id,jobs.category,"
+                           "stops.arrival,stops.departure,stops.type,stops.description,"
+                           "t1.name,t2.name,g1.track_side,g2.track_side,"
+                           "(SELECT st.name FROM stops p JOIN stations st ON st.id=p.station_id"
+                           " WHERE p.job_id=stops.job_id AND p.departure<stops.arrival"
+                           " ORDER BY p.departure DESC LIMIT 1),"
+                           "(SELECT st.name FROM stops n JOIN stations st ON st.id=n.station_id"
+                           " WHERE n.job_id=stops.job_id AND n.arrival>stops.arrival"
+                           " ORDER BY n.arrival LIMIT 1)"
+                           " FROM stops"
+                           " JOIN jobs ON jobs.id=stops.job_id"
+                           " LEFT JOIN station_gate_connections g1 ON g1.id=stops.in_gate_conn"
+                           " LEFT JOIN station_gate_connections g2 ON g2.id=stops.out_gate_conn"
+                           " LEFT JOIN station_tracks t1 ON t1.id=g1.track_id"
+                           " LEFT JOIN station_tracks t2 ON t2.id=g2.track_id"
+                           " WHERE stops.station_id=?"
+                           " ORDER BY stops.arrival,stops.job_id"),
+    q_getStationCouplings(mDb, "SELECT coupling.stop_id,coupling.operation,coupling.rs_id,"
+                               "rs_list.number,rs_models.name,rs_models.suffix,rs_models.type"
+                               " FROM coupling"
+                               " JOIN stops ON stops.id=coupling.stop_id"
+                               " JOIN rs_list ON rs_list.id=coupling.rs_id"
+                               " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
+                               " WHERE stops.station_id=?"
+                               " ORDER BY stops.arrival,stops.job_id,coupling.operation,"
+                               "coupling.rs_id")
+{
+}
+
+QByteArray SheetContentHash::hashItem(const SheetBatch::Item &item)
+{
+    QCryptographicHash h(hashAlgorithm);
+    h.addData(m_salt);
+
+    switch (item.type)
+    {
+    case SheetBatch::ItemType::Shift:
+        addShift(h, item.id);
+        break;
+    case SheetBatch::ItemType::Station:
+        addStation(h, item.id);
+        break;
+    case SheetBatch::ItemType::Job:
+        addJob(h, item.id);
+        break;
+    }
+
+    return h.result();
+}
+
+QByteArray SheetContentHash::calcGlobalSalt(database &db, const SheetExportOptions &options)
+{
+    QCryptographicHash h(hashAlgorithm);
+
+    addString(h, AppVersion);
+    addString(h, options.locale.bcp47Name());
+
+    // Used when not set in metadata
+    addString(h, options.header);
+    addString(h, options.footer);
+    addTag(h, 'L', options.storeLocationDateInMeta);
+
+    // Meeting information, logo picture, header and footer
+    query q(db, "SELECT name,val FROM metadata ORDER BY name");
+    addRows(h, q);
+
+    return h.result();
+}
+
+QByteArray SheetContentHash::calcRollingstockFingerprint(database &db)
+{
+    QCryptographicHash h(hashAlgorithm);
+
+    query q(db, "SELECT id,model_id,number FROM rs_list ORDER BY id");
+    addRows(h, q);
+
+    q.prepare("SELECT id,name,suffix,type,axes FROM rs_models ORDER BY id");
+    addRows(h, q);
+
+    return h.result();
+}
+
+void SheetContentHash::addJob(QCryptographicHash &h, db_id jobId)
+{
+    addTag(h, 'J', jobId);
+
+    q_getJob.bind(1, jobId);
+    addRows(h, q_getJob);
+
+    q_getJobStops.bind(1, jobId);
+    addRows(h, q_getJobStops);
+
+    q_getJobCouplings.bind(1, jobId);
+    addRows(h, q_getJobCouplings);
+
+    q_getJobPassings.bind(1, jobId);
+    addRows(h, q_getJobPassings);
+}
+
+void SheetContentHash::addShift(QCryptographicHash &h, db_id shiftId)
+{
+    addTag(h, 'S', shiftId);
+
+    q_getShift.bind(1, shiftId);
+    addRows(h, q_getShift);
+
+    // Shift sheet contains full sheet of each job, in this order
+    QVector<db_id> jobs;
+    q_getShiftJobs.bind(1, shiftId);
+    for (auto r : q_getShiftJobs)
+    {
+        jobs.append(r.get<db_id>(0));
+    }
+    q_getShiftJobs.reset();
+
+    for (db_id jobId : qAsConst(jobs))
+    {
+        addJob(h, jobId);
+    }
+}
+
+void SheetContentHash::addStation(QCryptographicHash &h, db_id stationId)
+{
+    addTag(h, 'T', stationId);
+
+    q_getStation.bind(1, stationId);
+    addRows(h, q_getStation);
+
+    q_getStationStops.bind(1, stationId);
+    addRows(h, q_getStationStops);
+
+    q_getStationCouplings.bind(1, stationId);
+    addRows(h, q_getStationCouplings);
+}
+
+void SheetContentHash::addRows(QCryptographicHash &h, query &q)
+{
+    sqlite3_stmt *stmt = q.stmt();
+    const int nCols    = sqlite3_column_count(stmt);
+
+    while (q.step() == SQLITE_ROW)
+    {
+        for (int i = 0; i < nCols; i++)
+        {
+            // Store type so NULL, 0 and empty text give different hashes
+            const char type = char(sqlite3_column_type(stmt, i));
+            h.addData(&type, 1);
+
+            switch (type)
+            {
+            case SQLITE_INTEGER:
+            {
+                const qint64 val = sqlite3_column_int64(stmt, i);
+                h.addData(reinterpret_cast<const char *>(&val), sizeof(val));
+                break;
+            }
+            case SQLITE_FLOAT:
+            {
+                const double val = sqlite3_column_double(stmt, i);
+                h.addData(reinterpret_cast<const char *>(&val), sizeof(val));
+                break;
+            }
+            case SQLITE_TEXT:
+            case SQLITE_BLOB:
+            {
+                const char *data = reinterpret_cast<const char *>(sqlite3_column_blob(stmt, i));
+                const qint32 len = sqlite3_column_bytes(stmt, i);
+                h.addData(reinterpret_cast<const char *>(&len), sizeof(len));
+                if (len > 0)
+                    h.addData(data, len);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    q.reset();
+}
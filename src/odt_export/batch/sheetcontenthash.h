@@ -0,0 +1,80 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETCONTENTHASH_H
+#define SHEETCONTENTHASH_H
+
+#include <QByteArray>
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+#include "sheetbatchexporttask.h"
+
+class QCryptographicHash;
+
+struct SheetExportOptions;
+
+/*!
+ * \brief The SheetContentHash class
+ *
+ * Calculates a hash of all rows a sheet is generated from,
+ * so unchanged sheets can be skipped on next export.
+ * Hash includes a salt which covers settings and metadata shared by all sheets.
+ *
+ * \sa SheetExportManifest
+ */
+class SheetContentHash
+{
+public:
+    SheetContentHash(database &db, const QByteArray &salt);
+
+    QByteArray hashItem(const SheetBatch::Item &item);
+
+    // Sheet header/footer, meeting information, logo, locale and program version
+    static QByteArray calcGlobalSalt(database &db, const SheetExportOptions &options);
+
+    // Rollingstock names can change without notification, see SheetExportTracker
+    static QByteArray calcRollingstockFingerprint(database &db);
+
+private:
+    void addJob(QCryptographicHash &h, db_id jobId);
+    void addShift(QCryptographicHash &h, db_id shiftId);
+    void addStation(QCryptographicHash &h, db_id stationId);
+
+    static void addRows(QCryptographicHash &h, query &q);
+
+private:
+    database &mDb;
+    QByteArray m_salt;
+
+    query q_getJob;
+    query q_getJobStops;
+    query q_getJobCouplings;
+    query q_getJobPassings;
+
+    query q_getShift;
+    query q_getShiftJobs;
+
+    query q_getStation;
+    query q_getStationStops;
+    query q_getStationCouplings;
+};
+
+#endif // SHEETCONTENTHASH_H
@@ -0,0 +1,121 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetexportmanifest.h"
+
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <QDebug>
+
+const QString SheetExportManifest::FileName = QStringLiteral(".sheets_manifest.json");
+
+static constexpr int ManifestVersion = 2;
+
+SheetExportManifest::SheetExportManifest()
+{
+}
+
+bool SheetExportManifest::load(const QString &dirPath)
+{
+    m_sheets.clear();
+
+    QFile f(QDir(dirPath).filePath(FileName));
+    if (!f.open(QFile::ReadOnly))
+        return false;
+
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll(), &err);
+    if (err.error != QJsonParseError::NoError || !doc.isObject())
+    {
+        qWarning() << "SheetExportManifest: invalid manifest" << err.errorString();
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != ManifestVersion)
+        return false; // Hashes of other versions cannot be compared
+
+    const QJsonObject sheets = root.value("sheets").toObject();
+    for (auto it = sheets.constBegin(); it != sheets.constEnd(); it++)
+    {
+        const QJsonObject obj = it.value().toObject();
+        const int type        = obj.value("type").toInt(-1);
+        if (type < int(SheetBatch::ItemType::Shift) || type > int(SheetBatch::ItemType::Job))
+            continue;
+
+        Sheet sheet;
+        sheet.hash = QByteArray::fromHex(obj.value("hash").toString().toLatin1());
+        sheet.type = SheetBatch::ItemType(type);
+        if (!sheet.hash.isEmpty())
+            m_sheets.insert(it.key(), sheet);
+    }
+
+    return true;
+}
+
+bool SheetExportManifest::save(const QString &dirPath) const
+{
+    QJsonObject sheets;
+    for (auto it = m_sheets.constBegin(); it != m_sheets.constEnd(); it++)
+    {
+        QJsonObject obj;
+        obj.insert("hash", QString::fromLatin1(it->hash.toHex()));
+        obj.insert("type", int(it->type));
+        sheets.insert(it.key(), obj);
+    }
+
+    QJsonObject root;
+    root.insert("version", ManifestVersion);
+    root.insert("sheets", sheets);
+
+    // Replace old manifest only if new one was written completely
+    QSaveFile f(QDir(dirPath).filePath(FileName));
+    if (!f.open(QFile::WriteOnly))
+    {
+        qWarning() << "SheetExportManifest: cannot save manifest" << f.errorString();
+        return false;
+    }
+
+    f.write(QJsonDocument(root).toJson());
+    return f.commit();
+}
+
+QStringList SheetExportManifest::takeStaleFiles(SheetBatch::ItemType type,
+                                                const QSet<QString> &current)
+{
+    QStringList stale;
+    for (auto it = m_sheets.begin(); it != m_sheets.end();)
+    {
+        if (it->type == type && !current.contains(it.key()))
+        {
+            stale.append(it.key());
+            it = m_sheets.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+    return stale;
+}
@@ -0,0 +1,86 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETEXPORTMANIFEST_H
+#define SHEETEXPORTMANIFEST_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+#include "sheetbatchexporttask.h"
+
+/*!
+ * \brief The SheetExportManifest class
+ *
+ * Stores content hash and type of each sheet saved in an export folder.
+ * It's saved as a JSON file in the same folder so it follows the sheets
+ * if the folder is moved or shared.
+ * Type is used to find sheets of items which were removed from session.
+ *
+ * \sa SheetContentHash
+ */
+class SheetExportManifest
+{
+public:
+    static const QString FileName;
+
+    SheetExportManifest();
+
+    // Returns false if manifest is missing or invalid, manifest is then empty
+    bool load(const QString &dirPath);
+    bool save(const QString &dirPath) const;
+
+    inline QByteArray getHash(const QString &fileName) const
+    {
+        return m_sheets.value(fileName).hash;
+    }
+
+    inline void setHash(const QString &fileName, SheetBatch::ItemType type,
+                        const QByteArray &hash)
+    {
+        m_sheets.insert(fileName, {hash, type});
+    }
+
+    inline void removeHash(const QString &fileName)
+    {
+        m_sheets.remove(fileName);
+    }
+
+    /*!
+     * rief take stale files
+     * \param type sheet type which was exported completely
+     * \param current file names of all items of this type in session
+     * eturn files of this type not in  current, their entries are removed
+     */
+    QStringList takeStaleFiles(SheetBatch::ItemType type, const QSet<QString> &current);
+
+private:
+    struct Sheet
+    {
+        QByteArray hash;
+        SheetBatch::ItemType type = SheetBatch::ItemType::Shift;
+    };
+
+    QHash<QString, Sheet> m_sheets;
+};
+
+#endif // SHEETEXPORTMANIFEST_H
@@ -0,0 +1,183 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetexporttracker.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+SheetExportTracker::SheetExportTracker(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void SheetExportTracker::collectChanges(database &db)
+{
+    QSet<db_id> jobs     = m_jobs;
+    QSet<db_id> stations = m_stations;
+    QSet<db_id> shifts   = m_shifts;
+
+    // Rollingstock names are shown where items are coupled or uncoupled
+    query q(db, "SELECT stops.job_id,stops.station_id FROM coupling"
+                " JOIN stops ON stops.id=coupling.stop_id"
+                " WHERE coupling.rs_id=?");
+    for (db_id rsId : qAsConst(m_rollingstock))
+    {
+        q.bind(1, rsId);
+        for (auto r : q)
+        {
+            jobs.insert(r.get<db_id>(0));
+            stations.insert(r.get<db_id>(1));
+        }
+        q.reset();
+    }
+
+    // Job sheets show crossings and passings in their stations
+    q.prepare("SELECT DISTINCT job_id FROM stops WHERE station_id=?");
+    for (db_id stationId : qAsConst(stations))
+    {
+        q.bind(1, stationId);
+        for (auto r : q)
+        {
+            jobs.insert(r.get<db_id>(0));
+        }
+        q.reset();
+    }
+
+    // Station sheets show jobs stopping there with previous and next station
+    q.prepare("SELECT DISTINCT station_id FROM stops WHERE job_id=?");
+    for (db_id jobId : qAsConst(jobs))
+    {
+        q.bind(1, jobId);
+        for (auto r : q)
+        {
+            stations.insert(r.get<db_id>(0));
+        }
+        q.reset();
+    }
+
+    // Shift sheets contain their jobs
+    q.prepare("SELECT shift_id FROM jobs WHERE id=? AND shift_id IS NOT NULL");
+    for (db_id jobId : qAsConst(jobs))
+    {
+        q.bind(1, jobId);
+        if (q.step() == SQLITE_ROW)
+            shifts.insert(q.getRows().get<db_id>(0));
+        q.reset();
+    }
+
+    m_state[int(SheetBatch::ItemType::Shift)].dirty.unite(shifts);
+    m_state[int(SheetBatch::ItemType::Station)].dirty.unite(stations);
+    m_state[int(SheetBatch::ItemType::Job)].dirty.unite(jobs);
+
+    m_shifts.clear();
+    m_jobs.clear();
+    m_stations.clear();
+    m_rollingstock.clear();
+}
+
+bool SheetExportTracker::isKnownClean(SheetBatch::ItemType type, db_id id, const QString &outDir,
+                                      const QByteArray &fingerprint) const
+{
+    const TypeState &state = m_state[int(type)];
+    if (state.cleanDir.isEmpty() || state.cleanDir != outDir)
+        return false;
+
+    if (state.fingerprint != fingerprint)
+        return false; // Something changed without notification
+
+    return !state.dirty.contains(id);
+}
+
+void SheetExportTracker::markExported(SheetBatch::ItemType type, const QString &outDir,
+                                      const QByteArray &fingerprint, const QSet<db_id> &notExported)
+{
+    TypeState &state  = m_state[int(type)];
+    state.cleanDir    = outDir;
+    state.fingerprint = fingerprint;
+    state.dirty       = notExported;
+}
+
+void SheetExportTracker::clear()
+{
+    for (TypeState &state : m_state)
+    {
+        state = TypeState();
+    }
+
+    m_shifts.clear();
+    m_jobs.clear();
+    m_stations.clear();
+    m_rollingstock.clear();
+}
+
+void SheetExportTracker::markShift(db_id shiftId)
+{
+    m_shifts.insert(shiftId);
+}
+
+void SheetExportTracker::onShiftJobsChanged(db_id shiftId, db_id jobId)
+{
+    m_shifts.insert(shiftId);
+    m_jobs.insert(jobId);
+}
+
+void SheetExportTracker::markJob(db_id jobId)
+{
+    m_jobs.insert(jobId);
+}
+
+void SheetExportTracker::onJobChanged(db_id jobId, db_id oldJobId)
+{
+    m_jobs.insert(jobId);
+    if (oldJobId != jobId)
+        m_jobs.insert(oldJobId);
+}
+
+void SheetExportTracker::onJobRemoved(db_id jobId)
+{
+    if (jobId == 0)
+    {
+        // Stations and shifts are not notified, check everything against manifest
+        clear();
+        return;
+    }
+
+    m_jobs.insert(jobId);
+}
+
+void SheetExportTracker::markStation(db_id stationId)
+{
+    m_stations.insert(stationId);
+}
+
+void SheetExportTracker::markStations(const QSet<db_id> &stationIds)
+{
+    m_stations.unite(stationIds);
+}
+
+void SheetExportTracker::markRollingstock(db_id rsId)
+{
+    m_rollingstock.insert(rsId);
+}
+
+void SheetExportTracker::markRollingstockSet(const QSet<db_id> &rsIds)
+{
+    m_rollingstock.unite(rsIds);
+}
@@ -0,0 +1,111 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETEXPORTTRACKER_H
+#define SHEETEXPORTTRACKER_H
+
+#include <QObject>
+#include <QSet>
+
+#include "sheetbatchexporttask.h"
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The SheetExportTracker class
+ *
+ * Records changes notified by MeetingSession between two sheet exports.
+ * Items not changed since last export in the same folder are known clean
+ * so incremental export can skip them without calculating content hash.
+ *
+ * Tracking is only valid in current session, after opening a file
+ * all items are unknown and get checked against export manifest.
+ * Settings, metadata and rollingstock renames are not notified, so a fingerprint
+ * of them is stored on export and tracker is not trusted if it changes.
+ *
+ * \sa MeetingSession::getSheetExportTracker()
+ * \sa SheetContentHash
+ */
+class SheetExportTracker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SheetExportTracker(QObject *parent = nullptr);
+
+    /*!
+     * \brief collect changes
+     * \param db session database
+     *
+     * Expands changes recorded so far to all affected sheets.
+     * A stop change affects sheets of its station, its job and jobs passing in same station.
+     * Must be called before checking items for a new export.
+     */
+    void collectChanges(sqlite3pp::database &db);
+
+    bool isKnownClean(SheetBatch::ItemType type, db_id id, const QString &outDir,
+                      const QByteArray &fingerprint) const;
+
+    /*!
+     * \brief mark exported
+     * \param type all items of this type were checked
+     * \param outDir export folder
+     * \param fingerprint fingerprint of data not notified at export time
+     * \param notExported items which failed or were not processed
+     */
+    void markExported(SheetBatch::ItemType type, const QString &outDir,
+                      const QByteArray &fingerprint, const QSet<db_id> &notExported);
+
+public slots:
+    void clear();
+
+    void markShift(db_id shiftId);
+    void onShiftJobsChanged(db_id shiftId, db_id jobId);
+
+    void markJob(db_id jobId);
+    void onJobChanged(db_id jobId, db_id oldJobId);
+
+    // Job ID 0 means all jobs were removed
+    void onJobRemoved(db_id jobId);
+
+    void markStation(db_id stationId);
+    void markStations(const QSet<db_id> &stationIds);
+
+    void markRollingstock(db_id rsId);
+    void markRollingstockSet(const QSet<db_id> &rsIds);
+
+private:
+    struct TypeState
+    {
+        QString cleanDir; // Empty if never exported
+        QByteArray fingerprint;
+        QSet<db_id> dirty;
+    };
+
+    TypeState m_state[3]; // Indexed by SheetBatch::ItemType
+
+    // Raw changes, not yet expanded
+    QSet<db_id> m_shifts;
+    QSet<db_id> m_jobs;
+    QSet<db_id> m_stations;
+    QSet<db_id> m_rollingstock;
+};
+
+#endif // SHEETEXPORTTRACKER_H
@@ -132,7 +132,12 @@ JobWriter::JobWriter(database &db) :
                             " FROM coupling"
                             " JOIN rs_list ON rs_list.id=coupling.rs_id"
                             " JOIN rs_models ON rs_models.id=rs_list.model_id"
-                            " WHERE coupling.stop_id=? AND coupling.operation=?")
+                            " WHERE coupling.stop_id=? AND coupling.operation=?"),
+
+    q_getRSInfo(mDb, "SELECT rs_list.number,rs_models.name,rs_models.suffix,rs_models.type"
+                     " FROM rs_list"
+                     " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
+                     " WHERE rs_list.id=?")
 {
 }
 
@@ -563,11 +568,6 @@ void JobWriter::writeJobStyles(QXmlStreamWriter &xml)
 
 void JobWriter::writeJob(QXmlStreamWriter &xml, db_id jobId, JobCategory jobCat)
 {
-    query q_getRSInfo(mDb, "SELECT rs_list.number,rs_models.name,rs_models.suffix,rs_models.type"
-                           " FROM rs_list"
-                           " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
-                           " WHERE rs_list.id=?");
-
     QList<QPair<QString, QList<db_id>>> stopsRS;
 
     // Title
@@ -961,6 +961,7 @@ void JobWriter::writeJob(QXmlStreamWriter &xml, db_id jobId, JobCategory jobCat)
             if (i < s.second.size() - 1)
                 xml.writeCharacters(" + ");
         }
+        q_getRSInfo.reset();
         writeCellListEnd(xml);
 
         xml.writeEndElement(); // end of row
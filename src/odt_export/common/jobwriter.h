@@ -46,6 +46,7 @@ private:
     query q_initialJobAxes;
     query q_selectPassings;
     query q_getStopCouplings;
+    query q_getRSInfo;
 };
 
 #endif // JOBWRITER_H
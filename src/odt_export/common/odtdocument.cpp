@@ -30,6 +30,7 @@
 #include "db_metadata/metadatamanager.h"
 
 #include "odtutils.h"
+#include "sheetexportoptions.h"
 
 // content.xml
 static constexpr char contentFileStr[] = "content.xml";
@@ -46,31 +47,142 @@ static constexpr char metaFileStr[]         = "meta.xml";
 static constexpr QLatin1String metaFileName = QLatin1String(metaFileStr, sizeof(metaFileStr) - 1);
 
 // META-INF/manifest.xml
-static constexpr char manifestFileNameStr[] = "manifest.xml";
-static constexpr QLatin1String manifestFileName =
-  QLatin1String(manifestFileNameStr, sizeof(manifestFileNameStr) - 1);
-static constexpr char metaInfPathStr[] = "/META-INF";
-static constexpr QLatin1String metaInfDirPath =
-  QLatin1String(metaInfPathStr, sizeof(metaInfPathStr) - 1);
 static constexpr char manifestFilePathStr[] = "META-INF/manifest.xml";
 static constexpr QLatin1String manifestFilePath =
   QLatin1String(manifestFilePathStr, sizeof(manifestFilePathStr) - 1);
 
-OdtDocument::OdtDocument()
+// Adds an entry to zip, data must stay valid until zip is closed
+static bool addZipEntry(zip_t *zipper, const char *name, const char *data, qint64 size)
 {
+    zip_source_t *source = zip_source_buffer(zipper, data, zip_uint64_t(size), 0);
+    if (source == nullptr)
+    {
+        qDebug() << "Failed to add file to zip:" << name << zip_strerror(zipper);
+        return false;
+    }
+
+    if (zip_file_add(zipper, name, source, ZIP_FL_ENC_UTF_8) < 0)
+    {
+        zip_source_free(source);
+        qDebug() << "Failed to add file to zip:" << name << zip_strerror(zipper);
+        return false;
+    }
+
+    return true;
 }
 
-bool OdtDocument::initDocument()
+static inline bool addZipEntry(zip_t *zipper, const char *name, const QByteArray &data)
+{
+    return addZipEntry(zipper, name, data.constData(), data.size());
+}
+
+struct DeviceSourceData
+{
+    QIODevice *dev;
+    zip_error_t error;
+};
+
+// Lets libzip pull entry data from a QIODevice while compressing
+static zip_int64_t deviceSourceCallback(void *userdata, void *data, zip_uint64_t len,
+                                        zip_source_cmd_t cmd)
 {
-    if (!dir.isValid())
+    DeviceSourceData *ctx = static_cast<DeviceSourceData *>(userdata);
+
+    switch (cmd)
+    {
+    case ZIP_SOURCE_OPEN:
+    {
+        if (!ctx->dev->seek(0))
+        {
+            zip_error_set(&ctx->error, ZIP_ER_SEEK, 0);
+            return -1;
+        }
+        return 0;
+    }
+    case ZIP_SOURCE_READ:
+    {
+        const qint64 ret = ctx->dev->read(static_cast<char *>(data), qint64(len));
+        if (ret < 0)
+        {
+            // Device returns -1 also at end of data
+            if (ctx->dev->atEnd())
+                return 0;
+
+            zip_error_set(&ctx->error, ZIP_ER_READ, 0);
+            return -1;
+        }
+        return ret;
+    }
+    case ZIP_SOURCE_CLOSE:
+        return 0;
+    case ZIP_SOURCE_STAT:
+    {
+        zip_stat_t *st = static_cast<zip_stat_t *>(data);
+        zip_stat_init(st);
+        st->size = zip_uint64_t(ctx->dev->size());
+        st->valid |= ZIP_STAT_SIZE;
+        return sizeof(zip_stat_t);
+    }
+    case ZIP_SOURCE_ERROR:
+        return zip_error_to_data(&ctx->error, data, len);
+    case ZIP_SOURCE_FREE:
+    {
+        zip_error_fini(&ctx->error);
+        delete ctx;
+        return 0;
+    }
+    case ZIP_SOURCE_SUPPORTS:
+        return zip_source_make_command_bitmap(ZIP_SOURCE_OPEN, ZIP_SOURCE_READ, ZIP_SOURCE_CLOSE,
+                                              ZIP_SOURCE_STAT, ZIP_SOURCE_ERROR, ZIP_SOURCE_FREE,
+                                              -1);
+    default:
+        break;
+    }
+
+    zip_error_set(&ctx->error, ZIP_ER_INVAL, 0);
+    return -1;
+}
+
+// Adds an entry to zip, device must stay valid until zip is closed
+static bool addZipEntry(zip_t *zipper, const char *name, QIODevice *dev)
+{
+    DeviceSourceData *ctx = new DeviceSourceData;
+    ctx->dev              = dev;
+    zip_error_init(&ctx->error);
+
+    zip_source_t *source = zip_source_function(zipper, deviceSourceCallback, ctx);
+    if (source == nullptr)
+    {
+        zip_error_fini(&ctx->error);
+        delete ctx;
+        qDebug() << "Failed to add file to zip:" << name << zip_strerror(zipper);
         return false;
+    }
 
-    content.setFileName(dir.filePath(contentFileName));
-    if (!content.open(QFile::WriteOnly | QFile::Truncate))
+    // From now on context is freed by source
+    if (zip_file_add(zipper, name, source, ZIP_FL_ENC_UTF_8) < 0)
+    {
+        zip_source_free(source);
+        qDebug() << "Failed to add file to zip:" << name << zip_strerror(zipper);
         return false;
+    }
 
-    styles.setFileName(dir.filePath(stylesFileName));
-    if (!styles.open(QFile::WriteOnly | QFile::Truncate))
+    return true;
+}
+
+OdtDocument::OdtDocument(sqlite3pp::database &db) :
+    mDb(db)
+{
+}
+
+bool OdtDocument::initDocument()
+{
+    content.setData(QByteArray());
+    if (!content.open(QIODevice::WriteOnly))
+        return false;
+
+    styles.setData(QByteArray());
+    if (!styles.open(QIODevice::WriteOnly))
         return false;
 
     contentXml.setDevice(&content);
@@ -127,102 +239,43 @@ bool OdtDocument::saveTo(const QString &fileName)
         return false;
     }
 
-    // Add mimetype file NOTE: must be the first file in archive
+    // Add mimetype file NOTE: must be the first file in archive and must not be compressed
     const char mimetype[] = "application/vnd.oasis.opendocument.text";
-    zip_source_t *source  = zip_source_buffer(zipper, mimetype, sizeof(mimetype) - 1, 0);
-    if (source == nullptr)
-    {
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    if (zip_file_add(zipper, "mimetype", source, ZIP_FL_ENC_UTF_8) < 0)
-    {
-        zip_source_free(source);
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    // Add META-INF/manifest.xml
-    QString fileToCompress = dir.filePath(manifestFilePath);
-
-    source                 = zip_source_file(zipper, fileToCompress.toUtf8(), 0, 0);
-    if (source == nullptr)
-    {
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    if (zip_file_add(zipper, manifestFilePath.data(), source, ZIP_FL_ENC_UTF_8) < 0)
-    {
-        zip_source_free(source);
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    // Add styles.xml
-    fileToCompress = dir.filePath(stylesFileName);
-
-    source         = zip_source_file(zipper, fileToCompress.toUtf8(), 0, 0);
-    if (source == nullptr)
-    {
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    if (zip_file_add(zipper, stylesFileName.data(), source, ZIP_FL_ENC_UTF_8) < 0)
-    {
-        zip_source_free(source);
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    // Add content.xml
-    fileToCompress = dir.filePath(contentFileName);
-
-    source         = zip_source_file(zipper, fileToCompress.toUtf8(), 0, 0);
-    if (source == nullptr)
-    {
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    if (zip_file_add(zipper, contentFileName.data(), source, ZIP_FL_ENC_UTF_8) < 0)
-    {
-        zip_source_free(source);
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
-
-    // Add meta.xml
-    fileToCompress = dir.filePath(metaFileName);
+    bool ok               = addZipEntry(zipper, "mimetype", mimetype, sizeof(mimetype) - 1);
+    if (ok)
+        zip_set_file_compression(zipper, 0, ZIP_CM_STORE, 0);
 
-    source         = zip_source_file(zipper, fileToCompress.toUtf8(), 0, 0);
-    if (source == nullptr)
-    {
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-    }
+    // Entries are read from memory buffers only when zip gets closed
+    ok = ok && addZipEntry(zipper, manifestFilePath.data(), manifestData);
+    ok = ok && addZipEntry(zipper, stylesFileName.data(), styles.data());
+    ok = ok && addZipEntry(zipper, contentFileName.data(), content.data());
+    ok = ok && addZipEntry(zipper, metaFileName.data(), metaData);
 
-    if (zip_file_add(zipper, metaFileName.data(), source, ZIP_FL_ENC_UTF_8) < 0)
+    // Add possible images
+    const QString imgBasePath = QLatin1String("Pictures/%1");
+    for (const Image &img : qAsConst(imageList))
     {
-        zip_source_free(source);
-        qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
+        if (!ok)
+            break;
+        const QByteArray imgPath = imgBasePath.arg(img.fileName).toUtf8();
+        if (img.device)
+            ok = addZipEntry(zipper, imgPath, img.device.data());
+        else
+            ok = addZipEntry(zipper, imgPath, img.data);
     }
 
-    // Add possible images
-    QString imgBasePath    = dir.filePath("Pictures") + QLatin1String("/%1");
-    QString imgNewBasePath = QLatin1String("Pictures/%1");
-    for (const auto &img : qAsConst(imageList))
+    if (!ok)
     {
-        source = zip_source_file(zipper, imgBasePath.arg(img.first).toUtf8(), 0, 0);
-        if (source == nullptr)
-        {
-            qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-        }
-
-        if (zip_file_add(zipper, imgNewBasePath.arg(img.first).toUtf8(), source, ZIP_FL_ENC_UTF_8)
-            < 0)
-        {
-            zip_source_free(source);
-            qDebug() << "Failed to add file to zip:" << zip_strerror(zipper);
-        }
+        // Do not leave a broken file
+        zip_discard(zipper);
+        return false;
     }
 
     if (zip_close(zipper) != 0)
     {
         qDebug() << "Failed to close zip:" << zip_strerror(zipper);
+        zip_discard(zipper);
+        return false;
     }
 
     return true;
@@ -230,8 +283,8 @@ bool OdtDocument::saveTo(const QString &fileName)
 
 void OdtDocument::endDocument()
 {
-    saveManifest(dir.path());
-    saveMeta(dir.path());
+    saveManifest();
+    saveMeta();
 
     contentXml.writeEndDocument();
     content.close();
@@ -240,17 +293,14 @@ void OdtDocument::endDocument()
     styles.close();
 }
 
-QString OdtDocument::addImage(const QString &name, const QString &mediaType)
+void OdtDocument::addImage(const QString &name, const QString &mediaType, const QByteArray &data)
 {
-    if (imageList.isEmpty())
-    {
-        // First image added, create Pictures folder
-        QDir pictures(dir.path());
-        if (!pictures.mkdir("Pictures"))
-            qWarning() << "OdtDocument: cannot create Pictures folder";
-    }
-    imageList.append({name, mediaType});
-    return dir.filePath("Pictures/" + name);
+    imageList.append({name, mediaType, data, QSharedPointer<QIODevice>()});
+}
+
+void OdtDocument::addImage(const QString &name, const QString &mediaType, QIODevice *device)
+{
+    imageList.append({name, mediaType, QByteArray(), QSharedPointer<QIODevice>(device)});
 }
 
 void OdtDocument::writeStartDoc(QXmlStreamWriter &xml)
@@ -270,17 +320,12 @@ void OdtDocument::writeFileEntry(QXmlStreamWriter &xml, const QString &fullPath,
     xml.writeEndElement();
 }
 
-void OdtDocument::saveManifest(const QString &path)
+void OdtDocument::saveManifest()
 {
     const QString xmlMime = QLatin1String("text/xml");
 
-    QDir manifestDir(path + metaInfDirPath);
-    if (!manifestDir.exists())
-        manifestDir.mkpath(".");
-
-    QFile manifest(manifestDir.filePath(manifestFileName));
-    manifest.open(QFile::WriteOnly | QFile::Truncate);
-    QXmlStreamWriter xml(&manifest);
+    manifestData.clear();
+    QXmlStreamWriter xml(&manifestData);
     writeStartDoc(xml);
 
     xml.writeStartElement("manifest:manifest");
@@ -300,9 +345,9 @@ void OdtDocument::saveManifest(const QString &path)
     writeFileEntry(xml, metaFileName, xmlMime);
 
     // Add possible images
-    for (const auto &img : qAsConst(imageList))
+    for (const Image &img : qAsConst(imageList))
     {
-        writeFileEntry(xml, "Pictures/" + img.first, img.second);
+        writeFileEntry(xml, "Pictures/" + img.fileName, img.mediaType);
     }
 
     xml.writeEndElement(); // manifest:manifest
@@ -310,13 +355,10 @@ void OdtDocument::saveManifest(const QString &path)
     xml.writeEndDocument();
 }
 
-void OdtDocument::saveMeta(const QString &path)
+void OdtDocument::saveMeta()
 {
-    QDir metaDir(path);
-
-    QFile metaFile(metaDir.filePath(metaFileName));
-    metaFile.open(QFile::WriteOnly | QFile::Truncate);
-    QXmlStreamWriter xml(&metaFile);
+    metaData.clear();
+    QXmlStreamWriter xml(&metaData);
     writeStartDoc(xml);
 
     xml.writeStartElement("office:document-meta");
@@ -329,8 +371,8 @@ void OdtDocument::saveMeta(const QString &path)
 
     xml.writeStartElement("office:meta");
 
-    MetaDataManager *meta           = Session->getMetaDataManager();
-    const bool storeLocationAndDate = AppSettings.getSheetStoreLocationDateInMeta();
+    MetaDataManager meta(mDb);
+    const SheetExportOptions options = SheetExportOptions::current();
 
     // Title
     if (!documentTitle.isEmpty())
@@ -348,15 +390,15 @@ void OdtDocument::saveMeta(const QString &path)
 
     // Description
     QString meetingLocation;
-    if (storeLocationAndDate)
+    if (options.storeLocationDateInMeta)
     {
-        meta->getString(meetingLocation, MetaDataKey::MeetingLocation);
+        meta.getString(meetingLocation, MetaDataKey::MeetingLocation);
 
         QDate start, end;
         qint64 tmp = 0;
-        if (meta->getInt64(tmp, MetaDataKey::MeetingStartDate) == MetaDataKey::ValueFound)
+        if (meta.getInt64(tmp, MetaDataKey::MeetingStartDate) == MetaDataKey::ValueFound)
             start = QDate::fromJulianDay(tmp);
-        if (meta->getInt64(tmp, MetaDataKey::MeetingEndDate) == MetaDataKey::ValueFound)
+        if (meta.getInt64(tmp, MetaDataKey::MeetingEndDate) == MetaDataKey::ValueFound)
             end = QDate::fromJulianDay(tmp);
         if (!end.isValid() || end < start)
             end = start;
@@ -387,7 +429,7 @@ void OdtDocument::saveMeta(const QString &path)
 
     // Language
     xml.writeStartElement("dc:language");
-    xml.writeCharacters(Session->getSheetExportLocale().bcp47Name());
+    xml.writeCharacters(options.locale.bcp47Name());
     xml.writeEndElement(); // dc:language
 
     // Generator
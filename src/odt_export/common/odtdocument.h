@@ -20,14 +20,26 @@
 #ifndef ODTDOCUMENT_H
 #define ODTDOCUMENT_H
 
-#include <QTemporaryDir>
-#include <QFile>
+#include <QBuffer>
+#include <QSharedPointer>
 #include <QXmlStreamWriter>
 
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The OdtDocument class
+ *
+ * Builds an OpenDocument Text package.
+ * All package entries are kept in memory and the final
+ * .odt file is written once by saveTo()
+ */
 class OdtDocument
 {
 public:
-    OdtDocument();
+    // Database is used to read meeting metadata
+    OdtDocument(sqlite3pp::database &db);
 
     bool saveTo(const QString &fileName);
 
@@ -35,8 +47,12 @@ public:
     void startBody();
     void endDocument();
 
-    // Returns a 'path + file name' where you must save the image
-    QString addImage(const QString &name, const QString &mediaType);
+    // Adds image data as 'Pictures/name' in package
+    void addImage(const QString &name, const QString &mediaType, const QByteArray &data);
+
+    // Same as above but image is read in chunks from device only when saving
+    // Takes ownership of device, which must be open and seekable
+    void addImage(const QString &name, const QString &mediaType, QIODevice *device);
 
     inline void setTitle(const QString &title)
     {
@@ -44,24 +60,34 @@ public:
     }
 
 public:
-    QTemporaryDir dir;
-    QFile content;
-    QFile styles;
+    QBuffer content;
+    QBuffer styles;
 
     QXmlStreamWriter contentXml;
     QXmlStreamWriter stylesXml;
 
 private:
     void writeStartDoc(QXmlStreamWriter &xml);
-    void saveMimetypeFile(const QString &path);
-    void saveManifest(const QString &path);
-    void saveMeta(const QString &path);
+    void saveManifest();
+    void saveMeta();
     void writeFileEntry(QXmlStreamWriter &xml, const QString &fullPath, const QString &mediaType);
 
 private:
+    sqlite3pp::database &mDb;
+
     QString documentTitle;
-    // pair: fileName, mediaType
-    QList<QPair<QString, QString>> imageList;
+
+    QByteArray manifestData;
+    QByteArray metaData;
+
+    struct Image
+    {
+        QString fileName;
+        QString mediaType;
+        QByteArray data;
+        QSharedPointer<QIODevice> device; // Used instead of data if set
+    };
+    QList<Image> imageList;
 };
 
 #endif // ODTDOCUMENT_H
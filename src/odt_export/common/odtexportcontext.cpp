@@ -0,0 +1,156 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "odtexportcontext.h"
+
+#include "jobwriter.h"
+#include "stationwriter.h"
+#include "odtutils.h"
+
+#include <QXmlStreamWriter>
+
+#include <QDebug>
+
+OdtExportContext::OdtExportContext(sqlite3pp::database &db) :
+    mDb(db)
+{
+}
+
+OdtExportContext::~OdtExportContext()
+{
+}
+
+JobWriter &OdtExportContext::jobWriter()
+{
+    if (!m_jobWriter)
+        m_jobWriter.reset(new JobWriter(mDb));
+    return *m_jobWriter;
+}
+
+StationWriter &OdtExportContext::stationWriter()
+{
+    if (!m_stationWriter)
+        m_stationWriter.reset(new StationWriter(mDb));
+    return *m_stationWriter;
+}
+
+void OdtExportContext::writeFragment(QXmlStreamWriter &xml, Fragment f)
+{
+    for (const Token &token : getFragment(f))
+    {
+        switch (token.type)
+        {
+        case QXmlStreamReader::StartElement:
+            xml.writeStartElement(token.text);
+            xml.writeAttributes(token.attributes);
+            break;
+        case QXmlStreamReader::EndElement:
+            xml.writeEndElement();
+            break;
+        case QXmlStreamReader::Characters:
+            xml.writeCharacters(token.text);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+const QVector<OdtExportContext::Token> &OdtExportContext::getFragment(Fragment f)
+{
+    QVector<Token> &tokens = m_fragments[f];
+    if (!tokens.isEmpty())
+        return tokens;
+
+    // Wrap fragment in a root element so it's a valid document
+    QByteArray data;
+    QXmlStreamWriter xml(&data);
+    xml.writeStartElement("fragment");
+
+    switch (f)
+    {
+    case FontFaces:
+        writeLiberationFontFaces(xml);
+        break;
+    case StandardStyle:
+        writeStandardStyle(xml);
+        break;
+    case GraphicsStyle:
+        writeGraphicsStyle(xml);
+        break;
+    case CommonStyles:
+        writeCommonStyles(xml);
+        break;
+    case FooterStyle:
+        writeFooterStyle(xml);
+        break;
+    case PageLayout:
+        writePageLayout(xml);
+        break;
+    case JobStyles:
+        JobWriter::writeJobStyles(xml);
+        break;
+    case JobAutomaticStyles:
+        JobWriter::writeJobAutomaticStyles(xml);
+        break;
+    case StationAutomaticStyles:
+        StationWriter::writeStationAutomaticStyles(xml);
+        break;
+    case NFragments:
+        break;
+    }
+
+    xml.writeEndElement(); // fragment
+
+    // Namespace prefixes are declared by documents, keep names as written
+    QXmlStreamReader reader(data);
+    reader.setNamespaceProcessing(false);
+
+    // Skip root element
+    reader.readNextStartElement();
+
+    while (!reader.atEnd())
+    {
+        Token token;
+        token.type = reader.readNext();
+        switch (token.type)
+        {
+        case QXmlStreamReader::StartElement:
+            token.text       = reader.qualifiedName().toString();
+            token.attributes = reader.attributes();
+            break;
+        case QXmlStreamReader::Characters:
+            token.text = reader.text().toString();
+            break;
+        case QXmlStreamReader::EndElement:
+            if (reader.qualifiedName() == QLatin1String("fragment"))
+                continue; // Root element
+            break;
+        default:
+            continue;
+        }
+
+        tokens.append(token);
+    }
+
+    if (reader.hasError())
+        qWarning() << "OdtExportContext: cannot parse fragment" << f << reader.errorString();
+
+    return tokens;
+}
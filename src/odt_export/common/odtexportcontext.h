@@ -0,0 +1,95 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ODTEXPORTCONTEXT_H
+#define ODTEXPORTCONTEXT_H
+
+#include <QString>
+#include <QVector>
+#include <QXmlStreamReader>
+
+#include <memory>
+
+class QXmlStreamWriter;
+
+class JobWriter;
+class StationWriter;
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The OdtExportContext class
+ *
+ * State shared by all documents of an export run.
+ * It owns JobWriter and StationWriter so their prepared statements
+ * are reused for every job and station, and caches style fragments
+ * which do not depend on document content so they are generated only once.
+ * Fragments are stored as a list of XML tokens and replayed through the document writer.
+ *
+ * A context is bound to a database connection and must be used by one thread.
+ * Documents without a context create a temporary one.
+ */
+class OdtExportContext
+{
+public:
+    enum Fragment
+    {
+        FontFaces = 0,
+        StandardStyle,
+        GraphicsStyle,
+        CommonStyles,
+        FooterStyle,
+        PageLayout,
+        JobStyles,
+        JobAutomaticStyles,
+        StationAutomaticStyles,
+        NFragments
+    };
+
+    explicit OdtExportContext(sqlite3pp::database &db);
+    ~OdtExportContext();
+
+    JobWriter &jobWriter();
+    StationWriter &stationWriter();
+
+    // Writes cached fragment in current position of xml
+    void writeFragment(QXmlStreamWriter &xml, Fragment f);
+
+private:
+    struct Token
+    {
+        QXmlStreamReader::TokenType type;
+        QString text; // Qualified name of StartElement or content of Characters
+        QXmlStreamAttributes attributes;
+    };
+
+    const QVector<Token> &getFragment(Fragment f);
+
+private:
+    sqlite3pp::database &mDb;
+
+    std::unique_ptr<JobWriter> m_jobWriter;
+    std::unique_ptr<StationWriter> m_stationWriter;
+
+    QVector<Token> m_fragments[NFragments];
+};
+
+#endif // ODTEXPORTCONTEXT_H
@@ -20,6 +20,7 @@
 #include "odtutils.h"
 
 #include "app/session.h"
+#include "sheetexportoptions.h"
 #include <QTranslator>
 
 /* writeColumnStyle
@@ -386,7 +387,9 @@ void writeLiberationFontFaces(QXmlStreamWriter &xml)
 
 QString Odt::text(const Text &t)
 {
-    QTranslator *translator = Session->getSheetExportTranslator();
+    // Do not copy options, this is called for every translated cell
+    const SheetExportOptions *options = SheetExportOptions::installed();
+    QTranslator *translator = options ? options->translator : Session->getSheetExportTranslator();
 
     QString result;
     if (translator)
@@ -394,7 +397,8 @@ QString Odt::text(const Text &t)
         // Prefer selected language
         result = translator->translate("Odt", t.sourceText, t.disambiguation);
     }
-    else if (Session->getSheetExportLocale() == MeetingSession::embeddedLocale)
+    else if ((options ? options->locale : Session->getSheetExportLocale())
+             == MeetingSession::embeddedLocale)
     {
         // Bypass any translation and use hardcoded string literals
         return QString::fromUtf8(t.sourceText);
@@ -0,0 +1,58 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "sheetexportoptions.h"
+
+#include "app/session.h"
+
+static thread_local const SheetExportOptions *threadOptions = nullptr;
+
+SheetExportOptions SheetExportOptions::fromSettings()
+{
+    SheetExportOptions options;
+    options.locale                  = Session->getSheetExportLocale();
+    options.translator              = Session->getSheetExportTranslator();
+    options.header                  = AppSettings.getSheetHeader();
+    options.footer                  = AppSettings.getSheetFooter();
+    options.storeLocationDateInMeta = AppSettings.getSheetStoreLocationDateInMeta();
+    return options;
+}
+
+SheetExportOptions SheetExportOptions::current()
+{
+    if (threadOptions)
+        return *threadOptions;
+    return fromSettings();
+}
+
+const SheetExportOptions *SheetExportOptions::installed()
+{
+    return threadOptions;
+}
+
+SheetExportOptions::ThreadScope::ThreadScope(const SheetExportOptions *options) :
+    m_prevOptions(threadOptions)
+{
+    threadOptions = options;
+}
+
+SheetExportOptions::ThreadScope::~ThreadScope()
+{
+    threadOptions = m_prevOptions;
+}
@@ -0,0 +1,71 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SHEETEXPORTOPTIONS_H
+#define SHEETEXPORTOPTIONS_H
+
+#include <QLocale>
+#include <QString>
+
+class QTranslator;
+
+/*!
+ * \brief The SheetExportOptions struct
+ *
+ * Settings which affect generated sheets: language, default header and footer.
+ * Settings and session are not thread safe, so export tasks use a copy taken on main thread
+ * and installed with \ref SheetExportOptions::ThreadScope.
+ *
+ * \sa current()
+ */
+struct SheetExportOptions
+{
+    QLocale locale;
+
+    // Owned by session, must not be changed while a task is using it
+    QTranslator *translator = nullptr;
+
+    // Used when not set in session metadata
+    QString header;
+    QString footer;
+
+    bool storeLocationDateInMeta = false;
+
+    // Must be called on main thread
+    static SheetExportOptions fromSettings();
+
+    // Options installed on current thread, or current settings if none
+    static SheetExportOptions current();
+
+    // Options installed on current thread, nullptr if none
+    static const SheetExportOptions *installed();
+
+    // Installs options on current thread for the scope lifetime
+    class ThreadScope
+    {
+    public:
+        explicit ThreadScope(const SheetExportOptions *options);
+        ~ThreadScope();
+
+    private:
+        const SheetExportOptions *m_prevOptions;
+    };
+};
+
+#endif // SHEETEXPORTOPTIONS_H
@@ -19,11 +19,11 @@
 
 #include "stationwriter.h"
 
-#include "jobs/jobsmanager/model/jobshelper.h"
-
 #include "utils/jobcategorystrings.h"
 #include "utils/rs_utils.h"
 
+#include "jobs/jobsmanager/model/jobshelper.h"
+
 #include <QXmlStreamWriter>
 
 #include "odtutils.h"
@@ -78,38 +78,131 @@ void StationWriter::insertStop(QXmlStreamWriter &xml, const Stop &stop, bool fir
 
 StationWriter::StationWriter(database &db) :
     mDb(db),
-    q_getJobsByStation(mDb, "SELECT stops.id,"
-                            "stops.job_id,"
-                            "jobs.category,"
-                            "stops.arrival,"
-                            "stops.departure,"
-                            "stops.type,"
-                            "stops.description,"
-                            "t1.name, t2.name,"
-                            "g1.track_side, g2.track_side"
-                            " FROM stops"
-                            " JOIN jobs ON jobs.id=stops.job_id"
-                            " LEFT JOIN station_gate_connections g1 ON g1.id=stops.in_gate_conn"
-                            " LEFT JOIN station_gate_connections g2 ON g2.id=stops.out_gate_conn"
-                            " LEFT JOIN station_tracks t1 ON t1.id=g1.track_id"
-                            " LEFT JOIN station_tracks t2 ON t2.id=g2.track_id"
-                            " WHERE stops.station_id=?"
-                            " ORDER BY stops.arrival,stops.job_id"),
-
-    q_selectPassings(mDb, "SELECT stops.id,stops.job_id,jobs.category"
-                          " FROM stops"
-                          " JOIN jobs ON jobs.id=stops.job_id"
-                          " WHERE stops.station_id=? AND stops.departure>=? AND stops.arrival<=? "
-                          "AND stops.job_id<>?"),
-    q_getStopCouplings(mDb, "SELECT coupling.rs_id,"
-                            "rs_list.number,rs_models.name,rs_models.suffix,rs_models.type"
-                            " FROM coupling"
-                            " JOIN rs_list ON rs_list.id=coupling.rs_id"
-                            " JOIN rs_models ON rs_models.id=rs_list.model_id"
-                            " WHERE coupling.stop_id=? AND coupling.operation=?")
+    // Previous and next stations are taken from adjacent stops of the same job
+    // Only jobs stopping in the station are considered to keep the window small
+    q_getStationStops(mDb, "SELECT sub.id,"
+                           "sub.job_id,"
+                           "jobs.category,"
+                           "sub.arrival,"
+                           "sub.departure,"
+                           "sub.type,"
+                           "sub.description,"
+                           "t1.name, t2.name,"
+                           "g1.track_side, g2.track_side,"
+                           "gate1.side, gate2.side,"
+                           "prev_st.name, next_st.name"
+                           " FROM ("
+                           " SELECT stops.id, stops.job_id, stops.station_id,"
+                           " stops.arrival, stops.departure, stops.type, stops.description,"
+                           " stops.in_gate_conn, stops.out_gate_conn,"
+                           " lag(stops.station_id, 1) OVER win AS prev_st_id,"
+                           " lead(stops.station_id, 1) OVER win AS next_st_id"
+                           " FROM stops"
+                           " WHERE stops.job_id IN (SELECT job_id FROM stops WHERE station_id=?1)"
+                           " WINDOW win AS (PARTITION BY stops.job_id ORDER BY stops.arrival)"
+                           ") AS sub"
+                           " JOIN jobs ON jobs.id=sub.job_id"
+                           " LEFT JOIN station_gate_connections g1 ON g1.id=sub.in_gate_conn"
+                           " LEFT JOIN station_gate_connections g2 ON g2.id=sub.out_gate_conn"
+                           " LEFT JOIN station_tracks t1 ON t1.id=g1.track_id"
+                           " LEFT JOIN station_tracks t2 ON t2.id=g2.track_id"
+                           " LEFT JOIN station_gates gate1 ON gate1.id=g1.gate_id"
+                           " LEFT JOIN station_gates gate2 ON gate2.id=g2.gate_id"
+                           " LEFT JOIN stations prev_st ON prev_st.id=sub.prev_st_id"
+                           " LEFT JOIN stations next_st ON next_st.id=sub.next_st_id"
+                           " WHERE sub.station_id=?1"
+                           " ORDER BY sub.arrival,sub.job_id"),
+
+    q_getStationCouplings(mDb, "SELECT coupling.stop_id,coupling.operation,"
+                               "rs_list.number,rs_models.name,rs_models.suffix,rs_models.type"
+                               " FROM coupling"
+                               " JOIN stops ON stops.id=coupling.stop_id"
+                               " JOIN rs_list ON rs_list.id=coupling.rs_id"
+                               " JOIN rs_models ON rs_models.id=rs_list.model_id"
+                               " WHERE stops.station_id=?"
+                               " ORDER BY coupling.stop_id,coupling.id"),
+
+    q_getStName(mDb, "SELECT name,short_name FROM stations WHERE id=?")
 {
 }
 
+void StationWriter::loadStops(db_id stationId, QVector<Stop> &stops)
+{
+    q_getStationStops.bind(1, stationId);
+    for (auto r : q_getStationStops)
+    {
+        Stop stop;
+        stop.stopId      = r.get<db_id>(0);
+        stop.jobId       = r.get<db_id>(1);
+        stop.jobCat      = JobCategory(r.get<int>(2));
+        stop.arrival     = r.get<QTime>(3);
+        stop.departure   = r.get<QTime>(4);
+        stop.isTransit   = r.get<int>(5) == 1;
+        stop.description = r.get<QString>(6);
+
+        stop.platform    = r.get<QString>(7);
+        if (stop.platform.isEmpty())
+            stop.platform = r.get<QString>(8); // Use out gate to get track name
+
+        utils::Side entranceSide = utils::Side(r.get<int>(9));
+        utils::Side exitSide     = utils::Side(r.get<int>(10));
+
+        if (entranceSide == exitSide && r.column_type(9) != SQLITE_NULL
+            && r.column_type(10) != SQLITE_NULL)
+        {
+            // Train enters and leaves from same track side, add reversal to description
+            QString descr2 = Odt::text(Odt::jobReverseDirection);
+            if (!stop.description.isEmpty())
+                descr2.append('\n'); // Separate from manually set description
+            descr2.append(stop.description);
+            stop.description = descr2;
+        }
+
+        // Direction
+        const utils::Side inSide =
+          r.column_type(11) != SQLITE_NULL ? utils::Side(r.get<int>(11)) : utils::Side::NSides;
+        const utils::Side outSide =
+          r.column_type(12) != SQLITE_NULL ? utils::Side(r.get<int>(12)) : utils::Side::NSides;
+        stop.direction = JobStopDirectionHelper::directionFromGateSides(inSide, outSide);
+
+        stop.prevSt = r.get<QString>(13);
+        stop.nextSt = r.get<QString>(14);
+
+        stops.append(stop);
+    }
+    q_getStationStops.reset();
+}
+
+void StationWriter::loadCouplings(db_id stationId, QHash<db_id, StopCouplings> &couplings)
+{
+    sqlite3_stmt *stmt = q_getStationCouplings.stmt();
+
+    q_getStationCouplings.bind(1, stationId);
+    for (auto coup : q_getStationCouplings)
+    {
+        db_id stopId            = coup.get<db_id>(0);
+        RsOp op                 = RsOp(coup.get<int>(1));
+
+        int number              = coup.get<int>(2);
+        int modelNameLen        = sqlite3_column_bytes(stmt, 3);
+        const char *modelName   = reinterpret_cast<char const *>(sqlite3_column_text(stmt, 3));
+
+        int modelSuffixLen      = sqlite3_column_bytes(stmt, 4);
+        const char *modelSuffix = reinterpret_cast<char const *>(sqlite3_column_text(stmt, 4));
+        RsType type             = RsType(sqlite3_column_int(stmt, 5));
+
+        const QString rsName    = rs_utils::formatNameRef(modelName, modelNameLen, number,
+                                                          modelSuffix, modelSuffixLen, type);
+
+        StopCouplings &entry    = couplings[stopId];
+        if (op == RsOp::Coupled)
+            entry.coupled.append(rsName);
+        else
+            entry.uncoupled.append(rsName);
+    }
+    q_getStationCouplings.reset();
+}
+
 // TODO: common styles with JobWriter should go in common
 void StationWriter::writeStationAutomaticStyles(QXmlStreamWriter &xml)
 {
@@ -321,13 +414,6 @@ void StationWriter::writeStation(QXmlStreamWriter &xml, db_id stationId, QString
 {
     QMap<QTime, Stop> stops; // Order by Departure ASC
 
-    query q_getStName(mDb, "SELECT name,short_name FROM stations WHERE id=?");
-
-    query q_getPrevStop(mDb, "SELECT id, station_id, MAX(departure) FROM stops"
-                             " WHERE job_id=? AND departure<?");
-    query q_getNextStop(mDb, "SELECT id, station_id, MIN(arrival) FROM stops"
-                             " WHERE job_id=? AND arrival>?");
-
     QString stationName;
     QString shortName;
     q_getStName.bind(1, stationId);
@@ -413,72 +499,20 @@ void StationWriter::writeStation(QXmlStreamWriter &xml, db_id stationId, QString
     xml.writeEndElement(); // end of row
     xml.writeEndElement(); // header section
 
+    // Load all station data before writing
+    QVector<Stop> stationStops;
+    QHash<db_id, StopCouplings> couplings;
+    loadStops(stationId, stationStops);
+    loadCouplings(stationId, couplings);
+
     // Stops
-    q_getJobsByStation.bind(1, stationId);
-    for (auto r : q_getJobsByStation)
+    for (const Stop &stop : qAsConst(stationStops))
     {
-        db_id stopId = r.get<db_id>(0);
-        Stop stop;
-        stop.jobId         = r.get<db_id>(1);
-        stop.jobCat        = JobCategory(r.get<int>(2));
-        stop.arrival       = r.get<QTime>(3);
-        stop.departure     = r.get<QTime>(4);
-        const int stopType = r.get<int>(5);
-        stop.description   = r.get<QString>(6);
-
-        stop.platform      = r.get<QString>(7);
-        if (stop.platform.isEmpty())
-            stop.platform = r.get<QString>(8); // Use out gate to get track name
-
-        utils::Side entranceSide = utils::Side(r.get<int>(9));
-        utils::Side exitSide     = utils::Side(r.get<int>(10));
-
-        if (entranceSide == exitSide && r.column_type(9) != SQLITE_NULL
-            && r.column_type(10) != SQLITE_NULL)
-        {
-            // Train enters and leaves from same track side, add reversal to description
-            QString descr2 = Odt::text(Odt::jobReverseDirection);
-            if (!stop.description.isEmpty())
-                descr2.append('\n'); // Separate from manually set description
-            descr2.append(stop.description);
-            stop.description = descr2;
-        }
-
-        const bool isTransit = stopType == 1;
+        const bool isTransit = stop.isTransit;
 
         // BIG TODO: if this is First or Last stop of this job
         // then it shouldn't be duplicated in 2 rows
 
-        // Comes from station
-        q_getPrevStop.bind(1, stop.jobId);
-        q_getPrevStop.bind(2, stop.arrival);
-        if (q_getPrevStop.step() == SQLITE_ROW)
-        {
-            db_id prevStId = q_getPrevStop.getRows().get<db_id>(1);
-            q_getStName.bind(1, prevStId);
-            if (q_getStName.step() == SQLITE_ROW)
-            {
-                stop.prevSt = q_getStName.getRows().get<QString>(0);
-            }
-            q_getStName.reset();
-        }
-        q_getPrevStop.reset();
-
-        // Goes to station
-        q_getNextStop.bind(1, stop.jobId);
-        q_getNextStop.bind(2, stop.arrival);
-        if (q_getNextStop.step() == SQLITE_ROW)
-        {
-            db_id nextStId = q_getNextStop.getRows().get<db_id>(1);
-            q_getStName.bind(1, nextStId);
-            if (q_getStName.step() == SQLITE_ROW)
-            {
-                stop.nextSt = q_getStName.getRows().get<QString>(0);
-            }
-            q_getStName.reset();
-        }
-        q_getNextStop.reset();
-
         for (auto s = stops.begin(); s != stops.end(); /*nothing because of erase*/)
         {
             // If 's' departs after 'stop' arrives then skip 's' for now
@@ -503,126 +537,82 @@ void StationWriter::writeStation(QXmlStreamWriter &xml, db_id stationId, QString
         // First time this stop is written, fill with other data
 
         // Rollingstock
-        sqlite3_stmt *stmt = q_getStopCouplings.stmt();
         writeCellListStart(xml, "stationtable.A2", "P3");
-
-        // Coupled rollingstock
-        bool firstCoupRow = true;
-        q_getStopCouplings.bind(1, stopId);
-        q_getStopCouplings.bind(2, int(RsOp::Coupled));
-        for (auto coup : q_getStopCouplings)
+        auto coup = couplings.constFind(stop.stopId);
+        if (coup != couplings.constEnd())
         {
-            // db_id rsId = coup.get<db_id>(0);
-
-            int number              = coup.get<int>(1);
-            int modelNameLen        = sqlite3_column_bytes(stmt, 2);
-            const char *modelName   = reinterpret_cast<char const *>(sqlite3_column_text(stmt, 2));
-
-            int modelSuffixLen      = sqlite3_column_bytes(stmt, 3);
-            const char *modelSuffix = reinterpret_cast<char const *>(sqlite3_column_text(stmt, 3));
-            RsType type             = RsType(sqlite3_column_int(stmt, 4));
-
-            const QString rsName    = rs_utils::formatNameRef(modelName, modelNameLen, number,
-                                                              modelSuffix, modelSuffixLen, type);
-
-            if (firstCoupRow)
+            // Coupled rollingstock
+            if (!coup->coupled.isEmpty())
             {
-                firstCoupRow = false;
                 // Use bold font
                 xml.writeStartElement("text:span");
                 xml.writeAttribute("text:style-name", "T1");
                 xml.writeCharacters(Odt::text(Odt::CoupledAbbr));
                 xml.writeEndElement(); // test:span
-            }
-
-            xml.writeEmptyElement("text:line-break");
-            xml.writeCharacters(rsName);
-        }
-        q_getStopCouplings.reset();
-
-        // Unoupled rollingstock
-        bool firstUncoupRow = true;
-        q_getStopCouplings.bind(1, stopId);
-        q_getStopCouplings.bind(2, int(RsOp::Uncoupled));
-        for (auto coup : q_getStopCouplings)
-        {
-            // db_id rsId = coup.get<db_id>(0);
-
-            int number              = coup.get<int>(1);
-            int modelNameLen        = sqlite3_column_bytes(stmt, 2);
-            const char *modelName   = reinterpret_cast<char const *>(sqlite3_column_text(stmt, 2));
-
-            int modelSuffixLen      = sqlite3_column_bytes(stmt, 3);
-            const char *modelSuffix = reinterpret_cast<char const *>(sqlite3_column_text(stmt, 3));
-            RsType type             = RsType(sqlite3_column_int(stmt, 4));
 
-            const QString rsName    = rs_utils::formatNameRef(modelName, modelNameLen, number,
-                                                              modelSuffix, modelSuffixLen, type);
+                for (const QString &rsName : coup->coupled)
+                {
+                    xml.writeEmptyElement("text:line-break");
+                    xml.writeCharacters(rsName);
+                }
+            }
 
-            if (firstUncoupRow)
+            // Unoupled rollingstock
+            if (!coup->uncoupled.isEmpty())
             {
-                if (!firstCoupRow) // Not first row, there were coupled rs
+                if (!coup->coupled.isEmpty()) // There were coupled rs
                     xml.writeEmptyElement("text:line-break"); // Separate from coupled
-                firstUncoupRow = false;
 
                 // Use bold font
                 xml.writeStartElement("text:span");
                 xml.writeAttribute("text:style-name", "T1");
                 xml.writeCharacters(Odt::text(Odt::UncoupledAbbr));
                 xml.writeEndElement(); // test:span
-            }
 
-            xml.writeEmptyElement("text:line-break");
-            xml.writeCharacters(rsName);
+                for (const QString &rsName : coup->uncoupled)
+                {
+                    xml.writeEmptyElement("text:line-break");
+                    xml.writeCharacters(rsName);
+                }
+            }
         }
-        q_getStopCouplings.reset();
         writeCellListEnd(xml);
 
         // Crossings, Passings
+        // Other jobs in station while this job is stopping
         QVector<JobEntry> passings;
-        JobStopDirectionHelper dirHelper(mDb);
-        utils::Side myDirection = dirHelper.getStopOutSide(stopId);
-
-        q_selectPassings.bind(1, stationId);
-        q_selectPassings.bind(2, stop.arrival);
-        q_selectPassings.bind(3, stop.departure);
-        q_selectPassings.bind(4, stop.jobId);
-        firstCoupRow = true;
+        bool firstRow = true;
 
         // Incroci
         writeCellListStart(xml, "stationtable.A2", "P3");
-        for (auto pass : q_selectPassings)
+        for (const Stop &other : qAsConst(stationStops))
         {
-            db_id otherStopId       = pass.get<db_id>(0);
-            db_id otherJobId        = pass.get<db_id>(1);
-            JobCategory otherJobCat = JobCategory(pass.get<int>(2));
+            if (other.arrival > stop.departure)
+                break; // Stops are sorted by arrival, next ones arrive later too
 
-            // QTime otherArr = pass.get<QTime>(3);
-            // QTime otherDep = pass.get<QTime>(4);
-
-            utils::Side otherDir = dirHelper.getStopOutSide(otherStopId);
+            if (other.departure < stop.arrival || other.jobId == stop.jobId)
+                continue;
 
-            if (myDirection == otherDir)
-                passings.append({otherJobId, otherJobCat});
+            if (stop.direction == other.direction)
+                passings.append({other.jobId, other.jobCat});
             else
             {
-                if (firstCoupRow)
-                    firstCoupRow = false;
+                if (firstRow)
+                    firstRow = false;
                 else
                     xml.writeEmptyElement("text:line-break");
-                xml.writeCharacters(JobCategoryName::jobName(otherJobId, otherJobCat));
+                xml.writeCharacters(JobCategoryName::jobName(other.jobId, other.jobCat));
             }
         }
-        q_selectPassings.reset();
         writeCellListEnd(xml);
 
         // Passings
-        firstCoupRow = true;
+        firstRow = true;
         writeCellListStart(xml, "stationtable.A2", "P3");
         for (auto entry : passings)
         {
-            if (firstCoupRow)
-                firstCoupRow = false;
+            if (firstRow)
+                firstRow = false;
             else
                 xml.writeEmptyElement("text:line-break");
             xml.writeCharacters(JobCategoryName::jobName(entry.jobId, entry.category));
@@ -682,7 +672,6 @@ void StationWriter::writeStation(QXmlStreamWriter &xml, db_id stationId, QString
             stops.insert(stop.departure, stop);
         }
     }
-    q_getJobsByStation.reset();
 
     for (const Stop &s : stops)
     {
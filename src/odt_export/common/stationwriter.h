@@ -21,7 +21,10 @@
 #define STATIONWRITER_H
 
 #include <QVector>
+#include <QHash>
+#include <QStringList>
 #include "utils/types.h"
+#include "stations/station_utils.h"
 
 #include <sqlite3pp/sqlite3pp.h>
 using namespace sqlite3pp;
@@ -40,6 +43,7 @@ public:
 private:
     struct Stop
     {
+        db_id stopId;
         db_id jobId;
 
         QString prevSt;
@@ -52,16 +56,28 @@ private:
         QTime departure;
 
         JobCategory jobCat;
+        utils::Side direction;
+        bool isTransit;
     };
 
+    struct StopCouplings
+    {
+        QStringList coupled;
+        QStringList uncoupled;
+    };
+
+    void loadStops(db_id stationId, QVector<Stop> &stops);
+    void loadCouplings(db_id stationId, QHash<db_id, StopCouplings> &couplings);
+
     void insertStop(QXmlStreamWriter &xml, const Stop &stop, bool first, bool transit);
 
 private:
     database &mDb;
 
-    query q_getJobsByStation;
-    query q_selectPassings;
-    query q_getStopCouplings;
+    // Whole station is loaded with set-based queries and joined in memory
+    query q_getStationStops;
+    query q_getStationCouplings;
+    query q_getStName;
 };
 
 #endif // STATIONWRITER_H
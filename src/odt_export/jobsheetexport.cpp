@@ -19,14 +19,17 @@
 
 #include "jobsheetexport.h"
 
+#include "common/odtexportcontext.h"
+
 #include "common/jobwriter.h"
 #include "common/odtutils.h"
 
 #include "app/session.h"
 
-#include <QDebug>
-
-JobSheetExport::JobSheetExport(db_id jobId, JobCategory cat) :
+JobSheetExport::JobSheetExport(sqlite3pp::database &db, db_id jobId, JobCategory cat) :
+    mDb(db),
+    m_ctx(nullptr),
+    odt(db),
     m_jobId(jobId),
     m_jobCat(cat)
 {
@@ -34,39 +37,42 @@ JobSheetExport::JobSheetExport(db_id jobId, JobCategory cat) :
 
 void JobSheetExport::write()
 {
-    qDebug() << "TEMP:" << odt.dir.path();
+    // Use a temporary context if none was set
+    OdtExportContext localCtx(mDb);
+    OdtExportContext &ctx = m_ctx ? *m_ctx : localCtx;
+
     odt.initDocument();
 
     // styles.xml font declarations
     odt.stylesXml.writeStartElement("office:font-face-decls");
-    writeLiberationFontFaces(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::FontFaces);
     odt.stylesXml.writeEndElement(); // office:font-face-decls
 
     // Content font declarations
     odt.contentXml.writeStartElement("office:font-face-decls");
-    writeLiberationFontFaces(odt.contentXml);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::FontFaces);
     odt.contentXml.writeEndElement(); // office:font-face-decls
 
     // Content Automatic styles
     odt.contentXml.writeStartElement("office:automatic-styles");
-    JobWriter::writeJobAutomaticStyles(odt.contentXml);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::JobAutomaticStyles);
 
     // Styles
     odt.stylesXml.writeStartElement("office:styles");
-    writeCommonStyles(odt.stylesXml);
-    JobWriter::writeJobStyles(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::CommonStyles);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::JobStyles);
     odt.stylesXml.writeEndElement();
 
     // Body
     odt.startBody();
 
-    JobWriter w(Session->m_Db);
+    JobWriter &w = ctx.jobWriter();
     w.writeJob(odt.contentXml, m_jobId, m_jobCat);
 
     odt.endDocument();
 }
 
-void JobSheetExport::save(const QString &fileName)
+bool JobSheetExport::save(const QString &fileName)
 {
-    odt.saveTo(fileName);
+    return odt.saveTo(fileName);
 }
@@ -24,15 +24,30 @@
 
 #include "utils/types.h"
 
+class OdtExportContext;
+
+namespace sqlite3pp {
+class database;
+}
+
 class JobSheetExport
 {
 public:
-    JobSheetExport(db_id jobId, JobCategory cat);
+    JobSheetExport(sqlite3pp::database &db, db_id jobId, JobCategory cat);
 
     void write();
-    void save(const QString &fileName);
+    bool save(const QString &fileName);
+
+    // Context must use same database, it's not owned
+    inline void setContext(OdtExportContext *ctx)
+    {
+        m_ctx = ctx;
+    }
 
 private:
+    sqlite3pp::database &mDb;
+    OdtExportContext *m_ctx;
+
     OdtDocument odt;
 
     db_id m_jobId;
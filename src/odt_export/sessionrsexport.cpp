@@ -21,13 +21,13 @@
 
 #include "common/odtutils.h"
 #include "common/sessionrswriter.h"
+#include "common/sheetexportoptions.h"
 
 #include "app/session.h"
 #include "db_metadata/metadatamanager.h"
 
-#include <QDebug>
-
 SessionRSExport::SessionRSExport(SessionRSMode mode, SessionRSOrder order) :
+    odt(Session->m_Db),
     m_mode(mode),
     m_order(order)
 {
@@ -35,7 +35,6 @@ SessionRSExport::SessionRSExport(SessionRSMode mode, SessionRSOrder order) :
 
 void SessionRSExport::write()
 {
-    qDebug() << "TEMP:" << odt.dir.path();
     odt.initDocument();
 
     // styles.xml font declarations
@@ -58,19 +57,21 @@ void SessionRSExport::write()
 
     MetaDataManager *meta = Session->getMetaDataManager();
 
+    const SheetExportOptions options = SheetExportOptions::current();
+
     // Retrive header and footer: give precedence to database metadata and then fallback to global
     // application settings If the text was explicitly set to empty in metadata no header/footer
     // will be displayed
     QString header;
     if (meta->getString(header, MetaDataKey::SheetHeaderText) != MetaDataKey::Result::ValueFound)
     {
-        header = AppSettings.getSheetHeader();
+        header = options.header;
     }
 
     QString footer;
     if (meta->getString(footer, MetaDataKey::SheetFooterText) != MetaDataKey::Result::ValueFound)
     {
-        footer = AppSettings.getSheetFooter();
+        footer = options.footer;
     }
 
     // Master styles
@@ -19,9 +19,12 @@
 
 #include "shiftsheetexport.h"
 
+#include "common/odtexportcontext.h"
+
 #include "common/jobwriter.h"
 
 #include "common/odtutils.h"
+#include "common/sheetexportoptions.h"
 
 #include "app/session.h"
 
@@ -39,7 +42,9 @@ using namespace sqlite3pp;
 
 ShiftSheetExport::ShiftSheetExport(sqlite3pp::database &db, db_id shiftId) :
     mDb(db),
+    m_ctx(nullptr),
     m_shiftId(shiftId),
+    odt(db),
     logoWidthCm(0),
     logoHeightCm(0)
 {
@@ -47,43 +52,48 @@ ShiftSheetExport::ShiftSheetExport(sqlite3pp::database &db, db_id shiftId) :
 
 void ShiftSheetExport::write()
 {
-    qDebug() << "TEMP:" << odt.dir.path();
+    // Use a temporary context if none was set
+    OdtExportContext localCtx(mDb);
+    OdtExportContext &ctx = m_ctx ? *m_ctx : localCtx;
+
     odt.initDocument();
 
     // styles.xml font declarations
     odt.stylesXml.writeStartElement("office:font-face-decls");
-    writeLiberationFontFaces(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::FontFaces);
     odt.stylesXml.writeEndElement(); // office:font-face-decls
 
     // Styles
     odt.stylesXml.writeStartElement("office:styles");
-    writeStandardStyle(odt.stylesXml);
-    writeGraphicsStyle(odt.stylesXml);
-    writeCommonStyles(odt.stylesXml);
-    JobWriter::writeJobStyles(odt.stylesXml);
-    writeFooterStyle(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::StandardStyle);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::GraphicsStyle);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::CommonStyles);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::JobStyles);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::FooterStyle);
     odt.stylesXml.writeEndElement();
 
     // Automatic styles
     odt.stylesXml.writeStartElement("office:automatic-styles");
-    writePageLayout(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::PageLayout);
     odt.stylesXml.writeEndElement();
 
-    MetaDataManager *meta = Session->getMetaDataManager();
+    MetaDataManager meta(mDb);
+
+    const SheetExportOptions options = SheetExportOptions::current();
 
     // Retrive header and footer: give precedence to database metadata and then fallback to global
     // application settings If the text was explicitly set to empty in metadata no header/footer
     // will be displayed
     QString header;
-    if (meta->getString(header, MetaDataKey::SheetHeaderText) != MetaDataKey::Result::ValueFound)
+    if (meta.getString(header, MetaDataKey::SheetHeaderText) != MetaDataKey::Result::ValueFound)
     {
-        header = AppSettings.getSheetHeader();
+        header = options.header;
     }
 
     QString footer;
-    if (meta->getString(footer, MetaDataKey::SheetFooterText) != MetaDataKey::Result::ValueFound)
+    if (meta.getString(footer, MetaDataKey::SheetFooterText) != MetaDataKey::Result::ValueFound)
     {
-        footer = AppSettings.getSheetFooter();
+        footer = options.footer;
     }
 
     // Master styles
@@ -93,14 +103,14 @@ void ShiftSheetExport::write()
 
     // Content font declarations
     odt.contentXml.writeStartElement("office:font-face-decls");
-    writeLiberationFontFaces(odt.contentXml);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::FontFaces);
     odt.contentXml.writeEndElement(); // office:font-face-decls
 
     // Content Automatic styles
     odt.contentXml.writeStartElement("office:automatic-styles");
-    JobWriter::writeJobAutomaticStyles(odt.contentXml);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::JobAutomaticStyles);
 
-    bool hasLogo = (meta->hasKey(MetaDataKey::MeetingLogoPicture) == MetaDataKey::ValueFound);
+    bool hasLogo = (meta.hasKey(MetaDataKey::MeetingLogoPicture) == MetaDataKey::ValueFound);
     if (hasLogo)
     {
         // Save image
@@ -124,7 +134,7 @@ void ShiftSheetExport::write()
 
     writeCover(odt.contentXml, shiftName, hasLogo);
 
-    JobWriter w(mDb);
+    JobWriter &w = ctx.jobWriter();
 
     q.prepare("SELECT jobs.id,jobs.category,MIN(s1.arrival)"
               " FROM jobs"
@@ -143,9 +153,9 @@ void ShiftSheetExport::write()
     odt.endDocument();
 }
 
-void ShiftSheetExport::save(const QString &fileName)
+bool ShiftSheetExport::save(const QString &fileName)
 {
-    odt.saveTo(fileName);
+    return odt.saveTo(fileName);
 }
 
 void ShiftSheetExport::writeCoverStyles(QXmlStreamWriter &xml, bool hasImage)
@@ -326,41 +336,29 @@ bool ShiftSheetExport::calculateLogoSize(QIODevice *dev)
 void ShiftSheetExport::saveLogoPicture()
 {
     std::unique_ptr<ImageMetaData::ImageBlobDevice> imageIO;
-    imageIO.reset(ImageMetaData::getImage(Session->m_Db, MetaDataKey::MeetingLogoPicture));
+    imageIO.reset(ImageMetaData::getImage(mDb, MetaDataKey::MeetingLogoPicture));
     if (!imageIO || !imageIO->open(QIODevice::ReadOnly))
     {
-        qWarning() << "ShiftSheetExport: error query image," << Session->m_Db.error_msg();
+        qWarning() << "ShiftSheetExport: error query image," << mDb.error_msg();
         return;
     }
 
     if (!calculateLogoSize(imageIO.get()))
         return; // Image is not valid
 
-    imageIO->seek(0); // Reset device
-
-    QString fileNamePath = odt.addImage("logo.png", "image/png");
-    QFile f(fileNamePath);
-    if (!f.open(QFile::WriteOnly | QFile::Truncate))
+    if (imageIO->size() <= 0)
     {
-        qWarning() << "ShiftSheetExport: error saving image," << f.errorString();
+        qWarning() << "ShiftSheetExport: error reading image," << imageIO->errorString();
         return;
     }
 
-    constexpr int bufSize = 4096;
-    char buf[bufSize];
-    qint64 size = 0;
-    while (!imageIO->atEnd() || size < 0)
-    {
-        size = imageIO->read(buf, bufSize);
-        if (f.write(buf, size) != size)
-            qWarning() << "ShiftSheetExport: error witing image," << f.errorString();
-    }
-    f.close();
+    // Image is copied in chunks directly from database when saving package
+    odt.addImage("logo.png", "image/png", imageIO.release());
 }
 
 void ShiftSheetExport::writeCover(QXmlStreamWriter &xml, const QString &shiftName, bool hasLogo)
 {
-    MetaDataManager *meta = Session->getMetaDataManager();
+    MetaDataManager meta(mDb);
 
     // Add some space
     xml.writeStartElement("text:p");
@@ -369,7 +367,7 @@ void ShiftSheetExport::writeCover(QXmlStreamWriter &xml, const QString &shiftNam
 
     // Host association
     QString str;
-    meta->getString(str, MetaDataKey::MeetingHostAssociation);
+    meta.getString(str, MetaDataKey::MeetingHostAssociation);
     if (!str.isEmpty())
     {
         xml.writeStartElement("text:p");
@@ -414,17 +412,17 @@ void ShiftSheetExport::writeCover(QXmlStreamWriter &xml, const QString &shiftNam
 
     // Meeting dates
     qint64 showDates = 1;
-    meta->getInt64(showDates, MetaDataKey::MeetingShowDates);
+    meta.getInt64(showDates, MetaDataKey::MeetingShowDates);
     if (showDates)
     {
         QDate start, end;
         qint64 tmp = 0;
 
-        if (meta->getInt64(tmp, MetaDataKey::MeetingStartDate) == MetaDataKey::ValueFound)
+        if (meta.getInt64(tmp, MetaDataKey::MeetingStartDate) == MetaDataKey::ValueFound)
         {
             start = QDate::fromJulianDay(tmp);
         }
-        if (meta->getInt64(tmp, MetaDataKey::MeetingEndDate) == MetaDataKey::ValueFound)
+        if (meta.getInt64(tmp, MetaDataKey::MeetingEndDate) == MetaDataKey::ValueFound)
         {
             end = QDate::fromJulianDay(tmp);
             if (!end.isValid() || end < start)
@@ -451,7 +449,7 @@ void ShiftSheetExport::writeCover(QXmlStreamWriter &xml, const QString &shiftNam
     xml.writeEndElement();
 
     // Location
-    meta->getString(str, MetaDataKey::MeetingLocation);
+    meta.getString(str, MetaDataKey::MeetingLocation);
     if (!str.isEmpty())
     {
         xml.writeStartElement("text:p");
@@ -467,7 +465,7 @@ void ShiftSheetExport::writeCover(QXmlStreamWriter &xml, const QString &shiftNam
     xml.writeEndElement();
 
     // Description
-    meta->getString(str, MetaDataKey::MeetingDescription);
+    meta.getString(str, MetaDataKey::MeetingDescription);
     if (!str.isEmpty())
     {
         xml.writeStartElement("text:p");
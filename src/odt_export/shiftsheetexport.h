@@ -24,6 +24,8 @@
 
 #include "utils/types.h"
 
+class OdtExportContext;
+
 namespace sqlite3pp {
 class database;
 }
@@ -34,7 +36,13 @@ public:
     ShiftSheetExport(sqlite3pp::database &db, db_id shiftId);
 
     void write();
-    void save(const QString &fileName);
+    bool save(const QString &fileName);
+
+    // Context must use same database, it's not owned
+    inline void setContext(OdtExportContext *ctx)
+    {
+        m_ctx = ctx;
+    }
 
     inline void setShiftId(db_id shiftId)
     {
@@ -49,6 +57,7 @@ private:
 
 private:
     sqlite3pp::database &mDb;
+    OdtExportContext *m_ctx;
     db_id m_shiftId;
 
     OdtDocument odt;
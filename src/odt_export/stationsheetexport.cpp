@@ -19,56 +19,65 @@
 
 #include "stationsheetexport.h"
 
+#include "common/odtexportcontext.h"
+
 #include "common/stationwriter.h"
 
 #include "common/odtutils.h"
+#include "common/sheetexportoptions.h"
 
 #include "app/session.h"
 #include "db_metadata/metadatamanager.h"
 
-#include <QDebug>
-
-StationSheetExport::StationSheetExport(db_id stationId) :
+StationSheetExport::StationSheetExport(sqlite3pp::database &db, db_id stationId) :
+    mDb(db),
+    m_ctx(nullptr),
+    odt(db),
     m_stationId(stationId)
 {
 }
 
 void StationSheetExport::write()
 {
-    qDebug() << "TEMP:" << odt.dir.path();
+    // Use a temporary context if none was set
+    OdtExportContext localCtx(mDb);
+    OdtExportContext &ctx = m_ctx ? *m_ctx : localCtx;
+
     odt.initDocument();
 
     // styles.xml font declarations
     odt.stylesXml.writeStartElement("office:font-face-decls");
-    writeLiberationFontFaces(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::FontFaces);
     odt.stylesXml.writeEndElement(); // office:font-face-decls
 
     // Styles
     odt.stylesXml.writeStartElement("office:styles");
-    writeStandardStyle(odt.stylesXml);
-    writeFooterStyle(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::StandardStyle);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::FooterStyle);
     odt.stylesXml.writeEndElement();
 
     // Automatic styles
     odt.stylesXml.writeStartElement("office:automatic-styles");
-    writePageLayout(odt.stylesXml);
+    ctx.writeFragment(odt.stylesXml, OdtExportContext::PageLayout);
     odt.stylesXml.writeEndElement();
 
-    MetaDataManager *meta = Session->getMetaDataManager();
+    MetaDataManager meta(mDb);
+
+    const SheetExportOptions options = SheetExportOptions::current();
 
     // Retrive header and footer: give precedence to database metadata and then fallback to global
     // application settings If the text was explicitly set to empty in metadata no header/footer
     // will be displayed
     QString header;
-    if (meta->getString(header, MetaDataKey::SheetHeaderText) != MetaDataKey::Result::ValueFound)
+    if (meta.getString(header, MetaDataKey::SheetHeaderText) != MetaDataKey::Result::ValueFound)
     {
-        header = AppSettings.getSheetHeader();
+        header = options.header;
     }
 
     QString footer;
-    if (meta->getString(footer, MetaDataKey::SheetFooterText) != MetaDataKey::Result::ValueFound)
+    if (meta.getString(footer, MetaDataKey::SheetFooterText) != MetaDataKey::Result::ValueFound)
     {
-        footer = AppSettings.getSheetFooter();
+        footer = options.footer;
     }
 
     // Master styles
@@ -78,18 +87,18 @@ void StationSheetExport::write()
 
     // Content font declarations
     odt.contentXml.writeStartElement("office:font-face-decls");
-    writeLiberationFontFaces(odt.contentXml);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::FontFaces);
     odt.contentXml.writeEndElement(); // office:font-face-decls
 
     // Content Automatic styles
     odt.contentXml.writeStartElement("office:automatic-styles");
-    writeCommonStyles(odt.contentXml);
-    StationWriter::writeStationAutomaticStyles(odt.contentXml);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::CommonStyles);
+    ctx.writeFragment(odt.contentXml, OdtExportContext::StationAutomaticStyles);
 
     // Body
     odt.startBody();
 
-    StationWriter w(Session->m_Db);
+    StationWriter &w = ctx.stationWriter();
     QString stName;
     w.writeStation(odt.contentXml, m_stationId, &stName);
     odt.setTitle(Odt::text(Odt::stationDocTitle).arg(stName));
@@ -97,7 +106,7 @@ void StationSheetExport::write()
     odt.endDocument();
 }
 
-void StationSheetExport::save(const QString &fileName)
+bool StationSheetExport::save(const QString &fileName)
 {
-    odt.saveTo(fileName);
+    return odt.saveTo(fileName);
 }
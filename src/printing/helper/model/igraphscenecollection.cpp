@@ -19,10 +19,41 @@
 
 #include "igraphscenecollection.h"
 
-IGraphSceneCollection::IGraphSceneCollection()
+// Default budget for caches and loaded scenes
+static constexpr qint64 DefaultMemoryBudget = 64 * 1024 * 1024;
+
+IGraphSceneCollection::IGraphSceneCollection() :
+    m_memoryBudget(DefaultMemoryBudget),
+    m_optimizeVectorOutput(false)
 {
 }
 
 IGraphSceneCollection::~IGraphSceneCollection()
 {
 }
+
+bool IGraphSceneCollection::supportsParallelLoading() const
+{
+    return false;
+}
+
+IGraphSceneCollection::ItemRef IGraphSceneCollection::getNextItemRef()
+{
+    return ItemRef();
+}
+
+IGraphSceneCollection::SceneItem IGraphSceneCollection::loadItem(const ItemRef &,
+                                                                 sqlite3pp::database &)
+{
+    return SceneItem();
+}
+
+void IGraphSceneCollection::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = bytes;
+}
+
+int IGraphSceneCollection::getPrefetchHint() const
+{
+    return 1;
+}
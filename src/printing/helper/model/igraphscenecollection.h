@@ -22,12 +22,22 @@
 
 #include <QString>
 
+#include "utils/types.h"
+
 class IGraphScene;
 
+namespace sqlite3pp {
+class database;
+}
+
 /*!
  * \brief The IGraphSceneCollection class
  *
  * Represents a forward iterable collection of IGraphScene
+ *
+ * Items are streamed: each scene is loaded when requested and freed by caller.
+ * Collections may share data between consecutive scenes within a memory budget
+ * and tell callers how many items they can load in advance.
  */
 class IGraphSceneCollection
 {
@@ -42,6 +52,17 @@ public:
         QString type;                 //! scene type name
     };
 
+    /*!
+     * \brief The ItemRef struct
+     *
+     * Identifies an item without loading its scene
+     */
+    struct ItemRef
+    {
+        db_id objectId = 0; //! object to load, 0 if iteration ended
+        int type       = 0; //! collection specific type
+    };
+
     IGraphSceneCollection();
     virtual ~IGraphSceneCollection();
 
@@ -69,6 +90,83 @@ public:
      * If iteration got after last item, \ref SceneItem::scene is nullptr
      */
     virtual SceneItem getNextItem() = 0;
+
+    /*!
+     * \brief supportsParallelLoading
+     * \return true if items can be loaded with \ref loadItem()
+     *
+     * Default implementation returns false
+     */
+    virtual bool supportsParallelLoading() const;
+
+    /*!
+     * \brief getNextItemRef
+     * \return reference to next item
+     *
+     * Like \ref getNextItem() but does not load the scene.
+     * If iteration got after last item, \ref ItemRef::objectId is 0
+     * Only valid if \ref supportsParallelLoading() returns true
+     */
+    virtual ItemRef getNextItemRef();
+
+    /*!
+     * \brief loadItem
+     * \param ref item to load
+     * \param db database connection used to load the scene
+     * \return item struct with scene and some infos
+     *
+     * Loads a scene on \a db connection.
+     * It is called concurrently from different threads, each with its own connection
+     * so it must not access collection state.
+     * The caller is responsible to free \ref SceneItem::scene pointer
+     */
+    virtual SceneItem loadItem(const ItemRef &ref, sqlite3pp::database &db);
+
+    /*!
+     * \brief setMemoryBudget
+     * \param bytes approximate memory available to collection caches and loaded scenes
+     *
+     * Default implementation only stores the value
+     * \sa getPrefetchHint()
+     */
+    virtual void setMemoryBudget(qint64 bytes);
+
+    inline qint64 getMemoryBudget() const
+    {
+        return m_memoryBudget;
+    }
+
+    /*!
+     * \brief getPrefetchHint
+     * \return number of items which can be loaded ahead of the one being rendered
+     *
+     * Callers loading scenes in advance should not keep more than this
+     * number of pending scenes so memory budget is respected.
+     * It's always at least 1 so next scene can load while current one renders.
+     * Default implementation returns 1
+     */
+    virtual int getPrefetchHint() const;
+
+    /*!
+     * \brief setOptimizeVectorOutput
+     * \param val true if scenes will be rendered to a vector device like PDF
+     *
+     * Collections can then load scenes with options that reduce drawing operations.
+     * Must be set before \ref startIteration()
+     */
+    inline void setOptimizeVectorOutput(bool val)
+    {
+        m_optimizeVectorOutput = val;
+    }
+
+    inline bool getOptimizeVectorOutput() const
+    {
+        return m_optimizeVectorOutput;
+    }
+
+protected:
+    qint64 m_memoryBudget;
+    bool m_optimizeVectorOutput;
 };
 
 #endif // IGRAPHSCENECOLLECTION_H
@@ -55,6 +55,9 @@ struct PrintBasicOptions
     QString filePath;
     bool useOneFileForEachScene = true;
     bool printSceneInOnePage    = false;
+
+    // Merge job lines in fewer paths and skip off page content to get smaller PDF files
+    bool optimizeVectorOutput = false;
 };
 
 // Implemented in printing/wizard/printwizard.cpp
@@ -107,6 +107,24 @@ void PrintHelper::calculatePageCount(IGraphScene *scene, Print::PageLayoutOpt &p
       qMax(1, qCeil(srcContentsSize.height() / outEffectivePageSizePoints.height()));
 }
 
+void PrintHelper::renderScene(QPainter *painter, IGraphScene *scene, const QRectF &sourceRect)
+{
+    // Render scene contets
+    scene->renderContents(painter, sourceRect);
+
+    // Render horizontal header
+    QRectF horizHeaderRect = sourceRect;
+    horizHeaderRect.moveTop(0);
+    horizHeaderRect.setBottom(scene->getHeaderSize().height());
+    scene->renderHeader(painter, horizHeaderRect, Qt::Horizontal, 0);
+
+    // Render vertical header
+    QRectF vertHeaderRect = sourceRect;
+    vertHeaderRect.moveLeft(0);
+    vertHeaderRect.setRight(scene->getHeaderSize().width());
+    scene->renderHeader(painter, vertHeaderRect, Qt::Vertical, 0);
+}
+
 bool PrintHelper::printPagedScene(QPainter *painter, Print::IPagedPaintDevice *dev,
                                   IGraphScene *scene, Print::IProgress *progress,
                                   Print::PageLayoutScaled &pageLay,
@@ -187,17 +205,25 @@ bool PrintHelper::printPagedScene(QPainter *painter, Print::IPagedPaintDevice *d
             // Render scene contets
             scene->renderContents(painter, sceneRect);
 
-            // Render horizontal header
-            QRectF horizHeaderRect = sceneRect;
-            horizHeaderRect.moveTop(0);
-            horizHeaderRect.setBottom(headerSize.height());
-            scene->renderHeader(painter, horizHeaderRect, Qt::Horizontal, 0);
-
-            // Render vertical header
-            QRectF vertHeaderRect = sceneRect;
-            vertHeaderRect.moveLeft(0);
-            vertHeaderRect.setRight(headerSize.width());
-            scene->renderHeader(painter, vertHeaderRect, Qt::Vertical, 0);
+            // Headers are at scene origin so they are visible only on first row/column
+            // Skip them on other pages, they would be clipped but still written to vector output
+            if (sceneRect.top() < headerSize.height())
+            {
+                // Render horizontal header
+                QRectF horizHeaderRect = sceneRect;
+                horizHeaderRect.moveTop(0);
+                horizHeaderRect.setBottom(headerSize.height());
+                scene->renderHeader(painter, horizHeaderRect, Qt::Horizontal, 0);
+            }
+
+            if (sceneRect.left() < headerSize.width())
+            {
+                // Render vertical header
+                QRectF vertHeaderRect = sceneRect;
+                vertHeaderRect.moveLeft(0);
+                vertHeaderRect.setRight(headerSize.width());
+                scene->renderHeader(painter, vertHeaderRect, Qt::Vertical, 0);
+            }
 
             if (pageLay.lay.drawPageMargins)
             {
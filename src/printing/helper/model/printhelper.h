@@ -114,6 +114,9 @@ public:
     static void calculatePageCount(IGraphScene *scene, Print::PageLayoutOpt &pageLay,
                                    QSizeF &outEffectivePageSizePoints);
 
+    // Render scene contents and headers in a single page
+    static void renderScene(QPainter *painter, IGraphScene *scene, const QRectF &sourceRect);
+
     static bool printPagedScene(QPainter *painter, Print::IPagedPaintDevice *dev,
                                 IGraphScene *scene, Print::IProgress *progress,
                                 Print::PageLayoutScaled &pageLay, Print::PageNumberOpt &pageNumOpt);
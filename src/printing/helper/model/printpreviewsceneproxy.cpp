@@ -25,10 +25,18 @@
 
 #include <QtMath>
 
+// Tile edge in device pixels
+static constexpr int TileSizePixels = 256;
+
+// Maximum number of cached tiles, about 64 MB
+static constexpr int MaxCachedTiles = 256;
+
 PrintPreviewSceneProxy::PrintPreviewSceneProxy(QObject *parent) :
     IGraphScene(parent),
     m_sourceScene(nullptr),
-    viewScaleFactor(1)
+    viewScaleFactor(1),
+    m_tiles(MaxCachedTiles),
+    m_tilePixelScale(0)
 {
     originalHeaderSize = QSizeF(70, 70);
     setViewScaleFactor(1.0);
@@ -69,26 +77,8 @@ void PrintPreviewSceneProxy::renderContents(QPainter *painter, const QRectF &sce
         painter->translate(origin);
         painter->scale(m_pageLay.sourceScaleFactor, m_pageLay.sourceScaleFactor);
 
-        // Draw source contents
-        m_sourceScene->renderContents(painter, sourceRect);
-
-        QSizeF headerSize = m_sourceScene->getHeaderSize();
-
-        // If on top draw horizontal header
-        if (sourceRect.top() < headerSize.height())
-        {
-            QRectF horizHeaderRect = sourceRect;
-            horizHeaderRect.setBottom(headerSize.height());
-            m_sourceScene->renderHeader(painter, horizHeaderRect, Qt::Horizontal, 0);
-        }
-
-        // If on left draw vertical header
-        if (sourceRect.left() < headerSize.width())
-        {
-            QRectF vertHeaderRect = sourceRect;
-            vertHeaderRect.setRight(headerSize.width());
-            m_sourceScene->renderHeader(painter, vertHeaderRect, Qt::Vertical, 0);
-        }
+        // Draw source contents and headers from cached tiles
+        renderSourceTiles(painter, sourceRect);
 
         // Wash out a bit to make page borders more visible
         painter->fillRect(sourceRect, QColor(40, 255, 40, 100));
@@ -170,9 +160,11 @@ void PrintPreviewSceneProxy::setSourceScene(IGraphScene *newSourceScene)
         disconnect(m_sourceScene, &QObject::destroyed, this,
                    &PrintPreviewSceneProxy::onSourceSceneDestroyed);
         disconnect(m_sourceScene, &IGraphScene::redrawGraph, this,
-                   &PrintPreviewSceneProxy::updateSourceSizeAndRedraw);
+                   &PrintPreviewSceneProxy::onSourceSceneChanged);
+        disconnect(m_sourceScene, &IGraphScene::redrawSceneRect, this,
+                   &PrintPreviewSceneProxy::onSourceSceneChanged);
         disconnect(m_sourceScene, &IGraphScene::headersSizeChanged, this,
-                   &PrintPreviewSceneProxy::updateSourceSizeAndRedraw);
+                   &PrintPreviewSceneProxy::onSourceSceneChanged);
     }
     m_sourceScene = newSourceScene;
     if (m_sourceScene)
@@ -180,12 +172,14 @@ void PrintPreviewSceneProxy::setSourceScene(IGraphScene *newSourceScene)
         connect(m_sourceScene, &QObject::destroyed, this,
                 &PrintPreviewSceneProxy::onSourceSceneDestroyed);
         connect(m_sourceScene, &IGraphScene::redrawGraph, this,
-                &PrintPreviewSceneProxy::updateSourceSizeAndRedraw);
+                &PrintPreviewSceneProxy::onSourceSceneChanged);
+        connect(m_sourceScene, &IGraphScene::redrawSceneRect, this,
+                &PrintPreviewSceneProxy::onSourceSceneChanged);
         connect(m_sourceScene, &IGraphScene::headersSizeChanged, this,
-                &PrintPreviewSceneProxy::updateSourceSizeAndRedraw);
+                &PrintPreviewSceneProxy::onSourceSceneChanged);
     }
 
-    updateSourceSizeAndRedraw();
+    onSourceSceneChanged();
 }
 
 double PrintPreviewSceneProxy::getViewScaleFactor() const
@@ -221,6 +215,13 @@ void PrintPreviewSceneProxy::setPageLay(const Print::PageLayoutOpt &newPageLay)
 void PrintPreviewSceneProxy::onSourceSceneDestroyed()
 {
     m_sourceScene = nullptr;
+    onSourceSceneChanged();
+}
+
+void PrintPreviewSceneProxy::onSourceSceneChanged()
+{
+    // Source contents changed, tiles must be rendered again
+    clearTiles();
     updateSourceSizeAndRedraw();
 }
 
@@ -501,3 +502,92 @@ void PrintPreviewSceneProxy::drawPageBorders(QPainter *painter, const QRectF &sc
     marginsVec.clear();
     marginsVec.squeeze();
 }
+
+void PrintPreviewSceneProxy::renderSourceTiles(QPainter *painter, const QRectF &sourceRect)
+{
+    // Painter is already mapped to source coordinates
+    // Tiles are rendered at same resolution as device to keep them sharp
+    const QTransform &t     = painter->worldTransform();
+    const double pixelScale = qSqrt(t.m11() * t.m11() + t.m12() * t.m12())
+                            * painter->device()->devicePixelRatioF();
+    if (pixelScale <= 0)
+        return;
+
+    if (!qFuzzyCompare(pixelScale, m_tilePixelScale))
+    {
+        // View zoom or source scale changed
+        clearTiles();
+        m_tilePixelScale = pixelScale;
+    }
+
+    const double tileSize = TileSizePixels / pixelScale;
+
+    const int firstCol    = qFloor(sourceRect.left() / tileSize);
+    const int lastCol     = qCeil(sourceRect.right() / tileSize);
+    const int firstRow    = qFloor(sourceRect.top() / tileSize);
+    const int lastRow     = qCeil(sourceRect.bottom() / tileSize);
+
+    for (int row = firstRow; row < lastRow; row++)
+    {
+        for (int col = firstCol; col < lastCol; col++)
+        {
+            const QRectF tileRect(col * tileSize, row * tileSize, tileSize, tileSize);
+            QPixmap *tile = getTile(col, row, tileRect);
+            if (tile)
+                painter->drawPixmap(tileRect, *tile, QRectF(tile->rect()));
+        }
+    }
+}
+
+QPixmap *PrintPreviewSceneProxy::getTile(int col, int row, const QRectF &tileRect)
+{
+    const quint64 key = (quint64(quint32(row)) << 32) | quint32(col);
+
+    QPixmap *tile     = m_tiles.object(key);
+    if (tile)
+        return tile;
+
+    // Do not render outside source contents
+    const QSizeF contentsSize = m_sourceScene->getContentsSize();
+    const QRectF rect         = tileRect.intersected(QRectF(QPointF(), contentsSize));
+    if (rect.isEmpty())
+        return nullptr;
+
+    tile = new QPixmap(TileSizePixels, TileSizePixels);
+    tile->fill(Qt::transparent);
+
+    QPainter painter(tile);
+    painter.scale(m_tilePixelScale, m_tilePixelScale);
+    painter.translate(-tileRect.topLeft());
+    painter.setClipRect(rect);
+
+    m_sourceScene->renderContents(&painter, rect);
+
+    const QSizeF headerSize = m_sourceScene->getHeaderSize();
+
+    // If on top draw horizontal header
+    if (rect.top() < headerSize.height())
+    {
+        QRectF horizHeaderRect = rect;
+        horizHeaderRect.setBottom(headerSize.height());
+        m_sourceScene->renderHeader(&painter, horizHeaderRect, Qt::Horizontal, 0);
+    }
+
+    // If on left draw vertical header
+    if (rect.left() < headerSize.width())
+    {
+        QRectF vertHeaderRect = rect;
+        vertHeaderRect.setRight(headerSize.width());
+        m_sourceScene->renderHeader(&painter, vertHeaderRect, Qt::Vertical, 0);
+    }
+
+    painter.end();
+
+    m_tiles.insert(key, tile);
+    return tile;
+}
+
+void PrintPreviewSceneProxy::clearTiles()
+{
+    m_tiles.clear();
+}
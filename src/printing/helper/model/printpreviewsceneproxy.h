@@ -24,6 +24,17 @@
 
 #include "printhelper.h"
 
+#include <QCache>
+#include <QPixmap>
+
+/*!
+ * \brief The PrintPreviewSceneProxy class
+ *
+ * Shows source scene split in printed pages.
+ * Source scene is rendered in pixmap tiles which are reused for every repaint,
+ * so scrolling and changing page margins only redraw page overlays.
+ * Tiles are discarded when source scene changes or the rendering scale changes.
+ */
 class PrintPreviewSceneProxy : public IGraphScene
 {
     Q_OBJECT
@@ -48,9 +59,14 @@ signals:
 
 private slots:
     void onSourceSceneDestroyed();
+    void onSourceSceneChanged();
     void updateSourceSizeAndRedraw();
 
 private:
+    void renderSourceTiles(QPainter *painter, const QRectF &sourceRect);
+    QPixmap *getTile(int col, int row, const QRectF &tileRect);
+    void clearTiles();
+
     void drawPageBorders(QPainter *painter, const QRectF &sceneRect, bool isHeader,
                          Qt::Orientation orient = Qt::Horizontal);
 
@@ -61,6 +77,10 @@ private:
 
     double viewScaleFactor;
     QSizeF originalHeaderSize;
+
+    // Tiles of source scene, keyed by row and column
+    QCache<quint64, QPixmap> m_tiles;
+    double m_tilePixelScale;
 };
 
 #endif // PRINTPREVIEWSCENEPROXY_H
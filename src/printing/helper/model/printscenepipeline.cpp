@@ -0,0 +1,274 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "printscenepipeline.h"
+#include "printing/wizard/printwizard.h" //For translations
+
+#include "printing/helper/model/printhelper.h"
+#include "utils/scene/igraphscene.h"
+
+#include <QPainter>
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <sqlite3pp/sqlite3pp.h>
+
+#include <QDebug>
+
+class PrintSceneLoader : public QRunnable
+{
+public:
+    PrintSceneLoader(PrintScenePipeline *pipeline, int loaderIdx) :
+        m_pipeline(pipeline),
+        m_loaderIdx(loaderIdx)
+    {
+        setAutoDelete(true);
+    }
+
+    void run() override
+    {
+        m_pipeline->runLoader(m_loaderIdx);
+    }
+
+private:
+    PrintScenePipeline *m_pipeline;
+    int m_loaderIdx;
+};
+
+PrintScenePipeline::PrintScenePipeline(IGraphSceneCollection *collection, const QString &dbPath,
+                                       Mode mode) :
+    m_collection(collection),
+    m_dbPath(dbPath),
+    m_printThread(nullptr),
+    m_mode(mode),
+    m_nextToLoad(0),
+    m_nextToTake(0),
+    m_maxAhead(0),
+    m_runningLoaders(0),
+    m_stopped(false)
+{
+}
+
+PrintScenePipeline::~PrintScenePipeline()
+{
+    stop();
+
+    // Delete scenes which were not taken before closing their connections
+    for (std::unique_ptr<Page> &page : m_pages)
+    {
+        if (page)
+            delete page->item.scene;
+    }
+    m_pages.clear();
+    m_connections.clear();
+}
+
+void PrintScenePipeline::setWriteFunc(const WriteFunc &func)
+{
+    m_writeFunc = func;
+}
+
+bool PrintScenePipeline::start(int maxThreads)
+{
+    m_printThread = QThread::currentThread();
+    m_style       = GraphStyle::current();
+
+    if (!m_collection->supportsParallelLoading() || !m_collection->startIteration())
+        return false;
+
+    if (m_mode == Mode::Write && !m_writeFunc)
+        return false;
+
+    // References are cheap, collect all of them now
+    m_refs.clear();
+    while (true)
+    {
+        const IGraphSceneCollection::ItemRef ref = m_collection->getNextItemRef();
+        if (!ref.objectId)
+            break;
+        m_refs.append(ref);
+    }
+
+    m_pages.clear();
+    m_pages.resize(size_t(m_refs.size()));
+
+    if (m_refs.isEmpty())
+        return true; // Nothing to load
+
+    // Collection tells how many scenes fit its memory budget
+    const int prefetch = qMax(1, m_collection->getPrefetchHint());
+
+    // Printing thread also needs a core
+    int threadCount    = maxThreads > 0 ? maxThreads : QThread::idealThreadCount() - 1;
+    threadCount        = qBound(1, threadCount, qMin(m_refs.size(), prefetch));
+
+    const QByteArray path = m_dbPath.toUtf8();
+    for (int i = 0; i < threadCount; i++)
+    {
+        std::unique_ptr<sqlite3pp::database> db(new sqlite3pp::database);
+        if (db->connect(path.constData(), SQLITE_OPEN_READONLY) != SQLITE_OK)
+        {
+            qWarning() << "PrintScenePipeline: cannot open database" << db->error_msg();
+            break;
+        }
+
+        // Same settings as main connection
+        db->enable_foreign_keys(true);
+        db->enable_extended_result_codes(true);
+        m_connections.push_back(std::move(db));
+    }
+
+    if (m_connections.empty())
+        return false;
+
+    m_maxAhead       = prefetch;
+    m_runningLoaders = int(m_connections.size());
+
+    for (int i = 0; i < m_runningLoaders; i++)
+        QThreadPool::globalInstance()->start(new PrintSceneLoader(this, i));
+
+    return true;
+}
+
+PrintScenePipeline::Result PrintScenePipeline::takeNext(Page &out, QString &errOut)
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (m_nextToTake >= m_refs.size())
+        return Result::Finished;
+
+    std::unique_ptr<Page> &slot = m_pages[size_t(m_nextToTake)];
+    while (!slot && !m_stopped)
+        m_pageReady.wait(&m_mutex);
+
+    if (!slot)
+    {
+        errOut = PrintWizard::tr("Printing was stopped.");
+        return Result::Error;
+    }
+
+    out = std::move(*slot);
+    slot.reset();
+
+    // Let loaders go ahead
+    m_nextToTake++;
+    m_loaderCanContinue.wakeAll();
+
+    if (!out.errMsg.isEmpty())
+    {
+        errOut = out.errMsg;
+        return Result::Error;
+    }
+
+    return Result::Ok;
+}
+
+void PrintScenePipeline::stop()
+{
+    QMutexLocker lock(&m_mutex);
+
+    m_stopped = true;
+    m_loaderCanContinue.wakeAll();
+
+    // Wait for loaders to finish current scene
+    while (m_runningLoaders > 0)
+        m_pageReady.wait(&m_mutex);
+}
+
+void PrintScenePipeline::runLoader(int loaderIdx)
+{
+    sqlite3pp::database &db = *m_connections[size_t(loaderIdx)];
+
+    // Settings must not be read outside main thread
+    GraphStyle::ThreadScope styleScope(&m_style);
+
+    QMutexLocker lock(&m_mutex);
+    while (true)
+    {
+        // Do not get too far from printing thread
+        while (!m_stopped && m_nextToLoad < m_refs.size()
+               && m_nextToLoad >= m_nextToTake + m_maxAhead)
+        {
+            m_loaderCanContinue.wait(&m_mutex);
+        }
+
+        if (m_stopped || m_nextToLoad >= m_refs.size())
+            break;
+
+        const int idx = m_nextToLoad++;
+
+        lock.unlock();
+        std::unique_ptr<Page> page(new Page);
+        loadPage(db, idx, *page);
+        lock.relock();
+
+        m_pages[size_t(idx)] = std::move(page);
+        m_pageReady.wakeAll();
+    }
+
+    m_runningLoaders--;
+    m_pageReady.wakeAll();
+}
+
+void PrintScenePipeline::loadPage(sqlite3pp::database &db, int idx, Page &page)
+{
+    page.item = m_collection->loadItem(m_refs.at(idx), db);
+
+    IGraphScene *scene = page.item.scene;
+    if (!scene)
+    {
+        page.errMsg = PrintWizard::tr("Cannot load item %1.\n"
+                                      "Check database connection.")
+                        .arg(idx + 1);
+        return;
+    }
+
+    page.contentsSize = scene->getContentsSize();
+
+    switch (m_mode)
+    {
+    case Mode::Load:
+    {
+        // Scene will be rendered and deleted by printing thread
+        scene->moveToThread(m_printThread);
+        return;
+    }
+    case Mode::Record:
+    {
+        const QRectF sourceRect(QPointF(), page.contentsSize);
+
+        QPainter painter(&page.picture);
+        PrintHelper::renderScene(&painter, scene, sourceRect);
+        painter.end();
+
+        page.recorded = true;
+        break;
+    }
+    case Mode::Write:
+    {
+        page.written = m_writeFunc(scene, page, idx, page.errMsg);
+        break;
+    }
+    }
+
+    delete scene;
+    page.item.scene = nullptr;
+}
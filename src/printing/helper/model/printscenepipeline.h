@@ -0,0 +1,153 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef PRINTSCENEPIPELINE_H
+#define PRINTSCENEPIPELINE_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include <QPicture>
+#include <QVector>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "printing/helper/model/igraphscenecollection.h"
+#include "graph/view/graphstyle.h"
+
+class QThread;
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The PrintScenePipeline class
+ *
+ * Loads scenes of an IGraphSceneCollection in parallel for PrintWorker.
+ * Each loader thread uses its own read-only database connection
+ * so it only sees committed data.
+ * Loaders render with the GraphStyle of printing thread, they never read settings.
+ *
+ * Depending on \ref Mode loaded scenes are:
+ * - Load: moved to printing thread which renders them.
+ * - Record: rendered by loaders in a QPicture which printing thread replays on output device.
+ * - Write: rendered by loaders directly to their own output, see \ref setWriteFunc()
+ *
+ * Pages are returned in collection order by \ref takeNext()
+ * Loaders work at most \ref IGraphSceneCollection::getPrefetchHint() pages ahead
+ * to respect collection memory budget.
+ *
+ * \sa PrintWorker
+ */
+class PrintScenePipeline
+{
+public:
+    enum class Mode
+    {
+        Load = 0,
+        Record,
+        Write
+    };
+
+    enum class Result
+    {
+        Ok = 0,
+        Finished,
+        Error
+    };
+
+    struct Page
+    {
+        IGraphSceneCollection::SceneItem item; //! scene is nullptr if page was recorded
+        QSizeF contentsSize;
+        QPicture picture;
+        QString errMsg;
+        bool recorded = false;
+        bool written  = false;
+    };
+
+    /*!
+     * Renders scene to a page specific output, used in Write mode.
+     * It is called concurrently by loaders so it must be thread safe.
+     * On failure it returns false and sets error message.
+     */
+    typedef std::function<bool(IGraphScene *scene, const Page &page, int idx, QString &errOut)>
+      WriteFunc;
+
+    PrintScenePipeline(IGraphSceneCollection *collection, const QString &dbPath, Mode mode);
+    ~PrintScenePipeline();
+
+    void setWriteFunc(const WriteFunc &func);
+
+    /*!
+     * \brief start
+     * \param maxThreads maximum number of loaders, 0 to use ideal thread count
+     * \return true on success
+     *
+     * Collects items to load and starts loaders.
+     * Must be called from printing thread before \ref takeNext()
+     * Current GraphStyle of printing thread is copied to loaders.
+     */
+    bool start(int maxThreads = 0);
+
+    /*!
+     * \brief takeNext
+     * \param out filled with next page
+     * \param errOut error message in case of failure
+     * \return Finished after last page
+     *
+     * Waits for next page to be loaded.
+     * Caller becomes owner of \ref SceneItem::scene
+     */
+    Result takeNext(Page &out, QString &errOut);
+
+    // Stop loaders and wait for them, pages not yet taken are discarded
+    void stop();
+
+private:
+    friend class PrintSceneLoader;
+    void runLoader(int loaderIdx);
+    void loadPage(sqlite3pp::database &db, int idx, Page &page);
+
+private:
+    IGraphSceneCollection *m_collection;
+    QString m_dbPath;
+    QThread *m_printThread;
+    Mode m_mode;
+    WriteFunc m_writeFunc;
+    GraphStyle m_style;
+
+    QVector<IGraphSceneCollection::ItemRef> m_refs;
+    std::vector<std::unique_ptr<Page>> m_pages;
+    std::vector<std::unique_ptr<sqlite3pp::database>> m_connections;
+
+    QMutex m_mutex;
+    QWaitCondition m_pageReady;
+    QWaitCondition m_loaderCanContinue;
+
+    int m_nextToLoad;
+    int m_nextToTake;
+    int m_maxAhead;
+    int m_runningLoaders;
+    bool m_stopped;
+};
+
+#endif // PRINTSCENEPIPELINE_H
@@ -33,6 +33,9 @@
 #include "info.h"
 
 #include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QElapsedTimer>
 
 #include <QtMath>
 
@@ -64,7 +67,8 @@ PrintProgressEvent::PrintProgressEvent(QRunnable *self, int pr, const QString &d
 PrintWorker::PrintWorker(sqlite3pp::database &db, QObject *receiver) :
     IQuittableTask(receiver),
     m_printer(nullptr),
-    m_collection(nullptr)
+    m_collection(nullptr),
+    m_style(GraphStyle::fromSettings())
 {
 }
 
@@ -100,10 +104,26 @@ void PrintWorker::setScenePageLay(const Print::PageLayoutOpt &pageLay)
     scenePageLay = pageLay;
 }
 
+void PrintWorker::setDatabasePath(const QString &path)
+{
+    m_dbPath = path;
+}
+
 void PrintWorker::run()
 {
+    // Scenes rendered on this thread and by loaders use this style
+    GraphStyle::ThreadScope styleScope(&m_style);
+
     sendEvent(new PrintProgressEvent(this, 0, QString()), false);
 
+    QElapsedTimer timer;
+    timer.start();
+    m_outputFiles.clear();
+
+    // Vector optimizations must be set before iteration starts
+    m_collection->setOptimizeVectorOutput(printOpt.outputType == Print::OutputType::Pdf
+                                          && printOpt.optimizeVectorOutput);
+
     bool success = true;
 
     switch (printOpt.outputType)
@@ -130,17 +150,38 @@ void PrintWorker::run()
 
     if (success)
     {
-        // Send 'Finished' and quit
-        sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressMaxFinished, QString()),
+        // Send 'Finished' with output summary and quit
+        sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressMaxFinished,
+                                         getOutputSummary(timer.elapsed())),
                   true);
     }
 }
 
+QString PrintWorker::getOutputSummary(qint64 elapsedMsec) const
+{
+    const QString seconds = QString::number(elapsedMsec / 1000.0, 'f', 1);
+
+    if (m_outputFiles.isEmpty())
+        return PrintWizard::tr("Printed in %1 seconds.").arg(seconds);
+
+    // All files are closed now, so their size is final
+    qint64 totalSize = 0;
+    for (const QString &fileName : m_outputFiles)
+        totalSize += QFileInfo(fileName).size();
+
+    return PrintWizard::tr("Written %1 in %2 file(s) in %3 seconds.")
+      .arg(QLocale().formattedDataSize(totalSize))
+      .arg(m_outputFiles.size())
+      .arg(seconds);
+}
+
 bool PrintWorker::printInternal(BeginPaintFunc func, bool endPaintingEveryPage)
 {
     QPainter painter;
 
-    if (!m_collection->startIteration())
+    // Each scene is a single page so loaders can also record it
+    std::unique_ptr<PrintScenePipeline> pipeline;
+    if (!startIteration(pipeline, PrintScenePipeline::Mode::Record))
     {
         // Send error and quit
         sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressError,
@@ -162,38 +203,28 @@ bool PrintWorker::printInternal(BeginPaintFunc func, bool endPaintingEveryPage)
             return false;
         }
 
-        // Lock to access 'm_collection'
-        lockTask();
-        if (!m_collection)
-        {
-            unlockTask();
-
-            // Task cannot proceed without collection. Abort
-            sendEvent(
-              new PrintProgressEvent(this, PrintProgressEvent::ProgressAbortedByUser, QString()),
-              true);
+        PrintScenePipeline::Page page;
+        if (!getNextPage(pipeline.get(), page))
             return false;
-        }
-        const IGraphSceneCollection::SceneItem item = m_collection->getNextItem();
-        unlockTask();
 
-        if (!item.scene)
+        if (!page.item.scene && !page.recorded)
             break; // Finished
 
-        QScopedPointer<IGraphScene> scenPtr(item.scene);
+        QScopedPointer<IGraphScene> scenPtr(page.item.scene);
 
-        const QRectF sourceRect(QPointF(), scenPtr->getContentsSize());
+        const QRectF sourceRect(QPointF(), page.contentsSize);
 
         // Send progress and description
-        sendEvent(new PrintProgressEvent(this, progressiveNum * ProgressStepsForScene, item.name),
-                  false);
+        sendEvent(
+          new PrintProgressEvent(this, progressiveNum * ProgressStepsForScene, page.item.name),
+          false);
 
         if (func)
         {
             bool valid = true;
             // Callback might access 'this' pointer so lock
             lockTask();
-            valid = func(&painter, item.name, sourceRect, item.type, progressiveNum);
+            valid = func(&painter, page.item.name, sourceRect, page.item.type, progressiveNum);
             unlockTask();
             if (!valid)
                 return false;
@@ -204,20 +235,10 @@ bool PrintWorker::printInternal(BeginPaintFunc func, bool endPaintingEveryPage)
             return true;
         }
 
-        // Render scene contets
-        scenPtr->renderContents(&painter, sourceRect);
-
-        // Render horizontal header
-        QRectF horizHeaderRect = sourceRect;
-        horizHeaderRect.moveTop(0);
-        horizHeaderRect.setBottom(item.scene->getHeaderSize().height());
-        scenPtr->renderHeader(&painter, horizHeaderRect, Qt::Horizontal, 0);
-
-        // Render vertical header
-        QRectF vertHeaderRect = sourceRect;
-        vertHeaderRect.moveLeft(0);
-        vertHeaderRect.setRight(item.scene->getHeaderSize().width());
-        scenPtr->renderHeader(&painter, vertHeaderRect, Qt::Vertical, 0);
+        if (page.recorded)
+            painter.drawPicture(QPointF(), page.picture);
+        else
+            PrintHelper::renderScene(&painter, scenPtr.data(), sourceRect);
 
         if (endPaintingEveryPage)
             painter.end();
@@ -228,6 +249,61 @@ bool PrintWorker::printInternal(BeginPaintFunc func, bool endPaintingEveryPage)
     return true;
 }
 
+bool PrintWorker::startIteration(std::unique_ptr<PrintScenePipeline> &pipeline,
+                                 PrintScenePipeline::Mode mode)
+{
+    if (!m_dbPath.isEmpty() && m_collection->supportsParallelLoading())
+    {
+        pipeline.reset(new PrintScenePipeline(m_collection, m_dbPath, mode));
+        if (pipeline->start())
+            return true;
+
+        // Fallback to loading on main connection
+        qWarning() << "PrintWorker: cannot start parallel loading, using single thread";
+        pipeline.reset();
+    }
+
+    return m_collection->startIteration();
+}
+
+bool PrintWorker::getNextPage(PrintScenePipeline *pipeline, PrintScenePipeline::Page &page)
+{
+    if (pipeline)
+    {
+        QString errMsg;
+        if (pipeline->takeNext(page, errMsg) == PrintScenePipeline::Result::Error)
+        {
+            // Send error and quit
+            sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressError, errMsg),
+                      true);
+            return false;
+        }
+
+        // On Finished page is left empty
+        return true;
+    }
+
+    // Lock to access 'm_collection'
+    lockTask();
+    if (!m_collection)
+    {
+        unlockTask();
+
+        // Task cannot proceed without collection. Abort
+        sendEvent(
+          new PrintProgressEvent(this, PrintProgressEvent::ProgressAbortedByUser, QString()),
+          true);
+        return false;
+    }
+    page.item = m_collection->getNextItem();
+    unlockTask();
+
+    if (page.item.scene)
+        page.contentsSize = page.item.scene->getContentsSize();
+
+    return true;
+}
+
 class PrintWorkerProgress : public Print::IProgress
 {
 public:
@@ -295,7 +371,9 @@ bool PrintWorker::printInternalPaged(BeginPaintFunc func, bool endPaintingEveryP
 
     QPainter painter;
 
-    if (!m_collection->startIteration())
+    // Scenes are split in many pages, loaders only load them
+    std::unique_ptr<PrintScenePipeline> pipeline;
+    if (!startIteration(pipeline, PrintScenePipeline::Mode::Load))
     {
         // Send error and quit
         sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressError,
@@ -327,7 +405,11 @@ bool PrintWorker::printInternalPaged(BeginPaintFunc func, bool endPaintingEveryP
             return false;
         }
 
-        const IGraphSceneCollection::SceneItem item = m_collection->getNextItem();
+        PrintScenePipeline::Page page;
+        if (!getNextPage(pipeline.get(), page))
+            return false;
+
+        const IGraphSceneCollection::SceneItem &item = page.item;
         if (!item.scene)
             break; // Finished
 
@@ -340,7 +422,7 @@ bool PrintWorker::printInternalPaged(BeginPaintFunc func, bool endPaintingEveryP
           new PrintProgressEvent(this, progress.sceneNumber * ProgressStepsForScene, item.name),
           false);
 
-        const QRectF sceneRect(QPointF(), scenPtr->getContentsSize());
+        const QRectF sceneRect(QPointF(), page.contentsSize);
         bool valid = true;
         if (func)
             valid = func(&painter, item.name, sceneRect, item.type,
@@ -386,56 +468,141 @@ bool PrintWorker::sendProgressOrAbort(int progress, const QString &msg)
     return true;
 }
 
-bool PrintWorker::printSvg()
+static bool beginSvgPainting(QPainter *painter, QSvgGenerator *svg, const QString &fileName,
+                             const QString &title, const QRectF &sourceRect, QString &errOut)
 {
-    std::unique_ptr<QSvgGenerator> svg;
     const QString docTitle = QStringLiteral("Timetable Session (%1)");
     const QString descr    = QStringLiteral("Generated by %1").arg(AppDisplayName);
 
-    auto beginPaint = [this, &svg, &docTitle, &descr](QPainter *painter, const QString &title,
-                                                      const QRectF &sourceRect, const QString &type,
-                                                      int progressiveNum) -> bool
+    svg->setTitle(docTitle.arg(title));
+    svg->setDescription(descr);
+    svg->setFileName(fileName);
+    svg->setSize(sourceRect.size().toSize());
+    svg->setViewBox(sourceRect);
+
+    if (!painter->begin(svg))
+    {
+        qWarning() << "PrintWorker::printSvg(): cannot begin QPainter";
+        QString fileErr;
+        bool writable = testFileIsWriteable(fileName, fileErr);
+
+        if (!writable)
+        {
+            errOut = PrintWizard::tr("SVG Error: cannot open output file.\n"
+                                     "Path: \"%1\"\n"
+                                     "Error: %2")
+                       .arg(fileName, fileErr);
+        }
+        else
+        {
+            errOut = PrintWizard::tr("SVG Error: generic error.");
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+bool PrintWorker::printSvg()
+{
+    if (!m_dbPath.isEmpty() && m_collection->supportsParallelLoading())
+    {
+        // Each scene has its own file, let loaders write them in parallel
+        // They render with m_style copied by pipeline, so this must not read settings
+        const Print::PrintBasicOptions opt = printOpt;
+
+        auto writeSvg = [opt](IGraphScene *scene, const PrintScenePipeline::Page &page, int idx,
+                              QString &errOut) -> bool
+        {
+            const QString fileName =
+              Print::getFileName(opt.filePath, opt.fileNamePattern, QLatin1String(".svg"),
+                                 page.item.name, page.item.type, idx);
+            const QRectF sourceRect(QPointF(), page.contentsSize);
+
+            QSvgGenerator svg;
+            QPainter painter;
+            if (!beginSvgPainting(&painter, &svg, fileName, page.item.name, sourceRect, errOut))
+                return false;
+
+            PrintHelper::renderScene(&painter, scene, sourceRect);
+            painter.end();
+            return true;
+        };
+
+        PrintScenePipeline pipeline(m_collection, m_dbPath, PrintScenePipeline::Mode::Write);
+        pipeline.setWriteFunc(writeSvg);
+        if (pipeline.start())
+            return printWrittenPages(&pipeline);
+
+        // Fallback to writing on this thread
+        qWarning() << "PrintWorker: cannot start parallel SVG export, using single thread";
+    }
+
+    std::unique_ptr<QSvgGenerator> svg;
+
+    auto beginPaint = [this, &svg](QPainter *painter, const QString &title,
+                                   const QRectF &sourceRect, const QString &type,
+                                   int progressiveNum) -> bool
     {
         const QString fileName =
           Print::getFileName(printOpt.filePath, printOpt.fileNamePattern, QLatin1String(".svg"),
                              title, type, progressiveNum);
         svg.reset(new QSvgGenerator);
-        svg->setTitle(docTitle.arg(title));
-        svg->setDescription(descr);
-        svg->setFileName(fileName);
-        svg->setSize(sourceRect.size().toSize());
-        svg->setViewBox(sourceRect);
 
-        if (!painter->begin(svg.get()))
+        QString errMsg;
+        if (!beginSvgPainting(painter, svg.get(), fileName, title, sourceRect, errMsg))
         {
-            qWarning() << "PrintWorker::printSvg(): cannot begin QPainter";
-            QString fileErr;
-            bool writable = testFileIsWriteable(fileName, fileErr);
-
-            QString msg;
-            if (!writable)
-            {
-                msg = PrintWizard::tr("SVG Error: cannot open output file.\n"
-                                      "Path: \"%1\"\n"
-                                      "Error: %2")
-                        .arg(fileName, fileErr);
-            }
-            else
-            {
-                msg = PrintWizard::tr("SVG Error: generic error.");
-            }
-
             // Send error and quit
-            sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressError, msg), true);
+            sendEvent(new PrintProgressEvent(this, PrintProgressEvent::ProgressError, errMsg),
+                      true);
             return false;
         }
 
+        m_outputFiles.append(fileName);
         return true;
     };
 
     return printInternal(beginPaint, true);
 }
 
+bool PrintWorker::printWrittenPages(PrintScenePipeline *pipeline)
+{
+    int progressiveNum = 0;
+
+    while (true)
+    {
+        if (wasStopped())
+        {
+            sendEvent(
+              new PrintProgressEvent(this, PrintProgressEvent::ProgressAbortedByUser, QString()),
+              true);
+            return false;
+        }
+
+        // Pages are already written, just report them in order
+        PrintScenePipeline::Page page;
+        if (!getNextPage(pipeline, page))
+            return false;
+
+        if (!page.written)
+            break; // Finished
+
+        // Only SVG pages are written by loaders, use same file name
+        m_outputFiles.append(Print::getFileName(printOpt.filePath, printOpt.fileNamePattern,
+                                                QLatin1String(".svg"), page.item.name,
+                                                page.item.type, progressiveNum));
+
+        sendEvent(
+          new PrintProgressEvent(this, progressiveNum * ProgressStepsForScene, page.item.name),
+          false);
+
+        progressiveNum++;
+    }
+
+    return true;
+}
+
 bool PrintWorker::printPdf()
 {
     std::unique_ptr<QPdfWriter> writer;
@@ -456,6 +623,7 @@ bool PrintWorker::printPdf()
         {
             // First page of new scene, create a new PDF
             writer.reset(new QPdfWriter(fileName));
+            m_outputFiles.append(fileName);
 
             writer->setCreator(AppDisplayName);
             writer->setTitle(title);
@@ -25,9 +25,13 @@
 
 #include "printdefs.h"
 
+#include <QStringList>
+
 #include "utils/types.h"
 
 #include "printing/helper/model/printhelper.h"
+#include "printing/helper/model/printscenepipeline.h"
+#include "graph/view/graphstyle.h"
 
 class QPrinter;
 class QPainter;
@@ -77,6 +81,15 @@ public:
 
     void setScenePageLay(const Print::PageLayoutOpt &pageLay);
 
+    /*!
+     * \brief setDatabasePath
+     * \param path database file, empty to disable parallel loading
+     *
+     * If set and collection supports it, scenes are loaded in parallel
+     * on separate connections. See \ref PrintScenePipeline
+     */
+    void setDatabasePath(const QString &path);
+
     // IQuittableTask
     void run() override;
 
@@ -93,6 +106,14 @@ private:
     bool printInternal(BeginPaintFunc func, bool endPaintingEveryPage);
     bool printInternalPaged(BeginPaintFunc func, bool endPaintingEveryPage);
 
+    bool printWrittenPages(PrintScenePipeline *pipeline);
+
+    bool startIteration(std::unique_ptr<PrintScenePipeline> &pipeline,
+                        PrintScenePipeline::Mode mode);
+    bool getNextPage(PrintScenePipeline *pipeline, PrintScenePipeline::Page &page);
+
+    QString getOutputSummary(qint64 elapsedMsec) const;
+
 public:
     // For each scene, count 10 steps
     static constexpr int ProgressStepsForScene = 10;
@@ -105,6 +126,13 @@ private:
     Print::PageLayoutOpt scenePageLay;
 
     IGraphSceneCollection *m_collection;
+    QString m_dbPath;
+
+    // Taken on main thread, settings must not be read while printing
+    GraphStyle m_style;
+
+    // Files written by last run, used to report output size
+    QStringList m_outputFiles;
 };
 
 #endif // PRINTWORKER_H
@@ -20,8 +20,13 @@
 #include "printworkerhandler.h"
 
 #include "printing/helper/model/printworker.h"
+#include "printing/helper/model/igraphscenecollection.h"
 #include <QThreadPool>
 
+#include "app/session.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+
 PrintWorkerHandler::PrintWorkerHandler(sqlite3pp::database &db, QObject *parent) :
     QObject(parent),
     mDb(db),
@@ -58,7 +63,12 @@ bool PrintWorkerHandler::event(QEvent *e)
             else if (ev->progress == PrintProgressEvent::ProgressAbortedByUser)
                 description = tr("Canceled");
             else if (ev->progress == PrintProgressEvent::ProgressMaxFinished)
+            {
+                // Worker reports output size and time
                 description = tr("Done!");
+                if (!ev->descriptionOrError.isEmpty())
+                    description += QLatin1Char(' ') + ev->descriptionOrError;
+            }
             else
                 description = tr("Printing %1...").arg(ev->descriptionOrError);
 
@@ -84,12 +94,24 @@ void PrintWorkerHandler::startPrintTask(QPrinter *printer, IGraphSceneCollection
 
     Print::validatePrintOptions(printOpt, printer);
 
+    // Settings are not thread safe, set budget before task starts
+    collection->setMemoryBudget(qint64(AppSettings.getPrintMemoryBudgetMiB()) * 1024 * 1024);
+
     printTask = new PrintWorker(mDb, this);
     printTask->setPrintOpt(printOpt);
     printTask->setScenePageLay(scenePageLay);
     printTask->setCollection(collection);
     printTask->setPrinter(printer);
 
+    // Loaders use separate connections which only see committed data
+    // So load in parallel only if main connection has no pending changes
+    const char *dbPath = mDb.db() ? sqlite3_db_filename(mDb.db(), "main") : nullptr;
+    if (collection->supportsParallelLoading() && dbPath && dbPath[0] != '\0'
+        && sqlite3_get_autocommit(mDb.db()))
+    {
+        printTask->setDatabasePath(QString::fromUtf8(dbPath));
+    }
+
     QThreadPool::globalInstance()->start(printTask);
 
     // Start progress
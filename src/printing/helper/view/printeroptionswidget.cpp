@@ -80,6 +80,7 @@ void PrinterOptionsWidget::setOptions(const Print::PrintBasicOptions &printOpt)
     patternEdit->setText(printOpt.fileNamePattern);
     differentFilesCheckBox->setChecked(printOpt.useOneFileForEachScene);
     sceneInOnePageCheckBox->setChecked(printOpt.printSceneInOnePage);
+    optimizeVectorCheckBox->setChecked(printOpt.optimizeVectorOutput);
     outputTypeCombo->setCurrentIndex(int(printOpt.outputType));
     updateOutputType();
 
@@ -96,6 +97,7 @@ Print::PrintBasicOptions PrinterOptionsWidget::getOptions() const
     printOpt.fileNamePattern        = patternEdit->text();
     printOpt.useOneFileForEachScene = differentFilesCheckBox->isChecked();
     printOpt.printSceneInOnePage    = sceneInOnePageCheckBox->isChecked();
+    printOpt.optimizeVectorOutput   = optimizeVectorCheckBox->isChecked();
     printOpt.outputType             = Print::OutputType(outputTypeCombo->currentIndex());
     return printOpt;
 }
@@ -348,6 +350,7 @@ void PrinterOptionsWidget::updateOutputType()
     fileBox->setEnabled(type != Print::OutputType::Native);
 
     pageLayoutBox->setEnabled(type != Print::OutputType::Svg);
+    optimizeVectorCheckBox->setEnabled(type == Print::OutputType::Pdf);
     pageSetupDlgBut->setText(type == Print::OutputType::Native ? tr("Printer Options")
                                                                : tr("Page Setup"));
 
@@ -400,6 +403,12 @@ void PrinterOptionsWidget::createFilesBox()
       tr("This will print a custom page size to fit everything in one page.\n"
          "Not available on native printer."));
 
+    optimizeVectorCheckBox = new QCheckBox(tr("Optimize PDF size"));
+    optimizeVectorCheckBox->setToolTip(
+      tr("Merge job lines of same category and skip hidden content.\n"
+         "Produces smaller PDF files which open faster on tablets.\n"
+         "Available only for PDF output."));
+
     pathEdit = new QLineEdit;
     connect(pathEdit, &QLineEdit::textChanged, this, &PrinterOptionsWidget::completeChanged);
 
@@ -415,10 +424,11 @@ void PrinterOptionsWidget::createFilesBox()
     QGridLayout *l = new QGridLayout;
     l->addWidget(differentFilesCheckBox, 0, 0, 1, 2);
     l->addWidget(sceneInOnePageCheckBox, 1, 0, 1, 2);
-    l->addWidget(label, 2, 0, 1, 2);
-    l->addWidget(pathEdit, 3, 0);
-    l->addWidget(fileBut, 3, 1);
-    l->addWidget(patternEdit, 4, 0);
+    l->addWidget(optimizeVectorCheckBox, 2, 0, 1, 2);
+    l->addWidget(label, 3, 0, 1, 2);
+    l->addWidget(pathEdit, 4, 0);
+    l->addWidget(fileBut, 4, 1);
+    l->addWidget(patternEdit, 5, 0);
     fileBox->setLayout(l);
 
     QString patternHelp = tr("File name pattern:<br>"
@@ -72,6 +72,7 @@ private:
     QGroupBox *fileBox;
     QCheckBox *differentFilesCheckBox;
     QCheckBox *sceneInOnePageCheckBox;
+    QCheckBox *optimizeVectorCheckBox;
     QLineEdit *pathEdit;
     QLineEdit *patternEdit;
     QPushButton *fileBut;
@@ -90,6 +90,12 @@ void Print::validatePrintOptions(Print::PrintBasicOptions &printOpt, QPrinter *p
         printOpt.printSceneInOnePage = false;
     }
 
+    if (printOpt.outputType != Print::OutputType::Pdf)
+    {
+        // Only PDF files benefit from vector optimization
+        printOpt.optimizeVectorOutput = false;
+    }
+
     if (printer)
     {
         // Update printer output format
@@ -20,6 +20,15 @@
 #include "sceneselectionmodel.h"
 
 #include "graph/model/linegraphscene.h"
+#include "graph/model/graphstationcache.h"
+
+// Part of memory budget reserved to station cache
+static constexpr int StationCacheBudgetDivisor = 4;
+
+// Rough size of a loaded line scene, including its recorded picture
+static constexpr qint64 EstimatedSceneSize = 4 * 1024 * 1024;
+
+static constexpr int MaxPrefetchHint = 16;
 
 SceneSelectionModel::SceneSelectionModel(sqlite3pp::database &db, QObject *parent) :
     QAbstractTableModel(parent),
@@ -29,6 +38,11 @@ SceneSelectionModel::SceneSelectionModel(sqlite3pp::database &db, QObject *paren
     selectionMode(UseSelectedEntries),
     cachedCount(-1),
     iterationIdx(-1)
+{
+    m_stationCache.reset(new GraphStationCache(m_memoryBudget / StationCacheBudgetDivisor));
+}
+
+SceneSelectionModel::~SceneSelectionModel()
 {
 }
 
@@ -199,6 +213,9 @@ qint64 SceneSelectionModel::getItemCount()
 
 bool SceneSelectionModel::startIteration()
 {
+    // Stations might have changed since last iteration
+    m_stationCache->clear();
+
     if (selectionMode == UseSelectedEntries)
     {
         iterationIdx = 0;
@@ -227,22 +244,62 @@ bool SceneSelectionModel::startIteration()
 
 IGraphSceneCollection::SceneItem SceneSelectionModel::getNextItem()
 {
-    SceneItem item;
+    return loadItem(getNextItemRef(), mDb);
+}
+
+bool SceneSelectionModel::supportsParallelLoading() const
+{
+    return true;
+}
+
+IGraphSceneCollection::ItemRef SceneSelectionModel::getNextItemRef()
+{
+    ItemRef ref;
 
     Entry entry = getNextEntry();
     if (!entry.objectId)
+        return ref;
+
+    ref.objectId = entry.objectId;
+    ref.type     = int(entry.type);
+    return ref;
+}
+
+IGraphSceneCollection::SceneItem SceneSelectionModel::loadItem(const ItemRef &ref,
+                                                               sqlite3pp::database &db)
+{
+    SceneItem item;
+    if (!ref.objectId)
         return item;
 
+    const LineGraphType type  = LineGraphType(ref.type);
+
     // Create new scene without parent so ownership is passed to caller
-    LineGraphScene *lineScene = new LineGraphScene(mDb);
-    lineScene->loadGraph(entry.objectId, entry.type);
+    LineGraphScene *lineScene = new LineGraphScene(db);
+    lineScene->setStationCache(m_stationCache.get());
+    lineScene->loadGraph(ref.objectId, type);
+    lineScene->setStationCache(nullptr); // Cache is only used while loading
+    lineScene->setMergeJobPaths(m_optimizeVectorOutput);
 
     item.scene = lineScene;
     item.name  = lineScene->getGraphObjectName();
-    item.type  = utils::getLineGraphTypeName(entry.type);
+    item.type  = utils::getLineGraphTypeName(type);
     return item;
 }
 
+void SceneSelectionModel::setMemoryBudget(qint64 bytes)
+{
+    IGraphSceneCollection::setMemoryBudget(bytes);
+    m_stationCache->setMaxBytes(m_memoryBudget / StationCacheBudgetDivisor);
+}
+
+int SceneSelectionModel::getPrefetchHint() const
+{
+    // Remaining budget is for loaded scenes
+    const qint64 scenesBudget = m_memoryBudget - m_memoryBudget / StationCacheBudgetDivisor;
+    return int(qBound(qint64(1), scenesBudget / EstimatedSceneSize, qint64(MaxPrefetchHint)));
+}
+
 QString SceneSelectionModel::getModeName(SelectionMode mode)
 {
     switch (mode)
@@ -30,6 +30,10 @@
 
 #include <sqlite3pp/sqlite3pp.h>
 
+#include <memory>
+
+class GraphStationCache;
+
 class SceneSelectionModel : public QAbstractTableModel, public IGraphSceneCollection
 {
     Q_OBJECT
@@ -57,6 +61,7 @@ public:
     };
 
     SceneSelectionModel(sqlite3pp::database &db, QObject *parent = nullptr);
+    ~SceneSelectionModel();
 
     // Header:
     QVariant headerData(int section, Qt::Orientation orientation,
@@ -87,6 +92,13 @@ public:
     bool startIteration() override;
     SceneItem getNextItem() override;
 
+    bool supportsParallelLoading() const override;
+    ItemRef getNextItemRef() override;
+    SceneItem loadItem(const ItemRef &ref, sqlite3pp::database &db) override;
+
+    void setMemoryBudget(qint64 bytes) override;
+    int getPrefetchHint() const override;
+
     static QString getModeName(SelectionMode mode);
 
 signals:
@@ -110,6 +122,9 @@ private:
 
     qint64 cachedCount;
     int iterationIdx;
+
+    // Stations shared by scenes of current iteration
+    std::unique_ptr<GraphStationCache> m_stationCache;
 };
 
 #endif // SCENESELECTIONMODEL_H
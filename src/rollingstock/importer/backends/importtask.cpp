@@ -19,12 +19,60 @@
 
 #include "importtask.h"
 
-#include "utils/types.h"
-
 #include <sqlite3pp/sqlite3pp.h>
 
 #include "loadprogressevent.h"
-#include <QCoreApplication>
+
+#include <QDebug>
+
+// New IDs are assigned after current maximum, in imported ID order.
+// The map tables let the UPDATE link imported items to created ones
+// without looking up each row.
+static const char *const sql_importOwners[] = {
+  "CREATE TEMP TABLE owners_map(imported_id INTEGER PRIMARY KEY, new_id INTEGER)",
+
+  "INSERT INTO temp.owners_map(imported_id,new_id)"
+  " SELECT id,(SELECT IFNULL(MAX(id),0) FROM rs_owners)+ROW_NUMBER() OVER (ORDER BY id)"
+  " FROM imported_rs_owners WHERE import=1 AND match_existing_id IS NULL",
+
+  "INSERT INTO rs_owners(id,name)"
+  " SELECT map.new_id,IFNULL(imp.new_name,imp.name)"
+  " FROM temp.owners_map map JOIN imported_rs_owners imp ON imp.id=map.imported_id",
+
+  "UPDATE imported_rs_owners SET match_existing_id="
+  "(SELECT new_id FROM temp.owners_map WHERE imported_id=imported_rs_owners.id)"
+  " WHERE id IN (SELECT imported_id FROM temp.owners_map)",
+
+  "DROP TABLE temp.owners_map",
+  nullptr};
+
+static const char *const sql_importModels[] = {
+  "CREATE TEMP TABLE models_map(imported_id INTEGER PRIMARY KEY, new_id INTEGER)",
+
+  "INSERT INTO temp.models_map(imported_id,new_id)"
+  " SELECT id,(SELECT IFNULL(MAX(id),0) FROM rs_models)+ROW_NUMBER() OVER (ORDER BY id)"
+  " FROM imported_rs_models WHERE import=1 AND match_existing_id IS NULL",
+
+  "INSERT INTO rs_models(id,name,suffix,max_speed,axes,type,sub_type)"
+  " SELECT map.new_id,IFNULL(imp.new_name,imp.name),imp.suffix,"
+  "imp.max_speed,imp.axes,imp.type,imp.sub_type"
+  " FROM temp.models_map map JOIN imported_rs_models imp ON imp.id=map.imported_id",
+
+  "UPDATE imported_rs_models SET match_existing_id="
+  "(SELECT new_id FROM temp.models_map WHERE imported_id=imported_rs_models.id)"
+  " WHERE id IN (SELECT imported_id FROM temp.models_map)",
+
+  "DROP TABLE temp.models_map",
+  nullptr};
+
+static const char *const sql_importRollingstock[] = {
+  "INSERT INTO rs_list(id,model_id,number,owner_id)"
+  " SELECT NULL,m.match_existing_id,IFNULL(imp.new_number,imp.number),o.match_existing_id"
+  " FROM imported_rs_list imp"
+  " JOIN imported_rs_models m ON m.id=imp.model_id"
+  " JOIN imported_rs_owners o ON o.id=imp.owner_id"
+  " WHERE imp.import=1 AND m.import=1 AND o.import=1",
+  nullptr};
 
 ImportTask::ImportTask(sqlite3pp::database &db, QObject *receiver) :
     IQuittableTask(receiver),
@@ -34,161 +82,83 @@ ImportTask::ImportTask(sqlite3pp::database &db, QObject *receiver) :
 
 void ImportTask::run()
 {
-    sendEvent(new LoadProgressEvent(this, 0, 4), false);
+    const char *const *const steps[] = {sql_importOwners, sql_importModels,
+                                        sql_importRollingstock};
+    const int max = 4; // Steps plus final commit
 
-    // FIXME: do copy in batches like LoadSQLiteTask
-    // TODO: get only owners used really
-    sqlite3pp::query q(mDb, "SELECT imp.id,imp.name,imp.new_name FROM imported_rs_owners imp WHERE "
-                            "imp.import=1 AND imp.match_existing_id IS NULL");
-    sqlite3pp::command q_create(mDb, "INSERT INTO rs_owners(id, name) VALUES(NULL, ?)");
-    sqlite3pp::command q_update(mDb,
-                                "UPDATE imported_rs_owners SET match_existing_id=? WHERE id=?");
+    sendEvent(new LoadProgressEvent(this, 0, max), false);
 
-    sqlite3_stmt *st     = q.stmt();
-    sqlite3_stmt *create = q_create.stmt();
-    sqlite3_stmt *update = q_update.stmt();
+    // Copy everything in a single transaction
+    // NOTE: do not use sqlite3pp::transaction, it throws if BEGIN fails
+    if (mDb.execute("BEGIN TRANSACTION") != SQLITE_OK)
+    {
+        qWarning() << "ImportTask: cannot begin transaction" << mDb.error_msg();
+        sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
+                                        LoadProgressEvent::ProgressMaxFinished),
+                  true);
+        return;
+    }
 
-    sqlite3 *db          = mDb.db();
-    sqlite3_mutex *m     = sqlite3_db_mutex(db);
+    // Imported tables reference created items before they are filled
+    mDb.execute("PRAGMA defer_foreign_keys=ON");
 
-    int n                = 0;
-    while (q.step() == SQLITE_ROW)
+    int progress = 0;
+    for (const char *const *stmts : steps)
     {
-        if (n % 8 == 0 && wasStopped())
+        if (wasStopped())
         {
+            mDb.execute("ROLLBACK");
             sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
                                             LoadProgressEvent::ProgressMaxFinished),
                       true);
             return;
         }
 
-        // Get imported owner id
-        db_id importedOwnerId = sqlite3_column_int64(st, 0);
-        int len               = 2;
-
-        if (sqlite3_column_type(st, 2) == SQLITE_NULL)
-        {
-            len = 1; // Get original name instead of the custom one
-        }
-
-        // Get its name (or new_name)
-        const char *name = reinterpret_cast<const char *>(sqlite3_column_text(st, len));
-        len              = sqlite3_column_bytes(st, len);
-
-        // Create a real owner with this name and get its id
-        sqlite3_bind_text(create, 1, name, len, SQLITE_STATIC);
-        sqlite3_mutex_enter(m);
-        sqlite3_step(create);
-        db_id existingOwnerId = sqlite3_last_insert_rowid(db);
-        sqlite3_mutex_leave(m);
-        sqlite3_reset(create);
-
-        // Set the real owner id in the imported owner record to use it later
-        sqlite3_bind_int64(update, 1, existingOwnerId);
-        sqlite3_bind_int64(update, 2, importedOwnerId);
-        sqlite3_step(update);
-        sqlite3_reset(update);
-
-        n++;
-    }
-
-    sendEvent(new LoadProgressEvent(this, 1, 4), false);
-
-    q.prepare(
-      "SELECT imp.id,imp.name,imp.suffix,imp.new_name,imp.max_speed,imp.axes,imp.type,imp.sub_type"
-      " FROM imported_rs_models imp WHERE imp.import=1 AND imp.match_existing_id IS NULL");
-    st = q.stmt();
-
-    q_create.prepare("INSERT INTO rs_models(id,name,suffix,max_speed,axes,type,sub_type) "
-                     "VALUES(NULL,?,?,?,?,?,?)"); // Create invalid engine
-    create = q_create.stmt();
-
-    q_update.prepare("UPDATE imported_rs_models SET match_existing_id=? WHERE id=?");
-    update = q_update.stmt();
-
-    n      = 0;
-    while (q.step() == SQLITE_ROW)
-    {
-        if (n % 8 == 0 && wasStopped())
+        if (!execStatements(stmts))
         {
-            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
+            mDb.execute("ROLLBACK");
+            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
                                             LoadProgressEvent::ProgressMaxFinished),
                       true);
             return;
         }
 
-        // Get imported model id
-        db_id importedModelId = sqlite3_column_int64(st, 0);
-
-        int len               = 3;
-        if (sqlite3_column_type(st, 3) == SQLITE_NULL)
-        {
-            len = 1; // Get original name instead of the custom one ('name' instead of 'new_name'
-        }
-
-        // Get its name (or new_name)
-        const char *name = reinterpret_cast<const char *>(sqlite3_column_text(st, len));
-        len              = sqlite3_column_bytes(st, len);
-        sqlite3_bind_text(create, 1, name, len, SQLITE_STATIC);
-
-        // Get its suffix
-        name = reinterpret_cast<const char *>(sqlite3_column_text(st, 2));
-        len  = sqlite3_column_bytes(st, 2);
-        sqlite3_bind_text(create, 2, name, len, SQLITE_STATIC);
-
-        // Get its max_speed
-        int val = sqlite3_column_int(st, 4);
-        sqlite3_bind_int(create, 3, val);
-
-        // Get its axes count
-        val = sqlite3_column_int(st, 5);
-        sqlite3_bind_int(create, 4, val);
-
-        // Get its type
-        val = sqlite3_column_int(st, 6);
-        sqlite3_bind_int(create, 5, val);
-
-        // Get its sub_type
-        val = sqlite3_column_int(st, 7);
-        sqlite3_bind_int(create, 6, val);
-
-        // Create a real model with this name and get its id
-        sqlite3_mutex_enter(m);
-        sqlite3_step(create);
-        db_id existingModelId = sqlite3_last_insert_rowid(db);
-        sqlite3_mutex_leave(m);
-        sqlite3_reset(create);
-
-        // Set the real owner id in the imported model record to use it later
-        sqlite3_bind_int64(update, 1, existingModelId);
-        sqlite3_bind_int64(update, 2, importedModelId);
-        sqlite3_step(update);
-        sqlite3_reset(update);
-        n++;
+        sendEvent(new LoadProgressEvent(this, ++progress, max), false);
     }
 
     if (wasStopped())
     {
+        mDb.execute("ROLLBACK");
         sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
                                         LoadProgressEvent::ProgressMaxFinished),
                   true);
         return;
     }
-    else
-    {
-        sendEvent(new LoadProgressEvent(this, 2, 4), false);
-    }
 
-    // Finally import rollingstock
-    q_create.prepare("INSERT INTO rs_list(id, model_id, number, owner_id)"
-                     " SELECT NULL, m.match_existing_id, (CASE WHEN imp.new_number IS NULL THEN "
-                     "imp.number ELSE imp.new_number END), o.match_existing_id"
-                     " FROM imported_rs_list imp"
-                     " JOIN imported_rs_models m ON m.id=imp.model_id "
-                     " JOIN imported_rs_owners o ON o.id=imp.owner_id"
-                     " WHERE imp.import=1 AND m.import=1 AND o.import=1");
+    if (mDb.execute("COMMIT") != SQLITE_OK)
+    {
+        qWarning() << "ImportTask: commit failed" << mDb.error_msg();
 
-    q_create.execute(); // Long running
+        // Transaction is still open if deferred foreign keys failed
+        mDb.execute("ROLLBACK");
+        sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
+                                        LoadProgressEvent::ProgressMaxFinished),
+                  true);
+        return;
+    }
 
     sendEvent(new LoadProgressEvent(this, 0, LoadProgressEvent::ProgressMaxFinished), true);
 }
+
+bool ImportTask::execStatements(const char *const *stmts)
+{
+    for (; *stmts; stmts++)
+    {
+        if (mDb.execute(*stmts) != SQLITE_OK)
+        {
+            qWarning() << "ImportTask: error" << mDb.error_msg() << "executing" << *stmts;
+            return false;
+        }
+    }
+    return true;
+}
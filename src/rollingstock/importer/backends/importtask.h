@@ -35,6 +35,10 @@ public:
 
     void run() override;
 
+private:
+    // Executes a NULL terminated list of statements
+    bool execStatements(const char *const *stmts);
+
 private:
     sqlite3pp::database &mDb;
 };
@@ -21,11 +21,11 @@
 #include "odsimporter.h"
 #include "../loadprogressevent.h"
 #include "options.h"
+#include "zipentrydevice.h"
 
-#include <QTemporaryFile>
 #include <QXmlStreamReader>
 
-#include <zip.h>
+#include <sqlite3pp/sqlite3pp.h>
 
 #include <QDebug>
 
@@ -56,117 +56,39 @@ void LoadODSTask::run()
     int progress = 0;
     sendEvent(new LoadProgressEvent(this, progress++, max), false);
 
-    int err       = 0;
-    zip_t *zipper = zip_open(mFileName.toUtf8(), ZIP_RDONLY, &err);
-
-    if (!zipper)
-    {
-        zip_error_t ziperror;
-        zip_error_init_with_code(&ziperror, err);
-        const char *msg = zip_error_strerror(&ziperror);
-        qDebug() << "Failed to open output file" << mFileName << "Err:" << msg;
-
-        errText = QString::fromUtf8(msg);
-        sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
-                                        LoadProgressEvent::ProgressMaxFinished),
-                  true);
-        return;
-    }
-
-    // Search for the file of given name
-    const char *name = "content.xml";
-    struct zip_stat st;
-    zip_stat_init(&st);
-    if (zip_stat(zipper, name, 0, &st) < 0)
+    // Decompress content while parsing, without storing it as a whole
+    ZipEntryDevice content;
+    if (!content.openEntry(mFileName, "content.xml"))
     {
-        const char *msg = zip_strerror(zipper);
-        errText         = QString::fromUtf8(msg);
-
-        // Close archive
-        zip_close(zipper);
+        qDebug() << "Failed to open ODS content" << mFileName << "Err:" << content.errorString();
 
+        errText = content.errorString();
         sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
                                         LoadProgressEvent::ProgressMaxFinished),
                   true);
         return;
     }
 
-    QTemporaryFile mContentFile;
-
-    if (mContentFile.isOpen())
-        mContentFile.close();
-
-    if (!mContentFile.open() || !mContentFile.resize(qint64(st.size)))
-    {
-        errText = mContentFile.errorString();
-        // Close archive
-        zip_close(zipper);
+    sendEvent(new LoadProgressEvent(this, progress++, max), false);
 
-        sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
-                                        LoadProgressEvent::ProgressMaxFinished),
-                  true);
-        return;
-    }
+    QXmlStreamReader xml(&content);
 
-    // Read the compressed file
-    zip_file *f = zip_fopen(zipper, name, 0);
-    if (!f)
+    // Insert all rows in a single transaction
+    // NOTE: do not use sqlite3pp::transaction, it throws if BEGIN fails
+    if (mDb.execute("BEGIN TRANSACTION") != SQLITE_OK)
     {
-        const char *msg = zip_strerror(zipper);
-        errText         = QString::fromUtf8(msg);
-        // Close archive
-        zip_close(zipper);
-
+        errText = mDb.error_msg();
         sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
                                         LoadProgressEvent::ProgressMaxFinished),
                   true);
         return;
     }
 
-    zip_uint64_t sum = 0;
-    char buf[4096];
-    while (sum != st.size)
-    {
-        zip_int64_t len = zip_fread(f, buf, 4096);
-        if (len < 0)
-        {
-            const char *msg = zip_file_strerror(f);
-            errText         = QString::fromUtf8(msg);
-            // Close file and archive
-            zip_fclose(f);
-            zip_close(zipper);
-
-            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
-                                            LoadProgressEvent::ProgressMaxFinished),
-                      true);
-            return;
-        }
-        mContentFile.write(buf, len);
-        sum += zip_uint64_t(len);
-    }
-
-    // Close file and archive
-    zip_fclose(f);
-    zip_close(zipper);
-
-    if (wasStopped())
-    {
-        sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
-                                        LoadProgressEvent::ProgressMaxFinished),
-                  true);
-        return;
-    }
-
-    sendEvent(new LoadProgressEvent(this, progress++, max), false);
-
-    mContentFile.reset(); // Seek to start
-
-    QXmlStreamReader xml(&mContentFile);
-
     ODSImporter importer(importMode, m_tblFirstRow, m_tblRSNumberCol, m_tblModelNameCol,
                          defaultSpeed, defaultType, mDb);
     if (!importer.loadDocument(xml))
     {
+        mDb.execute("ROLLBACK");
         errText = xml.errorString();
         sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressError,
                                         LoadProgressEvent::ProgressMaxFinished),
@@ -178,6 +100,7 @@ void LoadODSTask::run()
     {
         if (wasStopped())
         {
+            mDb.execute("ROLLBACK");
             sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
                                             LoadProgressEvent::ProgressMaxFinished),
                       true);
@@ -188,9 +111,16 @@ void LoadODSTask::run()
 
     if (xml.hasError())
     {
+        mDb.execute("ROLLBACK");
         progress = LoadProgressEvent::ProgressError;
         errText  = xml.errorString();
     }
+    else if (mDb.execute("COMMIT") != SQLITE_OK)
+    {
+        errText = mDb.error_msg();
+        mDb.execute("ROLLBACK");
+        progress = LoadProgressEvent::ProgressError;
+    }
 
     sendEvent(new LoadProgressEvent(this, progress, LoadProgressEvent::ProgressMaxFinished), true);
 }
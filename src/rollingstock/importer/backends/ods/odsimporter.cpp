@@ -33,6 +33,19 @@ const QString tbl     = QStringLiteral("table:table");
 const QString tblname = QStringLiteral("table:name");
 const QString offbody = QStringLiteral("office:body");
 
+const QLatin1String tblRowsRepeated("table:number-rows-repeated");
+const QLatin1String tblColsRepeated("table:number-columns-repeated");
+
+// Repeated counts are used only to advance row/column index
+static inline int readRepeatCount(const QXmlStreamReader &xml, QLatin1String attrName)
+{
+    const QXmlStreamAttributes attrs = xml.attributes();
+    const QStringRef val             = attrs.value(attrName);
+    if (val.isEmpty())
+        return 1;
+    return qMax(1, val.toInt());
+}
+
 ODSImporter::ODSImporter(const int mode, const int firstRow, const int numColm, const int nameCol,
                          int defSpeed, RsType defType, sqlite3pp::database &db) :
     mDb(db),
@@ -48,12 +61,13 @@ ODSImporter::ODSImporter(const int mode, const int firstRow, const int numColm,
                  " VALUES(NULL, 1, ?, ?, ?, NULL)"),
 
     q_findOwner(mDb, "SELECT id FROM rs_owners WHERE name=?"),
-    q_findModel(mDb, "SELECT id FROM rs_models WHERE name=?"),
+    q_findModel(mDb, "SELECT id,max_speed,axes,type,sub_type FROM rs_models WHERE name=?"),
     q_findImportedModel(mDb, "SELECT id FROM imported_rs_models WHERE name=?"),
 
     tableFirstRow(firstRow),
     tableRSNumberCol(numColm),
     tableModelNameCol(nameCol),
+    tableLastCol(qMax(numColm, nameCol)),
     importMode(mode),
 
     sheetIdx(0),
@@ -227,15 +241,19 @@ void ODSImporter::readTable(QXmlStreamReader &xml)
 
                 // qDebug() << "RS:" << model << number;
 
-                db_id importedModelId = 0;
+                // Sheets usually repeat few models on many rows, avoid looking them up again
+                db_id importedModelId = importedModels.value(model, 0);
 
-                sqlite3_bind_text(q_findImportedModel.stmt(), 1, model, model.size(),
-                                  SQLITE_STATIC);
-                if (q_findImportedModel.step() == SQLITE_ROW)
+                if (!importedModelId)
                 {
-                    importedModelId = q_findImportedModel.getRows().get<db_id>(0);
+                    sqlite3_bind_text(q_findImportedModel.stmt(), 1, model, model.size(),
+                                      SQLITE_STATIC);
+                    if (q_findImportedModel.step() == SQLITE_ROW)
+                    {
+                        importedModelId = q_findImportedModel.getRows().get<db_id>(0);
+                    }
+                    q_findImportedModel.reset();
                 }
-                q_findImportedModel.reset();
 
                 if (!importedModelId)
                 {
@@ -277,6 +295,8 @@ void ODSImporter::readTable(QXmlStreamReader &xml)
                     q_addModel.reset();
                 }
 
+                importedModels.insert(model, importedModelId);
+
                 if (importMode & RSImportMode::ImportRSPieces)
                 {
                     int num = number % 10000; // Cut at 4 digits
@@ -320,15 +340,8 @@ void ODSImporter::readRow(QXmlStreamReader &xml, QByteArray &model, qint64 &numb
     row++;
     col = 0;
 
-    for (const QXmlStreamAttribute &a : xml.attributes())
-    {
-        if (a.qualifiedName() == QLatin1String("table:number-rows-repeated"))
-        {
-            int rowsRepeated = a.value().toInt();
-            row += rowsRepeated - 1;
-            break;
-        }
-    }
+    // Empty formatted rows can be repeated up to sheet limit, just advance index
+    row += readRepeatCount(xml, tblRowsRepeated) - 1;
 
     while (xml.readNext() != QXmlStreamReader::Invalid)
     {
@@ -336,20 +349,17 @@ void ODSImporter::readRow(QXmlStreamReader &xml, QByteArray &model, qint64 &numb
         {
         case QXmlStreamReader::StartElement:
         {
-            if (xml.qualifiedName() == QLatin1String("table:table-cell"))
+            if (col >= tableLastCol)
+            {
+                // Past all needed columns, skip remaining cells without reading them
+                xml.skipCurrentElement();
+            }
+            else if (xml.qualifiedName() == QLatin1String("table:table-cell"))
             {
                 int oldCol = col;
 
-                col++;
-                for (const QXmlStreamAttribute &a : xml.attributes())
-                {
-                    if (a.qualifiedName() == QLatin1String("table:number-columns-repeated"))
-                    {
-                        int colsRepeated = a.value().toInt();
-                        col += colsRepeated - 1;
-                        break;
-                    }
-                }
+                // Repeated empty cells are not expanded, just advance index
+                col += readRepeatCount(xml, tblColsRepeated);
 
                 // Read current cell
                 int depth                         = 1;
@@ -22,6 +22,8 @@
 
 #include <sqlite3pp/sqlite3pp.h>
 
+#include <QHash>
+
 #include "utils/types.h"
 
 class QXmlStreamReader;
@@ -53,9 +55,13 @@ private:
     sqlite3pp::query q_findModel;
     sqlite3pp::query q_findImportedModel;
 
+    // Model name to imported model ID
+    QHash<QByteArray, db_id> importedModels;
+
     const int tableFirstRow;     // Start from 1 (not 0)
     const int tableRSNumberCol;  // Start from 1 (not 0)
     const int tableModelNameCol; // Start from 1 (not 0)
+    const int tableLastCol;      // Last needed column
     const int importMode;
 
     int sheetIdx;
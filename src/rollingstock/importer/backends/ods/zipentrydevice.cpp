@@ -0,0 +1,131 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "zipentrydevice.h"
+
+#include <zip.h>
+
+ZipEntryDevice::ZipEntryDevice(QObject *parent) :
+    QIODevice(parent),
+    m_archive(nullptr),
+    m_file(nullptr),
+    m_size(0),
+    m_pos(0)
+{
+}
+
+ZipEntryDevice::~ZipEntryDevice()
+{
+    close();
+}
+
+bool ZipEntryDevice::openEntry(const QString &archivePath, const char *entryName)
+{
+    close();
+
+    int err   = 0;
+    m_archive = zip_open(archivePath.toUtf8(), ZIP_RDONLY, &err);
+    if (!m_archive)
+    {
+        zip_error_t ziperror;
+        zip_error_init_with_code(&ziperror, err);
+        setErrorString(QString::fromUtf8(zip_error_strerror(&ziperror)));
+        zip_error_fini(&ziperror);
+        return false;
+    }
+
+    struct zip_stat st;
+    zip_stat_init(&st);
+    if (zip_stat(m_archive, entryName, 0, &st) < 0 || !(st.valid & ZIP_STAT_SIZE))
+    {
+        setErrorString(QString::fromUtf8(zip_strerror(m_archive)));
+        close();
+        return false;
+    }
+
+    m_file = zip_fopen(m_archive, entryName, 0);
+    if (!m_file)
+    {
+        setErrorString(QString::fromUtf8(zip_strerror(m_archive)));
+        close();
+        return false;
+    }
+
+    m_size = qint64(st.size);
+    m_pos  = 0;
+
+    // Reader already buffers data, avoid a second copy in QIODevice buffer
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void ZipEntryDevice::close()
+{
+    if (isOpen())
+        QIODevice::close();
+
+    if (m_file)
+    {
+        zip_fclose(m_file);
+        m_file = nullptr;
+    }
+
+    if (m_archive)
+    {
+        // Read only archive, discard is enough
+        zip_discard(m_archive);
+        m_archive = nullptr;
+    }
+
+    m_size = 0;
+    m_pos  = 0;
+}
+
+bool ZipEntryDevice::isSequential() const
+{
+    return true;
+}
+
+qint64 ZipEntryDevice::bytesAvailable() const
+{
+    return m_size - m_pos + QIODevice::bytesAvailable();
+}
+
+qint64 ZipEntryDevice::readData(char *data, qint64 maxSize)
+{
+    if (!m_file)
+        return -1;
+
+    if (m_pos >= m_size)
+        return -1; // End of entry
+
+    zip_int64_t len = zip_fread(m_file, data, zip_uint64_t(maxSize));
+    if (len < 0)
+    {
+        setErrorString(QString::fromUtf8(zip_file_strerror(m_file)));
+        return -1;
+    }
+
+    m_pos += len;
+    return len;
+}
+
+qint64 ZipEntryDevice::writeData(const char *, qint64)
+{
+    return -1; // Read only
+}
@@ -0,0 +1,71 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef ZIPENTRYDEVICE_H
+#define ZIPENTRYDEVICE_H
+
+#include <QIODevice>
+
+typedef struct zip zip_t;
+typedef struct zip_file zip_file_t;
+
+/*!
+ * \brief The ZipEntryDevice class
+ *
+ * Read only sequential device which decompresses a single zip archive entry on demand.
+ * Data is never stored as a whole, each read only inflates requested bytes
+ * so it can be passed directly to QXmlStreamReader.
+ */
+class ZipEntryDevice : public QIODevice
+{
+public:
+    explicit ZipEntryDevice(QObject *parent = nullptr);
+    ~ZipEntryDevice();
+
+    /*!
+     * \brief openEntry
+     * \param archivePath zip file path
+     * \param entryName name of entry inside archive
+     * \return true on success, otherwise check errorString()
+     */
+    bool openEntry(const QString &archivePath, const char *entryName);
+
+    void close() override;
+
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+    // Uncompressed size of entry
+    inline qint64 entrySize() const
+    {
+        return m_size;
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    zip_t *m_archive;
+    zip_file_t *m_file;
+    qint64 m_size;
+    qint64 m_pos;
+};
+
+#endif // ZIPENTRYDEVICE_H
@@ -24,6 +24,8 @@
 
 #include <sqlite3pp/sqlite3pp.h>
 
+#include <QUrl>
+
 #include <QDebug>
 
 LoadSQLiteTask::LoadSQLiteTask(sqlite3pp::database &db, int mode, const QString &fileName,
@@ -36,8 +38,6 @@ LoadSQLiteTask::LoadSQLiteTask(sqlite3pp::database &db, int mode, const QString
 void LoadSQLiteTask::run()
 {
     currentProgress = 0;
-    localCount      = 0;
-    localProgress   = 0;
 
     if (wasStopped())
     {
@@ -52,18 +52,14 @@ void LoadSQLiteTask::run()
     if (!attachDB())
         return;
 
-    if (!copyOwners())
-        return;
+    const bool copied = copyItems();
 
-    if (!copyModels())
-        return;
-
-    if (!copyRS())
-        return;
-
-    // Cleanup
+    // Cleanup, must be done after transaction has ended
     mDb.execute("DETACH rs_source");
 
+    if (!copied)
+        return; // Error or abort already reported
+
     if (!unselectOwnersWithNoRS())
         return;
 
@@ -73,8 +69,6 @@ void LoadSQLiteTask::run()
 
 void LoadSQLiteTask::endWithDbError(const QString &text)
 {
-    mDb.execute("DETACH rs_source");
-
     errText = LoadTaskUtils::tr("%1\n"
                                 "Code: %2\n"
                                 "Message: %3")
@@ -87,12 +81,33 @@ void LoadSQLiteTask::endWithDbError(const QString &text)
               true);
 }
 
+bool LoadSQLiteTask::endIfStopped()
+{
+    if (!wasStopped())
+        return false;
+
+    sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
+                                    LoadProgressEvent::ProgressMaxFinished),
+              true);
+    return true;
+}
+
+void LoadSQLiteTask::advanceStep()
+{
+    currentProgress += StepSize;
+    sendEvent(new LoadProgressEvent(this, currentProgress, MaxProgress), false);
+}
+
 bool LoadSQLiteTask::attachDB()
 {
     // ATTACH other database to this session
-    localCount = 1;
-    sqlite3pp::command q(mDb, "ATTACH ? AS rs_source"); // TODO: use URI to pass 'readonly'
-    q.bind(1, mFileName);
+    // Source file is opened read-only and never changes while we read it
+    // so SQLite can skip locking and change detection
+    QUrl url = QUrl::fromLocalFile(mFileName);
+    url.setQuery(QStringLiteral("mode=ro&immutable=1"));
+
+    sqlite3pp::command q(mDb, "ATTACH ? AS rs_source");
+    q.bind(1, url.toString(QUrl::FullyEncoded));
     int ret = q.execute();
     if (ret != SQLITE_OK)
     {
@@ -100,87 +115,62 @@ bool LoadSQLiteTask::attachDB()
         return false;
     }
 
-    localProgress = 0; // Advance by 1 step, clear partial progress
-    currentProgress += StepSize;
-    sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
+    // Read source pages directly from the mapped file instead of copying them in page cache
+    mDb.execute("PRAGMA rs_source.mmap_size=268435456");
+
+    advanceStep();
     return true;
 }
 
-bool LoadSQLiteTask::copyOwners()
+bool LoadSQLiteTask::copyItems()
 {
-    if ((importMode & RSImportMode::ImportRSOwners) == 0)
-        return true; // Skip owners importation
+    // Copy all items in a single transaction
+    // NOTE: do not use sqlite3pp::transaction, it throws if BEGIN fails
+    if (mDb.execute("BEGIN TRANSACTION") != SQLITE_OK)
+    {
+        endWithDbError(LoadTaskUtils::tr("Could not save imported items."));
+        return false;
+    }
 
-    sqlite3pp::query q(mDb);
-    sqlite3pp::query q_getFirstIdGreaterThan(mDb);
-
-    // Calculate maximum number of batches
-    q.prepare("SELECT MAX(id) FROM rs_source.rs_owners");
-    q.step();
-    localCount = sqlite3_column_int(q.stmt(), 0);
-    localCount = localCount / LoadTaskUtils::BatchSize
-                 + (localCount % LoadTaskUtils::BatchSize != 0); // Round up
-    if (localCount < 1)
-        localCount = 1; // At least 1 batch
-
-    // Init query: get first id to import
-    int ret = q_getFirstIdGreaterThan.prepare("SELECT MIN(id) FROM rs_source.rs_owners WHERE id>?");
-    sqlite3_stmt *stmt = q_getFirstIdGreaterThan.stmt();
-    if (ret != SQLITE_OK)
+    if (!copyOwners() || !copyModels() || !copyRS())
     {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed A1."));
+        mDb.execute("ROLLBACK");
         return false;
     }
 
-    ret = q.prepare("INSERT OR IGNORE INTO main.imported_rs_owners(id, name, import, new_name, "
-                    "match_existing_id, sheet_idx)"
-                    " SELECT NULL,own1.name,1,NULL,own2.id,0"
-                    " FROM rs_source.rs_owners AS own1"
-                    " LEFT JOIN main.rs_owners own2 ON own1.name=own2.name"
-                    " WHERE own1.id BETWEEN ? AND ?");
-    if (ret != SQLITE_OK)
+    if (mDb.execute("COMMIT") != SQLITE_OK)
     {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed A2."));
+        endWithDbError(LoadTaskUtils::tr("Could not save imported items."));
+        mDb.execute("ROLLBACK");
         return false;
     }
 
-    int firstId   = 0;
-    localProgress = 0;
-    while (true)
+    return true;
+}
+
+bool LoadSQLiteTask::copyOwners()
+{
+    if ((importMode & RSImportMode::ImportRSOwners) == 0)
+        return true; // Skip owners importation
+
+    if (endIfStopped())
+        return false;
+
+    sqlite3pp::command q(
+      mDb,
+      "INSERT OR IGNORE INTO main.imported_rs_owners(id, name, import, new_name, "
+      "match_existing_id, sheet_idx)"
+      " SELECT NULL,own1.name,1,NULL,own2.id,0"
+      " FROM rs_source.rs_owners AS own1"
+      " LEFT JOIN main.rs_owners own2 ON own1.name=own2.name"
+      " ORDER BY own1.id");
+    if (q.execute() != SQLITE_OK)
     {
-        if (wasStopped())
-        {
-            q.prepare("DETACH rs_source"); // Cleanup
-            q.step();
-
-            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
-                                            LoadProgressEvent::ProgressMaxFinished),
-                      true);
-            return false;
-        }
-
-        q_getFirstIdGreaterThan.bind(1, firstId);
-        q_getFirstIdGreaterThan.step();
-        if (sqlite3_column_type(stmt, 0) == SQLITE_NULL)
-            break; // No more owners to import
-
-        firstId = sqlite3_column_int(stmt, 0);
-        q_getFirstIdGreaterThan.reset();
-
-        const int lastId = firstId + LoadTaskUtils::BatchSize;
-        q.bind(1, firstId);
-        q.bind(2, lastId);
-        firstId = lastId;
-
-        q.step();
-
-        localProgress++;
-        sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
+        endWithDbError(LoadTaskUtils::tr("Could not import owners."));
+        return false;
     }
 
-    localProgress = 0; // Advance by 1 step, clear partial progress
-    currentProgress += StepSize;
-    sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
+    advanceStep();
     return true;
 }
 
@@ -189,78 +179,25 @@ bool LoadSQLiteTask::copyModels()
     if ((importMode & RSImportMode::ImportRSModels) == 0)
         return true; // Skip models importation
 
-    sqlite3pp::query q(mDb);
-    sqlite3pp::query q_getFirstIdGreaterThan(mDb);
-
-    // Calculate maximum number of batches
-    q.prepare("SELECT MAX(id) FROM rs_source.rs_models");
-    q.step();
-    localCount = sqlite3_column_int(q.stmt(), 0);
-    localCount = localCount / LoadTaskUtils::BatchSize
-                 + (localCount % LoadTaskUtils::BatchSize != 0); // Round up
-    if (localCount < 1)
-        localCount = 1; // At least 1 batch
-
-    // Init query: get first id to import
-    int ret = q_getFirstIdGreaterThan.prepare("SELECT MIN(id) FROM rs_source.rs_models WHERE id>?");
-    sqlite3_stmt *stmt = q_getFirstIdGreaterThan.stmt();
-    if (ret != SQLITE_OK)
-    {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed B1."));
+    if (endIfStopped())
         return false;
-    }
 
-    ret = q.prepare(
+    sqlite3pp::command q(
+      mDb,
       "INSERT OR IGNORE INTO main.imported_rs_models(id, name, suffix, import, new_name, "
       "match_existing_id, max_speed, axes, type, sub_type)"
       " SELECT "
       "NULL,mod1.name,mod1.suffix,1,NULL,mod2.id,mod1.max_speed,mod1.axes,mod1.type,mod1.sub_type"
       " FROM rs_source.rs_models AS mod1"
       " LEFT JOIN main.rs_models mod2 ON mod1.name=mod2.name AND mod1.suffix=mod2.suffix"
-      " WHERE mod1.id BETWEEN ? AND ?");
-    if (ret != SQLITE_OK)
+      " ORDER BY mod1.id");
+    if (q.execute() != SQLITE_OK)
     {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed B2."));
+        endWithDbError(LoadTaskUtils::tr("Could not import models."));
         return false;
     }
 
-    int firstId   = 0;
-    localProgress = 0;
-    while (true)
-    {
-        if (wasStopped())
-        {
-            q.prepare("DETACH rs_source"); // Cleanup
-            q.step();
-
-            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
-                                            LoadProgressEvent::ProgressMaxFinished),
-                      true);
-            return false;
-        }
-
-        q_getFirstIdGreaterThan.bind(1, firstId);
-        q_getFirstIdGreaterThan.step();
-        if (sqlite3_column_type(stmt, 0) == SQLITE_NULL)
-            break; // No more models to import
-
-        firstId = sqlite3_column_int(stmt, 0);
-        q_getFirstIdGreaterThan.reset();
-
-        const int lastId = firstId + LoadTaskUtils::BatchSize;
-        q.bind(1, firstId);
-        q.bind(2, lastId);
-        firstId = lastId;
-
-        q.step();
-
-        localProgress++;
-        sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
-    }
-
-    localProgress = 0; // Advance by 1 step, clear partial progress
-    currentProgress += StepSize;
-    sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
+    advanceStep();
     return true;
 }
 
@@ -269,153 +206,44 @@ bool LoadSQLiteTask::copyRS()
     if ((importMode & RSImportMode::ImportRSPieces) == 0)
         return true; // Skip RS importation
 
-    sqlite3pp::query q(mDb);
-    sqlite3pp::query q_getFirstIdGreaterThan(mDb);
-
-    // Calculate maximum number of batches
-    q.prepare("SELECT MAX(id) FROM rs_source.rs_models");
-    q.step();
-    localCount = sqlite3_column_int(q.stmt(), 0);
-    localCount = localCount / LoadTaskUtils::BatchSize
-                 + (localCount % LoadTaskUtils::BatchSize != 0); // Round up
-    if (localCount < 1)
-        localCount = 1; // At least 1 batch
-
-    // Init query: get first id to import
-    int ret = q_getFirstIdGreaterThan.prepare("SELECT MIN(id) FROM rs_source.rs_models WHERE id>?");
-    sqlite3_stmt *stmt = q_getFirstIdGreaterThan.stmt();
-    if (ret != SQLITE_OK)
-    {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed C1."));
+    if (endIfStopped())
         return false;
-    }
 
-    ret = q.prepare(
+    sqlite3pp::command q(
+      mDb,
       "INSERT OR IGNORE INTO main.imported_rs_list(id, import, model_id, owner_id, number, "
       "new_number)"
       " SELECT NULL,1,mod2.id,own2.id,rs.number % 10000,NULL"
       " FROM rs_source.rs_list AS rs"
-      " LEFT JOIN rs_source.rs_models mod1 ON mod1.id=rs.model_id"
+      " JOIN rs_source.rs_models mod1 ON mod1.id=rs.model_id"
       " LEFT JOIN main.imported_rs_models mod2 ON mod1.name=mod2.name AND mod1.suffix=mod2.suffix"
       " LEFT JOIN rs_source.rs_owners own1 ON own1.id=rs.owner_id"
       " LEFT JOIN main.imported_rs_owners own2 ON own1.name=own2.name"
-      " WHERE mod1.id BETWEEN ? AND ?");
-    if (ret != SQLITE_OK)
+      " ORDER BY rs.id");
+    if (q.execute() != SQLITE_OK)
     {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed C2."));
+        endWithDbError(LoadTaskUtils::tr("Could not import rollingstock."));
         return false;
     }
 
-    int firstId   = 0;
-    localProgress = 0;
-    while (true)
-    {
-        if (wasStopped())
-        {
-            q.prepare("DETACH rs_source"); // Cleanup
-            q.step();
-
-            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
-                                            LoadProgressEvent::ProgressMaxFinished),
-                      true);
-            return false;
-        }
-
-        q_getFirstIdGreaterThan.bind(1, firstId);
-        q_getFirstIdGreaterThan.step();
-        if (sqlite3_column_type(stmt, 0) == SQLITE_NULL)
-            break; // No more RS to import
-
-        firstId = sqlite3_column_int(stmt, 0);
-        q_getFirstIdGreaterThan.reset();
-
-        const int lastId = firstId + LoadTaskUtils::BatchSize;
-        q.bind(1, firstId);
-        q.bind(2, lastId);
-        firstId = lastId;
-
-        q.step();
-
-        localProgress++;
-        sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
-    }
-
-    localProgress = 0; // Advance by 1 step, clear partial progress
-    currentProgress += StepSize;
-    sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
+    advanceStep();
     return true;
 }
 
 bool LoadSQLiteTask::unselectOwnersWithNoRS()
 {
-    sqlite3pp::query q(mDb);
-    sqlite3pp::query q_getFirstIdGreaterThan(mDb);
-
-    // Calculate maximum number of batches
-    q.prepare("SELECT MAX(id) FROM imported_rs_owners");
-    q.step();
-    localCount = sqlite3_column_int(q.stmt(), 0);
-    localCount = localCount / LoadTaskUtils::BatchSize
-                 + (localCount % LoadTaskUtils::BatchSize != 0); // Round up
-    if (localCount < 1)
-        localCount = 1; // At least 1 batch
-
-    // Init query: get first id to query
-    int ret = q_getFirstIdGreaterThan.prepare("SELECT MIN(id) FROM imported_rs_owners WHERE id>?");
-    sqlite3_stmt *stmt = q_getFirstIdGreaterThan.stmt();
-    if (ret != SQLITE_OK)
-    {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed C1."));
+    if (endIfStopped())
         return false;
-    }
 
-    ret = q.prepare("UPDATE imported_rs_owners SET import=0 WHERE id IN("
-                    " SELECT own.id"
-                    " FROM imported_rs_owners own"
-                    " LEFT JOIN imported_rs_list rs ON rs.owner_id=own.id"
-                    " WHERE own.id BETWEEN ? AND ?"
-                    " GROUP BY own.id"
-                    " HAVING COUNT(rs.id)=0)");
-    if (ret != SQLITE_OK)
+    sqlite3pp::command q(mDb, "UPDATE imported_rs_owners SET import=0"
+                              " WHERE NOT EXISTS (SELECT 1 FROM imported_rs_list rs"
+                              " WHERE rs.owner_id=imported_rs_owners.id)");
+    if (q.execute() != SQLITE_OK)
     {
-        endWithDbError(LoadTaskUtils::tr("Query preparation failed C2."));
+        endWithDbError(LoadTaskUtils::tr("Could not unselect unused owners."));
         return false;
     }
 
-    int firstId   = 0;
-    localProgress = 0;
-    while (true)
-    {
-        if (wasStopped())
-        {
-            // No cleanup, already done after importing RS
-            sendEvent(new LoadProgressEvent(this, LoadProgressEvent::ProgressAbortedByUser,
-                                            LoadProgressEvent::ProgressMaxFinished),
-                      true);
-            return false;
-        }
-
-        q_getFirstIdGreaterThan.bind(1, firstId);
-        q_getFirstIdGreaterThan.step();
-        if (sqlite3_column_type(stmt, 0) == SQLITE_NULL)
-            break; // No more owners to edit
-
-        firstId = sqlite3_column_int(stmt, 0);
-        q_getFirstIdGreaterThan.reset();
-
-        const int lastId = firstId + LoadTaskUtils::BatchSize;
-        q.bind(1, firstId);
-        q.bind(2, lastId);
-        firstId = lastId;
-
-        q.step();
-
-        localProgress++;
-        sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
-    }
-
-    localProgress = 0; // Advance by 1 step, clear partial progress
-    currentProgress += StepSize;
-    sendEvent(new LoadProgressEvent(this, calcProgress(), MaxProgress), false);
+    advanceStep();
     return true;
 }
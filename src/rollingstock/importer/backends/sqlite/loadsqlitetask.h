@@ -44,13 +44,11 @@ public:
 
 private:
     void endWithDbError(const QString &text);
-
-    inline int calcProgress() const
-    {
-        return currentProgress + localProgress / localCount * StepSize;
-    }
+    bool endIfStopped();
+    void advanceStep();
 
     bool attachDB();
+    bool copyItems();
     bool copyOwners();
     bool copyModels();
     bool copyRS();
@@ -59,8 +57,6 @@ private:
 private:
     const int importMode;
     int currentProgress;
-    int localCount;
-    int localProgress;
 };
 
 #endif // LOADSQLITETASK_H
@@ -35,6 +35,7 @@ class DuplicatesImportedRSModelTask : public IQuittableTask
 {
 public:
     QVector<DuplicatesImportedRSModel::DuplicatedItem> items;
+    RSDuplicatesIndex index;
 
     inline DuplicatesImportedRSModelTask(int mode, sqlite3pp::database &db, QObject *receiver) :
         IQuittableTask(receiver),
@@ -67,37 +68,13 @@ public:
         if (fixItemsWithSameValues)
             execFixItemsWithSameValues();
 
-        // Count how many items
-        query q(
-          mDb,
-          "SELECT COUNT(1) FROM ("
-          "SELECT (CASE WHEN imp.new_number NOT NULL THEN imp.new_number ELSE imp.number END) AS "
-          "num,"
-          " (CASE WHEN dup.new_number NOT NULL THEN dup.new_number ELSE dup.number END) AS dup_num"
-          " FROM imported_rs_list imp"
-          " JOIN imported_rs_models mod1 ON mod1.id=imp.model_id"
-          " JOIN imported_rs_owners own1 ON own1.id=imp.owner_id"
-
-          " LEFT JOIN imported_rs_list dup ON dup.id<>imp.id"
-          " LEFT JOIN imported_rs_models mod2 ON mod2.id=dup.model_id"
-          " LEFT JOIN imported_rs_owners own2 ON own2.id=dup.owner_id"
-          " LEFT JOIN rs_list ON rs_list.model_id=mod1.match_existing_id"
-          " WHERE own1.import AND mod1.import AND imp.import=1 AND"
-          " ("
-          "  rs_list.number=num OR"
-          "  ("
-          "   ("
-          "     imp.model_id=dup.model_id OR"
-          "     ("
-          "       mod1.match_existing_id NOT NULL AND mod1.match_existing_id=mod2.match_existing_id"
-          "     )"
-          "   )"
-          "   AND num=dup_num AND own2.import=1 AND mod2.import=1 AND dup.import=1"
-          "  )"
-          " )"
-          " GROUP BY imp.id)");
+        // Count importable items, only used to report progress
+        query q(mDb, "SELECT COUNT(1) FROM imported_rs_list imp"
+                     " JOIN imported_rs_models mod1 ON mod1.id=imp.model_id"
+                     " JOIN imported_rs_owners own1 ON own1.id=imp.owner_id"
+                     " WHERE own1.import AND mod1.import AND imp.import=1");
         q.step();
-        count = q.getRows().get<int>(0);
+        const int total = q.getRows().get<int>(0);
         if (wasStopped())
         {
             sendEvent(new IDuplicatesItemEvent(this, IDuplicatesItemEvent::ProgressAbortedByUser,
@@ -107,9 +84,10 @@ public:
             return;
         }
 
-        if (count == 0)
+        if (total == 0)
         {
             // No data to load, finish
+            count = 0;
             state = IDuplicatesItemModel::Loaded;
             sendEvent(new IDuplicatesItemEvent(
                         this, progress, IDuplicatesItemEvent::ProgressMaxFinished, count, state),
@@ -117,51 +95,40 @@ public:
             return;
         }
 
+        if (!index.loadExisting(mDb))
+        {
+            sendEvent(new IDuplicatesItemEvent(this, IDuplicatesItemEvent::ProgressError,
+                                               IDuplicatesItemEvent::ProgressMaxFinished, count,
+                                               state),
+                      true);
+            return;
+        }
+
         // Now load data
         state    = IDuplicatesItemModel::LoadingData;
-        max      = count + 10;
+        max      = total + 10;
         progress = 10;
 
         // Do not send event if the process is fast
         if (timer.elapsed() > IDuplicatesItemEvent::MinimumMSecsBeforeFirstEvent)
             sendEvent(new IDuplicatesItemEvent(this, progress, max, count, state), false);
 
-        items.reserve(count);
-
-        q.prepare(
-          "SELECT imp.id, mod1.id, mod1.match_existing_id, mod1.type,"
-          " mod1.name, mod1.new_name, rs_models.name, rs_models.type,"
-          " imp.number, imp.new_number,"
-          " own1.name, own1.new_name, rs_owners.name,"
-          " (CASE WHEN imp.new_number NOT NULL THEN imp.new_number ELSE imp.number END) AS num,"
-          " (CASE WHEN dup.new_number NOT NULL THEN dup.new_number ELSE dup.number END) AS dup_num"
-          " FROM imported_rs_list imp"
-          " JOIN imported_rs_models mod1 ON mod1.id=imp.model_id"
-          " JOIN imported_rs_owners own1 ON own1.id=imp.owner_id"
-
-          " LEFT JOIN imported_rs_list dup ON dup.id<>imp.id"
-          " LEFT JOIN imported_rs_models mod2 ON mod2.id=dup.model_id"
-          " LEFT JOIN imported_rs_owners own2 ON own2.id=dup.owner_id"
-          " LEFT JOIN rs_list ON rs_list.model_id=mod1.match_existing_id"
-
-          " LEFT JOIN rs_owners ON rs_owners.id=own1.match_existing_id"
-          " LEFT JOIN rs_models ON rs_models.id=mod1.match_existing_id"
-
-          " WHERE own1.import AND mod1.import AND imp.import=1 AND"
-          " ("
-          "  rs_list.number=num OR"
-          "  ("
-          "   ("
-          "     imp.model_id=dup.model_id OR"
-          "     ("
-          "       mod1.match_existing_id NOT NULL AND mod1.match_existing_id=mod2.match_existing_id"
-          "     )"
-          "   )"
-          "   AND num=dup_num AND own2.import=1 AND mod2.import=1 AND dup.import=1"
-          "  )"
-          " )"
-          " GROUP BY imp.id"
-          " ORDER BY mod1.name, imp.number, own1.name");
+        // Load all importable items in a single pass and index their numbers
+        // Duplicates are then found with hash lookups instead of joining the table with itself
+        QVector<DuplicatesImportedRSModel::DuplicatedItem> allItems;
+        allItems.reserve(total);
+
+        q.prepare("SELECT imp.id, mod1.id, mod1.match_existing_id, mod1.type,"
+                  " mod1.name, mod1.new_name, rs_models.name, rs_models.type,"
+                  " imp.number, imp.new_number,"
+                  " own1.name, own1.new_name, rs_owners.name"
+                  " FROM imported_rs_list imp"
+                  " JOIN imported_rs_models mod1 ON mod1.id=imp.model_id"
+                  " JOIN imported_rs_owners own1 ON own1.id=imp.owner_id"
+                  " LEFT JOIN rs_owners ON rs_owners.id=own1.match_existing_id"
+                  " LEFT JOIN rs_models ON rs_models.id=mod1.match_existing_id"
+                  " WHERE own1.import AND mod1.import AND imp.import=1"
+                  " ORDER BY mod1.name, imp.number, own1.name");
         sqlite3_stmt *st = q.stmt();
 
         // Send about 5 progress events during loading (but process at least 5 items between 2
@@ -179,7 +146,7 @@ public:
                 return;
             }
 
-            if (progress % sentTreshold
+            if (progress % sentTreshold == 0
                 && timer.elapsed() > IDuplicatesItemEvent::MinimumMSecsBeforeFirstEvent)
             {
                 // It's time to report our progress
@@ -187,84 +154,103 @@ public:
             }
 
             DuplicatesImportedRSModel::DuplicatedItem item;
-            item.importedId      = r.get<db_id>(0);
-            item.importedModelId = r.get<db_id>(1);
-
-            // Model
-            item.matchExistingModelId = r.get<db_id>(2);
-            item.type                 = RsType(r.get<int>(3));
-            item.modelName = QByteArray(reinterpret_cast<char const *>(sqlite3_column_text(st, 4)),
-                                        sqlite3_column_bytes(st, 4));
-            if (r.column_type(5) != SQLITE_NULL)
+            readItem(r, st, item);
+            allItems.append(item);
+
+            index.addItem(item.importedId,
+                          RSDuplicatesIndex::modelGroup(item.importedModelId,
+                                                        item.matchExistingModelId),
+                          DuplicatesImportedRSModel::effectiveNumber(item));
+
+            progress++;
+        }
+
+        // Keep only duplicated items, query order is preserved
+        for (const DuplicatesImportedRSModel::DuplicatedItem &item : qAsConst(allItems))
+        {
+            if (index.isDuplicated(item.importedId))
+                items.append(item);
+        }
+        count = items.size();
+
+        state = IDuplicatesItemModel::Loaded;
+        sendEvent(new IDuplicatesItemEvent(this, progress,
+                                           IDuplicatesItemEvent::ProgressMaxFinished, count, state),
+                  true);
+    }
+
+    static void readItem(query::rows &r, sqlite3_stmt *st,
+                         DuplicatesImportedRSModel::DuplicatedItem &item)
+    {
+        item.importedId      = r.get<db_id>(0);
+        item.importedModelId = r.get<db_id>(1);
+
+        // Model
+        item.matchExistingModelId = r.get<db_id>(2);
+        item.type                 = RsType(r.get<int>(3));
+        item.modelName = QByteArray(reinterpret_cast<char const *>(sqlite3_column_text(st, 4)),
+                                    sqlite3_column_bytes(st, 4));
+        if (r.column_type(5) != SQLITE_NULL)
+        {
+            // 'name (new_name)'
+            item.modelName.append(" (", 2);
+            item.modelName.append(reinterpret_cast<char const *>(sqlite3_column_text(st, 5)),
+                                  sqlite3_column_bytes(st, 5));
+            item.modelName.append(')');
+        }
+
+        if (r.column_type(6) != SQLITE_NULL)
+        {
+            // 'name (match_existing name)'
+            QByteArray tmp =
+              QByteArray::fromRawData(reinterpret_cast<char const *>(sqlite3_column_text(st, 6)),
+                                      sqlite3_column_bytes(st, 6));
+
+            if (tmp != item.modelName)
             {
-                // 'name (new_name)'
                 item.modelName.append(" (", 2);
-                item.modelName.append(reinterpret_cast<char const *>(sqlite3_column_text(st, 5)),
-                                      sqlite3_column_bytes(st, 5));
+                item.modelName.append(tmp);
                 item.modelName.append(')');
             }
+            // Prefer matched model type when available
+            item.type = RsType(r.get<int>(7));
+        }
 
-            if (r.column_type(6) != SQLITE_NULL)
-            {
-                // 'name (match_existing name)'
-                QByteArray tmp = QByteArray::fromRawData(
-                  reinterpret_cast<char const *>(sqlite3_column_text(st, 6)),
-                  sqlite3_column_bytes(st, 6));
+        // Number
+        item.number = r.get<int>(8);
 
-                if (tmp != item.modelName)
-                {
-                    item.modelName.append(" (", 2);
-                    item.modelName.append(tmp);
-                    item.modelName.append(')');
-                }
-                // Prefer matched model type when available
-                item.type = RsType(r.get<int>(7));
-            }
+        if (r.column_type(9) == SQLITE_NULL)
+            item.new_number = -1;
+        else
+            item.new_number = r.get<int>(9);
 
-            // Number
-            item.number = r.get<int>(8);
+        item.ownerName = QByteArray(reinterpret_cast<char const *>(sqlite3_column_text(st, 10)),
+                                    sqlite3_column_bytes(st, 10));
+        if (r.column_type(11) != SQLITE_NULL)
+        {
+            // 'name (new_name)'
+            item.ownerName.append(" (", 2);
+            item.ownerName.append(reinterpret_cast<char const *>(sqlite3_column_text(st, 11)),
+                                  sqlite3_column_bytes(st, 11));
+            item.ownerName.append(')');
+        }
 
-            if (r.column_type(9) == SQLITE_NULL)
-                item.new_number = -1;
-            else
-                item.new_number = r.get<int>(9);
+        if (r.column_type(12) != SQLITE_NULL)
+        {
+            // 'name (match_existing name)'
+            QByteArray tmp =
+              QByteArray::fromRawData(reinterpret_cast<char const *>(sqlite3_column_text(st, 12)),
+                                      sqlite3_column_bytes(st, 12));
 
-            item.ownerName = QByteArray(reinterpret_cast<char const *>(sqlite3_column_text(st, 10)),
-                                        sqlite3_column_bytes(st, 10));
-            if (r.column_type(11) != SQLITE_NULL)
+            if (tmp != item.ownerName)
             {
-                // 'name (new_name)'
                 item.ownerName.append(" (", 2);
-                item.ownerName.append(reinterpret_cast<char const *>(sqlite3_column_text(st, 11)),
-                                      sqlite3_column_bytes(st, 11));
+                item.ownerName.append(tmp);
                 item.ownerName.append(')');
             }
-
-            if (r.column_type(12) != SQLITE_NULL)
-            {
-                // 'name (match_existing name)'
-                QByteArray tmp = QByteArray::fromRawData(
-                  reinterpret_cast<char const *>(sqlite3_column_text(st, 12)),
-                  sqlite3_column_bytes(st, 12));
-
-                if (tmp != item.ownerName)
-                {
-                    item.ownerName.append(" (", 2);
-                    item.ownerName.append(tmp);
-                    item.ownerName.append(')');
-                }
-            }
-            item.import = true; // Only imported items get selected so import is true
-
-            items.append(item);
-
-            progress++;
         }
-
-        state = IDuplicatesItemModel::Loaded;
-        sendEvent(new IDuplicatesItemEvent(this, progress,
-                                           IDuplicatesItemEvent::ProgressMaxFinished, count, state),
-                  true);
+        item.import     = true; // Only imported items get selected so import is true
+        item.duplicated = true;
     }
 
     void execFixItemsWithSameValues()
@@ -357,6 +343,14 @@ QVariant DuplicatesImportedRSModel::data(const QModelIndex &idx, int role) const
             return Qt::AlignRight + Qt::AlignVCenter;
         break;
     }
+    case Qt::ForegroundRole:
+    {
+        // Highlight number which still clashes
+        const int numCol = item.new_number == -1 ? Number : NewNumber;
+        if (item.import && item.duplicated && idx.column() == numCol)
+            return QBrush(Qt::red);
+        break;
+    }
     case Qt::BackgroundRole:
     {
         if (!item.import || (idx.column() == NewNumber && item.new_number == -1))
@@ -413,7 +407,10 @@ bool DuplicatesImportedRSModel::setData(const QModelIndex &idx, const QVariant &
                 return false;
 
             item.new_number = newNumber;
-            emit dataChanged(idx, idx);
+            updateDuplicates(idx.row());
+
+            // Update number columns to update foreground
+            emit dataChanged(index(idx.row(), Number), idx);
         }
         break;
     }
@@ -446,6 +443,7 @@ bool DuplicatesImportedRSModel::setData(const QModelIndex &idx, const QVariant &
                 return false;
 
             item.import = import;
+            updateDuplicates(idx.row());
 
             // Update all columns to update background
             QModelIndex first = index(idx.row(), 0);
@@ -480,7 +478,56 @@ IQuittableTask *DuplicatesImportedRSModel::createTask(int mode)
 
 void DuplicatesImportedRSModel::handleResult(IQuittableTask *task)
 {
+    DuplicatesImportedRSModelTask *loadTask = static_cast<DuplicatesImportedRSModelTask *>(task);
+
     beginResetModel();
-    items = static_cast<DuplicatesImportedRSModelTask *>(task)->items;
+    items = loadTask->items;
+
+    // Take index from task, it will be updated when user edits items
+    m_index = std::move(loadTask->index);
+    m_rows.clear();
+    m_rows.reserve(items.size());
+    for (int row = 0; row < items.size(); row++)
+        m_rows.insert(items.at(row).importedId, row);
     endResetModel();
 }
+
+void DuplicatesImportedRSModel::updateDuplicates(int row)
+{
+    DuplicatedItem &item = items[row];
+
+    // Items sharing old number might not be duplicated anymore
+    QVector<db_id> affected = m_index.getItemsWithSameNumber(item.importedId);
+
+    if (item.import)
+    {
+        m_index.addItem(
+          item.importedId,
+          RSDuplicatesIndex::modelGroup(item.importedModelId, item.matchExistingModelId),
+          effectiveNumber(item));
+
+        // Items sharing new number are now duplicated
+        affected += m_index.getItemsWithSameNumber(item.importedId);
+    }
+    else
+    {
+        m_index.removeItem(item.importedId);
+    }
+
+    item.duplicated = m_index.isDuplicated(item.importedId);
+
+    for (db_id importedId : qAsConst(affected))
+    {
+        const int otherRow = m_rows.value(importedId, -1);
+        if (otherRow < 0)
+            continue; // Item is not shown
+
+        DuplicatedItem &other = items[otherRow];
+        const bool duplicated = m_index.isDuplicated(importedId);
+        if (other.duplicated == duplicated)
+            continue;
+
+        other.duplicated = duplicated;
+        emit dataChanged(index(otherRow, Number), index(otherRow, NewNumber));
+    }
+}
@@ -22,11 +22,14 @@
 
 #include <QAbstractTableModel>
 #include <QVector>
+#include <QHash>
 
 #include "utils/types.h"
 
 #include "../intefaces/iduplicatesitemmodel.h"
 
+#include "rsduplicatesindex.h"
+
 #include <sqlite3pp/sqlite3pp.h>
 using namespace sqlite3pp;
 
@@ -58,8 +61,14 @@ public:
         int new_number;
         RsType type;
         bool import;
+        bool duplicated; // Still clashing with other items
     };
 
+    static inline int effectiveNumber(const DuplicatedItem &item)
+    {
+        return item.new_number == -1 ? item.number : item.new_number;
+    }
+
     DuplicatesImportedRSModel(database &db, ICheckName *i, QObject *parent = nullptr);
 
     // Header:
@@ -82,10 +91,16 @@ protected:
     IQuittableTask *createTask(int mode) override;
     void handleResult(IQuittableTask *task) override;
 
+private:
+    void updateDuplicates(int row);
+
 private:
     ICheckName *iface;
 
     QVector<DuplicatedItem> items;
+
+    RSDuplicatesIndex m_index;
+    QHash<db_id, int> m_rows; // Imported item ID to row
 };
 
 #endif // DUPLICATESIMPORTEDRSMODEL_H
@@ -0,0 +1,95 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "rsduplicatesindex.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+void RSDuplicatesIndex::clear()
+{
+    m_imported.clear();
+    m_itemKeys.clear();
+    m_existing.clear();
+}
+
+bool RSDuplicatesIndex::loadExisting(sqlite3pp::database &db)
+{
+    m_existing.clear();
+
+    query q(db, "SELECT model_id,number FROM rs_list WHERE model_id IN ("
+                "SELECT match_existing_id FROM imported_rs_models"
+                " WHERE import=1 AND match_existing_id NOT NULL)");
+    for (auto r : q)
+    {
+        m_existing.insert(Key(r.get<db_id>(0), r.get<int>(1)));
+    }
+
+    return q.stmt() != nullptr;
+}
+
+void RSDuplicatesIndex::addItem(db_id importedId, qint64 group, int number)
+{
+    removeItem(importedId);
+
+    const Key key(group, number);
+    m_imported[key].append(importedId);
+    m_itemKeys.insert(importedId, key);
+}
+
+void RSDuplicatesIndex::removeItem(db_id importedId)
+{
+    auto it = m_itemKeys.find(importedId);
+    if (it == m_itemKeys.end())
+        return;
+
+    auto bucket = m_imported.find(it.value());
+    if (bucket != m_imported.end())
+    {
+        bucket->removeOne(importedId);
+        if (bucket->isEmpty())
+            m_imported.erase(bucket);
+    }
+
+    m_itemKeys.erase(it);
+}
+
+bool RSDuplicatesIndex::isDuplicated(db_id importedId) const
+{
+    auto it = m_itemKeys.constFind(importedId);
+    if (it == m_itemKeys.constEnd())
+        return false; // Not imported
+
+    // Only matched models (positive group) can clash with existing items
+    if (it->first > 0 && m_existing.contains(it.value()))
+        return true;
+
+    return m_imported.value(it.value()).size() > 1;
+}
+
+QVector<db_id> RSDuplicatesIndex::getItemsWithSameNumber(db_id importedId) const
+{
+    auto it = m_itemKeys.constFind(importedId);
+    if (it == m_itemKeys.constEnd())
+        return QVector<db_id>();
+
+    QVector<db_id> result = m_imported.value(it.value());
+    result.removeOne(importedId);
+    return result;
+}
@@ -0,0 +1,86 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSDUPLICATESINDEX_H
+#define RSDUPLICATESINDEX_H
+
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QVector>
+
+#include "utils/types.h"
+
+namespace sqlite3pp {
+class database;
+} // namespace sqlite3pp
+
+/*!
+ * \brief The RSDuplicatesIndex class
+ *
+ * In memory hash index of imported rollingstock numbers.
+ * Items are grouped by model: imported models matched to an existing model
+ * share the group of the existing model so they also clash with 'rs_list' items,
+ * unmatched models only clash with items of the same imported model.
+ * An item is duplicated if another imported item has the same number in its group
+ * or if an existing item of the matched model has the same number.
+ *
+ * The index is built once when loading duplicates and then updated one item at a time
+ * when user changes number or import state, so conflicts are recomputed
+ * without querying the database again.
+ *
+ * \sa DuplicatesImportedRSModel
+ */
+class RSDuplicatesIndex
+{
+public:
+    static inline qint64 modelGroup(db_id importedModelId, db_id matchExistingModelId)
+    {
+        // Negative values for imported models to avoid clashes with existing model IDs
+        return matchExistingModelId ? matchExistingModelId : -importedModelId;
+    }
+
+    void clear();
+
+    /*!
+     * \brief loadExisting
+     * \param db the database
+     * \return false on error
+     *
+     * Loads numbers of existing items belonging to models matched by imported models
+     */
+    bool loadExisting(sqlite3pp::database &db);
+
+    void addItem(db_id importedId, qint64 group, int number);
+    void removeItem(db_id importedId);
+
+    bool isDuplicated(db_id importedId) const;
+
+    // Other imported items with same number in same group of item
+    QVector<db_id> getItemsWithSameNumber(db_id importedId) const;
+
+private:
+    typedef QPair<qint64, int> Key; // Model group, number
+
+    QHash<Key, QVector<db_id>> m_imported;
+    QHash<db_id, Key> m_itemKeys;
+    QSet<Key> m_existing;
+};
+
+#endif // RSDUPLICATESINDEX_H
@@ -0,0 +1,413 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "rsoccupancyindex.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+#include <algorithm>
+
+static const char sql_selectOps[] =
+  "SELECT coupling.rs_id,stops.arrival,coupling.operation,"
+  "stops.station_id,stops.job_id,stops.id"
+  " FROM coupling"
+  " JOIN stops ON stops.id=coupling.stop_id";
+
+// Uncoupling first so an item uncoupled and coupled at same time ends up coupled
+static const char sql_orderOps[] = " ORDER BY coupling.rs_id,stops.arrival,coupling.operation";
+
+static inline RSOccupancyIndex::Operation readOperation(query::rows &r)
+{
+    RSOccupancyIndex::Operation op;
+    op.time      = r.get<int>(1);
+    op.op        = RsOp(r.get<int>(2));
+    op.stationId = r.get<db_id>(3);
+    op.jobId     = r.get<db_id>(4);
+    op.stopId    = r.get<db_id>(5);
+    return op;
+}
+
+RSOccupancyIndex::RSOccupancyIndex(sqlite3pp::database &db, QObject *parent) :
+    QObject(parent),
+    mDb(db),
+    m_loaded(false)
+{
+}
+
+RSOccupancyIndex::~RSOccupancyIndex()
+{
+}
+
+bool RSOccupancyIndex::getPosition(db_id rsId, int time, Position &out)
+{
+    ensureUpToDate();
+
+    auto it = m_rs.constFind(rsId);
+    if (it == m_rs.constEnd() || it->ops.isEmpty())
+        return false;
+
+    const QVector<Operation> &ops = it->ops;
+
+    // First operation after time
+    auto next = std::upper_bound(ops.cbegin(), ops.cend(), time,
+                                 [](int t, const Operation &op) { return t < op.time; });
+
+    if (next == ops.cbegin())
+    {
+        // Not yet operated, it waits where it will be coupled
+        out.stationId = next->stationId;
+        out.jobId     = 0;
+        out.stopId    = next->stopId;
+        out.coupled   = false;
+        return true;
+    }
+
+    const Operation &last = *(next - 1);
+    out.stationId         = last.stationId;
+    out.stopId            = last.stopId;
+    out.coupled           = last.op == RsOp::Coupled;
+    out.jobId             = out.coupled ? last.jobId : 0;
+    return true;
+}
+
+QVector<RSOccupancyIndex::FreeInterval> RSOccupancyIndex::getFreeRS(db_id stationId, int time)
+{
+    ensureUpToDate();
+
+    QVector<FreeInterval> result;
+
+    auto it = m_stations.find(stationId);
+    if (it == m_stations.end())
+        return result;
+
+    StationData &st = it.value();
+    if (st.dirty)
+        rebuildStation(stationId, st);
+
+    // Only intervals started before time can contain it
+    auto end = std::upper_bound(st.free.cbegin(), st.free.cend(), time,
+                                [](int t, const FreeInterval &f) { return t < f.from; });
+
+    for (auto f = st.free.cbegin(); f != end; f++)
+    {
+        if (f->to == NoTime || f->to > time)
+            result.append(*f);
+    }
+
+    return result;
+}
+
+QVector<RSOccupancyIndex::FreeInterval> RSOccupancyIndex::getStationFreeRS(db_id stationId)
+{
+    ensureUpToDate();
+
+    auto it = m_stations.find(stationId);
+    if (it == m_stations.end())
+        return QVector<FreeInterval>();
+
+    StationData &st = it.value();
+    if (st.dirty)
+        rebuildStation(stationId, st);
+
+    return st.free;
+}
+
+bool RSOccupancyIndex::getNextOpTime(db_id stationId, int time, int &outTime)
+{
+    ensureUpToDate();
+
+    auto it = m_stations.find(stationId);
+    if (it == m_stations.end())
+        return false;
+
+    StationData &st = it.value();
+    if (st.dirty)
+        rebuildStation(stationId, st);
+
+    auto next = std::upper_bound(st.opTimes.cbegin(), st.opTimes.cend(), time);
+    if (next == st.opTimes.cend())
+        return false;
+
+    outTime = *next;
+    return true;
+}
+
+bool RSOccupancyIndex::getPrevOpTime(db_id stationId, int time, int &outTime)
+{
+    ensureUpToDate();
+
+    auto it = m_stations.find(stationId);
+    if (it == m_stations.end())
+        return false;
+
+    StationData &st = it.value();
+    if (st.dirty)
+        rebuildStation(stationId, st);
+
+    auto prev = std::lower_bound(st.opTimes.cbegin(), st.opTimes.cend(), time);
+    if (prev == st.opTimes.cbegin())
+        return false;
+
+    outTime = *(prev - 1);
+    return true;
+}
+
+void RSOccupancyIndex::clear()
+{
+    m_rs.clear();
+    m_stations.clear();
+    m_dirtyRS.clear();
+    m_loaded = false;
+}
+
+void RSOccupancyIndex::invalidateRS(const QSet<db_id> &rsIds)
+{
+    if (!m_loaded)
+        return; // Nothing to invalidate
+
+    m_dirtyRS.unite(rsIds);
+}
+
+void RSOccupancyIndex::invalidateStations(const QSet<db_id> &stationIds)
+{
+    if (!m_loaded)
+        return; // Nothing to invalidate
+
+    // Stop times might have changed, reload items operated in these stations
+    for (db_id stationId : stationIds)
+    {
+        auto it = m_stations.constFind(stationId);
+        if (it != m_stations.constEnd())
+            m_dirtyRS.unite(it->rollingstock);
+    }
+}
+
+void RSOccupancyIndex::onRollingstockRemoved(db_id rsId)
+{
+    if (!m_loaded)
+        return;
+
+    removeRS(rsId);
+    m_dirtyRS.remove(rsId);
+}
+
+void RSOccupancyIndex::onJobRemoved(db_id jobId)
+{
+    // Single job removal also notifies its stations and rollingstock
+    if (jobId == 0)
+        clear();
+}
+
+void RSOccupancyIndex::ensureUpToDate()
+{
+    if (!mDb.db())
+        return;
+
+    // When most items changed it's faster to load everything in one pass
+    if (!m_loaded || m_dirtyRS.size() > m_rs.size() / 4 + 16)
+    {
+        loadAll();
+        return;
+    }
+
+    if (m_dirtyRS.isEmpty())
+        return;
+
+    const QByteArray sql = QByteArray(sql_selectOps) + " WHERE coupling.rs_id=?" + sql_orderOps;
+    query q(mDb, sql.constData());
+    for (db_id rsId : qAsConst(m_dirtyRS))
+    {
+        reloadRS(rsId, q);
+    }
+    m_dirtyRS.clear();
+}
+
+void RSOccupancyIndex::loadAll()
+{
+    clear();
+
+    const QByteArray sql = QByteArray(sql_selectOps) + sql_orderOps;
+    query q(mDb, sql.constData());
+
+    db_id lastRsId = 0;
+    QVector<Operation> ops;
+    for (auto r : q)
+    {
+        const db_id rsId = r.get<db_id>(0);
+        if (rsId != lastRsId)
+        {
+            if (lastRsId)
+                setRSOperations(lastRsId, ops);
+            ops.clear();
+            lastRsId = rsId;
+        }
+
+        ops.append(readOperation(r));
+    }
+
+    if (lastRsId)
+        setRSOperations(lastRsId, ops);
+
+    m_loaded = true;
+}
+
+void RSOccupancyIndex::reloadRS(db_id rsId, sqlite3pp::query &q)
+{
+    QVector<Operation> ops;
+
+    q.bind(1, rsId);
+    for (auto r : q)
+    {
+        ops.append(readOperation(r));
+    }
+    q.reset();
+
+    setRSOperations(rsId, ops);
+}
+
+void RSOccupancyIndex::setRSOperations(db_id rsId, const QVector<Operation> &ops)
+{
+    removeRS(rsId);
+
+    if (ops.isEmpty())
+        return;
+
+    RSData &data = m_rs[rsId];
+    data.ops     = ops;
+    calcFreeIntervals(rsId, data.ops, data.free);
+
+    for (const Operation &op : ops)
+    {
+        StationData &st = m_stations[op.stationId];
+        st.rollingstock.insert(rsId);
+        st.dirty = true;
+    }
+}
+
+void RSOccupancyIndex::removeRS(db_id rsId)
+{
+    auto it = m_rs.find(rsId);
+    if (it == m_rs.end())
+        return;
+
+    for (const Operation &op : qAsConst(it->ops))
+    {
+        auto st = m_stations.find(op.stationId);
+        if (st == m_stations.end())
+            continue;
+
+        st->rollingstock.remove(rsId);
+        st->dirty = true;
+    }
+
+    m_rs.erase(it);
+}
+
+void RSOccupancyIndex::rebuildStation(db_id stationId, StationData &st)
+{
+    st.free.clear();
+    st.opTimes.clear();
+
+    for (db_id rsId : qAsConst(st.rollingstock))
+    {
+        auto data = m_rs.constFind(rsId);
+        if (data == m_rs.constEnd())
+            continue;
+
+        for (const FreeInterval &f : data->free)
+        {
+            if (f.stationId == stationId)
+                st.free.append(f);
+        }
+
+        for (const Operation &op : data->ops)
+        {
+            if (op.stationId == stationId)
+                st.opTimes.append(op.time);
+        }
+    }
+
+    std::sort(st.free.begin(), st.free.end(),
+              [](const FreeInterval &a, const FreeInterval &b)
+              { return a.from < b.from || (a.from == b.from && a.rsId < b.rsId); });
+    std::sort(st.opTimes.begin(), st.opTimes.end());
+
+    st.dirty = false;
+}
+
+void RSOccupancyIndex::calcFreeIntervals(db_id rsId, const QVector<Operation> &ops,
+                                         QVector<FreeInterval> &outFree)
+{
+    outFree.clear();
+    if (ops.isEmpty())
+        return;
+
+    const Operation &first = ops.first();
+    if (first.op == RsOp::Coupled)
+    {
+        // Item waits in station since session start
+        FreeInterval f;
+        f.rsId      = rsId;
+        f.stationId = first.stationId;
+        f.to        = first.time;
+        f.toJob     = first.jobId;
+        f.toStop    = first.stopId;
+        outFree.append(f);
+    }
+
+    for (int i = 0; i < ops.size(); i++)
+    {
+        const Operation &op = ops.at(i);
+        if (op.op != RsOp::Uncoupled)
+            continue;
+
+        FreeInterval f;
+        f.rsId      = rsId;
+        f.stationId = op.stationId;
+        f.from      = op.time;
+        f.fromJob   = op.jobId;
+        f.fromStop  = op.stopId;
+
+        if (i + 1 < ops.size() && ops.at(i + 1).op == RsOp::Coupled)
+        {
+            const Operation &next = ops.at(i + 1);
+            if (next.stationId == op.stationId)
+            {
+                f.to     = next.time;
+                f.toJob  = next.jobId;
+                f.toStop = next.stopId;
+            }
+            else
+            {
+                // Inconsistent plan, item is coupled in a different station
+                // Treat it as 2 separate open intervals
+                FreeInterval g;
+                g.rsId      = rsId;
+                g.stationId = next.stationId;
+                g.to        = next.time;
+                g.toJob     = next.jobId;
+                g.toStop    = next.stopId;
+                outFree.append(g);
+            }
+        }
+
+        outFree.append(f);
+    }
+}
@@ -0,0 +1,193 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef RSOCCUPANCYINDEX_H
+#define RSOCCUPANCYINDEX_H
+
+#include <QObject>
+
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include "utils/types.h"
+
+namespace sqlite3pp {
+class database;
+class query;
+} // namespace sqlite3pp
+
+/*!
+ * \brief The RSOccupancyIndex class
+ *
+ * In memory index of rollingstock couplings of current session.
+ * For each rollingstock item it stores operations sorted by time
+ * and the intervals in which item is free (uncoupled) in a station.
+ * Lookups are binary searches instead of aggregate queries on 'coupling' table.
+ *
+ * The index is loaded on first lookup and kept up to date by marking
+ * items and stations dirty when their plan changes, dirty entries
+ * are reloaded on next lookup.
+ * StopModel also marks them after every edit, so lookups see uncommitted Job Editor changes.
+ * It must only be used from main thread.
+ *
+ * Times are minutes since midnight, same unit used by 'stops' table.
+ *
+ * \sa MeetingSession::getRSOccupancyIndex()
+ */
+class RSOccupancyIndex : public QObject
+{
+    Q_OBJECT
+public:
+    // Used for missing bound of a free interval
+    static constexpr int NoTime = -1;
+
+    struct Operation
+    {
+        int time        = 0;
+        RsOp op         = RsOp::Uncoupled;
+        db_id stationId = 0;
+        db_id jobId     = 0;
+        db_id stopId    = 0;
+    };
+
+    /*!
+     * \brief The FreeInterval struct
+     *
+     * Item is uncoupled in \a stationId from \a from time up to \a to time.
+     * \a from is NoTime if item was never coupled before.
+     * \a to is NoTime if item is not coupled anymore.
+     */
+    struct FreeInterval
+    {
+        db_id rsId      = 0;
+        db_id stationId = 0;
+        int from        = NoTime;
+        int to          = NoTime;
+        db_id fromJob   = 0;
+        db_id fromStop  = 0;
+        db_id toJob     = 0;
+        db_id toStop    = 0;
+    };
+
+    struct Position
+    {
+        db_id stationId = 0; // Last station in which item was operated
+        db_id jobId     = 0; // Job which is carrying item, 0 if free
+        db_id stopId    = 0; // Stop of last operation
+        bool coupled    = false;
+    };
+
+    explicit RSOccupancyIndex(sqlite3pp::database &db, QObject *parent = nullptr);
+    ~RSOccupancyIndex();
+
+    /*!
+     * \brief getPosition
+     * \param rsId the rollingstock item
+     * \param time minutes since midnight
+     * \param out filled with item position
+     * \return false if item is never used in session
+     *
+     * Operations happening exactly at \a time are considered already done.
+     * Before first operation item is considered free in the station where it gets coupled.
+     */
+    bool getPosition(db_id rsId, int time, Position &out);
+
+    /*!
+     * \brief getFreeRS
+     * \param stationId the station
+     * \param time minutes since midnight
+     * \return intervals of items free in station at \a time, sorted by start time
+     *
+     * Item uncoupled exactly at \a time is free, item coupled exactly at \a time is not.
+     */
+    QVector<FreeInterval> getFreeRS(db_id stationId, int time);
+
+    /*!
+     * \brief getStationFreeRS
+     * \param stationId the station
+     * \return all free intervals in station during the day, sorted by start time
+     */
+    QVector<FreeInterval> getStationFreeRS(db_id stationId);
+
+    /*!
+     * \brief getNextOpTime
+     * \param stationId the station
+     * \param time minutes since midnight
+     * \param outTime time of first operation in station after \a time
+     * \return false if there are no operations after \a time
+     */
+    bool getNextOpTime(db_id stationId, int time, int &outTime);
+
+    /*!
+     * \brief getPrevOpTime
+     * \param stationId the station
+     * \param time minutes since midnight
+     * \param outTime time of last operation in station before \a time
+     * \return false if there are no operations before \a time
+     */
+    bool getPrevOpTime(db_id stationId, int time, int &outTime);
+
+public slots:
+    // Drop all data, index will be loaded again on next lookup
+    void clear();
+
+    void invalidateRS(const QSet<db_id> &rsIds);
+    void invalidateStations(const QSet<db_id> &stationIds);
+    void onRollingstockRemoved(db_id rsId);
+
+    // Job ID 0 means all jobs were removed
+    void onJobRemoved(db_id jobId);
+
+private:
+    struct StationData
+    {
+        QVector<FreeInterval> free; // Sorted by start time
+        QVector<int> opTimes;       // Sorted, all operations in station
+        QSet<db_id> rollingstock;   // Items operated in station
+        bool dirty = true;
+    };
+
+    struct RSData
+    {
+        QVector<Operation> ops; // Sorted by time, uncoupling first
+        QVector<FreeInterval> free;
+    };
+
+    void ensureUpToDate();
+    void loadAll();
+    void reloadRS(db_id rsId, sqlite3pp::query &q);
+    void setRSOperations(db_id rsId, const QVector<Operation> &ops);
+    void removeRS(db_id rsId);
+    void rebuildStation(db_id stationId, StationData &st);
+
+    static void calcFreeIntervals(db_id rsId, const QVector<Operation> &ops,
+                                  QVector<FreeInterval> &outFree);
+
+private:
+    sqlite3pp::database &mDb;
+
+    QHash<db_id, RSData> m_rs;
+    QHash<db_id, StationData> m_stations;
+
+    QSet<db_id> m_dirtyRS;
+    bool m_loaded;
+};
+
+#endif // RSOCCUPANCYINDEX_H
@@ -140,6 +140,9 @@ public:
     FIELD(CheckCrossingWhenOpeningDB, "background_tasks/check_crossing_at_startup", bool, true)
     FIELD(CheckCrossingOnJobEdit, "background_tasks/check_crossing_on_job_edited", bool, true)
 
+    // Printing, NOTE: budget is shared by station cache and scenes loaded ahead
+    FIELD(PrintMemoryBudgetMiB, "printing/memory_budget_mib", int, 64)
+
 signals:
     void jobColorsChanged();
     void jobGraphOptionsChanged();
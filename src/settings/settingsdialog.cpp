@@ -276,6 +276,9 @@ void SettingsDialog::loadSettings()
     ui->crossingErrCheckAtFileOpen->setChecked(settings.getCheckCrossingWhenOpeningDB());
     ui->crossingErrCheckOnJobEdited->setChecked(settings.getCheckCrossingOnJobEdit());
 
+    // Printing
+    set(ui->printMemoryBudgetSpin, settings.getPrintMemoryBudgetMiB());
+
     updateJobsColors      = false;
     updateJobGraphOptions = false;
 }
@@ -364,6 +367,9 @@ void SettingsDialog::saveSettings()
     settings.setCheckCrossingWhenOpeningDB(ui->crossingErrCheckAtFileOpen->isChecked());
     settings.setCheckCrossingOnJobEdit(ui->crossingErrCheckOnJobEdited->isChecked());
 
+    // Printing
+    settings.setPrintMemoryBudgetMiB(ui->printMemoryBudgetSpin->value());
+
     settings.saveSettings(); // Sync to file
 
     if (updateJobGraphOptions)
@@ -20,6 +20,7 @@
 #include "shiftgraphscene.h"
 
 #include "app/session.h"
+#include "graph/view/graphstyle.h"
 
 #include "utils/jobcategorystrings.h"
 
@@ -29,23 +30,78 @@ using namespace sqlite3pp;
 #include <QPainter>
 #include "utils/font_utils.h"
 
-#include <QtMath>
+#include <algorithm>
 
 static constexpr const char *sql_getStName = "SELECT name,short_name FROM stations"
                                              " WHERE id=?";
 
-static constexpr const char *sql_countJobs = "SELECT COUNT(1) FROM jobs"
-                                             " WHERE jobs.shift_id=?";
+// First and last stop of each job, numbered in a single pass on stops
+// Must be followed by a filter on jobs.shift_id
+static const char sql_jobStops[] =
+  "WITH job_stops AS ("
+  "SELECT stops.job_id,stops.station_id,stops.arrival,stops.departure,"
+  " ROW_NUMBER() OVER (PARTITION BY stops.job_id ORDER BY stops.arrival ASC) AS first_num,"
+  " ROW_NUMBER() OVER (PARTITION BY stops.job_id ORDER BY stops.departure DESC) AS last_num"
+  " FROM stops"
+  " JOIN jobs ON jobs.id=stops.job_id";
+
+// Shifts with their jobs, shifts without jobs get a single row with NULL job
+static const char sql_shiftJobs[] =
+  "), shift_jobs AS ("
+  "SELECT jobs.shift_id,jobs.id AS job_id,jobs.category,"
+  " s1.arrival,s1.station_id AS from_st,s2.departure,s2.station_id AS to_st"
+  " FROM jobs"
+  " JOIN job_stops s1 ON s1.job_id=jobs.id AND s1.first_num=1"
+  " JOIN job_stops s2 ON s2.job_id=jobs.id AND s2.last_num=1)"
+  " SELECT jobshifts.id,jobshifts.name,"
+  " sj.job_id,sj.category,sj.arrival,sj.from_st,sj.departure,sj.to_st"
+  " FROM jobshifts"
+  " LEFT JOIN shift_jobs sj ON sj.shift_id=jobshifts.id";
+
+static const char sql_getAllStNames[] = "SELECT id,name,short_name FROM stations"
+                                        " WHERE id IN ("
+                                        "SELECT stops.station_id FROM stops"
+                                        " JOIN jobs ON jobs.id=stops.job_id"
+                                        " WHERE jobs.shift_id NOT NULL)";
+
+static QByteArray getAllShiftsSql()
+{
+    return QByteArray(sql_jobStops) + " WHERE jobs.shift_id NOT NULL" + sql_shiftJobs
+           + " ORDER BY jobshifts.name,jobshifts.id,sj.arrival";
+}
+
+static QByteArray getSingleShiftSql()
+{
+    return QByteArray(sql_jobStops) + " WHERE jobs.shift_id=?1" + sql_shiftJobs
+           + " WHERE jobshifts.id=?1 ORDER BY sj.arrival";
+}
+
+// Returns false if row has no job
+static bool readJobItem(query::rows &r, ShiftGraphScene::JobItem &item)
+{
+    if (r.column_type(2) == SQLITE_NULL)
+        return false;
 
-static constexpr const char *sql_getJobs   = "SELECT jobs.id, jobs.category,"
-                                             " MIN(s1.arrival), s1.station_id,"
-                                             " MAX(s2.departure), s2.station_id"
-                                             " FROM jobs"
-                                             " JOIN stops s1 ON s1.job_id=jobs.id"
-                                             " JOIN stops s2 ON s2.job_id=jobs.id"
-                                             " WHERE jobs.shift_id=?"
-                                             " GROUP BY jobs.id"
-                                             " ORDER BY s1.arrival ASC";
+    item.job.jobId    = r.get<db_id>(2);
+    item.job.category = JobCategory(r.get<int>(3));
+
+    item.start        = r.get<QTime>(4);
+    item.fromStId     = r.get<db_id>(5);
+
+    item.end          = r.get<QTime>(6);
+    item.toStId       = r.get<db_id>(7);
+    return true;
+}
+
+// Jobs of same shift cannot overlap so list is sorted by both start and end
+// Returns first job ending at or after time, the only one which can contain it
+static QVector<ShiftGraphScene::JobItem>::const_iterator
+  lowerBoundJob(const QVector<ShiftGraphScene::JobItem> &jobList, const QTime &t)
+{
+    return std::lower_bound(jobList.cbegin(), jobList.cend(), t,
+                            [](const ShiftGraphScene::JobItem &item, const QTime &time)
+                            { return item.end < time; });
+}
 
 ShiftGraphScene::ShiftGraphScene(sqlite3pp::database &db, QObject *parent) :
     IGraphScene(parent),
@@ -85,6 +141,8 @@ void ShiftGraphScene::renderHeader(QPainter *painter, const QRectF &sceneRect,
 
 void ShiftGraphScene::drawShifts(QPainter *painter, const QRectF &sceneRect)
 {
+    const GraphStyle style = GraphStyle::current();
+
     QTextOption jobTextOpt(Qt::AlignCenter);
     QTextOption fromStationTextOpt(Qt::AlignVCenter | Qt::AlignLeft);
     QTextOption toStationTextOpt(Qt::AlignVCenter | Qt::AlignRight);
@@ -104,16 +162,20 @@ void ShiftGraphScene::drawShifts(QPainter *painter, const QRectF &sceneRect)
 
     QPen textPen(Qt::black, 2);
 
-    qreal y = vertOffset + rowSpaceOffset / 2;
-    for (const ShiftGraph &shift : qAsConst(m_shifts))
+    // Skip rows above requested view
+    const int firstRow   = qMax(0, rowAt(sceneRect.top()));
+
+    // Jobs ending before this time are at left of requested view
+    const QTime leftTime = timeAt(sceneRect.left());
+
+    for (int row = firstRow; row < m_shifts.size(); row++)
     {
-        const qreal top = y;
-        qreal jobY      = top + shiftRowHeight / 2;
-        qreal bottomY   = top + shiftRowHeight;
-        y               = bottomY + rowSpaceOffset;
+        const ShiftGraph &shift = m_shifts.at(row);
+
+        const qreal top         = rowTop(row);
+        qreal jobY              = top + shiftRowHeight / 2;
+        qreal bottomY           = top + shiftRowHeight;
 
-        if (bottomY < sceneRect.top())
-            continue; // Shift is above requested view
         if (top > sceneRect.bottom())
             break; // Shift is below requested view and next will be out too
 
@@ -122,10 +184,11 @@ void ShiftGraphScene::drawShifts(QPainter *painter, const QRectF &sceneRect)
         double prevJobNameLastX     = horizOffset;
         double prevStationNameLastX = horizOffset;
 
-        for (const JobItem &item : shift.jobList)
+        for (auto it = lowerBoundJob(shift.jobList, leftTime); it != shift.jobList.cend(); it++)
         {
-            double firstX = jobPos(item.start);
-            double lastX  = jobPos(item.end);
+            const JobItem &item = *it;
+            double firstX       = jobPos(item.start);
+            double lastX        = jobPos(item.end);
 
             if (lastX < sceneRect.left())
                 continue; // Job is at left of requested view
@@ -133,7 +196,7 @@ void ShiftGraphScene::drawShifts(QPainter *painter, const QRectF &sceneRect)
             if (firstX > sceneRect.right())
                 break; // Next Jobs are after in time so they will be out too
 
-            jobPen.setColor(Session->colorForCat(item.job.category));
+            jobPen.setColor(style.colorForCat(item.job.category));
             painter->setPen(jobPen);
 
             // Draw Job line
@@ -250,20 +313,15 @@ void ShiftGraphScene::drawShiftHeader(QPainter *painter, const QRectF &rect)
     QRectF labelRect = rect;
     labelRect.setHeight(shiftRowHeight);
 
-    qreal y = vertOffset + rowSpaceOffset / 2;
-    for (const ShiftGraph &shift : qAsConst(m_shifts))
+    // Skip rows above requested view
+    for (int row = qMax(0, rowAt(rect.top())); row < m_shifts.size(); row++)
     {
-        const qreal top = y;
-        qreal bottomY   = top + shiftRowHeight;
-        y               = bottomY + rowSpaceOffset;
-
-        if (bottomY < rect.top())
-            continue; // Shift is above requested view
+        const qreal top = rowTop(row);
         if (top > rect.bottom())
             break; // Shift is below requested view and next will be out too
 
         labelRect.moveTop(top);
-        painter->drawText(labelRect, shift.shiftName, shiftTextOpt);
+        painter->drawText(labelRect, m_shifts.at(row).shiftName, shiftTextOpt);
     }
 }
 
@@ -274,7 +332,7 @@ void ShiftGraphScene::drawHourHeader(QPainter *painter, const QRectF &rect)
     QFont hourTextFont;
     setFontPointSizeDPI(hourTextFont, 20, painter);
 
-    QPen hourTextPen(AppSettings.getHourTextColor());
+    QPen hourTextPen(GraphStyle::current().hourTextColor);
 
     painter->setFont(hourTextFont);
     painter->setPen(hourTextPen);
@@ -307,8 +365,7 @@ ShiftGraphScene::JobItem ShiftGraphScene::getJobAt(const QPointF &scenePos,
 {
     JobItem job;
 
-    const qreal y = scenePos.y() - vertOffset - rowSpaceOffset / 2;
-    int shiftIdx  = qFloor(y / (shiftRowHeight + rowSpaceOffset));
+    const int shiftIdx = rowAt(scenePos.y());
     if (shiftIdx < 0 || shiftIdx >= m_shifts.size())
         return job;
 
@@ -320,19 +377,29 @@ ShiftGraphScene::JobItem ShiftGraphScene::getJobAt(const QPointF &scenePos,
 
     const ShiftGraph &shift = m_shifts.at(shiftIdx);
 
-    for (const JobItem &item : shift.jobList)
+    auto it = lowerBoundJob(shift.jobList, t);
+    if (it != shift.jobList.cend() && it->start <= t)
     {
-        if (item.start <= t && item.end >= t)
-        {
-            job          = item;
-            outShiftName = shift.shiftName;
-            break;
-        }
+        job          = *it;
+        outShiftName = shift.shiftName;
     }
 
     return job;
 }
 
+QTime ShiftGraphScene::timeAt(qreal x) const
+{
+    const qreal msecs = (x - horizOffset) / hourOffset * MSEC_PER_HOUR;
+    return QTime::fromMSecsSinceStartOfDay(qBound(0, qFloor(msecs), 24 * 60 * 60 * 1000 - 1));
+}
+
+QRectF ShiftGraphScene::getRowRect(int row) const
+{
+    // Include half spacing on both sides, separator line is drawn there
+    return QRectF(0, rowTop(row) - rowSpaceOffset / 2, m_cachedContentsSize.width(),
+                  shiftRowHeight + rowSpaceOffset);
+}
+
 bool ShiftGraphScene::loadShifts()
 {
     m_shifts.clear();
@@ -340,34 +407,41 @@ bool ShiftGraphScene::loadShifts()
     m_stationCache.clear();
     m_stationCache.squeeze();
 
-    query q(mDb, "SELECT COUNT(1) FROM jobshifts");
-    q.step();
-    int count = q.getRows().get<int>(0);
-
-    if (count == 0)
+    // Load names of all stations used by shifts in one pass
+    query q(mDb, sql_getAllStNames);
+    for (auto st : q)
     {
-        // Nothing to load
-        m_shifts.squeeze();
-        return true;
-    }
+        StationCache entry;
+        entry.name                = st.get<QString>(1);
+        entry.shortNameOrFallback = st.get<QString>(2);
 
-    m_shifts.reserve(count);
+        // If 'Short Name' is empty fallback to 'Full Name'
+        if (entry.shortNameOrFallback.isEmpty())
+            entry.shortNameOrFallback = entry.name;
 
-    query q_getStName(mDb, sql_getStName);
-    query q_countJobs(mDb, sql_countJobs);
-    query q_getJobs(mDb, sql_getJobs);
+        m_stationCache.insert(st.get<db_id>(0), entry);
+    }
 
-    q.prepare("SELECT id,name FROM jobshifts ORDER BY name");
-    for (auto shift : q)
+    // Rows are grouped by shift and sorted by job start
+    q.prepare(getAllShiftsSql().constData());
+    for (auto r : q)
     {
-        ShiftGraph obj;
-        obj.shiftId   = shift.get<db_id>(0);
-        obj.shiftName = shift.get<QString>(1);
+        const db_id shiftId = r.get<db_id>(0);
+        if (m_shifts.isEmpty() || m_shifts.last().shiftId != shiftId)
+        {
+            ShiftGraph obj;
+            obj.shiftId   = shiftId;
+            obj.shiftName = r.get<QString>(1);
+            m_shifts.append(obj);
+        }
 
-        loadShiftRow(obj, q_getStName, q_countJobs, q_getJobs);
-        m_shifts.append(obj);
+        JobItem item;
+        if (readJobItem(r, item))
+            m_shifts.last().jobList.append(item);
     }
 
+    m_shifts.squeeze();
+
     recalcContentSize();
 
     emit redrawGraph();
@@ -417,9 +491,8 @@ void ShiftGraphScene::onShiftNameChanged(db_id shiftId)
 
         // Load jobs
         query q_getStName(mDb, sql_getStName);
-        query q_countJobs(mDb, sql_countJobs);
-        query q_getJobs(mDb, sql_getJobs);
-        loadShiftRow(obj, q_getStName, q_countJobs, q_getJobs);
+        query q_getJobs(mDb, getSingleShiftSql().constData());
+        loadShiftRow(obj, q_getStName, q_getJobs);
 
         m_shifts.insert(pos.second, obj);
 
@@ -470,19 +543,20 @@ void ShiftGraphScene::onShiftJobsChanged(db_id shiftId)
 {
     // Reload single shift
     query q_getStName(mDb, sql_getStName);
-    query q_countJobs(mDb, sql_countJobs);
-    query q_getJobs(mDb, sql_getJobs);
+    query q_getJobs(mDb, getSingleShiftSql().constData());
 
-    for (ShiftGraph &shift : m_shifts)
+    for (int row = 0; row < m_shifts.size(); row++)
     {
+        ShiftGraph &shift = m_shifts[row];
         if (shift.shiftId == shiftId)
         {
-            loadShiftRow(shift, q_getStName, q_countJobs, q_getJobs);
+            loadShiftRow(shift, q_getStName, q_getJobs);
+
+            // Rows have fixed height, only this one needs repainting
+            emit redrawSceneRect(getRowRect(row));
             break;
         }
     }
-
-    emit redrawGraph();
 }
 
 void ShiftGraphScene::onJobRemoved(db_id jobId)
@@ -504,37 +578,17 @@ void ShiftGraphScene::recalcContentSize()
     m_cachedContentsSize = QSizeF(width, height);
 }
 
-bool ShiftGraphScene::loadShiftRow(ShiftGraph &shiftObj, query &q_getStName, query &q_countJobs,
+bool ShiftGraphScene::loadShiftRow(ShiftGraph &shiftObj, query &q_getStName,
                                    sqlite3pp::query &q_getJobs)
 {
     shiftObj.jobList.clear();
 
-    q_countJobs.bind(1, shiftObj.shiftId);
-    q_countJobs.step();
-    int count = q_countJobs.getRows().get<int>(0);
-    q_countJobs.reset();
-
-    if (count == 0)
-    {
-        // Nothing to load
-        return true;
-    }
-
-    shiftObj.jobList.reserve(count);
-
     q_getJobs.bind(1, shiftObj.shiftId);
     for (auto job : q_getJobs)
     {
         JobItem item;
-
-        item.job.jobId    = job.get<db_id>(0);
-        item.job.category = JobCategory(job.get<int>(1));
-
-        item.start        = job.get<QTime>(2);
-        item.fromStId     = job.get<db_id>(3);
-
-        item.end          = job.get<QTime>(4);
-        item.toStId       = job.get<db_id>(5);
+        if (!readJobItem(job, item))
+            continue; // Shift has no jobs
 
         loadStationName(item.fromStId, q_getStName);
         loadStationName(item.toStId, q_getStName);
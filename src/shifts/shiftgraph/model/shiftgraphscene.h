@@ -25,6 +25,7 @@
 #include <QVector>
 #include <QHash>
 #include <QTime>
+#include <QtMath>
 
 #include "utils/types.h"
 
@@ -113,7 +114,7 @@ private:
     void recalcContentSize();
 
     bool loadShiftRow(ShiftGraph &shiftObj, sqlite3pp::query &q_getStName,
-                      sqlite3pp::query &q_countJobs, sqlite3pp::query &q_getJobs);
+                      sqlite3pp::query &q_getJobs);
     void loadStationName(db_id stationId, sqlite3pp::query &q_getStName);
 
     std::pair<int, int> lowerBound(db_id shiftId, const QString &name);
@@ -124,6 +125,23 @@ private:
         return t.msecsSinceStartOfDay() / MSEC_PER_HOUR * hourOffset + horizOffset;
     }
 
+    // Inverse of jobPos(), bounded to a valid time
+    QTime timeAt(qreal x) const;
+
+    // Rows have fixed height so they are indexed by position
+    inline qreal rowTop(int row) const
+    {
+        return vertOffset + rowSpaceOffset / 2 + row * (shiftRowHeight + rowSpaceOffset);
+    }
+
+    // Can return out of range index, caller must check it
+    inline int rowAt(qreal y) const
+    {
+        return qFloor((y - vertOffset - rowSpaceOffset / 2) / (shiftRowHeight + rowSpaceOffset));
+    }
+
+    QRectF getRowRect(int row) const;
+
 private:
     sqlite3pp::database &mDb;
 
@@ -32,14 +32,17 @@
 
 SQLConsole::SQLConsole(QWidget *parent) :
     QDialog(parent),
-    timer(nullptr)
+    timer(nullptr),
+    isTimedRun(false)
 {
     setWindowTitle(QStringLiteral("SQL Console"));
 
     edit                  = new QPlainTextEdit;
-    viewer                = new SQLViewer(nullptr);
+    viewer                = new SQLViewer;
     QPushButton *clearBut = new QPushButton("Clear");
-    QPushButton *runBut   = new QPushButton("Run");
+    runBut                = new QPushButton("Run");
+    stopBut               = new QPushButton("Stop");
+    stopBut->setEnabled(false);
 
     intervalSpin          = new QSpinBox;
     intervalSpin->setMinimum(0);
@@ -47,14 +50,19 @@ SQLConsole::SQLConsole(QWidget *parent) :
     intervalSpin->setSuffix(" seconds");
 
     QGridLayout *lay = new QGridLayout(this);
-    lay->addWidget(edit, 0, 0, 1, 3);
+    lay->addWidget(edit, 0, 0, 1, 4);
     lay->addWidget(runBut, 1, 0, 1, 1);
-    lay->addWidget(clearBut, 1, 1, 1, 1);
-    lay->addWidget(intervalSpin, 1, 2, 1, 1);
-    lay->addWidget(viewer, 2, 0, 1, 3);
+    lay->addWidget(stopBut, 1, 1, 1, 1);
+    lay->addWidget(clearBut, 1, 2, 1, 1);
+    lay->addWidget(intervalSpin, 1, 3, 1, 1);
+    lay->addWidget(viewer, 2, 0, 1, 4);
 
     connect(clearBut, &QPushButton::clicked, edit, &QPlainTextEdit::clear);
     connect(runBut, &QPushButton::clicked, this, &SQLConsole::executeQuery);
+    connect(stopBut, &QPushButton::clicked, viewer, &SQLViewer::stopQuery);
+
+    connect(viewer, &SQLViewer::queryStarted, this, &SQLConsole::onQueryStarted);
+    connect(viewer, &SQLViewer::queryFinished, this, &SQLConsole::onQueryFinished);
 
     connect(intervalSpin, &QSpinBox::editingFinished, this, &SQLConsole::onIntervalChangedUser);
 
@@ -97,21 +105,46 @@ void SQLConsole::onIntervalChangedUser()
 bool SQLConsole::executeQuery()
 {
     QString sql = edit->toPlainText();
-    if (!viewer->prepare(sql.toUtf8()))
+    if (!viewer->execQuery(sql))
         return false;
 
-    viewer->execQuery();
+    // Timer runs last started query
+    lastQuery = sql;
     return true;
 }
 
 void SQLConsole::timedExec()
 {
-    if (!viewer->execQuery())
+    if (lastQuery.isEmpty() || viewer->isRunning())
+        return; // Skip this round
+
+    if (!viewer->execQuery(lastQuery))
     {
         setInterval(0); // Abort timer
         return;
     }
-    viewer->timedExec();
+    isTimedRun = true;
+}
+
+void SQLConsole::onQueryStarted()
+{
+    runBut->setEnabled(false);
+    stopBut->setEnabled(true);
+}
+
+void SQLConsole::onQueryFinished(bool success)
+{
+    runBut->setEnabled(true);
+    stopBut->setEnabled(false);
+
+    if (!isTimedRun)
+        return;
+
+    isTimedRun = false;
+    if (success)
+        viewer->timedExec();
+    else
+        setInterval(0); // Abort timer
 }
 
 #endif // ENABLE_USER_QUERY
@@ -26,6 +26,7 @@
 
 class SQLViewer;
 class QPlainTextEdit;
+class QPushButton;
 class QSpinBox;
 class QTimer;
 
@@ -45,12 +46,19 @@ private slots:
     void onIntervalChangedUser();
 
     void timedExec();
+    void onQueryStarted();
+    void onQueryFinished(bool success);
 
 private:
     QPlainTextEdit *edit;
     SQLViewer *viewer;
+    QPushButton *runBut;
+    QPushButton *stopBut;
     QSpinBox *intervalSpin;
     QTimer *timer;
+
+    QString lastQuery;
+    bool isTimedRun;
 };
 
 #endif // ENABLE_USER_QUERY
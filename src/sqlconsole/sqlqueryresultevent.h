@@ -0,0 +1,61 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SQLQUERYRESULTEVENT_H
+#define SQLQUERYRESULTEVENT_H
+
+#ifdef ENABLE_USER_QUERY
+
+#    include "utils/thread/taskprogressevent.h"
+
+#    include <QStringList>
+
+#    include "sqlresultbuffer.h"
+
+class SQLQueryTask;
+
+class SQLQueryResultEvent : public GenericTaskEvent
+{
+public:
+    enum Status
+    {
+        Started = 0, // Query prepared, column names are set
+        Rows,        // A new batch of rows
+        Finished,    // Last event, all rows were read
+        Interrupted, // Last event, stopped by user
+        Error        // Last event, error fields are set
+    };
+
+    static constexpr Type _Type = Type(CustomEvents::SQLConsoleQueryResult);
+
+    SQLQueryResultEvent(SQLQueryTask *self, Status s);
+
+    Status status;
+    QStringList columnNames;
+    SQLResultBuffer rows;
+    qint64 elapsedMs = 0; // Time since task started
+
+    int errCode     = 0;
+    int extendedErr = 0;
+    QString errMsg;
+};
+
+#endif // ENABLE_USER_QUERY
+
+#endif // SQLQUERYRESULTEVENT_H
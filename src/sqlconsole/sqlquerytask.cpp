@@ -0,0 +1,154 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef ENABLE_USER_QUERY
+
+#    include "sqlquerytask.h"
+
+#    include "sqlqueryresultevent.h"
+
+#    include <QElapsedTimer>
+
+#    include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+SQLQueryTask::SQLQueryTask(const QString &dbPath, const QByteArray &sql, QObject *receiver) :
+    IQuittableTask(receiver),
+    m_dbPath(dbPath),
+    m_sql(sql),
+    m_handle(nullptr)
+{
+}
+
+void SQLQueryTask::run()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    SQLQueryResultEvent *ev = nullptr;
+
+    {
+        database db;
+        // Writes must go through main connection, see SQLViewer::execQuery()
+        const int ret = db.connect(m_dbPath.toUtf8(), SQLITE_OPEN_READONLY);
+        if (ret != SQLITE_OK)
+        {
+            ev = errorEvent(db, ret);
+        }
+        else
+        {
+            // Same settings as main connection
+            db.enable_foreign_keys(true);
+            db.enable_extended_result_codes(true);
+            db.set_busy_timeout(BusyTimeout);
+
+            setHandle(db.db());
+            ev = execQuery(db, timer);
+            setHandle(nullptr);
+        }
+    }
+
+    ev->elapsedMs = timer.elapsed();
+    sendEvent(ev, true);
+}
+
+void SQLQueryTask::interrupt()
+{
+    QMutexLocker lock(&m_handleMutex);
+    if (m_handle)
+        sqlite3_interrupt(m_handle);
+}
+
+SQLQueryResultEvent *SQLQueryTask::execQuery(database &db, const QElapsedTimer &timer)
+{
+    if (wasStopped())
+        return new SQLQueryResultEvent(this, SQLQueryResultEvent::Interrupted);
+
+    query q(db);
+    int ret = q.prepare(m_sql.constData());
+    if (ret != SQLITE_OK)
+        return errorEvent(db, ret);
+
+    // NOTE: statement is null if SQL contains only comments or white spaces
+    sqlite3_stmt *stmt = q.stmt();
+    const int colCount = stmt ? sqlite3_column_count(stmt) : 0;
+
+    SQLQueryResultEvent *ev = new SQLQueryResultEvent(this, SQLQueryResultEvent::Started);
+    ev->columnNames.reserve(colCount);
+    for (int i = 0; i < colCount; i++)
+        ev->columnNames.append(QString::fromUtf8(sqlite3_column_name(stmt, i)));
+
+    // NOTE: event is owned by receiver after posting it, do not access it anymore
+    qint64 lastBatchTime = timer.elapsed();
+    ev->elapsedMs        = lastBatchTime;
+    sendEvent(ev, false);
+
+    if (!stmt)
+        return new SQLQueryResultEvent(this, SQLQueryResultEvent::Finished);
+
+    SQLResultBuffer batch(colCount);
+
+    while ((ret = sqlite3_step(stmt)) == SQLITE_ROW)
+    {
+        batch.appendRow(stmt);
+
+        if (wasStopped())
+            break;
+
+        const qint64 now = timer.elapsed();
+        if (now - lastBatchTime < BatchInterval && batch.rowCount() < MaxBatchRows)
+            continue;
+
+        ev            = new SQLQueryResultEvent(this, SQLQueryResultEvent::Rows);
+        ev->rows      = batch;
+        ev->elapsedMs = now;
+        sendEvent(ev, false);
+
+        batch.clear();
+        lastBatchTime = now;
+    }
+
+    if (ret == SQLITE_DONE)
+        ev = new SQLQueryResultEvent(this, SQLQueryResultEvent::Finished);
+    else if (ret == SQLITE_ROW || (ret & 0xFF) == SQLITE_INTERRUPT)
+        ev = new SQLQueryResultEvent(this, SQLQueryResultEvent::Interrupted);
+    else
+        ev = errorEvent(db, ret);
+
+    // Send rows read before query ended
+    ev->rows = batch;
+    return ev;
+}
+
+SQLQueryResultEvent *SQLQueryTask::errorEvent(database &db, int ret)
+{
+    SQLQueryResultEvent *ev = new SQLQueryResultEvent(this, SQLQueryResultEvent::Error);
+    ev->errCode             = ret & 0xFF;
+    ev->extendedErr         = db.extended_error_code();
+    ev->errMsg              = db.error_msg();
+    return ev;
+}
+
+void SQLQueryTask::setHandle(sqlite3 *handle)
+{
+    QMutexLocker lock(&m_handleMutex);
+    m_handle = handle;
+}
+
+#endif // ENABLE_USER_QUERY
@@ -0,0 +1,92 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SQLQUERYTASK_H
+#define SQLQUERYTASK_H
+
+#ifdef ENABLE_USER_QUERY
+
+#    include "utils/thread/iquittabletask.h"
+
+#    include <QByteArray>
+#    include <QString>
+#    include <QMutex>
+
+typedef struct sqlite3 sqlite3;
+
+class QElapsedTimer;
+class SQLQueryResultEvent;
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The SQLQueryTask class
+ *
+ * Runs a read-only SQL Console query on a separate connection to session file
+ * so GUI thread is not blocked by long queries.
+ * Connection is opened read-only, statements which write are run by SQLViewer on main connection
+ * so they respect its savepoints and locks.
+ * Rows are sent to receiver in batches with SQLQueryResultEvent.
+ * While the query runs the file is read locked, so writes on main connection
+ * might fail with SQLITE_BUSY until the task finishes or it's interrupted.
+ *
+ * \sa interrupt()
+ */
+class SQLQueryTask : public IQuittableTask
+{
+public:
+    // Rows are sent to receiver at most every BatchInterval milliseconds
+    static constexpr int BatchInterval = 100;
+    static constexpr int MaxBatchRows  = 10000;
+
+    // Wait for main connection to release its locks before failing
+    static constexpr int BusyTimeout   = 2000;
+
+    SQLQueryTask(const QString &dbPath, const QByteArray &sql, QObject *receiver);
+
+    void run() override;
+
+    /*!
+     * \brief interrupt query
+     *
+     * Can be called from any thread.
+     * Calls sqlite3_interrupt() on worker connection so a long step is aborted.
+     * Call \ref stop() before so task does not start new steps.
+     */
+    void interrupt();
+
+private:
+    SQLQueryResultEvent *execQuery(sqlite3pp::database &db, const QElapsedTimer &timer);
+    SQLQueryResultEvent *errorEvent(sqlite3pp::database &db, int ret);
+
+    void setHandle(sqlite3 *handle);
+
+private:
+    QString m_dbPath;
+    QByteArray m_sql;
+
+    QMutex m_handleMutex;
+    sqlite3 *m_handle;
+};
+
+#endif // ENABLE_USER_QUERY
+
+#endif // SQLQUERYTASK_H
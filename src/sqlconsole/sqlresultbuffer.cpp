@@ -0,0 +1,146 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef ENABLE_USER_QUERY
+
+#    include "sqlresultbuffer.h"
+
+#    include <sqlite3pp/sqlite3pp.h>
+
+SQLResultBuffer::SQLResultBuffer(int columnCount) :
+    m_rowCount(0)
+{
+    reset(columnCount);
+}
+
+void SQLResultBuffer::reset(int columnCount)
+{
+    m_columns.clear();
+    m_columns.resize(columnCount);
+    m_rowCount = 0;
+}
+
+void SQLResultBuffer::clear()
+{
+    reset(m_columns.size());
+}
+
+void SQLResultBuffer::appendRow(sqlite3_stmt *stmt)
+{
+    for (int c = 0; c < m_columns.size(); c++)
+    {
+        Column &col    = m_columns[c];
+        const int type = sqlite3_column_type(stmt, c);
+
+        Cell cell;
+        cell.integer = 0;
+
+        switch (type)
+        {
+        case SQLITE_INTEGER:
+        {
+            cell.integer = sqlite3_column_int64(stmt, c);
+            break;
+        }
+        case SQLITE_FLOAT:
+        {
+            cell.real = sqlite3_column_double(stmt, c);
+            break;
+        }
+        case SQLITE_TEXT:
+        case SQLITE_BLOB:
+        {
+            // NOTE: get data pointer before size as recommended by SQLite docs
+            const void *data = type == SQLITE_TEXT ? sqlite3_column_text(stmt, c)
+                                                   : sqlite3_column_blob(stmt, c);
+            cell.str.offset  = col.strings.size();
+            cell.str.size    = sqlite3_column_bytes(stmt, c);
+            if (cell.str.size > 0)
+                col.strings.append(static_cast<const char *>(data), cell.str.size);
+            break;
+        }
+        default:
+            break;
+        }
+
+        col.types.append(quint8(type));
+        col.cells.append(cell);
+    }
+
+    m_rowCount++;
+}
+
+void SQLResultBuffer::append(const SQLResultBuffer &other)
+{
+    if (other.m_columns.size() != m_columns.size() || other.m_rowCount == 0)
+        return;
+
+    for (int c = 0; c < m_columns.size(); c++)
+    {
+        Column &col       = m_columns[c];
+        const Column &src = other.m_columns.at(c);
+
+        const int firstRow = col.cells.size();
+        const int base     = col.strings.size();
+
+        col.types += src.types;
+        col.cells += src.cells;
+        col.strings += src.strings;
+
+        if (base == 0)
+            continue;
+
+        // Shift string references after data of previous rows
+        for (int r = firstRow; r < col.cells.size(); r++)
+        {
+            const quint8 type = col.types.at(r);
+            if (type == SQLITE_TEXT || type == SQLITE_BLOB)
+                col.cells[r].str.offset += base;
+        }
+    }
+
+    m_rowCount += other.m_rowCount;
+}
+
+QVariant SQLResultBuffer::value(int row, int col) const
+{
+    const Column &column = m_columns.at(col);
+    const Cell &cell     = column.cells.at(row);
+
+    switch (column.types.at(row))
+    {
+    case SQLITE_INTEGER:
+        return cell.integer;
+    case SQLITE_FLOAT:
+        return cell.real;
+    case SQLITE_TEXT:
+        return QString::fromUtf8(column.strings.constData() + cell.str.offset, cell.str.size);
+    case SQLITE_BLOB:
+        return QStringLiteral("BLOB ")
+               + QString::fromUtf8(column.strings.constData() + cell.str.offset, cell.str.size);
+    case SQLITE_NULL:
+        return QStringLiteral("NULL");
+    default:
+        break;
+    }
+
+    return QVariant();
+}
+
+#endif // ENABLE_USER_QUERY
@@ -0,0 +1,97 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef SQLRESULTBUFFER_H
+#define SQLRESULTBUFFER_H
+
+#ifdef ENABLE_USER_QUERY
+
+#    include <QVector>
+#    include <QByteArray>
+#    include <QVariant>
+
+typedef struct sqlite3_stmt sqlite3_stmt;
+
+/*!
+ * \brief The SQLResultBuffer class
+ *
+ * Compact columnar storage for SQL Console results.
+ * Each column stores SQLite type and value of every row in 2 plain arrays,
+ * text and blob data is appended to a single byte array of the column.
+ * Cells are converted to QVariant only when requested by the view.
+ *
+ * \sa SQLResultModel
+ */
+class SQLResultBuffer
+{
+public:
+    explicit SQLResultBuffer(int columnCount = 0);
+
+    // Remove all rows and set a new column count
+    void reset(int columnCount);
+
+    // Remove all rows but keep columns
+    void clear();
+
+    inline int columnCount() const
+    {
+        return m_columns.size();
+    }
+
+    inline int rowCount() const
+    {
+        return m_rowCount;
+    }
+
+    // Read current row of a stepped statement
+    void appendRow(sqlite3_stmt *stmt);
+
+    // Append all rows of another buffer with same column count
+    void append(const SQLResultBuffer &other);
+
+    QVariant value(int row, int col) const;
+
+private:
+    struct StrRef
+    {
+        int offset;
+        int size;
+    };
+
+    union Cell
+    {
+        qint64 integer;
+        double real;
+        StrRef str; // Text and blob data in Column::strings
+    };
+
+    struct Column
+    {
+        QVector<quint8> types; // SQLITE_INTEGER, SQLITE_TEXT, etc
+        QVector<Cell> cells;
+        QByteArray strings;
+    };
+
+    QVector<Column> m_columns;
+    int m_rowCount;
+};
+
+#endif // ENABLE_USER_QUERY
+
+#endif // SQLRESULTBUFFER_H
@@ -25,9 +25,7 @@
 #    include <QAbstractTableModel>
 #    include <QColor>
 
-namespace sqlite3pp {
-class query;
-}
+#    include "sqlresultbuffer.h"
 
 class SQLResultModel : public QAbstractTableModel
 {
@@ -45,15 +43,16 @@ public:
                         int role = Qt::DisplayRole) const override;
 
     void setBackground(const QColor &col);
-    bool initFromQuery(sqlite3pp::query *q);
 
-signals:
-    void error(int err, int extendedErr, const QString &msg);
+    // Clear all rows and set columns of a new query
+    void setColumns(const QStringList &names);
+
+    // Append a batch of rows streamed by SQLQueryTask
+    void appendRows(const SQLResultBuffer &rows);
 
 private:
     QStringList colNames;
-    QVector<QVariant> m_data;
-    int colCount;
+    SQLResultBuffer m_data;
     QColor backGround;
 };
 
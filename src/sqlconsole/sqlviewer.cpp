@@ -24,53 +24,130 @@
 #    include "app/session.h"
 
 #    include "sqlresultmodel.h"
+#    include "sqlquerytask.h"
+#    include "sqlqueryresultevent.h"
+#    include "sqlresultbuffer.h"
+
 #    include <sqlite3pp/sqlite3pp.h>
 
 #    include <QTableView>
+#    include <QLabel>
 #    include <QMessageBox>
 #    include <QVBoxLayout>
 
 #    include <QTimer>
+#    include <QThreadPool>
 
 #    include <QDebug>
 
-SQLViewer::SQLViewer(sqlite3pp::query *q, QWidget *parent) :
+SQLViewer::SQLViewer(QWidget *parent) :
     QWidget(parent),
     model(nullptr),
-    mQuery(nullptr),
     view(nullptr),
-    deleteQuery(false)
+    statusLabel(nullptr),
+    mTask(nullptr)
 {
-    setQuery(q);
     setWindowTitle(QStringLiteral("SQL Viewer"));
     view           = new QTableView(this);
+    statusLabel    = new QLabel(this);
     QVBoxLayout *l = new QVBoxLayout(this);
     l->addWidget(view);
+    l->addWidget(statusLabel);
 
     model = new SQLResultModel(this);
-    connect(model, &SQLResultModel::error, this, &SQLViewer::onError);
     resetColor();
     view->setModel(model);
     view->setEditTriggers(QTableView::NoEditTriggers);
 
+    // Refresh elapsed time also when query does not return rows for a while
+    statusTimer = new QTimer(this);
+    statusTimer->setInterval(250);
+    connect(statusTimer, &QTimer::timeout, this, &SQLViewer::updateStatus);
+
     setMinimumSize(300, 200);
 }
 
 SQLViewer::~SQLViewer()
 {
-    if (deleteQuery)
-        delete mQuery;
+    if (mTask)
+    {
+        // Task will delete itself when done
+        mTask->stop();
+        mTask->interrupt();
+        mTask->cleanup();
+        mTask = nullptr;
+    }
 }
 
-bool SQLViewer::execQuery()
+bool SQLViewer::execQuery(const QString &sql)
 {
-    bool ret = false;
+    if (mTask)
+        return false; // Wait for current query to finish
+
+    if (!Session->m_Db.db())
+    {
+        statusLabel->setText(tr("No session is open"));
+        return false;
+    }
+
+    const QByteArray utf8 = sql.toUtf8();
+
+    // Task connection is read-only, so it cannot bypass main connection savepoints
+    // Check statement on main connection and run it there if it writes
+    sqlite3pp::query q(Session->m_Db);
+    const int ret = q.prepare(utf8.constData());
+    if (ret != SQLITE_OK)
+    {
+        const QString errMsg = Session->m_Db.error_msg();
+        statusLabel->setText(tr("Error: %1").arg(errMsg));
+        showErrorMsg(tr("Query Error"), errMsg, ret & 0xFF, Session->m_Db.extended_error_code());
+        return false;
+    }
+
+    elapsed.start();
+
+    // NOTE: statement is null if SQL contains only comments or white spaces
+    if (q.stmt() && !sqlite3_stmt_readonly(q.stmt()))
     {
-        mQuery->reset();
-        ret = model->initFromQuery(mQuery);
-        mQuery->reset();
+        emit queryStarted();
+        execOnMainConnection(q.stmt());
+        return true;
     }
-    return ret;
+    q.finish();
+
+    mTask = new SQLQueryTask(Session->fileName, utf8, this);
+    QThreadPool::globalInstance()->start(mTask);
+
+    statusTimer->start();
+    statusLabel->setText(tr("Running..."));
+
+    emit queryStarted();
+    return true;
+}
+
+bool SQLViewer::event(QEvent *e)
+{
+    if (e->type() == SQLQueryResultEvent::_Type)
+    {
+        SQLQueryResultEvent *ev = static_cast<SQLQueryResultEvent *>(e);
+        ev->setAccepted(true);
+
+        if (mTask && ev->task == mTask)
+            handleResult(ev);
+
+        return true;
+    }
+
+    return QWidget::event(e);
+}
+
+void SQLViewer::stopQuery()
+{
+    if (!mTask)
+        return;
+
+    mTask->stop();
+    mTask->interrupt();
 }
 
 void SQLViewer::timedExec()
@@ -85,9 +162,101 @@ void SQLViewer::resetColor()
     model->setBackground(Qt::white);
 }
 
-void SQLViewer::onError(int err, int extended, const QString &msg)
+void SQLViewer::updateStatus()
+{
+    if (mTask)
+        statusLabel->setText(tr("Running... %1").arg(statsText(elapsed.elapsed())));
+}
+
+void SQLViewer::execOnMainConnection(sqlite3_stmt *stmt)
+{
+    const int colCount = sqlite3_column_count(stmt);
+
+    QStringList names;
+    names.reserve(colCount);
+    for (int i = 0; i < colCount; i++)
+        names.append(QString::fromUtf8(sqlite3_column_name(stmt, i)));
+    model->setColumns(names);
+
+    // Statements with RETURNING clause give rows
+    SQLResultBuffer rows(colCount);
+    int ret = SQLITE_OK;
+    while ((ret = sqlite3_step(stmt)) == SQLITE_ROW)
+        rows.appendRow(stmt);
+    model->appendRows(rows);
+
+    const bool success = ret == SQLITE_DONE;
+    if (success)
+    {
+        statusLabel->setText(tr("Done: %1").arg(statsText(elapsed.elapsed())));
+    }
+    else
+    {
+        const QString errMsg = Session->m_Db.error_msg();
+        statusLabel->setText(tr("Error: %1").arg(errMsg));
+        showErrorMsg(tr("Query Error"), errMsg, ret & 0xFF, Session->m_Db.extended_error_code());
+    }
+
+    emit queryFinished(success);
+}
+
+void SQLViewer::handleResult(SQLQueryResultEvent *ev)
 {
-    showErrorMsg(tr("Query Error"), msg, err, extended);
+    switch (ev->status)
+    {
+    case SQLQueryResultEvent::Started:
+    {
+        model->setColumns(ev->columnNames);
+        return;
+    }
+    case SQLQueryResultEvent::Rows:
+    {
+        model->appendRows(ev->rows);
+        updateStatus();
+        return;
+    }
+    default:
+        break;
+    }
+
+    // Last event, task has finished
+    model->appendRows(ev->rows);
+
+    delete mTask;
+    mTask = nullptr;
+    statusTimer->stop();
+
+    switch (ev->status)
+    {
+    case SQLQueryResultEvent::Finished:
+    {
+        statusLabel->setText(tr("Done: %1").arg(statsText(ev->elapsedMs)));
+        break;
+    }
+    case SQLQueryResultEvent::Interrupted:
+    {
+        statusLabel->setText(tr("Interrupted: %1").arg(statsText(ev->elapsedMs)));
+        break;
+    }
+    default:
+    {
+        statusLabel->setText(tr("Error: %1").arg(ev->errMsg));
+        showErrorMsg(tr("Query Error"), ev->errMsg, ev->errCode, ev->extendedErr);
+        break;
+    }
+    }
+
+    emit queryFinished(ev->status == SQLQueryResultEvent::Finished);
+}
+
+QString SQLViewer::statsText(qint64 msecs) const
+{
+    const int rows     = model->rowCount();
+    const qint64 speed = msecs > 0 ? qint64(rows) * 1000 / msecs : rows;
+    return tr("%1 rows in %2 s (%3 rows/s)")
+      .arg(rows)
+      .arg(double(msecs) / 1000.0, 0, 'f', 2)
+      .arg(speed);
 }
 
 void SQLViewer::showErrorMsg(const QString &title, const QString &msg, int err, int extendedErr)
@@ -101,26 +270,4 @@ void SQLViewer::showErrorMsg(const QString &title, const QString &msg, int err,
                            .arg(msg));
 }
 
-void SQLViewer::setQuery(sqlite3pp::query *query)
-{
-    if (deleteQuery)
-        delete mQuery;
-    mQuery      = query;
-    deleteQuery = !mQuery;
-    if (!mQuery)
-        mQuery = new sqlite3pp::query(Session->m_Db);
-}
-
-bool SQLViewer::prepare(const QByteArray &sql)
-{
-    int ret = mQuery->prepare(sql);
-    if (ret != SQLITE_OK)
-    {
-        showErrorMsg(tr("Preparation Failed"), Session->m_Db.error_msg(), ret,
-                     Session->m_Db.extended_error_code());
-        return false;
-    }
-    return true;
-}
-
 #endif // ENABLE_USER_QUERY
@@ -23,37 +23,69 @@
 #ifdef ENABLE_USER_QUERY
 
 #    include <QWidget>
+#    include <QElapsedTimer>
 
 class QTableView;
-class SQLResultModel;
+class QLabel;
+class QTimer;
 
-namespace sqlite3pp {
-class query;
-}
+typedef struct sqlite3_stmt sqlite3_stmt;
+class SQLResultModel;
+class SQLQueryTask;
+class SQLQueryResultEvent;
 
+/*!
+ * \brief The SQLViewer class
+ *
+ * Shows results of SQL Console queries.
+ * Read-only queries run on a background SQLQueryTask and rows are shown as they arrive,
+ * a status line reports row count, elapsed time and rows per second.
+ * Statements which write the database run on main connection and block until done.
+ */
 class SQLViewer : public QWidget
 {
     Q_OBJECT
 public:
-    SQLViewer(sqlite3pp::query *q, QWidget *parent = nullptr);
+    SQLViewer(QWidget *parent = nullptr);
     virtual ~SQLViewer();
 
     void showErrorMsg(const QString &title, const QString &msg, int err, int extendedErr);
 
-    void setQuery(sqlite3pp::query *query);
-    bool prepare(const QByteArray &sql);
+    // Returns false if another query is still running or SQL is not valid
+    bool execQuery(const QString &sql);
+
+    inline bool isRunning() const
+    {
+        return mTask != nullptr;
+    }
+
+    bool event(QEvent *e) override;
+
+signals:
+    void queryStarted();
+    void queryFinished(bool success);
+
 public slots:
-    bool execQuery();
+    void stopQuery();
     void timedExec();
     void resetColor();
 
-    void onError(int err, int extended, const QString &msg);
+private slots:
+    void updateStatus();
+
+private:
+    void execOnMainConnection(sqlite3_stmt *stmt);
+    void handleResult(SQLQueryResultEvent *ev);
+    QString statsText(qint64 msecs) const;
 
 private:
     SQLResultModel *model;
-    sqlite3pp::query *mQuery;
     QTableView *view;
-    bool deleteQuery;
+    QLabel *statusLabel;
+
+    SQLQueryTask *mTask;
+    QTimer *statusTimer;
+    QElapsedTimer elapsed;
 };
 
 #endif // ENABLE_USER_QUERY
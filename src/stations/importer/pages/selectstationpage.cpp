@@ -47,6 +47,7 @@ SelectStationPage::SelectStationPage(StationImportWizard *w) :
     lay->addWidget(toolBar);
 
     view = new QTableView;
+    view->setSelectionBehavior(QTableView::SelectRows);
     lay->addWidget(view);
 
     // Custom colun sorting and filtering
@@ -142,6 +143,13 @@ void SelectStationPage::importSelectedStation()
     if (!view->selectionModel()->hasSelection())
         return;
 
+    const QModelIndexList rows = view->selectionModel()->selectedRows();
+    if (rows.size() > 1)
+    {
+        importMultipleStations(rows);
+        return;
+    }
+
     QModelIndex idx = view->currentIndex();
     db_id stationId = stationsModel->getIdAtRow(idx.row());
     if (!stationId)
@@ -181,7 +189,11 @@ void SelectStationPage::importSelectedStation()
             continue; // Second chance
         }
 
-        if (!mWizard->addStation(stationId, name, shortName))
+        StationBulkCopier::Item item;
+        item.sourceStId = stationId;
+        item.name       = name;
+        item.shortName  = shortName;
+        if (!mWizard->addStations({item}))
         {
             QMessageBox::warning(this, tr("Import Error"),
                                  tr("Could not import station <b>%1</b>.").arg(name));
@@ -202,3 +214,46 @@ void SelectStationPage::importSelectedStation()
     // Reset selection
     view->clearSelection();
 }
+
+void SelectStationPage::importMultipleStations(const QModelIndexList &rows)
+{
+    // Stations keep their original name, the ones already existing are skipped
+    QVector<StationBulkCopier::Item> items;
+    items.reserve(rows.size());
+    QStringList skipped;
+
+    for (const QModelIndex &idx : rows)
+    {
+        StationBulkCopier::Item item;
+        item.sourceStId = stationsModel->getIdAtRow(idx.row());
+        if (!item.sourceStId)
+            continue;
+
+        item.name = stationsModel->getNameAtRow(idx.row());
+        if (!mWizard->checkNames(item.sourceStId, QString(), item.shortName))
+        {
+            skipped.append(item.name);
+            continue;
+        }
+
+        items.append(item);
+    }
+
+    if (!items.isEmpty() && !mWizard->addStations(items))
+    {
+        QMessageBox::warning(this, tr("Import Error"),
+                             tr("Could not import %1 stations.").arg(items.size()));
+        return;
+    }
+
+    QString msg = tr("%1 stations succesfully imported in current session.").arg(items.size());
+    if (!skipped.isEmpty())
+    {
+        msg.append(tr("<br>Stations with names already existing were skipped:<br><b>%1</b>")
+                     .arg(skipped.join(QLatin1String(", "))));
+    }
+    QMessageBox::information(this, tr("Importation Done"), msg);
+
+    // Reset selection
+    view->clearSelection();
+}
@@ -21,6 +21,7 @@
 #define SELECTSTATIONPAGE_H
 
 #include <QWizardPage>
+#include <QModelIndex>
 
 #include "utils/types.h"
 
@@ -46,6 +47,9 @@ private slots:
     void openStationSVGPlan();
     void importSelectedStation();
 
+private:
+    void importMultipleStations(const QModelIndexList &rows);
+
 private:
     StationImportWizard *mWizard;
 
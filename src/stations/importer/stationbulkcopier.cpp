@@ -0,0 +1,238 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stationbulkcopier.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+using namespace sqlite3pp;
+
+#include <QRgb>
+#include <QUrl>
+
+#include <QDebug>
+
+// Source tracks and gates of imported stations get new IDs after current maximum
+static const char *const sql_mapTracksAndGates[] = {
+  "CREATE TEMP TABLE track_map(source_id INTEGER PRIMARY KEY, new_id INTEGER)",
+
+  "INSERT INTO temp.track_map(source_id,new_id)"
+  " SELECT t.id,(SELECT IFNULL(MAX(id),0) FROM main.station_tracks)"
+  "+ROW_NUMBER() OVER (ORDER BY t.id)"
+  " FROM st_source.station_tracks t"
+  " JOIN temp.station_map m ON m.source_id=t.station_id",
+
+  "CREATE TEMP TABLE gate_map(source_id INTEGER PRIMARY KEY, new_id INTEGER)",
+
+  "INSERT INTO temp.gate_map(source_id,new_id)"
+  " SELECT g.id,(SELECT IFNULL(MAX(id),0) FROM main.station_gates)"
+  "+ROW_NUMBER() OVER (ORDER BY g.id)"
+  " FROM st_source.station_gates g"
+  " JOIN temp.station_map m ON m.source_id=g.station_id",
+  nullptr};
+
+// NOTE: phone number is not imported because it's UNIQUE in our session,
+// it may already exist for a different station. User can set it afterwards if needed.
+static const char sql_copyStations[] =
+  "INSERT INTO main.stations(id,name,short_name,type,phone_number,svg_data)"
+  " SELECT m.new_id,m.name,m.short_name,s.type,NULL,s.svg_data"
+  " FROM temp.station_map m"
+  " JOIN st_source.stations s ON s.id=m.source_id";
+
+// White is the default color, it's stored as NULL
+static const char sql_copyTracks[] =
+  "INSERT INTO main.station_tracks(id,station_id,pos,type,"
+  "track_length_cm,platf_length_cm,freight_length_cm,max_axes,color_rgb,name)"
+  " SELECT tm.new_id,m.new_id,t.pos,t.type,"
+  "t.track_length_cm,t.platf_length_cm,t.freight_length_cm,t.max_axes,NULLIF(t.color_rgb,?1),t.name"
+  " FROM temp.track_map tm"
+  " JOIN st_source.station_tracks t ON t.id=tm.source_id"
+  " JOIN temp.station_map m ON m.source_id=t.station_id";
+
+// Gates are created without default platform because triggers require
+// the platform to be already connected, it's set after copying connections.
+static const char *const sql_copyGates[] = {
+  "INSERT INTO main.station_gates(id,station_id,out_track_count,type,def_in_platf_id,name,side)"
+  " SELECT gm.new_id,m.new_id,g.out_track_count,g.type,NULL,g.name,g.side"
+  " FROM temp.gate_map gm"
+  " JOIN st_source.station_gates g ON g.id=gm.source_id"
+  " JOIN temp.station_map m ON m.source_id=g.station_id",
+
+  "INSERT INTO main.station_gate_connections(id,track_id,track_side,gate_id,gate_track)"
+  " SELECT NULL,tm.new_id,c.track_side,gm.new_id,c.gate_track"
+  " FROM st_source.station_gate_connections c"
+  " JOIN temp.gate_map gm ON gm.source_id=c.gate_id"
+  " JOIN temp.track_map tm ON tm.source_id=c.track_id",
+
+  "UPDATE main.station_gates SET def_in_platf_id=("
+  " SELECT tm.new_id FROM temp.gate_map gm"
+  " JOIN st_source.station_gates g ON g.id=gm.source_id"
+  " JOIN temp.track_map tm ON tm.source_id=g.def_in_platf_id"
+  " WHERE gm.new_id=station_gates.id)"
+  " WHERE id IN (SELECT new_id FROM temp.gate_map)"
+  " AND EXISTS (SELECT 1 FROM temp.gate_map gm"
+  " JOIN st_source.station_gates g ON g.id=gm.source_id"
+  " JOIN temp.track_map tm ON tm.source_id=g.def_in_platf_id"
+  " JOIN main.station_gate_connections c ON c.gate_id=gm.new_id AND c.track_id=tm.new_id"
+  " WHERE gm.new_id=station_gates.id)",
+
+  "DROP TABLE temp.gate_map",
+  "DROP TABLE temp.track_map",
+  "DROP TABLE temp.station_map",
+  nullptr};
+
+StationBulkCopier::StationBulkCopier(sqlite3pp::database &db) :
+    mDb(db)
+{
+}
+
+bool StationBulkCopier::copyStations(const QString &sourceFile, const QVector<Item> &items,
+                                     QSet<db_id> &outStations)
+{
+    outStations.clear();
+    if (items.isEmpty())
+        return true;
+
+    if (!attachSource(sourceFile))
+        return false;
+
+    // Copy everything in a single transaction
+    // NOTE: do not use sqlite3pp::transaction, it throws if BEGIN fails
+    bool ok = mDb.execute("BEGIN TRANSACTION") == SQLITE_OK;
+    if (!ok)
+    {
+        qWarning() << "Station Import: cannot begin transaction" << mDb.error_msg();
+    }
+    else if (!createStationMap(items, outStations) || !copyStationGraph())
+    {
+        mDb.execute("ROLLBACK");
+        ok = false;
+    }
+    else if (mDb.execute("COMMIT") != SQLITE_OK)
+    {
+        qWarning() << "Station Import: commit failed" << mDb.error_msg();
+
+        // Transaction is still open if COMMIT failed
+        mDb.execute("ROLLBACK");
+        ok = false;
+    }
+
+    // Cleanup, must be done after transaction has ended
+    mDb.execute("DETACH st_source");
+
+    if (!ok)
+        outStations.clear();
+    return ok;
+}
+
+bool StationBulkCopier::attachSource(const QString &sourceFile)
+{
+    // Source file is opened read-only and never changes while we read it
+    QUrl url = QUrl::fromLocalFile(sourceFile);
+    url.setQuery(QStringLiteral("mode=ro&immutable=1"));
+
+    command cmd(mDb, "ATTACH ? AS st_source");
+    cmd.bind(1, url.toString(QUrl::FullyEncoded));
+    if (cmd.execute() != SQLITE_OK)
+    {
+        qWarning() << "Station Import: cannot attach" << sourceFile << mDb.error_msg();
+        return false;
+    }
+
+    return true;
+}
+
+bool StationBulkCopier::createStationMap(const QVector<Item> &items, QSet<db_id> &outStations)
+{
+    if (mDb.execute("CREATE TEMP TABLE station_map(source_id INTEGER PRIMARY KEY,"
+                    " new_id INTEGER, name TEXT, short_name TEXT)")
+        != SQLITE_OK)
+    {
+        qWarning() << "Station Import: cannot create station map" << mDb.error_msg();
+        return false;
+    }
+
+    query q(mDb, "SELECT IFNULL(MAX(id),0) FROM main.stations");
+    if (q.step() != SQLITE_ROW)
+        return false;
+    db_id newStId = q.getRows().get<db_id>(0);
+    q.finish();
+
+    // Only the list of stations is inserted row by row, their content is copied as a whole
+    command cmd(mDb, "INSERT INTO temp.station_map(source_id,new_id,name,short_name)"
+                     " VALUES(?,?,?,?)");
+    outStations.reserve(items.size());
+    for (const Item &item : items)
+    {
+        newStId++;
+        cmd.bind(1, item.sourceStId);
+        cmd.bind(2, newStId);
+        cmd.bind(3, item.name);
+        if (item.shortName.isEmpty())
+            cmd.bind(4); // Bind NULL
+        else
+            cmd.bind(4, item.shortName);
+
+        if (cmd.execute() != SQLITE_OK)
+        {
+            qWarning() << "Station Import: cannot map station" << item.sourceStId
+                       << mDb.error_msg();
+            return false;
+        }
+        cmd.reset();
+
+        outStations.insert(newStId);
+    }
+
+    return true;
+}
+
+bool StationBulkCopier::copyStationGraph()
+{
+    if (!execStatements(sql_mapTracksAndGates))
+        return false;
+
+    if (mDb.execute(sql_copyStations) != SQLITE_OK)
+    {
+        qWarning() << "Station Import: cannot copy stations" << mDb.error_msg();
+        return false;
+    }
+
+    command cmd(mDb, sql_copyTracks);
+    cmd.bind(1, int(qRgb(255, 255, 255)));
+    if (cmd.execute() != SQLITE_OK)
+    {
+        qWarning() << "Station Import: cannot copy tracks" << mDb.error_msg();
+        return false;
+    }
+
+    return execStatements(sql_copyGates);
+}
+
+bool StationBulkCopier::execStatements(const char *const *stmts)
+{
+    for (; *stmts; stmts++)
+    {
+        if (mDb.execute(*stmts) != SQLITE_OK)
+        {
+            qWarning() << "Station Import: error" << mDb.error_msg() << "executing" << *stmts;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,77 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef STATIONBULKCOPIER_H
+#define STATIONBULKCOPIER_H
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include "utils/types.h"
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The StationBulkCopier class
+ *
+ * Copies stations from another session file into current session.
+ * Source file is attached read-only and each station is copied
+ * with its tracks, gates, gate connections and SVG plan.
+ * Every table is copied with a single INSERT ... SELECT statement,
+ * source IDs are remapped to new IDs through temporary tables.
+ * Everything happens in one transaction, nothing is copied on error.
+ *
+ * \sa StationImportWizard
+ */
+class StationBulkCopier
+{
+public:
+    struct Item
+    {
+        db_id sourceStId = 0;
+        QString name;
+        QString shortName; // Empty for NULL
+    };
+
+    explicit StationBulkCopier(sqlite3pp::database &db);
+
+    /*!
+     * \brief copyStations
+     * \param sourceFile path of session file to copy from
+     * \param items stations to copy with their new names
+     * \param outStations filled with IDs of created stations
+     * \return false on error
+     */
+    bool copyStations(const QString &sourceFile, const QVector<Item> &items,
+                      QSet<db_id> &outStations);
+
+private:
+    bool attachSource(const QString &sourceFile);
+    bool createStationMap(const QVector<Item> &items, QSet<db_id> &outStations);
+    bool copyStationGraph();
+    bool execStatements(const char *const *stmts);
+
+private:
+    sqlite3pp::database &mDb;
+};
+
+#endif // STATIONBULKCOPIER_H
@@ -23,6 +23,8 @@
 #include <QWizard>
 #include "utils/types.h"
 
+#include "stationbulkcopier.h"
+
 namespace sqlite3pp {
 class database;
 }
@@ -55,12 +57,11 @@ private:
 
     friend class SelectStationPage;
     bool checkNames(db_id sourceStId, const QString &newName, QString &outShortName);
-    bool addStation(db_id sourceStId, const QString &fullName, const QString &shortName);
-
-    bool copySVGData(db_id sourceStId, db_id destStId);
+    bool addStations(const QVector<StationBulkCopier::Item> &items);
 
 private:
     sqlite3pp::database *mTempDB;
+    QString mFileName;
     bool mInMemory;
 };
 
@@ -23,6 +23,9 @@
 #include "utils/jobcategorystrings.h"
 #include "utils/rs_utils.h"
 
+#include "app/session.h"
+#include "rollingstock/rsoccupancyindex.h"
+
 #include <sqlite3pp/sqlite3pp.h>
 using namespace sqlite3pp;
 
@@ -31,6 +34,8 @@ using namespace sqlite3pp;
 StationFreeRSModel::StationFreeRSModel(sqlite3pp::database &db, QObject *parent) :
     QAbstractTableModel(parent),
     sortCol(RSNameCol),
+    m_scrubPos(0),
+    m_scrubLoaded(false),
     mDb(db)
 {
 }
@@ -145,86 +150,22 @@ void StationFreeRSModel::reloadData()
     m_data.clear();
     QHash<db_id, Item> tempLookup;
 
-    query q(mDb,
-            "SELECT coupling.rs_id,rs_list.number,rs_models.name,rs_models.suffix,rs_models.type,"
-            "MAX(stops.arrival),stops.job_id,jobs.category,stops.id"
-            " FROM coupling"
-            " JOIN stops ON stops.id=coupling.stop_id"
-            " JOIN jobs ON jobs.id=stops.job_id"
-            " JOIN rs_list ON rs_list.id=coupling.rs_id"
-            " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
-            " WHERE stops.station_id=? AND stops.arrival<=?" // Less than OR equal (this includes RS
-                                                             // uncoupled exactly at that time)
-            " GROUP BY coupling.rs_id"
-            " HAVING coupling.operation=0");
-    q.bind(1, m_stationId);
-    q.bind(2, m_time);
-
-    // Select uncoupled before m_time
-    for (auto r : q)
-    {
-        Item item;
-        item.rsId               = r.get<db_id>(0);
+    // Scrubber events must be reloaded too
+    m_scrubItems.clear();
+    m_scrubEvents.clear();
+    m_scrubPos              = 0;
+    m_scrubLoaded           = false;
 
-        int number              = r.get<int>(1);
-        int modelNameLen        = sqlite3_column_bytes(q.stmt(), 2);
-        const char *modelName   = reinterpret_cast<char const *>(sqlite3_column_text(q.stmt(), 2));
+    RSOccupancyIndex *index = Session->getRSOccupancyIndex();
 
-        int modelSuffixLen      = sqlite3_column_bytes(q.stmt(), 3);
-        const char *modelSuffix = reinterpret_cast<char const *>(sqlite3_column_text(q.stmt(), 3));
-        RsType type             = RsType(sqlite3_column_int(q.stmt(), 4));
+    QVector<Item> items;
+    loadItems(index->getFreeRS(m_stationId, m_time.msecsSinceStartOfDay() / 60000), items);
 
-        item.from               = r.get<QTime>(5);
-        item.fromJob            = r.get<db_id>(6);
-        item.fromJobCat         = JobCategory(r.get<int>(7));
-        item.fromStopId         = r.get<db_id>(8);
-        item.name = rs_utils::formatNameRef(modelName, modelNameLen, number, modelSuffix,
-                                            modelSuffixLen, type);
-
-        tempLookup.insert(item.rsId, item);
-    }
-
-    q.prepare(
-      "SELECT coupling.rs_id,rs_list.number,rs_models.name,rs_models.suffix,rs_models.type,"
-      "MIN(stops.arrival),stops.job_id,jobs.category,stops.id"
-      " FROM coupling"
-      " JOIN stops ON stops.id=coupling.stop_id"
-      " JOIN jobs ON jobs.id=stops.job_id"
-      " JOIN rs_list ON rs_list.id=coupling.rs_id"
-      " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
-      " WHERE stops.station_id=? AND stops.arrival>?" // Greater than NOT equal (this exclude RS
-                                                      // coupled at exactly that time)
-      " GROUP BY coupling.rs_id"
-      " HAVING coupling.operation=1");
-    q.bind(1, m_stationId);
-    q.bind(2, m_time);
-
-    // Select coupled after m_time
-    for (auto r : q)
+    for (const Item &item : qAsConst(items))
     {
-        db_id rsId = r.get<db_id>(0);
-        Item &item = tempLookup[rsId]; // Create entry if key doesn't exist
-        if (!item.rsId)
-        {
-            item.rsId        = rsId;
-
-            int number       = r.get<int>(1);
-            int modelNameLen = sqlite3_column_bytes(q.stmt(), 2);
-            const char *modelName =
-              reinterpret_cast<char const *>(sqlite3_column_text(q.stmt(), 2));
-
-            int modelSuffixLen = sqlite3_column_bytes(q.stmt(), 3);
-            const char *modelSuffix =
-              reinterpret_cast<char const *>(sqlite3_column_text(q.stmt(), 3));
-            RsType type = RsType(sqlite3_column_int(q.stmt(), 4));
-
-            item.name   = rs_utils::formatNameRef(modelName, modelNameLen, number, modelSuffix,
-                                                  modelSuffixLen, type);
-        }
-        item.to       = r.get<QTime>(5);
-        item.toJob    = r.get<db_id>(6);
-        item.toJobCat = JobCategory(r.get<int>(7));
-        item.toStopId = r.get<db_id>(8);
+        // Inconsistent plan, keep only first interval
+        if (!tempLookup.contains(item.rsId))
+            tempLookup.insert(item.rsId, item);
     }
 
     m_data.reserve(tempLookup.size());
@@ -326,6 +267,236 @@ void StationFreeRSModel::reloadData()
     endResetModel();
 }
 
+void StationFreeRSModel::loadItems(const QVector<RSOccupancyIndex::FreeInterval> &intervals,
+                                   QVector<Item> &outItems)
+{
+    query q_getRSName(mDb, "SELECT rs_list.number,rs_models.name,rs_models.suffix,rs_models.type"
+                           " FROM rs_list"
+                           " LEFT JOIN rs_models ON rs_models.id=rs_list.model_id"
+                           " WHERE rs_list.id=?");
+    query q_getJobCat(mDb, "SELECT category FROM jobs WHERE id=?");
+
+    // Many items share same jobs, query each job once
+    QHash<db_id, JobCategory> jobCats;
+    auto getJobCat = [&jobCats, &q_getJobCat](db_id jobId) -> JobCategory
+    {
+        auto it = jobCats.constFind(jobId);
+        if (it != jobCats.constEnd())
+            return it.value();
+
+        JobCategory cat = JobCategory::FREIGHT;
+        q_getJobCat.bind(1, jobId);
+        if (q_getJobCat.step() == SQLITE_ROW)
+            cat = JobCategory(q_getJobCat.getRows().get<int>(0));
+        q_getJobCat.reset();
+
+        jobCats.insert(jobId, cat);
+        return cat;
+    };
+
+    outItems.clear();
+    outItems.reserve(intervals.size());
+
+    for (const RSOccupancyIndex::FreeInterval &f : intervals)
+    {
+        Item item;
+        item.rsId = f.rsId;
+
+        q_getRSName.bind(1, f.rsId);
+        if (q_getRSName.step() == SQLITE_ROW)
+        {
+            int number       = sqlite3_column_int(q_getRSName.stmt(), 0);
+            int modelNameLen = sqlite3_column_bytes(q_getRSName.stmt(), 1);
+            const char *modelName =
+              reinterpret_cast<char const *>(sqlite3_column_text(q_getRSName.stmt(), 1));
+
+            int modelSuffixLen = sqlite3_column_bytes(q_getRSName.stmt(), 2);
+            const char *modelSuffix =
+              reinterpret_cast<char const *>(sqlite3_column_text(q_getRSName.stmt(), 2));
+            RsType type = RsType(sqlite3_column_int(q_getRSName.stmt(), 3));
+
+            item.name   = rs_utils::formatNameRef(modelName, modelNameLen, number, modelSuffix,
+                                                  modelSuffixLen, type);
+        }
+        q_getRSName.reset();
+
+        if (f.from != RSOccupancyIndex::NoTime)
+        {
+            item.from       = QTime::fromMSecsSinceStartOfDay(f.from * 60000);
+            item.fromJob    = f.fromJob;
+            item.fromJobCat = getJobCat(f.fromJob);
+            item.fromStopId = f.fromStop;
+        }
+
+        if (f.to != RSOccupancyIndex::NoTime)
+        {
+            item.to       = QTime::fromMSecsSinceStartOfDay(f.to * 60000);
+            item.toJob    = f.toJob;
+            item.toJobCat = getJobCat(f.toJob);
+            item.toStopId = f.toStop;
+        }
+
+        outItems.append(item);
+    }
+}
+
+void StationFreeRSModel::scrubToTime(QTime time)
+{
+    if (!m_scrubLoaded)
+        loadScrubEvents();
+
+    m_time            = time;
+    const int minutes = m_time.msecsSinceStartOfDay() / 60000;
+
+    // Apply events up to new time
+    while (m_scrubPos < m_scrubEvents.size() && m_scrubEvents.at(m_scrubPos).time <= minutes)
+    {
+        applyScrubEvent(m_scrubEvents.at(m_scrubPos), true);
+        m_scrubPos++;
+    }
+
+    // Revert events after new time
+    while (m_scrubPos > 0 && m_scrubEvents.at(m_scrubPos - 1).time > minutes)
+    {
+        m_scrubPos--;
+        applyScrubEvent(m_scrubEvents.at(m_scrubPos), false);
+    }
+}
+
+void StationFreeRSModel::loadScrubEvents()
+{
+    beginResetModel();
+
+    m_data.clear();
+    m_scrubEvents.clear();
+
+    RSOccupancyIndex *index = Session->getRSOccupancyIndex();
+    loadItems(index->getStationFreeRS(m_stationId), m_scrubItems);
+
+    // Each interval adds item when it starts and removes it when it ends
+    m_scrubEvents.reserve(m_scrubItems.size() * 2);
+    for (int i = 0; i < m_scrubItems.size(); i++)
+    {
+        const Item &item = m_scrubItems.at(i);
+        if (item.from.isValid() && item.from == item.to)
+            continue; // Coupled again in same minute, never shown
+
+        ScrubEvent ev;
+        ev.itemIdx = i;
+        ev.add     = true;
+        ev.time    = item.from.isValid() ? item.from.msecsSinceStartOfDay() / 60000 : -1;
+        m_scrubEvents.append(ev);
+
+        if (item.to.isValid())
+        {
+            ev.add  = false;
+            ev.time = item.to.msecsSinceStartOfDay() / 60000;
+            m_scrubEvents.append(ev);
+        }
+    }
+
+    // At same time remove items before adding new ones
+    std::sort(m_scrubEvents.begin(), m_scrubEvents.end(),
+              [](const ScrubEvent &a, const ScrubEvent &b)
+              { return a.time < b.time || (a.time == b.time && a.add < b.add); });
+
+    // Apply initial state without notifying single rows
+    const int minutes = m_time.msecsSinceStartOfDay() / 60000;
+    m_scrubPos        = 0;
+    while (m_scrubPos < m_scrubEvents.size() && m_scrubEvents.at(m_scrubPos).time <= minutes)
+    {
+        const ScrubEvent &ev = m_scrubEvents.at(m_scrubPos);
+        const Item &item     = m_scrubItems.at(ev.itemIdx);
+        if (ev.add)
+        {
+            m_data.append(item);
+        }
+        else
+        {
+            const int row = findItemRow(item);
+            if (row >= 0)
+                m_data.removeAt(row);
+        }
+        m_scrubPos++;
+    }
+
+    std::sort(m_data.begin(), m_data.end(),
+              [this](const Item &a, const Item &b) { return itemLessThan(a, b); });
+
+    m_scrubLoaded = true;
+
+    endResetModel();
+}
+
+void StationFreeRSModel::applyScrubEvent(const ScrubEvent &ev, bool forward)
+{
+    const Item &item = m_scrubItems.at(ev.itemIdx);
+
+    if (ev.add == forward)
+    {
+        // Keep current sorting
+        auto pos = std::upper_bound(m_data.begin(), m_data.end(), item,
+                                    [this](const Item &a, const Item &b)
+                                    { return itemLessThan(a, b); });
+        const int row = int(pos - m_data.begin());
+
+        beginInsertRows(QModelIndex(), row, row);
+        m_data.insert(row, item);
+        endInsertRows();
+    }
+    else
+    {
+        const int row = findItemRow(item);
+        if (row < 0)
+            return;
+
+        beginRemoveRows(QModelIndex(), row, row);
+        m_data.removeAt(row);
+        endRemoveRows();
+    }
+}
+
+int StationFreeRSModel::findItemRow(const Item &item) const
+{
+    // Same item can be free many times, stops identify the interval
+    for (int row = 0; row < m_data.size(); row++)
+    {
+        const Item &other = m_data.at(row);
+        if (other.rsId == item.rsId && other.fromStopId == item.fromStopId
+            && other.toStopId == item.toStopId)
+            return row;
+    }
+    return -1;
+}
+
+bool StationFreeRSModel::itemLessThan(const Item &lhs, const Item &rhs) const
+{
+    switch (sortCol)
+    {
+    default:
+    case RSNameCol:
+        break;
+    case FreeFromTimeCol:
+        if (lhs.from != rhs.from)
+            return lhs.from < rhs.from;
+        break;
+    case FreeUpToTimeCol:
+        if (lhs.to != rhs.to)
+            return lhs.to < rhs.to;
+        break;
+    case FromJobCol:
+        if (lhs.fromJob != rhs.fromJob)
+            return lhs.fromJob < rhs.fromJob;
+        break;
+    case ToJobCol:
+        if (lhs.toJob != rhs.toJob)
+            return lhs.toJob < rhs.toJob;
+        break;
+    }
+
+    return lhs.name < rhs.name;
+}
+
 int StationFreeRSModel::getSortCol() const
 {
     return sortCol;
@@ -351,79 +522,37 @@ QTime StationFreeRSModel::getTime() const
 
 StationFreeRSModel::ErrorCodes StationFreeRSModel::getNextOpTime(QTime &time)
 {
-    ErrorCodes err = NoError;
-
-    query q_getNextOpTime(mDb, "SELECT coupling.rs_id, MIN(stops.arrival) FROM coupling"
-                               " JOIN stops ON stops.id=coupling.stop_id"
-                               " WHERE stops.station_id=? AND stops.arrival>?");
-    q_getNextOpTime.bind(1, m_stationId);
-    q_getNextOpTime.bind(2, m_time);
+    RSOccupancyIndex *index = Session->getRSOccupancyIndex();
 
-    if (q_getNextOpTime.step() == SQLITE_ROW)
+    int minutes             = 0;
+    if (!index->getNextOpTime(m_stationId, m_time.msecsSinceStartOfDay() / 60000, minutes))
     {
-        auto r = q_getNextOpTime.getRows();
-        if (r.column_type(1) != SQLITE_NULL)
-        {
-            time = r.get<QTime>(1);
-        }
-        else
-        {
-            // There aren't operations next to m_time
-            err = NoOperationFound;
-        }
-    }
-    else
-    {
-        // Error
-        qDebug() << __PRETTY_FUNCTION__ << "DB Error:" << mDb.error_code() << mDb.error_msg()
-                 << mDb.extended_error_code();
-        err = DBError;
+        // There aren't operations next to m_time
+        return NoOperationFound;
     }
 
-    q_getNextOpTime.reset();
-    return err;
+    time = QTime::fromMSecsSinceStartOfDay(minutes * 60000);
+    return NoError;
 }
 
 StationFreeRSModel::ErrorCodes StationFreeRSModel::getPrevOpTime(QTime &time)
 {
     // TODO: if on last/first operation increment by 1 to see after/before prev, last operation
-    ErrorCodes err = NoError;
+    RSOccupancyIndex *index = Session->getRSOccupancyIndex();
 
-    query q_getPrevOpTime(mDb, "SELECT coupling.rs_id, MAX(stops.arrival) FROM coupling"
-                               " JOIN stops ON stops.id=coupling.stop_id"
-                               " WHERE stops.station_id=? AND stops.arrival<?");
-    q_getPrevOpTime.bind(1, m_stationId);
-    q_getPrevOpTime.bind(2, m_time);
-
-    if (q_getPrevOpTime.step() == SQLITE_ROW)
+    int minutes             = 0;
+    if (!index->getPrevOpTime(m_stationId, m_time.msecsSinceStartOfDay() / 60000, minutes))
     {
-        auto r = q_getPrevOpTime.getRows();
-        if (r.column_type(1) != SQLITE_NULL)
-        {
-            time = r.get<QTime>(1);
-        }
-        else
-        {
-            // There aren't operations previous to m_time
-            // But because RS uncoupled before m_time are taken with 'less than OR equal'
-            // we should show also the situation before this time.
-
-            // err = NoOperationFound;
+        // There aren't operations previous to m_time
+        // But because RS uncoupled before m_time are taken with 'less than OR equal'
+        // we should show also the situation before this time.
 
-            // Fake operation at first morning
-            time = QTime(0, 0);
-        }
-    }
-    else
-    {
-        // Error
-        qDebug() << __PRETTY_FUNCTION__ << "DB Error:" << mDb.error_code() << mDb.error_msg()
-                 << mDb.extended_error_code();
-        err = DBError;
+        // Fake operation at first morning
+        minutes = 0;
     }
 
-    q_getPrevOpTime.reset();
-    return err;
+    time = QTime::fromMSecsSinceStartOfDay(minutes * 60000);
+    return NoError;
 }
 
 bool StationFreeRSModel::sortByColumn(int col)
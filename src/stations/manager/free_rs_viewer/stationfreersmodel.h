@@ -29,6 +29,7 @@
 #include <sqlite3pp/sqlite3pp.h>
 
 #include "utils/types.h"
+#include "rollingstock/rsoccupancyindex.h"
 
 // TODO: on-demand load and let SQL do the sorting
 class StationFreeRSModel : public QAbstractTableModel
@@ -77,6 +78,17 @@ public:
     void setStation(db_id stId);
     void setTime(QTime time);
 
+    /*!
+     * \brief scrubToTime
+     * \param time the new time
+     *
+     * Like setTime() but instead of reloading the model it moves through
+     * station events inserting and removing single rows.
+     * Events are loaded on first call and kept until next reloadData().
+     * Useful to update the list while dragging a time slider.
+     */
+    void scrubToTime(QTime time);
+
     enum ErrorCodes
     {
         NoError = 0,
@@ -99,6 +111,22 @@ public:
 public slots:
     void reloadData();
 
+private:
+    struct ScrubEvent
+    {
+        int time    = 0; // Minutes since midnight, -1 if before first operation
+        int itemIdx = 0; // Index in m_scrubItems
+        bool add    = true;
+    };
+
+    void loadItems(const QVector<RSOccupancyIndex::FreeInterval> &intervals,
+                   QVector<Item> &outItems);
+
+    void loadScrubEvents();
+    void applyScrubEvent(const ScrubEvent &ev, bool forward);
+    int findItemRow(const Item &item) const;
+    bool itemLessThan(const Item &lhs, const Item &rhs) const;
+
 private:
     db_id m_stationId;
     QTime m_time;
@@ -106,6 +134,12 @@ private:
 
     QVector<Item> m_data;
 
+    // Scrubber
+    QVector<Item> m_scrubItems;
+    QVector<ScrubEvent> m_scrubEvents;
+    int m_scrubPos; // Events before this index are applied to m_data
+    bool m_scrubLoaded;
+
     sqlite3pp::database &mDb;
 };
 
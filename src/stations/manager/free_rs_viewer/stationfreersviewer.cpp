@@ -22,6 +22,7 @@
 #include <QTableView>
 #include <QHeaderView>
 #include <QTimeEdit>
+#include <QSlider>
 #include <QPushButton>
 #include <QLabel>
 #include <QGridLayout>
@@ -52,16 +53,23 @@ StationFreeRSViewer::StationFreeRSViewer(QWidget *parent) :
     timeEdit = new QTimeEdit;
     lay->addWidget(timeEdit, 1, 1);
 
+    // Drag to scrub through the day, rows are updated incrementally
+    timeSlider = new QSlider(Qt::Horizontal);
+    timeSlider->setRange(0, 24 * 60 - 1);
+    timeSlider->setPageStep(60);
+    timeSlider->setToolTip(tr("Drag to move through the day"));
+    lay->addWidget(timeSlider, 2, 0, 1, 2);
+
     prevOpBut = new QPushButton(tr("Previous Operation"));
-    lay->addWidget(prevOpBut, 2, 0);
+    lay->addWidget(prevOpBut, 3, 0);
 
     nextOpBut = new QPushButton(tr("Next Operation"));
-    lay->addWidget(nextOpBut, 2, 1);
+    lay->addWidget(nextOpBut, 3, 1);
 
     view = new QTableView;
     view->setContextMenuPolicy(Qt::CustomContextMenu);
     view->setSelectionBehavior(QTableView::SelectRows);
-    lay->addWidget(view, 3, 0, 1, 2);
+    lay->addWidget(view, 4, 0, 1, 2);
 
     model = new StationFreeRSModel(Session->m_Db, this);
     view->setModel(model);
@@ -69,6 +77,7 @@ StationFreeRSViewer::StationFreeRSViewer(QWidget *parent) :
     connect(refreshBut, &QPushButton::clicked, model, &StationFreeRSModel::reloadData);
     connect(timeEdit, &QTimeEdit::editingFinished, this,
             &StationFreeRSViewer::onTimeEditingFinished);
+    connect(timeSlider, &QSlider::valueChanged, this, &StationFreeRSViewer::onScrubberMoved);
 
     connect(nextOpBut, &QPushButton::clicked, this, &StationFreeRSViewer::goToNext);
     connect(prevOpBut, &QPushButton::clicked, this, &StationFreeRSViewer::goToPrev);
@@ -112,6 +121,25 @@ void StationFreeRSViewer::updateData()
 void StationFreeRSViewer::onTimeEditingFinished()
 {
     model->setTime(timeEdit->time());
+    syncScrubber();
+}
+
+void StationFreeRSViewer::onScrubberMoved(int minutes)
+{
+    const QTime time(minutes / 60, minutes % 60);
+
+    QSignalBlocker blk(timeEdit);
+    timeEdit->setTime(time);
+
+    model->scrubToTime(time);
+}
+
+void StationFreeRSViewer::syncScrubber()
+{
+    const QTime time = model->getTime();
+
+    QSignalBlocker blk(timeSlider);
+    timeSlider->setValue(time.hour() * 60 + time.minute());
 }
 
 /* void StationFreeRSViewer::goToNext()
@@ -141,6 +169,7 @@ void StationFreeRSViewer::goToNext()
 
     timeEdit->setTime(time);
     model->setTime(time);
+    syncScrubber();
 }
 
 /* void StationFreeRSViewer::goToPrev()
@@ -171,6 +200,7 @@ void StationFreeRSViewer::goToPrev()
 
     timeEdit->setTime(time);
     model->setTime(time);
+    syncScrubber();
 }
 
 void StationFreeRSViewer::showContextMenu(const QPoint &pos)
@@ -28,6 +28,7 @@ class StationFreeRSModel;
 class QTimeEdit;
 class QTableView;
 class QPushButton;
+class QSlider;
 
 class StationFreeRSViewer : public QWidget
 {
@@ -45,16 +46,21 @@ public slots:
 
 private slots:
     void onTimeEditingFinished();
+    void onScrubberMoved(int minutes);
 
     void showContextMenu(const QPoint &pos);
 
     void sectionClicked(int col);
 
+private:
+    void syncScrubber();
+
 private:
     StationFreeRSModel *model;
     QTableView *view;
 
     QTimeEdit *timeEdit;
+    QSlider *timeSlider;
     QPushButton *refreshBut;
     QPushButton *nextOpBut;
     QPushButton *prevOpBut;
@@ -156,7 +156,7 @@ void StationJobView::onSaveSheet()
 
     RecentDirStore::setPath(station_sheet_key, fileName);
 
-    StationSheetExport sheet(m_stationId);
+    StationSheetExport sheet(Session->m_Db, m_stationId);
     sheet.write();
     sheet.save(fileName);
 
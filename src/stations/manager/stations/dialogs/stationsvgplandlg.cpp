@@ -37,6 +37,7 @@
 #include <ssplib/svgstationplanlib.h>
 
 #include "stations/manager/stations/model/stationsvghelper.h"
+#include "stations/manager/stations/model/stationsvgplancache.h"
 #include "stations/manager/segments/model/railwaysegmenthelper.h"
 #include "utils/delegates/kmspinbox/kmutils.h"
 
@@ -128,6 +129,7 @@ StationSVGPlanDlg::~StationSVGPlanDlg()
 
     view->setPlan(nullptr);
     view->setRenderer(nullptr);
+    m_cachedSvg.reset();
 
     delete m_plan;
     m_plan = nullptr;
@@ -160,6 +162,7 @@ void StationSVGPlanDlg::reloadSVG(QIODevice *dev)
 
     QXmlStreamReader xml(dev);
     mSvg->load(&xml);
+    setRenderer(mSvg);
 
     view->update();
     zoomToFit();
@@ -280,6 +283,28 @@ bool StationSVGPlanDlg::stationHasSVG(sqlite3pp::database &db, db_id stId, QStri
 
 void StationSVGPlanDlg::reloadPlan()
 {
+    if (&mDb == &Session->m_Db)
+    {
+        // Reuse plan already parsed if SVG did not change
+        const StationSVGPlanCache::Entry *entry =
+          Session->getStationSVGPlanCache()->getPlan(mDb, stationId);
+        if (!entry)
+        {
+            QMessageBox::warning(this, tr("Error Loading SVG"), tr("Cannot find SVG data"));
+            return;
+        }
+
+        *m_plan = entry->plan;
+        setRenderer(entry->renderer.data());
+        m_cachedSvg = entry->renderer;
+
+        view->update();
+        zoomToFit();
+
+        reloadDBData();
+        return;
+    }
+
     std::unique_ptr<QIODevice> dev;
     dev.reset(StationSVGHelper::loadImage(mDb, stationId));
 
@@ -300,6 +325,15 @@ void StationSVGPlanDlg::reloadPlan()
     reloadDBData();
 }
 
+void StationSVGPlanDlg::setRenderer(QSvgRenderer *renderer)
+{
+    view->setRenderer(renderer);
+
+    // Release previous cached renderer after viewer stopped using it
+    if (renderer != m_cachedSvg.data())
+        m_cachedSvg.reset();
+}
+
 void StationSVGPlanDlg::setZoom(int val, bool force)
 {
     val = qBound(10, val, 500);
@@ -21,6 +21,7 @@
 #define STATIONSVGPLANDLG_H
 
 #include <QWidget>
+#include <QSharedPointer>
 
 #include "utils/types.h"
 
@@ -89,6 +90,7 @@ protected:
 
 private:
     void clearJobs_internal();
+    void setRenderer(QSvgRenderer *renderer);
 
 private:
     sqlite3pp::database &mDb;
@@ -105,6 +107,7 @@ private:
     ssplib::SSPViewer *view;
 
     QSvgRenderer *mSvg;
+    QSharedPointer<QSvgRenderer> m_cachedSvg; // Shared with StationSVGPlanCache
     ssplib::StationPlan *m_plan;
 
     StationSVGJobStops *m_station;
@@ -32,6 +32,7 @@
 #include "stations/station_utils.h"
 
 #include "app/session.h"
+#include "stationsvgplancache.h"
 
 #include "utils/jobcategorystrings.h"
 
@@ -47,6 +48,13 @@ static ImageMetaData::ImageBlobDevice *loadImage_internal(sqlite3pp::database &d
     return dev;
 }
 
+static void invalidatePlanCache(sqlite3pp::database &db, db_id stationId)
+{
+    // Only plans of current session are cached
+    if (&db == &Session->m_Db)
+        Session->getStationSVGPlanCache()->invalidateStation(stationId);
+}
+
 bool StationSVGHelper::stationHasSVG(sqlite3pp::database &db, db_id stationId, QString *stNameOut)
 {
     sqlite3pp::query q(db);
@@ -75,6 +83,8 @@ bool StationSVGHelper::addImage(sqlite3pp::database &db, db_id stationId, QIODev
         return false;
     }
 
+    invalidatePlanCache(db, stationId);
+
     // Make room for storing data and open device
     if (!dest->reserveSizeAndReset(source->size()))
     {
@@ -98,6 +108,8 @@ bool StationSVGHelper::addImage(sqlite3pp::database &db, db_id stationId, QIODev
 
 bool StationSVGHelper::removeImage(sqlite3pp::database &db, db_id stationId, QString *errOut)
 {
+    invalidatePlanCache(db, stationId);
+
     sqlite3pp::command cmd(db, "UPDATE stations SET svg_data = NULL WHERE id=?");
     cmd.bind(1, stationId);
     int ret = cmd.execute();
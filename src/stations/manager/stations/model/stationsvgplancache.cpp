@@ -0,0 +1,114 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "stationsvgplancache.h"
+
+#include "stationsvghelper.h"
+
+#include <sqlite3pp/sqlite3pp.h>
+
+#include <ssplib/parsing/streamparser.h>
+
+#include <QSvgRenderer>
+#include <QXmlStreamReader>
+
+#include <QDebug>
+
+#include <algorithm>
+#include <memory>
+
+StationSVGPlanCache::StationSVGPlanCache(QObject *parent) :
+    QObject(parent)
+{
+    m_cache.setMaxCost(MaxCostKiB);
+}
+
+const StationSVGPlanCache::Entry *StationSVGPlanCache::getPlan(sqlite3pp::database &db,
+                                                               db_id stationId)
+{
+    // length() of a BLOB does not need to read its content
+    sqlite3pp::query q(db, "SELECT length(svg_data) FROM stations WHERE id=?");
+    q.bind(1, stationId);
+    if (q.step() != SQLITE_ROW || q.getRows().column_type(0) == SQLITE_NULL)
+    {
+        m_cache.remove(stationId);
+        return nullptr;
+    }
+
+    const qint64 blobSize = q.getRows().get<qint64>(0);
+    q.finish();
+
+    Entry *entry = m_cache.object(stationId);
+    if (entry && entry->blobSize == blobSize)
+        return entry;
+
+    return loadEntry(db, stationId, blobSize);
+}
+
+void StationSVGPlanCache::clear()
+{
+    m_cache.clear();
+}
+
+void StationSVGPlanCache::invalidateStation(db_id stationId)
+{
+    m_cache.remove(stationId);
+}
+
+StationSVGPlanCache::Entry *StationSVGPlanCache::loadEntry(sqlite3pp::database &db,
+                                                           db_id stationId, qint64 blobSize)
+{
+    m_cache.remove(stationId);
+
+    std::unique_ptr<QIODevice> dev;
+    dev.reset(StationSVGHelper::loadImage(db, stationId));
+    if (!dev || !dev->open(QIODevice::ReadOnly))
+    {
+        qWarning() << "StationSVGPlanCache: cannot read SVG of station" << stationId
+                   << (dev ? dev->errorString() : QString());
+        return nullptr;
+    }
+
+    Entry *entry    = new Entry;
+    entry->blobSize = blobSize;
+
+    ssplib::StreamParser parser(&entry->plan, dev.get());
+    parser.parse();
+
+    // Sort items
+    std::sort(entry->plan.labels.begin(), entry->plan.labels.end());
+    std::sort(entry->plan.platforms.begin(), entry->plan.platforms.end());
+    std::sort(entry->plan.trackConnections.begin(), entry->plan.trackConnections.end());
+
+    dev->reset();
+
+    entry->renderer.reset(new QSvgRenderer);
+    QXmlStreamReader xml(dev.get());
+    entry->renderer->load(&xml);
+
+    // Cost is image size, at least 1 KiB
+    const int cost = int(qBound<qint64>(1, blobSize / 1024, MaxCostKiB));
+    if (!m_cache.insert(stationId, entry, cost))
+    {
+        // Entry was deleted by insert()
+        return nullptr;
+    }
+
+    return entry;
+}
@@ -0,0 +1,88 @@
+/*
+ * ModelRailroadTimetablePlanner
+ * Copyright 2016-2023, Filippo Gentile
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef STATIONSVGPLANCACHE_H
+#define STATIONSVGPLANCACHE_H
+
+#include <QObject>
+
+#include <QCache>
+#include <QSharedPointer>
+
+#include <ssplib/stationplan.h>
+
+#include "utils/types.h"
+
+class QSvgRenderer;
+
+namespace sqlite3pp {
+class database;
+}
+
+/*!
+ * \brief The StationSVGPlanCache class
+ *
+ * Session scoped LRU cache of parsed station SVG plans.
+ * Each entry stores the plan as parsed from SVG, without database data,
+ * and the QSvgRenderer loaded from the same SVG so reopening a plan
+ * does not parse the image again.
+ * Entries are checked against size of 'svg_data' blob and
+ * explicitly invalidated when image is replaced or station removed.
+ *
+ * \sa StationSVGHelper
+ * \sa MeetingSession::getStationSVGPlanCache()
+ */
+class StationSVGPlanCache : public QObject
+{
+    Q_OBJECT
+public:
+    // Maximum total size of cached SVG images in KiB
+    static constexpr int MaxCostKiB = 32 * 1024;
+
+    struct Entry
+    {
+        ssplib::StationPlan plan;
+        QSharedPointer<QSvgRenderer> renderer;
+        qint64 blobSize = 0;
+    };
+
+    explicit StationSVGPlanCache(QObject *parent = nullptr);
+
+    /*!
+     * \brief getPlan
+     * \param db the database
+     * \param stationId the station
+     * \return cached entry, nullptr if station has no valid SVG
+     *
+     * Returned pointer is valid until next call
+     */
+    const Entry *getPlan(sqlite3pp::database &db, db_id stationId);
+
+public slots:
+    void clear();
+    void invalidateStation(db_id stationId);
+
+private:
+    Entry *loadEntry(sqlite3pp::database &db, db_id stationId, qint64 blobSize);
+
+private:
+    QCache<db_id, Entry> m_cache;
+};
+
+#endif // STATIONSVGPLANCACHE_H
@@ -65,6 +65,7 @@ void BasicGraphView::setScene(IGraphScene *newScene)
     if (m_scene)
     {
         disconnect(m_scene, &IGraphScene::redrawGraph, this, &BasicGraphView::redrawGraph);
+        disconnect(m_scene, &IGraphScene::redrawSceneRect, this, &BasicGraphView::redrawSceneRect);
         disconnect(m_scene, &IGraphScene::headersSizeChanged, this, &BasicGraphView::resizeHeaders);
         disconnect(m_scene, &IGraphScene::requestShowRect, this,
                    &BasicGraphView::ensureRectVisible);
@@ -74,6 +75,7 @@ void BasicGraphView::setScene(IGraphScene *newScene)
     if (m_scene)
     {
         connect(m_scene, &IGraphScene::redrawGraph, this, &BasicGraphView::redrawGraph);
+        connect(m_scene, &IGraphScene::redrawSceneRect, this, &BasicGraphView::redrawSceneRect);
         connect(m_scene, &IGraphScene::headersSizeChanged, this, &BasicGraphView::resizeHeaders);
         connect(m_scene, &IGraphScene::requestShowRect, this, &BasicGraphView::ensureRectVisible);
         connect(m_scene, &QObject::destroyed, this, &BasicGraphView::onSceneDestroyed);
@@ -158,6 +160,17 @@ void BasicGraphView::redrawGraph()
     m_horizontalHeader->update();
 }
 
+void BasicGraphView::redrawSceneRect(const QRectF &r)
+{
+    const double scaleFactor = mZoom / 100.0;
+    const QPoint origin(-horizontalScrollBar()->value(), -verticalScrollBar()->value());
+
+    // Map to viewport, round outwards so antialiased edges are included
+    QRectF vpRect(r.topLeft() * scaleFactor, r.size() * scaleFactor);
+    vpRect.translate(origin);
+    viewport()->update(vpRect.toAlignedRect().adjusted(-1, -1, 1, 1));
+}
+
 void BasicGraphView::ensureRectVisible(const QRectF &r)
 {
     // FIXME: better implementation
@@ -87,6 +87,12 @@ public slots:
      */
     void redrawGraph();
 
+    /*!
+     * \brief Triggers redrawing of a portion of contents
+     * \param r Rect in scene coordinates
+     */
+    void redrawSceneRect(const QRectF &r);
+
     /*!
      * \brief ensure a rect is visible in the viewport
      *
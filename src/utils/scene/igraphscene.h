@@ -118,6 +118,15 @@ signals:
      */
     void redrawGraph();
 
+    /*!
+     * \brief request BasicGraphView to redraw part of contents
+     * \param sceneRect Rect to redraw in scene coordinates
+     *
+     * Use instead of \ref redrawGraph() when only some items changed
+     * and content size did not change.
+     */
+    void redrawSceneRect(const QRectF &sceneRect);
+
     /*!
      * \brief tell BasicGraphView to resize headers
      *
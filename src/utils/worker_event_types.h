@@ -72,7 +72,10 @@ enum class CustomEvents
     PrintProgress,
 
     // Line Graph Manager
-    LineGraphManagerUpdate
+    LineGraphManagerUpdate,
+
+    // SQL Console
+    SQLConsoleQueryResult
 };
 
 #endif // WORKER_EVENT_TYPES_H